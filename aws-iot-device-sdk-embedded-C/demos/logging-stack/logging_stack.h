@@ -35,7 +35,13 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
-#include <applibs/log.h>
+
+#if defined( AzureSpherePlatform )
+    #include <applibs/log.h>
+#else
+    /* Outside of Azure Sphere, such as in the host build, log to stdout. */
+    #define Log_Debug    printf
+#endif
 
 /* The macro definition for LIBRARY_LOG_NAME is for Doxygen
  * documentation only. This macro is typically defined in only the
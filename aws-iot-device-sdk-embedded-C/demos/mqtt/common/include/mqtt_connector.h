@@ -0,0 +1,234 @@
+/*
+ * AWS IoT Device SDK for Embedded C V202011.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MQTT_CONNECTOR_H_
+#define MQTT_CONNECTOR_H_
+
+/**
+ * @file mqtt_connector.h
+ * @brief Non-blocking establishment of MQTT sessions over TLS.
+ *
+ * A connector walks one connection through DNS resolution, TCP connect, TLS
+ * handshake, MQTT CONNECT and SUBSCRIBE without ever blocking on the network.
+ * The application waits for the descriptor returned by
+ * #MqttConnector_GetPollInfo in the same poll loop that serves its
+ * established connections and calls #MqttConnector_Step when it is ready, so
+ * a gateway can restore hundreds of sessions concurrently.
+ */
+
+/* Standard includes. */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* POSIX includes. */
+#include <poll.h>
+
+/* MQTT API header. */
+#include "core_mqtt.h"
+
+/* Transport includes. */
+#include "wolfssl_posix.h"
+
+/**
+ * @brief Interval in milliseconds at which a pending DNS query is polled.
+ */
+#ifndef MQTT_CONNECTOR_RESOLVE_POLL_MS
+    #define MQTT_CONNECTOR_RESOLVE_POLL_MS    ( 10U )
+#endif
+
+/**
+ * @brief Default time in milliseconds that each phase may take.
+ */
+#ifndef MQTT_CONNECTOR_PHASE_TIMEOUT_MS
+    #define MQTT_CONNECTOR_PHASE_TIMEOUT_MS   ( 10000U )
+#endif
+
+/* Resolver structures, defined in <netdb.h>. */
+struct addrinfo;
+struct gaicb;
+
+/**
+ * @brief Phases of a connection attempt, in the order they are run.
+ */
+typedef enum MqttConnectorPhase
+{
+    MQTT_CONNECTOR_PHASE_RESOLVE = 0,   /**< Resolving the broker host name. */
+    MQTT_CONNECTOR_PHASE_TCP_CONNECT,   /**< Connecting to one of the resolved addresses. */
+    MQTT_CONNECTOR_PHASE_TLS_HANDSHAKE, /**< Performing the TLS handshake. */
+    MQTT_CONNECTOR_PHASE_MQTT_CONNECT,  /**< Sending CONNECT and waiting for CONNACK. */
+    MQTT_CONNECTOR_PHASE_SUBSCRIBE,     /**< Sending SUBSCRIBE. */
+    MQTT_CONNECTOR_PHASE_COUNT          /**< Number of phases; the phase of a completed connector. */
+} MqttConnectorPhase_t;
+
+/**
+ * @brief Connector return status.
+ */
+typedef enum MqttConnectorStatus
+{
+    MQTT_CONNECTOR_SUCCESS = 0,       /**< All phases completed. */
+    MQTT_CONNECTOR_IN_PROGRESS,       /**< The connector waits for its descriptor or for the resolver. */
+    MQTT_CONNECTOR_INVALID_PARAMETER, /**< At least one parameter was invalid. */
+    MQTT_CONNECTOR_DNS_FAILURE,       /**< Resolving hostname of the server failed. */
+    MQTT_CONNECTOR_CONNECT_FAILURE,   /**< No resolved address accepted the TCP connection. */
+    MQTT_CONNECTOR_TLS_FAILURE,       /**< Setting up the TLS session failed. */
+    MQTT_CONNECTOR_MQTT_FAILURE,      /**< Exchanging MQTT packets failed or the broker refused the session. */
+    MQTT_CONNECTOR_TIMEOUT            /**< A phase took longer than its timeout. */
+} MqttConnectorStatus_t;
+
+/**
+ * @brief Parameters of a connection attempt.
+ *
+ * All pointers must stay valid until the connector has completed.
+ */
+typedef struct MqttConnectorConfig
+{
+    const ServerInfo_t * pServerInfo;              /**< @brief Broker to connect to. */
+    const WolfsslCredentials_t * pCredentials;     /**< @brief Credentials for the TLS session. */
+    const MQTTConnectInfo_t * pConnectInfo;        /**< @brief Parameters of the CONNECT packet. */
+    const MQTTPublishInfo_t * pWillInfo;           /**< @brief Last Will and Testament. NULL if not used. */
+    const MQTTSubscribeInfo_t * pSubscriptionList; /**< @brief Subscriptions to send after CONNACK. NULL if none. */
+    size_t subscriptionCount;                      /**< @brief Number of entries in pSubscriptionList. */
+    uint32_t phaseTimeoutMs;                       /**< @brief Time each phase may take. 0 selects #MQTT_CONNECTOR_PHASE_TIMEOUT_MS. */
+} MqttConnectorConfig_t;
+
+/**
+ * @brief State of one connection attempt.
+ *
+ * @note This structure is managed by the connector and should only be read
+ * by the application.
+ */
+typedef struct MqttConnector
+{
+    MqttConnectorConfig_t config;  /**< @brief Copy of the connection parameters. */
+    MQTTContext_t * pMqttContext;  /**< @brief MQTT context of the connection. */
+    MqttConnectorPhase_t phase;    /**< @brief Current phase, or the phase that failed. */
+    MqttConnectorStatus_t status;  /**< @brief Status returned by the last step. */
+
+    /* Resolver and TCP state. */
+    struct gaicb * pResolveRequest;  /**< @brief Pending asynchronous DNS query. */
+    struct addrinfo * pAddresses;    /**< @brief Resolved addresses of the broker. */
+    struct addrinfo * pNextAddress;  /**< @brief Next address to try. */
+    int32_t socketDescriptor;        /**< @brief Socket while connecting, -1 otherwise. */
+    int16_t pollEvents;              /**< @brief Events the current phase waits for. */
+
+    /* MQTT state. Packets are written from and read into the network buffer
+     * of the MQTT context. */
+    size_t txLength;            /**< @brief Length of the serialized packets to write. */
+    size_t txSent;              /**< @brief Bytes of them already written. */
+    size_t rxLength;            /**< @brief Bytes of CONNACK read so far. */
+    bool connackReceived;       /**< @brief Whether CONNACK has been received. */
+    bool sessionPresent;        /**< @brief Session present flag of CONNACK. */
+    uint16_t subscribePacketId; /**< @brief Packet ID of the SUBSCRIBE; its SUBACK is delivered by MQTT_ProcessLoop. */
+
+    /* Timings. */
+    uint32_t startTimeMs;                                      /**< @brief Time the attempt started. */
+    uint32_t phaseStartMs;                                     /**< @brief Time the current phase started. */
+    uint32_t phaseDurationMs[ MQTT_CONNECTOR_PHASE_COUNT ];    /**< @brief Time each completed phase took. */
+} MqttConnector_t;
+
+/**
+ * @brief Start a connection attempt.
+ *
+ * The MQTT context must have been initialized with #MQTT_Init using the
+ * wolfSSL transport functions and the network context the connection is set
+ * up in. Only the DNS query is issued here; the remaining phases are run by
+ * #MqttConnector_Step.
+ *
+ * @note The DNS query only runs in the background when the connector is
+ * built with MQTT_CONNECTOR_ASYNC_DNS, which needs glibc's getaddrinfo_a
+ * (libanl before glibc 2.34). Otherwise the first step resolves the host
+ * name with a blocking getaddrinfo call.
+ *
+ * @param[out] pConnector The connector to start.
+ * @param[in] pConfig Parameters of the connection attempt.
+ * @param[in] pMqttContext Initialized MQTT context of the connection.
+ *
+ * @return #MQTT_CONNECTOR_IN_PROGRESS on success;
+ * #MQTT_CONNECTOR_INVALID_PARAMETER or #MQTT_CONNECTOR_DNS_FAILURE on failure.
+ */
+MqttConnectorStatus_t MqttConnector_Start( MqttConnector_t * pConnector,
+                                           const MqttConnectorConfig_t * pConfig,
+                                           MQTTContext_t * pMqttContext );
+
+/**
+ * @brief Get what the connector is waiting for.
+ *
+ * @param[in] pConnector The connector started with #MqttConnector_Start.
+ * @param[out] pPollFd Descriptor and events to wait for. The descriptor is
+ * negative while the connector only waits for time to pass, which poll(2)
+ * ignores.
+ *
+ * @return Time in milliseconds after which #MqttConnector_Step must be called
+ * even if the descriptor did not become ready.
+ */
+uint32_t MqttConnector_GetPollInfo( const MqttConnector_t * pConnector,
+                                    struct pollfd * pPollFd );
+
+/**
+ * @brief Advance the connector as far as possible without blocking.
+ *
+ * On failure all resources of the attempt are released and #MqttConnector_t.phase
+ * tells which phase failed. On success the MQTT context is connected and its
+ * socket is left non-blocking: the application waits for it with the rest
+ * of its connections and runs MQTT_ProcessLoop with a timeout of 0 when it
+ * is readable. The SUBACK of the subscriptions arrives through that loop,
+ * as it does for #MQTT_Subscribe.
+ *
+ * @param[in] pConnector The connector started with #MqttConnector_Start.
+ *
+ * @return #MQTT_CONNECTOR_IN_PROGRESS if the connector has to wait again;
+ * #MQTT_CONNECTOR_SUCCESS once the session is established; any other status
+ * on failure.
+ */
+MqttConnectorStatus_t MqttConnector_Step( MqttConnector_t * pConnector );
+
+/**
+ * @brief Abandon a connection attempt that is in progress and release its
+ * resources.
+ *
+ * The connector then reports #MQTT_CONNECTOR_TIMEOUT.
+ *
+ * @param[in] pConnector The connector started with #MqttConnector_Start.
+ */
+void MqttConnector_Abort( MqttConnector_t * pConnector );
+
+/**
+ * @brief Wait once for any of a set of connectors and step the ones that are
+ * ready or whose deadline has passed.
+ *
+ * This is a minimal poll(2) reactor for applications without their own event
+ * loop. Connectors that are not in progress are skipped.
+ *
+ * @param[in] pConnectors Array of started connectors.
+ * @param[in] pPollFds Scratch array with one entry per connector.
+ * @param[in] connectorCount Number of connectors.
+ * @param[in] timeoutMs Maximum time to wait.
+ *
+ * @return Number of connectors still in progress.
+ */
+size_t MqttConnector_PollAll( MqttConnector_t * pConnectors,
+                              struct pollfd * pPollFds,
+                              size_t connectorCount,
+                              uint32_t timeoutMs );
+
+#endif /* ifndef MQTT_CONNECTOR_H_ */
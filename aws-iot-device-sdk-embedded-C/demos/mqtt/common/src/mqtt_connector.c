@@ -0,0 +1,1173 @@
+/*
+ * AWS IoT Device SDK for Embedded C V202011.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file mqtt_connector.c
+ * @brief Non-blocking establishment of MQTT sessions over TLS.
+ */
+
+#if defined( MQTT_CONNECTOR_ASYNC_DNS )
+    /* getaddrinfo_a is a GNU extension. */
+    #define _GNU_SOURCE
+#endif
+
+/* Standard includes. */
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* POSIX includes. */
+#include <fcntl.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+/**************************************************/
+/******* DO NOT CHANGE the following order ********/
+/**************************************************/
+
+/* Logging related header files are required to be included in the following order:
+ * 1. Include the header file "logging_levels.h".
+ * 2. Define LIBRARY_LOG_NAME and  LIBRARY_LOG_LEVEL.
+ * 3. Include the header file "logging_stack.h".
+ */
+
+/* Include header that defines log levels. */
+#include "logging_levels.h"
+
+/* Logging configuration for the MQTT connector. It does not use the demo
+ * configuration, so it builds outside of the demos. */
+#ifndef LIBRARY_LOG_NAME
+    #define LIBRARY_LOG_NAME     "MQTT_Connector"
+#endif
+#ifndef LIBRARY_LOG_LEVEL
+    #define LIBRARY_LOG_LEVEL    LOG_INFO
+#endif
+
+#include "logging_stack.h"
+
+/************ End of logging configuration ****************/
+
+#include "mqtt_connector.h"
+
+/* MQTT state include, to resend PUBRELs of a resumed session. */
+#include "core_mqtt_state.h"
+
+/* Clock for the phase timings. */
+#include "clock.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Size of the fixed part of a CONNACK packet.
+ */
+#define CONNACK_PACKET_SIZE                   ( 4U )
+
+/**
+ * @brief Remaining length of a CONNACK packet.
+ */
+#define CONNACK_REMAINING_LENGTH              ( 2U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Record the duration of the current phase and enter the next one.
+ *
+ * @param[in] pConnector The connector.
+ * @param[in] nextPhase Phase to enter.
+ */
+static void enterPhase( MqttConnector_t * pConnector,
+                        MqttConnectorPhase_t nextPhase );
+
+/**
+ * @brief Release the resolver, the socket and, after the TCP connection has
+ * been handed to the transport, the network context.
+ *
+ * @param[in] pConnector The connector.
+ */
+static void releaseResources( MqttConnector_t * pConnector );
+
+/**
+ * @brief Check whether the DNS query has completed.
+ *
+ * @param[in] pConnector The connector.
+ *
+ * @return #MQTT_CONNECTOR_SUCCESS when the addresses are available;
+ * #MQTT_CONNECTOR_IN_PROGRESS while the query runs;
+ * #MQTT_CONNECTOR_DNS_FAILURE on failure.
+ */
+static MqttConnectorStatus_t resolveHostName( MqttConnector_t * pConnector );
+
+/**
+ * @brief Start a non-blocking connect to the next resolved address.
+ *
+ * Addresses that refuse the connection immediately are skipped.
+ *
+ * @param[in] pConnector The connector.
+ *
+ * @return #MQTT_CONNECTOR_SUCCESS if the connection completed immediately;
+ * #MQTT_CONNECTOR_IN_PROGRESS if it is pending;
+ * #MQTT_CONNECTOR_CONNECT_FAILURE when no address is left.
+ */
+static MqttConnectorStatus_t connectNextAddress( MqttConnector_t * pConnector );
+
+/**
+ * @brief Check the outcome of a pending TCP connect and move on to the next
+ * address if it failed.
+ *
+ * @param[in] pConnector The connector.
+ *
+ * @return #MQTT_CONNECTOR_SUCCESS once connected;
+ * #MQTT_CONNECTOR_IN_PROGRESS while pending;
+ * #MQTT_CONNECTOR_CONNECT_FAILURE when no address is left.
+ */
+static MqttConnectorStatus_t checkConnect( MqttConnector_t * pConnector );
+
+/**
+ * @brief Advance the TLS handshake.
+ *
+ * @param[in] pConnector The connector.
+ *
+ * @return #MQTT_CONNECTOR_SUCCESS once the handshake has completed;
+ * #MQTT_CONNECTOR_IN_PROGRESS while it waits for the socket;
+ * #MQTT_CONNECTOR_TLS_FAILURE on failure.
+ */
+static MqttConnectorStatus_t continueHandshake( MqttConnector_t * pConnector );
+
+/**
+ * @brief Write the serialized packets in the network buffer.
+ *
+ * @param[in] pConnector The connector.
+ *
+ * @return #MQTT_CONNECTOR_SUCCESS once everything is written;
+ * #MQTT_CONNECTOR_IN_PROGRESS if the socket is full;
+ * #MQTT_CONNECTOR_MQTT_FAILURE on failure.
+ */
+static MqttConnectorStatus_t flushPackets( MqttConnector_t * pConnector );
+
+/**
+ * @brief Serialize the CONNECT packet into the network buffer.
+ *
+ * @param[in] pConnector The connector.
+ *
+ * @return #MQTT_CONNECTOR_SUCCESS on success;
+ * #MQTT_CONNECTOR_MQTT_FAILURE on failure.
+ */
+static MqttConnectorStatus_t serializeConnect( MqttConnector_t * pConnector );
+
+/**
+ * @brief Read and check CONNACK.
+ *
+ * @param[in] pConnector The connector.
+ *
+ * @return #MQTT_CONNECTOR_SUCCESS once CONNACK accepted the session;
+ * #MQTT_CONNECTOR_IN_PROGRESS while it has not fully arrived;
+ * #MQTT_CONNECTOR_MQTT_FAILURE on failure.
+ */
+static MqttConnectorStatus_t receiveConnack( MqttConnector_t * pConnector );
+
+/**
+ * @brief Bring the MQTT context into the state #MQTT_Connect leaves it in.
+ *
+ * A new session clears the publish records. A resumed session gets the
+ * PUBRELs it still owes serialized into the network buffer.
+ *
+ * @param[in] pConnector The connector.
+ *
+ * @return #MQTT_CONNECTOR_SUCCESS on success;
+ * #MQTT_CONNECTOR_MQTT_FAILURE on failure.
+ */
+static MqttConnectorStatus_t startSession( MqttConnector_t * pConnector );
+
+/**
+ * @brief Serialize the SUBSCRIBE packet into the network buffer.
+ *
+ * @param[in] pConnector The connector.
+ *
+ * @return #MQTT_CONNECTOR_SUCCESS on success;
+ * #MQTT_CONNECTOR_MQTT_FAILURE on failure.
+ */
+static MqttConnectorStatus_t serializeSubscribe( MqttConnector_t * pConnector );
+
+/**
+ * @brief Run the current phase once.
+ *
+ * @param[in] pConnector The connector.
+ * @param[out] pPhaseDone Set to true when the phase completed.
+ *
+ * @return #MQTT_CONNECTOR_IN_PROGRESS unless the connector completed or failed.
+ */
+static MqttConnectorStatus_t runPhase( MqttConnector_t * pConnector,
+                                       bool * pPhaseDone );
+
+/*-----------------------------------------------------------*/
+
+static void enterPhase( MqttConnector_t * pConnector,
+                        MqttConnectorPhase_t nextPhase )
+{
+    uint32_t nowMs = Clock_GetTimeMs();
+
+    assert( pConnector != NULL );
+    assert( pConnector->phase < MQTT_CONNECTOR_PHASE_COUNT );
+
+    pConnector->phaseDurationMs[ pConnector->phase ] = nowMs - pConnector->phaseStartMs;
+
+    LogDebug( ( "Connector phase %d took %u ms.",
+                ( int ) pConnector->phase,
+                ( unsigned int ) pConnector->phaseDurationMs[ pConnector->phase ] ) );
+
+    pConnector->phase = nextPhase;
+    pConnector->phaseStartMs = nowMs;
+    pConnector->pollEvents = 0;
+}
+/*-----------------------------------------------------------*/
+
+static void releaseResources( MqttConnector_t * pConnector )
+{
+    assert( pConnector != NULL );
+
+    #if defined( MQTT_CONNECTOR_ASYNC_DNS )
+        if( pConnector->pResolveRequest != NULL )
+        {
+            /* A query that cannot be cancelled any more finishes on its own;
+             * wait for it so that its result can be freed. */
+            if( gai_cancel( pConnector->pResolveRequest ) == EAI_NOTCANCELED )
+            {
+                const struct gaicb * pRequestList[ 1 ] = { pConnector->pResolveRequest };
+
+                ( void ) gai_suspend( pRequestList, 1, NULL );
+            }
+
+            if( pConnector->pResolveRequest->ar_result != NULL )
+            {
+                freeaddrinfo( pConnector->pResolveRequest->ar_result );
+            }
+
+            free( pConnector->pResolveRequest );
+            pConnector->pResolveRequest = NULL;
+        }
+    #endif /* if defined( MQTT_CONNECTOR_ASYNC_DNS ) */
+
+    if( pConnector->pAddresses != NULL )
+    {
+        freeaddrinfo( pConnector->pAddresses );
+        pConnector->pAddresses = NULL;
+        pConnector->pNextAddress = NULL;
+    }
+
+    if( pConnector->socketDescriptor >= 0 )
+    {
+        ( void ) close( pConnector->socketDescriptor );
+        pConnector->socketDescriptor = -1;
+    }
+    else if( ( pConnector->phase >= MQTT_CONNECTOR_PHASE_TLS_HANDSHAKE ) &&
+             ( pConnector->phase < MQTT_CONNECTOR_PHASE_COUNT ) )
+    {
+        /* The network context owns the socket since the handshake started. */
+        ( void ) Wolfssl_Disconnect( pConnector->pMqttContext->transportInterface.pNetworkContext );
+        pConnector->pMqttContext->connectStatus = MQTTNotConnected;
+    }
+    else
+    {
+        /* Empty else. */
+    }
+}
+/*-----------------------------------------------------------*/
+
+static MqttConnectorStatus_t resolveHostName( MqttConnector_t * pConnector )
+{
+    MqttConnectorStatus_t returnStatus = MQTT_CONNECTOR_SUCCESS;
+    int32_t dnsStatus = 0;
+
+    assert( pConnector != NULL );
+
+    #if defined( MQTT_CONNECTOR_ASYNC_DNS )
+        assert( pConnector->pResolveRequest != NULL );
+
+        dnsStatus = gai_error( pConnector->pResolveRequest );
+
+        if( dnsStatus == EAI_INPROGRESS )
+        {
+            returnStatus = MQTT_CONNECTOR_IN_PROGRESS;
+        }
+        else if( dnsStatus == 0 )
+        {
+            /* Take over the result so that only the request is freed. */
+            pConnector->pAddresses = pConnector->pResolveRequest->ar_result;
+            pConnector->pResolveRequest->ar_result = NULL;
+            free( pConnector->pResolveRequest );
+            pConnector->pResolveRequest = NULL;
+        }
+        else
+        {
+            returnStatus = MQTT_CONNECTOR_DNS_FAILURE;
+        }
+    #else /* if defined( MQTT_CONNECTOR_ASYNC_DNS ) */
+        struct addrinfo hints;
+
+        ( void ) memset( &hints, 0, sizeof( hints ) );
+
+        /* Address family of either IPv4 or IPv6. */
+        hints.ai_family = AF_UNSPEC;
+        /* TCP Socket. */
+        hints.ai_socktype = ( int32_t ) SOCK_STREAM;
+        hints.ai_protocol = IPPROTO_TCP;
+
+        /* Without getaddrinfo_a this is the one blocking call. */
+        dnsStatus = getaddrinfo( pConnector->config.pServerInfo->pHostName,
+                                 NULL,
+                                 &hints,
+                                 &pConnector->pAddresses );
+
+        if( dnsStatus != 0 )
+        {
+            returnStatus = MQTT_CONNECTOR_DNS_FAILURE;
+        }
+    #endif /* if defined( MQTT_CONNECTOR_ASYNC_DNS ) */
+
+    if( returnStatus == MQTT_CONNECTOR_DNS_FAILURE )
+    {
+        LogError( ( "Failed to resolve DNS: Hostname=%.*s, ErrorCode=%d.",
+                    ( int32_t ) pConnector->config.pServerInfo->hostNameLength,
+                    pConnector->config.pServerInfo->pHostName,
+                    ( int ) dnsStatus ) );
+    }
+    else if( returnStatus == MQTT_CONNECTOR_SUCCESS )
+    {
+        pConnector->pNextAddress = pConnector->pAddresses;
+    }
+    else
+    {
+        /* Empty else. */
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static MqttConnectorStatus_t connectNextAddress( MqttConnector_t * pConnector )
+{
+    MqttConnectorStatus_t returnStatus = MQTT_CONNECTOR_CONNECT_FAILURE;
+    struct addrinfo * pAddress = NULL;
+    struct sockaddr_in * pIpv4Address = NULL;
+    struct sockaddr_in6 * pIpv6Address = NULL;
+    int32_t tcpSocket = -1;
+    int32_t flags = 0;
+
+    assert( pConnector != NULL );
+    assert( pConnector->socketDescriptor < 0 );
+
+    while( ( pConnector->pNextAddress != NULL ) &&
+           ( returnStatus == MQTT_CONNECTOR_CONNECT_FAILURE ) )
+    {
+        pAddress = pConnector->pNextAddress;
+        pConnector->pNextAddress = pAddress->ai_next;
+
+        tcpSocket = -1;
+
+        /* Only IPv4 and IPv6 addresses are connected to. */
+        if( pAddress->ai_family == AF_INET )
+        {
+            /* coverity[misra_c_2012_rule_11_3_violation] */
+            pIpv4Address = ( struct sockaddr_in * ) pAddress->ai_addr;
+            pIpv4Address->sin_port = htons( pConnector->config.pServerInfo->port );
+            tcpSocket = socket( pAddress->ai_family, pAddress->ai_socktype, pAddress->ai_protocol );
+        }
+        else if( pAddress->ai_family == AF_INET6 )
+        {
+            /* coverity[misra_c_2012_rule_11_3_violation] */
+            pIpv6Address = ( struct sockaddr_in6 * ) pAddress->ai_addr;
+            pIpv6Address->sin6_port = htons( pConnector->config.pServerInfo->port );
+            tcpSocket = socket( pAddress->ai_family, pAddress->ai_socktype, pAddress->ai_protocol );
+        }
+        else
+        {
+            /* Empty else. */
+        }
+
+        if( tcpSocket >= 0 )
+        {
+            flags = fcntl( tcpSocket, F_GETFL, 0 );
+
+            if( ( flags < 0 ) || ( fcntl( tcpSocket, F_SETFL, flags | O_NONBLOCK ) < 0 ) )
+            {
+                ( void ) close( tcpSocket );
+            }
+            else if( connect( tcpSocket, pAddress->ai_addr, pAddress->ai_addrlen ) == 0 )
+            {
+                pConnector->socketDescriptor = tcpSocket;
+                returnStatus = MQTT_CONNECTOR_SUCCESS;
+            }
+            else if( errno == EINPROGRESS )
+            {
+                pConnector->socketDescriptor = tcpSocket;
+                pConnector->pollEvents = POLLOUT;
+                returnStatus = MQTT_CONNECTOR_IN_PROGRESS;
+            }
+            else
+            {
+                LogWarn( ( "Failed to connect to a resolved address: errno=%d.", errno ) );
+                ( void ) close( tcpSocket );
+            }
+        }
+    }
+
+    if( returnStatus == MQTT_CONNECTOR_CONNECT_FAILURE )
+    {
+        LogError( ( "Could not connect to any resolved IP address from %.*s.",
+                    ( int32_t ) pConnector->config.pServerInfo->hostNameLength,
+                    pConnector->config.pServerInfo->pHostName ) );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static MqttConnectorStatus_t checkConnect( MqttConnector_t * pConnector )
+{
+    MqttConnectorStatus_t returnStatus = MQTT_CONNECTOR_IN_PROGRESS;
+    struct pollfd pollFd;
+    int32_t socketError = 0;
+    socklen_t optionLength = ( socklen_t ) sizeof( socketError );
+
+    assert( pConnector != NULL );
+
+    if( pConnector->socketDescriptor < 0 )
+    {
+        returnStatus = connectNextAddress( pConnector );
+    }
+    else
+    {
+        /* SO_ERROR is only meaningful once the socket is writable. */
+        pollFd.fd = pConnector->socketDescriptor;
+        pollFd.events = POLLOUT;
+        pollFd.revents = 0;
+
+        if( poll( &pollFd, 1, 0 ) > 0 )
+        {
+            if( ( getsockopt( pConnector->socketDescriptor,
+                              SOL_SOCKET,
+                              SO_ERROR,
+                              &socketError,
+                              &optionLength ) == 0 ) &&
+                ( socketError == 0 ) )
+            {
+                returnStatus = MQTT_CONNECTOR_SUCCESS;
+            }
+            else
+            {
+                LogWarn( ( "Failed to connect to a resolved address: error=%d.",
+                           ( int ) socketError ) );
+                ( void ) close( pConnector->socketDescriptor );
+                pConnector->socketDescriptor = -1;
+                returnStatus = connectNextAddress( pConnector );
+            }
+        }
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static MqttConnectorStatus_t continueHandshake( MqttConnector_t * pConnector )
+{
+    MqttConnectorStatus_t returnStatus = MQTT_CONNECTOR_TLS_FAILURE;
+    WolfsslStatus_t wolfsslStatus = WOLFSSL_SUCCEED;
+
+    assert( pConnector != NULL );
+
+    wolfsslStatus = Wolfssl_HandshakeContinue( pConnector->pMqttContext->transportInterface.pNetworkContext );
+
+    if( wolfsslStatus == WOLFSSL_SUCCEED )
+    {
+        returnStatus = MQTT_CONNECTOR_SUCCESS;
+    }
+    else if( wolfsslStatus == WOLFSSL_HANDSHAKE_WANT_READ )
+    {
+        pConnector->pollEvents = POLLIN;
+        returnStatus = MQTT_CONNECTOR_IN_PROGRESS;
+    }
+    else if( wolfsslStatus == WOLFSSL_HANDSHAKE_WANT_WRITE )
+    {
+        pConnector->pollEvents = POLLOUT;
+        returnStatus = MQTT_CONNECTOR_IN_PROGRESS;
+    }
+    else
+    {
+        /* Empty else. */
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static MqttConnectorStatus_t flushPackets( MqttConnector_t * pConnector )
+{
+    MqttConnectorStatus_t returnStatus = MQTT_CONNECTOR_SUCCESS;
+    MQTTContext_t * pContext = NULL;
+    int32_t bytesSent = 0;
+
+    assert( pConnector != NULL );
+
+    pContext = pConnector->pMqttContext;
+
+    while( ( pConnector->txSent < pConnector->txLength ) &&
+           ( returnStatus == MQTT_CONNECTOR_SUCCESS ) )
+    {
+        bytesSent = pContext->transportInterface.send( pContext->transportInterface.pNetworkContext,
+                                                       &pContext->networkBuffer.pBuffer[ pConnector->txSent ],
+                                                       pConnector->txLength - pConnector->txSent );
+
+        if( bytesSent < 0 )
+        {
+            LogError( ( "Transport send failed while establishing the session." ) );
+            returnStatus = MQTT_CONNECTOR_MQTT_FAILURE;
+        }
+        else if( bytesSent == 0 )
+        {
+            pConnector->pollEvents = POLLOUT;
+            returnStatus = MQTT_CONNECTOR_IN_PROGRESS;
+        }
+        else
+        {
+            pConnector->txSent += ( size_t ) bytesSent;
+        }
+    }
+
+    if( ( returnStatus == MQTT_CONNECTOR_SUCCESS ) && ( pConnector->txLength > 0U ) )
+    {
+        pContext->lastPacketTime = pContext->getTime();
+        pConnector->txLength = 0U;
+        pConnector->txSent = 0U;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static MqttConnectorStatus_t serializeConnect( MqttConnector_t * pConnector )
+{
+    MqttConnectorStatus_t returnStatus = MQTT_CONNECTOR_SUCCESS;
+    MQTTStatus_t mqttStatus = MQTTSuccess;
+    size_t remainingLength = 0UL, packetSize = 0UL;
+
+    assert( pConnector != NULL );
+
+    mqttStatus = MQTT_GetConnectPacketSize( pConnector->config.pConnectInfo,
+                                            pConnector->config.pWillInfo,
+                                            &remainingLength,
+                                            &packetSize );
+
+    if( mqttStatus == MQTTSuccess )
+    {
+        mqttStatus = MQTT_SerializeConnect( pConnector->config.pConnectInfo,
+                                            pConnector->config.pWillInfo,
+                                            remainingLength,
+                                            &pConnector->pMqttContext->networkBuffer );
+    }
+
+    if( mqttStatus == MQTTSuccess )
+    {
+        pConnector->txLength = packetSize;
+        pConnector->txSent = 0U;
+        pConnector->rxLength = 0U;
+        pConnector->connackReceived = false;
+    }
+    else
+    {
+        LogError( ( "Failed to serialize CONNECT packet: MQTTStatus=%s.",
+                    MQTT_Status_strerror( mqttStatus ) ) );
+        returnStatus = MQTT_CONNECTOR_MQTT_FAILURE;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static MqttConnectorStatus_t receiveConnack( MqttConnector_t * pConnector )
+{
+    MqttConnectorStatus_t returnStatus = MQTT_CONNECTOR_IN_PROGRESS;
+    MQTTContext_t * pContext = NULL;
+    MQTTPacketInfo_t packetInfo;
+    MQTTStatus_t mqttStatus = MQTTSuccess;
+    uint16_t packetId = 0U;
+    int32_t bytesReceived = 1;
+
+    assert( pConnector != NULL );
+
+    pContext = pConnector->pMqttContext;
+
+    /* CONNACK always has the same size, so exactly its bytes are read and
+     * nothing that follows it is taken from MQTT_ProcessLoop. */
+    while( ( pConnector->rxLength < CONNACK_PACKET_SIZE ) &&
+           ( bytesReceived > 0 ) )
+    {
+        bytesReceived = pContext->transportInterface.recv( pContext->transportInterface.pNetworkContext,
+                                                           &pContext->networkBuffer.pBuffer[ pConnector->rxLength ],
+                                                           CONNACK_PACKET_SIZE - pConnector->rxLength );
+
+        if( bytesReceived < 0 )
+        {
+            LogError( ( "Transport receive failed while waiting for CONNACK." ) );
+            returnStatus = MQTT_CONNECTOR_MQTT_FAILURE;
+        }
+        else if( bytesReceived == 0 )
+        {
+            pConnector->pollEvents = POLLIN;
+        }
+        else
+        {
+            pConnector->rxLength += ( size_t ) bytesReceived;
+        }
+    }
+
+    if( ( returnStatus == MQTT_CONNECTOR_IN_PROGRESS ) &&
+        ( pConnector->rxLength == CONNACK_PACKET_SIZE ) )
+    {
+        packetInfo.type = pContext->networkBuffer.pBuffer[ 0 ];
+        packetInfo.remainingLength = ( size_t ) pContext->networkBuffer.pBuffer[ 1 ];
+        packetInfo.pRemainingData = &pContext->networkBuffer.pBuffer[ 2 ];
+
+        if( ( packetInfo.type != MQTT_PACKET_TYPE_CONNACK ) ||
+            ( packetInfo.remainingLength != CONNACK_REMAINING_LENGTH ) )
+        {
+            LogError( ( "Expected CONNACK, received packet type %02x.",
+                        ( unsigned int ) packetInfo.type ) );
+            mqttStatus = MQTTBadResponse;
+        }
+        else
+        {
+            mqttStatus = MQTT_DeserializeAck( &packetInfo, &packetId, &pConnector->sessionPresent );
+        }
+
+        if( mqttStatus == MQTTSuccess )
+        {
+            returnStatus = MQTT_CONNECTOR_SUCCESS;
+        }
+        else
+        {
+            LogError( ( "CONNACK did not accept the session: MQTTStatus=%s.",
+                        MQTT_Status_strerror( mqttStatus ) ) );
+            returnStatus = MQTT_CONNECTOR_MQTT_FAILURE;
+        }
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static MqttConnectorStatus_t startSession( MqttConnector_t * pConnector )
+{
+    MqttConnectorStatus_t returnStatus = MQTT_CONNECTOR_SUCCESS;
+    MQTTContext_t * pContext = NULL;
+    MQTTStatus_t mqttStatus = MQTTSuccess;
+    MQTTStateCursor_t cursor = MQTT_STATE_CURSOR_INITIALIZER;
+    MQTTPublishState_t state = MQTTStateNull;
+    MQTTFixedBuffer_t ackBuffer;
+    uint16_t packetId = MQTT_PACKET_ID_INVALID;
+
+    assert( pConnector != NULL );
+
+    pContext = pConnector->pMqttContext;
+    pConnector->txLength = 0U;
+    pConnector->txSent = 0U;
+
+    if( pConnector->sessionPresent == true )
+    {
+        /* Queue all PUBRELs of the resumed session in one write. */
+        packetId = MQTT_PubrelToResend( pContext, &cursor, &state );
+
+        while( ( packetId != MQTT_PACKET_ID_INVALID ) && ( mqttStatus == MQTTSuccess ) )
+        {
+            ackBuffer.pBuffer = &pContext->networkBuffer.pBuffer[ pConnector->txLength ];
+            ackBuffer.size = pContext->networkBuffer.size - pConnector->txLength;
+
+            mqttStatus = MQTT_SerializeAck( &ackBuffer, MQTT_PACKET_TYPE_PUBREL, packetId );
+
+            if( mqttStatus == MQTTSuccess )
+            {
+                pConnector->txLength += MQTT_PUBLISH_ACK_PACKET_SIZE;
+                mqttStatus = MQTT_UpdateStateAck( pContext, packetId, MQTTPubrel, MQTT_SEND, &state );
+            }
+
+            packetId = MQTT_PubrelToResend( pContext, &cursor, &state );
+        }
+    }
+    else
+    {
+        /* Clear any existing records if a new session is established. */
+        ( void ) memset( pContext->outgoingPublishRecords,
+                         0x00,
+                         sizeof( pContext->outgoingPublishRecords ) );
+        ( void ) memset( pContext->incomingPublishRecords,
+                         0x00,
+                         sizeof( pContext->incomingPublishRecords ) );
+    }
+
+    if( mqttStatus == MQTTSuccess )
+    {
+        pContext->connectStatus = MQTTConnected;
+        pContext->keepAliveIntervalSec = pConnector->config.pConnectInfo->keepAliveSeconds;
+        pContext->waitingForPingResp = false;
+        pContext->pingReqSendTimeMs = 0U;
+        pConnector->connackReceived = true;
+    }
+    else
+    {
+        LogError( ( "Failed to resend PUBRELs of the resumed session: MQTTStatus=%s.",
+                    MQTT_Status_strerror( mqttStatus ) ) );
+        returnStatus = MQTT_CONNECTOR_MQTT_FAILURE;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static MqttConnectorStatus_t serializeSubscribe( MqttConnector_t * pConnector )
+{
+    MqttConnectorStatus_t returnStatus = MQTT_CONNECTOR_SUCCESS;
+    MQTTStatus_t mqttStatus = MQTTSuccess;
+    size_t remainingLength = 0UL, packetSize = 0UL;
+
+    assert( pConnector != NULL );
+
+    mqttStatus = MQTT_GetSubscribePacketSize( pConnector->config.pSubscriptionList,
+                                              pConnector->config.subscriptionCount,
+                                              &remainingLength,
+                                              &packetSize );
+
+    if( mqttStatus == MQTTSuccess )
+    {
+        pConnector->subscribePacketId = MQTT_GetPacketId( pConnector->pMqttContext );
+
+        mqttStatus = MQTT_SerializeSubscribe( pConnector->config.pSubscriptionList,
+                                              pConnector->config.subscriptionCount,
+                                              pConnector->subscribePacketId,
+                                              remainingLength,
+                                              &pConnector->pMqttContext->networkBuffer );
+    }
+
+    if( mqttStatus == MQTTSuccess )
+    {
+        pConnector->txLength = packetSize;
+        pConnector->txSent = 0U;
+    }
+    else
+    {
+        LogError( ( "Failed to serialize SUBSCRIBE packet: MQTTStatus=%s.",
+                    MQTT_Status_strerror( mqttStatus ) ) );
+        returnStatus = MQTT_CONNECTOR_MQTT_FAILURE;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static MqttConnectorStatus_t runPhase( MqttConnector_t * pConnector,
+                                       bool * pPhaseDone )
+{
+    MqttConnectorStatus_t returnStatus = MQTT_CONNECTOR_IN_PROGRESS;
+    MqttConnectorStatus_t phaseStatus = MQTT_CONNECTOR_IN_PROGRESS;
+    WolfsslStatus_t wolfsslStatus = WOLFSSL_SUCCEED;
+
+    assert( pConnector != NULL );
+    assert( pPhaseDone != NULL );
+
+    *pPhaseDone = false;
+
+    if( pConnector->phase == MQTT_CONNECTOR_PHASE_RESOLVE )
+    {
+        phaseStatus = resolveHostName( pConnector );
+    }
+    else if( pConnector->phase == MQTT_CONNECTOR_PHASE_TCP_CONNECT )
+    {
+        phaseStatus = checkConnect( pConnector );
+
+        if( phaseStatus == MQTT_CONNECTOR_SUCCESS )
+        {
+            /* The socket belongs to the network context from here on. */
+            freeaddrinfo( pConnector->pAddresses );
+            pConnector->pAddresses = NULL;
+            pConnector->pNextAddress = NULL;
+
+            wolfsslStatus = Wolfssl_HandshakeStart( pConnector->pMqttContext->transportInterface.pNetworkContext,
+                                                    pConnector->socketDescriptor,
+                                                    pConnector->config.pCredentials );
+            pConnector->socketDescriptor = -1;
+
+            if( wolfsslStatus != WOLFSSL_SUCCEED )
+            {
+                /* Entering the TLS phase lets the network context close the socket. */
+                enterPhase( pConnector, MQTT_CONNECTOR_PHASE_TLS_HANDSHAKE );
+                phaseStatus = MQTT_CONNECTOR_TLS_FAILURE;
+            }
+        }
+    }
+    else if( pConnector->phase == MQTT_CONNECTOR_PHASE_TLS_HANDSHAKE )
+    {
+        phaseStatus = continueHandshake( pConnector );
+
+        if( phaseStatus == MQTT_CONNECTOR_SUCCESS )
+        {
+            phaseStatus = serializeConnect( pConnector );
+        }
+    }
+    else if( pConnector->phase == MQTT_CONNECTOR_PHASE_MQTT_CONNECT )
+    {
+        phaseStatus = flushPackets( pConnector );
+
+        if( ( phaseStatus == MQTT_CONNECTOR_SUCCESS ) && ( pConnector->connackReceived == false ) )
+        {
+            phaseStatus = receiveConnack( pConnector );
+
+            if( phaseStatus == MQTT_CONNECTOR_SUCCESS )
+            {
+                phaseStatus = startSession( pConnector );
+            }
+
+            /* Write the PUBRELs of a resumed session before completing. */
+            if( ( phaseStatus == MQTT_CONNECTOR_SUCCESS ) && ( pConnector->txLength > 0U ) )
+            {
+                phaseStatus = flushPackets( pConnector );
+            }
+        }
+
+        if( ( phaseStatus == MQTT_CONNECTOR_SUCCESS ) && ( pConnector->config.subscriptionCount > 0U ) )
+        {
+            phaseStatus = serializeSubscribe( pConnector );
+        }
+    }
+    else
+    {
+        phaseStatus = flushPackets( pConnector );
+    }
+
+    if( phaseStatus == MQTT_CONNECTOR_SUCCESS )
+    {
+        *pPhaseDone = true;
+
+        /* Without subscriptions there is no SUBSCRIBE phase. */
+        if( ( pConnector->phase == MQTT_CONNECTOR_PHASE_MQTT_CONNECT ) &&
+            ( pConnector->config.subscriptionCount == 0U ) )
+        {
+            enterPhase( pConnector, MQTT_CONNECTOR_PHASE_SUBSCRIBE );
+        }
+
+        enterPhase( pConnector, ( MqttConnectorPhase_t ) ( ( int ) pConnector->phase + 1 ) );
+
+        if( pConnector->phase == MQTT_CONNECTOR_PHASE_COUNT )
+        {
+            returnStatus = MQTT_CONNECTOR_SUCCESS;
+        }
+        else if( pConnector->phase == MQTT_CONNECTOR_PHASE_TCP_CONNECT )
+        {
+            returnStatus = connectNextAddress( pConnector );
+
+            /* A connection that completed immediately is picked up by the
+             * next run of the phase. */
+            if( returnStatus != MQTT_CONNECTOR_CONNECT_FAILURE )
+            {
+                returnStatus = MQTT_CONNECTOR_IN_PROGRESS;
+            }
+        }
+        else
+        {
+            /* Empty else. */
+        }
+    }
+    else if( phaseStatus != MQTT_CONNECTOR_IN_PROGRESS )
+    {
+        returnStatus = phaseStatus;
+    }
+    else
+    {
+        /* Empty else. */
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+MqttConnectorStatus_t MqttConnector_Start( MqttConnector_t * pConnector,
+                                           const MqttConnectorConfig_t * pConfig,
+                                           MQTTContext_t * pMqttContext )
+{
+    MqttConnectorStatus_t returnStatus = MQTT_CONNECTOR_IN_PROGRESS;
+
+    #if defined( MQTT_CONNECTOR_ASYNC_DNS )
+        struct gaicb * pRequestList[ 1 ];
+        struct addrinfo * pHints = NULL;
+    #endif
+
+    if( ( pConnector == NULL ) || ( pConfig == NULL ) || ( pMqttContext == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pConnector=%p, pConfig=%p, pMqttContext=%p.",
+                    ( void * ) pConnector,
+                    ( const void * ) pConfig,
+                    ( void * ) pMqttContext ) );
+        returnStatus = MQTT_CONNECTOR_INVALID_PARAMETER;
+    }
+    else if( ( pConfig->pServerInfo == NULL ) ||
+             ( pConfig->pServerInfo->pHostName == NULL ) ||
+             ( pConfig->pCredentials == NULL ) ||
+             ( pConfig->pConnectInfo == NULL ) ||
+             ( pMqttContext->transportInterface.pNetworkContext == NULL ) ||
+             ( pMqttContext->getTime == NULL ) )
+    {
+        LogError( ( "Parameter check failed: incomplete connector configuration or "
+                    "uninitialized MQTT context." ) );
+        returnStatus = MQTT_CONNECTOR_INVALID_PARAMETER;
+    }
+    else if( ( pConfig->subscriptionCount > 0U ) && ( pConfig->pSubscriptionList == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pSubscriptionList is NULL." ) );
+        returnStatus = MQTT_CONNECTOR_INVALID_PARAMETER;
+    }
+    else
+    {
+        ( void ) memset( pConnector, 0x00, sizeof( MqttConnector_t ) );
+        pConnector->config = *pConfig;
+        pConnector->pMqttContext = pMqttContext;
+        pConnector->phase = MQTT_CONNECTOR_PHASE_RESOLVE;
+        pConnector->socketDescriptor = -1;
+        pConnector->startTimeMs = Clock_GetTimeMs();
+        pConnector->phaseStartMs = pConnector->startTimeMs;
+
+        if( pConnector->config.phaseTimeoutMs == 0U )
+        {
+            pConnector->config.phaseTimeoutMs = MQTT_CONNECTOR_PHASE_TIMEOUT_MS;
+        }
+
+        #if defined( MQTT_CONNECTOR_ASYNC_DNS )
+            /* The hints have to outlive the query, so they share its allocation. */
+            pConnector->pResolveRequest = malloc( sizeof( struct gaicb ) + sizeof( struct addrinfo ) );
+
+            if( pConnector->pResolveRequest == NULL )
+            {
+                LogError( ( "Failed to allocate the DNS query." ) );
+                returnStatus = MQTT_CONNECTOR_DNS_FAILURE;
+            }
+            else
+            {
+                pHints = ( struct addrinfo * ) &pConnector->pResolveRequest[ 1 ];
+                ( void ) memset( pConnector->pResolveRequest, 0x00, sizeof( struct gaicb ) );
+                ( void ) memset( pHints, 0x00, sizeof( struct addrinfo ) );
+
+                pHints->ai_family = AF_UNSPEC;
+                pHints->ai_socktype = ( int32_t ) SOCK_STREAM;
+                pHints->ai_protocol = IPPROTO_TCP;
+
+                pConnector->pResolveRequest->ar_name = pConfig->pServerInfo->pHostName;
+                pConnector->pResolveRequest->ar_request = pHints;
+                pRequestList[ 0 ] = pConnector->pResolveRequest;
+
+                if( getaddrinfo_a( GAI_NOWAIT, pRequestList, 1, NULL ) != 0 )
+                {
+                    LogError( ( "Failed to start the DNS query." ) );
+                    free( pConnector->pResolveRequest );
+                    pConnector->pResolveRequest = NULL;
+                    returnStatus = MQTT_CONNECTOR_DNS_FAILURE;
+                }
+            }
+        #endif /* if defined( MQTT_CONNECTOR_ASYNC_DNS ) */
+
+        pConnector->status = returnStatus;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t MqttConnector_GetPollInfo( const MqttConnector_t * pConnector,
+                                    struct pollfd * pPollFd )
+{
+    uint32_t timeoutMs = 0U;
+    uint32_t elapsedMs = 0U;
+    int32_t pollDescriptor = -1;
+
+    assert( pConnector != NULL );
+    assert( pPollFd != NULL );
+
+    if( pConnector->status == MQTT_CONNECTOR_IN_PROGRESS )
+    {
+        elapsedMs = Clock_GetTimeMs() - pConnector->phaseStartMs;
+
+        if( elapsedMs < pConnector->config.phaseTimeoutMs )
+        {
+            timeoutMs = pConnector->config.phaseTimeoutMs - elapsedMs;
+        }
+
+        if( pConnector->phase == MQTT_CONNECTOR_PHASE_RESOLVE )
+        {
+            /* getaddrinfo_a has no descriptor to wait for. */
+            if( timeoutMs > MQTT_CONNECTOR_RESOLVE_POLL_MS )
+            {
+                timeoutMs = MQTT_CONNECTOR_RESOLVE_POLL_MS;
+            }
+        }
+        else if( pConnector->socketDescriptor >= 0 )
+        {
+            pollDescriptor = pConnector->socketDescriptor;
+        }
+        else
+        {
+            pollDescriptor = pConnector->pMqttContext->transportInterface.pNetworkContext->socketDescriptor;
+        }
+    }
+
+    pPollFd->fd = pollDescriptor;
+    pPollFd->events = pConnector->pollEvents;
+    pPollFd->revents = 0;
+
+    return timeoutMs;
+}
+/*-----------------------------------------------------------*/
+
+MqttConnectorStatus_t MqttConnector_Step( MqttConnector_t * pConnector )
+{
+    MqttConnectorStatus_t returnStatus = MQTT_CONNECTOR_INVALID_PARAMETER;
+    bool phaseDone = true;
+
+    if( pConnector == NULL )
+    {
+        LogError( ( "Parameter check failed: pConnector is NULL." ) );
+    }
+    else if( pConnector->status != MQTT_CONNECTOR_IN_PROGRESS )
+    {
+        returnStatus = pConnector->status;
+    }
+    else
+    {
+        returnStatus = MQTT_CONNECTOR_IN_PROGRESS;
+
+        /* Run phases until one has to wait. */
+        while( ( returnStatus == MQTT_CONNECTOR_IN_PROGRESS ) && ( phaseDone == true ) )
+        {
+            returnStatus = runPhase( pConnector, &phaseDone );
+        }
+
+        if( ( returnStatus == MQTT_CONNECTOR_IN_PROGRESS ) &&
+            ( ( Clock_GetTimeMs() - pConnector->phaseStartMs ) >= pConnector->config.phaseTimeoutMs ) )
+        {
+            LogError( ( "Connector phase %d timed out.", ( int ) pConnector->phase ) );
+            returnStatus = MQTT_CONNECTOR_TIMEOUT;
+        }
+
+        if( returnStatus == MQTT_CONNECTOR_SUCCESS )
+        {
+            LogInfo( ( "Established MQTT session in %u ms: resolve=%u, tcp=%u, tls=%u, "
+                       "connect=%u, subscribe=%u.",
+                       ( unsigned int ) ( pConnector->phaseStartMs - pConnector->startTimeMs ),
+                       ( unsigned int ) pConnector->phaseDurationMs[ MQTT_CONNECTOR_PHASE_RESOLVE ],
+                       ( unsigned int ) pConnector->phaseDurationMs[ MQTT_CONNECTOR_PHASE_TCP_CONNECT ],
+                       ( unsigned int ) pConnector->phaseDurationMs[ MQTT_CONNECTOR_PHASE_TLS_HANDSHAKE ],
+                       ( unsigned int ) pConnector->phaseDurationMs[ MQTT_CONNECTOR_PHASE_MQTT_CONNECT ],
+                       ( unsigned int ) pConnector->phaseDurationMs[ MQTT_CONNECTOR_PHASE_SUBSCRIBE ] ) );
+        }
+        else if( returnStatus != MQTT_CONNECTOR_IN_PROGRESS )
+        {
+            releaseResources( pConnector );
+        }
+        else
+        {
+            /* Empty else. */
+        }
+
+        pConnector->status = returnStatus;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+void MqttConnector_Abort( MqttConnector_t * pConnector )
+{
+    if( pConnector == NULL )
+    {
+        LogError( ( "Parameter check failed: pConnector is NULL." ) );
+    }
+    else if( pConnector->status == MQTT_CONNECTOR_IN_PROGRESS )
+    {
+        releaseResources( pConnector );
+        pConnector->status = MQTT_CONNECTOR_TIMEOUT;
+    }
+    else
+    {
+        /* Empty else. */
+    }
+}
+/*-----------------------------------------------------------*/
+
+size_t MqttConnector_PollAll( MqttConnector_t * pConnectors,
+                              struct pollfd * pPollFds,
+                              size_t connectorCount,
+                              uint32_t timeoutMs )
+{
+    size_t index = 0U;
+    size_t inProgressCount = 0U;
+    uint32_t waitMs = timeoutMs;
+    uint32_t connectorWaitMs = 0U;
+
+    if( ( pConnectors == NULL ) || ( pPollFds == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pConnectors=%p, pPollFds=%p.",
+                    ( void * ) pConnectors,
+                    ( void * ) pPollFds ) );
+    }
+    else
+    {
+        for( index = 0U; index < connectorCount; index++ )
+        {
+            pPollFds[ index ].fd = -1;
+            pPollFds[ index ].events = 0;
+            pPollFds[ index ].revents = 0;
+
+            if( pConnectors[ index ].status == MQTT_CONNECTOR_IN_PROGRESS )
+            {
+                connectorWaitMs = MqttConnector_GetPollInfo( &pConnectors[ index ], &pPollFds[ index ] );
+
+                if( connectorWaitMs < waitMs )
+                {
+                    waitMs = connectorWaitMs;
+                }
+            }
+        }
+
+        ( void ) poll( pPollFds, ( nfds_t ) connectorCount, ( int ) waitMs );
+
+        /* Connectors waiting on time alone are stepped as well, which is
+         * cheap: a step only makes non-blocking calls. */
+        for( index = 0U; index < connectorCount; index++ )
+        {
+            if( ( pConnectors[ index ].status == MQTT_CONNECTOR_IN_PROGRESS ) &&
+                ( MqttConnector_Step( &pConnectors[ index ] ) == MQTT_CONNECTOR_IN_PROGRESS ) )
+            {
+                inProgressCount++;
+            }
+        }
+    }
+
+    return inProgressCount;
+}
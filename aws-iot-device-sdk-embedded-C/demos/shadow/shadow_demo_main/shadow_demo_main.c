@@ -62,6 +62,12 @@
 /* JSON API header. */
 #include "core_json.h"
 
+/* JSON writer API header. */
+#include "core_json_writer.h"
+
+/* JSON number API header. */
+#include "core_json_number.h"
+
 /* Clock for timer. */
 #include "clock.h"
 
@@ -70,88 +76,31 @@
 
 
 /**
- * @brief Format string representing a Shadow document with a "desired" state.
+ * @brief The maximum size of a Shadow update document built by
+ * #buildUpdateDocument.
  *
- * The real json document will look like this:
- * {
- *   "state": {
- *     "desired": {
- *       "powerOn": 1
- *     }
- *   },
- *   "clientToken": "021909"
- * }
- *
- * Note the client token, which is optional for all Shadow updates. The client
- * token must be unique at any given time, but may be reused once the update is
- * completed. For this demo, a timestamp is used for a client token.
+ * The documents of this demo are about 70 bytes long; the writer reports
+ * an error rather than truncating one that does not fit.
  */
-#define SHADOW_DESIRED_JSON     \
-    "{"                         \
-    "\"state\":{"               \
-    "\"desired\":{"             \
-    "\"powerOn\":%01d"          \
-    "}"                         \
-    "},"                        \
-    "\"clientToken\":\"%06lu\"" \
-    "}"
+#define SHADOW_UPDATE_DOCUMENT_MAX_LENGTH    ( 128U )
 
 /**
- * @brief The expected size of #SHADOW_DESIRED_JSON.
- *
- * Because all the format specifiers in #SHADOW_DESIRED_JSON include a length,
- * its full actual size is known by pre-calculation, here's the formula why
- * the length need to minus 3:
- * 1. The length of "%01d" is 4.
- * 2. The length of %06lu is 5.
- * 3. The actual length we will use in case 1. is 1 ( for the state of powerOn ).
- * 4. The actual length we will use in case 2. is 6 ( for the clientToken length ).
- * 5. Thus the additional size 3 = 4 + 5 - 1 - 6 + 1 (termination character).
- *
- * In your own application, you could calculate the size of the json doc in this way.
+ * @brief The length of the client token in Shadow update documents.
  */
-#define SHADOW_DESIRED_JSON_LENGTH    ( sizeof( SHADOW_DESIRED_JSON ) - 3 )
+#define SHADOW_CLIENT_TOKEN_LENGTH           ( 6U )
 
 /**
- * @brief Format string representing a Shadow document with a "reported" state.
- *
- * The real json document will look like this:
- * {
- *   "state": {
- *     "reported": {
- *       "powerOn": 1
- *     }
- *   },
- *   "clientToken": "021909"
- * }
- *
- * Note the client token, which is required for all Shadow updates. The client
- * token must be unique at any given time, but may be reused once the update is
- * completed. For this demo, a timestamp is used for a client token.
- */
-#define SHADOW_REPORTED_JSON    \
-    "{"                         \
-    "\"state\":{"               \
-    "\"reported\":{"            \
-    "\"powerOn\":%01d"          \
-    "}"                         \
-    "},"                        \
-    "\"clientToken\":\"%06lu\"" \
-    "}"
+* @brief The maximum size of all shadow topic
+*/
+#define SHADOW_TOPIC_MAX_LENGTH  ( 256U )
 
 /**
- * @brief The expected size of #SHADOW_REPORTED_JSON.
+ * @brief The maximum number of JSON values indexed in an /update/delta payload.
  *
- * Because all the format specifiers in #SHADOW_REPORTED_JSON include a length,
- * its full size is known at compile-time by pre-calculation. Users could refer to
- * the way how to calculate the actual length in #SHADOW_DESIRED_JSON_LENGTH.
+ * The delta payload of this demo holds about a dozen values, counting the
+ * objects and their members.
  */
-#define SHADOW_REPORTED_JSON_LENGTH    ( sizeof( SHADOW_REPORTED_JSON ) - 3 )
-
-/**
-* @brief The maximum size of all shadow topic
-*/
-#define SHADOW_TOPIC_MAX_LENGTH  ( 256U )
+#define SHADOW_DELTA_INDEX_ENTRIES    ( 32U )
 
 /*-----------------------------------------------------------*/
 
@@ -226,6 +175,39 @@ static void updateDeltaHandler( MQTTPublishInfo_t * pPublishInfo );
 static void updateAcceptedHandler( MQTTPublishInfo_t * pPublishInfo );
 
 
+/**
+ * @brief Build a Shadow update document with a "desired" or "reported" state.
+ *
+ * The document looks like this:
+ * {
+ *   "state": {
+ *     "reported": {
+ *       "powerOn": 1
+ *     }
+ *   },
+ *   "clientToken": "021909"
+ * }
+ *
+ * Note the client token, which is optional for all Shadow updates. The client
+ * token must be unique at any given time, but may be reused once the update is
+ * completed. For this demo, a timestamp is used for a client token.
+ *
+ * @param[in] pState "desired" or "reported".
+ * @param[in] powerOnState The power on state to send.
+ * @param[in] token The client token, of which the last 6 decimal digits are sent.
+ * @param[out] pDocument The buffer to hold the document.
+ * @param[in] documentSize The size of the buffer.
+ * @param[out] pDocumentLength The length of the document.
+ *
+ * @return EXIT_SUCCESS if the document was built; EXIT_FAILURE otherwise.
+ */
+static int buildUpdateDocument( const char * pState,
+                                uint32_t powerOnState,
+                                uint32_t token,
+                                char * pDocument,
+                                size_t documentSize,
+                                size_t * pDocumentLength );
+
 static int loadTopicStrings(void);
 
 /* Import GetDeviceID */
@@ -236,8 +218,11 @@ extern int GetDeviceID(char* deviceId, size_t deviceIdLength);
 static void updateDeltaHandler( MQTTPublishInfo_t * pPublishInfo )
 {
     static uint32_t currentVersion = 0; /* Remember the latestVersion # we've ever received */
+    static JSONIndexEntry_t deltaIndex[ SHADOW_DELTA_INDEX_ENTRIES ];
+    size_t deltaIndexCount = 0U;
     uint32_t version = 0U;
     uint32_t newState = 0U;
+    uint64_t number = 0U;
     char * outValue = NULL;
     uint32_t outValueLength = 0U;
     JSONStatus_t result = JSONSuccess;
@@ -263,19 +248,30 @@ static void updateDeltaHandler( MQTTPublishInfo_t * pPublishInfo )
      *  }
      */
 
-    /* Make sure the payload is a valid json document. */
-    result = JSON_Validate( pPublishInfo->pPayload,
-                            pPublishInfo->payloadLength );
+    /* Make sure the payload is a valid json document, and index its values
+     * so that the searches below do not parse the payload again. */
+    result = JSON_BuildIndex( pPublishInfo->pPayload,
+                              pPublishInfo->payloadLength,
+                              deltaIndex,
+                              SHADOW_DELTA_INDEX_ENTRIES,
+                              &deltaIndexCount );
 
     if( result == JSONSuccess )
     {
         /* Then we start to get the version value by JSON keyword "version". */
-        result = JSON_Search( ( char * ) pPublishInfo->pPayload,
-                              pPublishInfo->payloadLength,
-                              "version",
-                              sizeof( "version" ) - 1,
-                              &outValue,
-                              ( size_t * ) &outValueLength );
+        result = JSON_SearchIndex( ( char * ) pPublishInfo->pPayload,
+                                   deltaIndex,
+                                   deltaIndexCount,
+                                   "version",
+                                   sizeof( "version" ) - 1,
+                                   &outValue,
+                                   ( size_t * ) &outValueLength );
+    }
+    else if( result == JSONInsufficientMemory )
+    {
+        LogError( ( "The json document has %lu values, more than SHADOW_DELTA_INDEX_ENTRIES.",
+                    ( unsigned long ) deltaIndexCount ) );
+        eventCallbackError = true;
     }
     else
     {
@@ -290,7 +286,17 @@ static void updateDeltaHandler( MQTTPublishInfo_t * pPublishInfo )
                    outValue ) );
 
         /* Convert the extracted value to an unsigned integer value. */
-        version = ( uint32_t ) strtoul( outValue, NULL, 10 );
+        result = JSON_GetUint64( outValue, outValueLength, &number );
+
+        if( ( result == JSONSuccess ) && ( number <= UINT32_MAX ) )
+        {
+            version = ( uint32_t ) number;
+        }
+        else
+        {
+            LogError( ( "The version is not a 32-bit unsigned integer!!" ) );
+            eventCallbackError = true;
+        }
     }
     else
     {
@@ -308,12 +314,13 @@ static void updateDeltaHandler( MQTTPublishInfo_t * pPublishInfo )
         currentVersion = version;
 
         /* Get powerOn state from json documents. */
-        result = JSON_Search( ( char * ) pPublishInfo->pPayload,
-                              pPublishInfo->payloadLength,
-                              "state.powerOn",
-                              sizeof( "state.powerOn" ) - 1,
-                              &outValue,
-                              ( size_t * ) &outValueLength );
+        result = JSON_SearchIndex( ( char * ) pPublishInfo->pPayload,
+                                   deltaIndex,
+                                   deltaIndexCount,
+                                   "state.powerOn",
+                                   sizeof( "state.powerOn" ) - 1,
+                                   &outValue,
+                                   ( size_t * ) &outValueLength );
     }
     else
     {
@@ -328,7 +335,17 @@ static void updateDeltaHandler( MQTTPublishInfo_t * pPublishInfo )
     if( result == JSONSuccess )
     {
         /* Convert the powerOn state value to an unsigned integer value. */
-        newState = ( uint32_t ) strtoul( outValue, NULL, 10 );
+        if( ( JSON_GetUint64( outValue, outValueLength, &number ) == JSONSuccess ) &&
+            ( number <= UINT32_MAX ) )
+        {
+            newState = ( uint32_t ) number;
+        }
+        else
+        {
+            LogError( ( "The powerOn state is not a 32-bit unsigned integer!!" ) );
+            eventCallbackError = true;
+            newState = currentPowerOnState;
+        }
 
         LogInfo( ( "The new power on state newState:%d, currentPowerOnState:%d \r\n",
                    newState, currentPowerOnState ) );
@@ -357,6 +374,8 @@ static void updateDeltaHandler( MQTTPublishInfo_t * pPublishInfo )
 
 static void updateAcceptedHandler( MQTTPublishInfo_t * pPublishInfo )
 {
+    /* The query "clientToken", compiled at build time. */
+    static const JSONQueryStep_t clientTokenQuery[] = { JSON_QUERY_KEY( "clientToken" ) };
     char * outValue = NULL;
     uint32_t outValueLength = 0U;
     uint32_t receivedToken = 0U;
@@ -397,12 +416,12 @@ static void updateAcceptedHandler( MQTTPublishInfo_t * pPublishInfo )
     if( result == JSONSuccess )
     {
         /* Get clientToken from json documents. */
-        result = JSON_Search( ( char * ) pPublishInfo->pPayload,
-                              pPublishInfo->payloadLength,
-                              "clientToken",
-                              sizeof( "clientToken" ) - 1,
-                              &outValue,
-                              ( size_t * ) &outValueLength );
+        result = JSON_SearchCompiled( ( char * ) pPublishInfo->pPayload,
+                                      pPublishInfo->payloadLength,
+                                      clientTokenQuery,
+                                      sizeof( clientTokenQuery ) / sizeof( clientTokenQuery[ 0 ] ),
+                                      &outValue,
+                                      ( size_t * ) &outValueLength );
     }
     else
     {
@@ -516,6 +535,70 @@ static void eventCallback( MQTTContext_t * pMqttContext,
     }
 }
 
+/* Build a Shadow update document for the desired or reported power on
+ * state with the coreJSON writer, into a caller's buffer.
+ */
+static int buildUpdateDocument( const char * pState,
+                                uint32_t powerOnState,
+                                uint32_t token,
+                                char * pDocument,
+                                size_t documentSize,
+                                size_t * pDocumentLength )
+{
+    JSONWriter_t writer;
+    JSONStatus_t result;
+    char tokenString[ SHADOW_CLIENT_TOKEN_LENGTH ];
+    uint32_t tokenDigits = token;
+    size_t i;
+
+    /* The client token is sent as a string of fixed length, zero padded. */
+    for( i = SHADOW_CLIENT_TOKEN_LENGTH; i > 0U; i-- )
+    {
+        tokenString[ i - 1U ] = ( char ) ( '0' + ( tokenDigits % 10U ) );
+        tokenDigits /= 10U;
+    }
+
+    result = JSON_WriterInit( &writer, pDocument, documentSize, NULL, NULL );
+
+    if( result == JSONSuccess )
+    {
+        ( void ) JSON_WriteObjectStart( &writer );
+        ( void ) JSON_WriteKey( &writer, "state", sizeof( "state" ) - 1U );
+        ( void ) JSON_WriteObjectStart( &writer );
+        ( void ) JSON_WriteKey( &writer, pState, strlen( pState ) );
+        ( void ) JSON_WriteObjectStart( &writer );
+        ( void ) JSON_WriteKey( &writer, "powerOn", sizeof( "powerOn" ) - 1U );
+        ( void ) JSON_WriteUint64( &writer, powerOnState );
+        ( void ) JSON_WriteObjectEnd( &writer );
+        ( void ) JSON_WriteObjectEnd( &writer );
+        ( void ) JSON_WriteKey( &writer, "clientToken", sizeof( "clientToken" ) - 1U );
+        ( void ) JSON_WriteString( &writer, tokenString, SHADOW_CLIENT_TOKEN_LENGTH );
+        ( void ) JSON_WriteObjectEnd( &writer );
+
+        /* Errors are sticky, so checking the result once covers every call. */
+        result = JSON_WriterFinish( &writer, pDocumentLength );
+    }
+
+    if( result == JSONInsufficientMemory )
+    {
+        LogError( ( "Shadow update document needs %lu bytes, buffer has %lu.",
+                    ( unsigned long ) *pDocumentLength,
+                    ( unsigned long ) documentSize ) );
+    }
+    else if( result != JSONSuccess )
+    {
+        LogError( ( "Failed to build Shadow update document: %d.", ( int ) result ) );
+    }
+    else
+    {
+        /* Empty else. */
+    }
+
+    return ( result == JSONSuccess ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*-----------------------------------------------------------*/
+
 /* 
  * Load device ID to build topic strings needed in this demo
  */
@@ -568,7 +651,8 @@ int shadow_demo_main( int argc,
 
     /* A buffer containing the update document. It has static duration to prevent
      * it from being placed on the call stack. */
-    static char updateDocument[ SHADOW_REPORTED_JSON_LENGTH + 1 ] = { 0 };
+    static char updateDocument[ SHADOW_UPDATE_DOCUMENT_MAX_LENGTH ] = { 0 };
+    size_t updateDocumentLength = 0U;
 
     ( void ) argc;
     ( void ) argv;
@@ -651,20 +735,20 @@ int shadow_demo_main( int argc,
             /* desired power on state . */
             LogInfo( ( "Send desired power state with 1." ) );
 
-            ( void ) memset( updateDocument,
-                             0x00,
-                             sizeof( updateDocument ) );
-
-            snprintf( updateDocument,
-                      SHADOW_DESIRED_JSON_LENGTH + 1,
-                      SHADOW_DESIRED_JSON,
-                      ( int ) 1,
-                      ( long unsigned ) ( Clock_GetTimeMs() % 1000000 ) );
+            returnStatus = buildUpdateDocument( "desired",
+                                                1U,
+                                                ( uint32_t ) Clock_GetTimeMs(),
+                                                updateDocument,
+                                                sizeof( updateDocument ),
+                                                &updateDocumentLength );
+        }
 
+        if( returnStatus == EXIT_SUCCESS )
+        {
             returnStatus = PublishToTopic( ShadowTopicStringUpdate,
                                            strlen( ShadowTopicStringUpdate ),
                                            updateDocument,
-                                           ( SHADOW_DESIRED_JSON_LENGTH + 1 ) );
+                                           updateDocumentLength );
         }
 
         if( returnStatus == EXIT_SUCCESS )
@@ -679,24 +763,25 @@ int shadow_demo_main( int argc,
             {
                 /* Report the latest power state back to device shadow. */
                 LogInfo( ( "Report to the state change: %d", currentPowerOnState ) );
-                ( void ) memset( updateDocument,
-                                 0x00,
-                                 sizeof( updateDocument ) );
 
                 /* Keep the client token in global variable used to compare if
                  * the same token in /update/accepted. */
                 clientToken = ( Clock_GetTimeMs() % 1000000 );
 
-                snprintf( updateDocument,
-                          SHADOW_REPORTED_JSON_LENGTH + 1,
-                          SHADOW_REPORTED_JSON,
-                          ( int ) currentPowerOnState,
-                          ( long unsigned ) clientToken );
-
-                returnStatus = PublishToTopic( ShadowTopicStringUpdate,
-                                               strlen( ShadowTopicStringUpdate ),
-                                               updateDocument,
-                                               ( SHADOW_DESIRED_JSON_LENGTH + 1 ) );
+                returnStatus = buildUpdateDocument( "reported",
+                                                    currentPowerOnState,
+                                                    clientToken,
+                                                    updateDocument,
+                                                    sizeof( updateDocument ),
+                                                    &updateDocumentLength );
+
+                if( returnStatus == EXIT_SUCCESS )
+                {
+                    returnStatus = PublishToTopic( ShadowTopicStringUpdate,
+                                                   strlen( ShadowTopicStringUpdate ),
+                                                   updateDocument,
+                                                   updateDocumentLength );
+                }
             }
             else
             {
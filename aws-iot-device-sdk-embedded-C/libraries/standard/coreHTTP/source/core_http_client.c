@@ -95,6 +95,38 @@ static HTTPStatus_t sendHttpBody( const TransportInterface_t * pTransport,
                                   const uint8_t * pRequestBodyBuf,
                                   size_t reqBodyBufLen );
 
+/**
+ * @brief Send the HTTP body from a file over the transport.
+ *
+ * The body is sent with #HTTPFileBody_t.sendFile when it is set, and otherwise
+ * read into #HTTPFileBody_t.pBuffer one chunk at a time and sent with the
+ * transport send function.
+ *
+ * @param[in] pTransport Transport interface; its network context is passed
+ * to #HTTPFileBody_t.sendFile.
+ * @param[in] pFileBody Request body to send.
+ *
+ * @return #HTTPSuccess if successful. If there was a network error, a read
+ * error, or the file ended early, then #HTTPNetworkError.
+ */
+static HTTPStatus_t sendHttpFileBody( const TransportInterface_t * pTransport,
+                                      const HTTPFileBody_t * pFileBody );
+
+/**
+ * @brief Check the parameters common to #HTTPClient_Send and
+ * #HTTPClient_SendFile.
+ *
+ * @param[in] pTransport Transport interface.
+ * @param[in] pRequestHeaders Request headers to send.
+ * @param[in] pResponse Response to receive into, or NULL.
+ *
+ * @return #HTTPSuccess if the parameters are valid; #HTTPInvalidParameter
+ * otherwise.
+ */
+static HTTPStatus_t checkRequestParameters( const TransportInterface_t * pTransport,
+                                            const HTTPRequestHeaders_t * pRequestHeaders,
+                                            const HTTPResponse_t * pResponse );
+
 /**
  * @brief A strncpy replacement with HTTP header validation.
  *
@@ -1848,6 +1880,97 @@ static HTTPStatus_t sendHttpBody( const TransportInterface_t * pTransport,
 
 /*-----------------------------------------------------------*/
 
+static HTTPStatus_t sendHttpFileBody( const TransportInterface_t * pTransport,
+                                      const HTTPFileBody_t * pFileBody )
+{
+    HTTPStatus_t returnStatus = HTTPSuccess;
+    int64_t offset = 0;
+    size_t bytesRemaining = 0U;
+    size_t chunkLen = 0U;
+    int32_t status = 0;
+    uint32_t zeroSends = 0U;
+
+    assert( pTransport != NULL );
+    assert( pTransport->send != NULL );
+    assert( pFileBody != NULL );
+
+    offset = pFileBody->offset;
+    bytesRemaining = pFileBody->length;
+
+    LogDebug( ( "Sending the HTTP request body from a file: BodyBytes=%lu, ZeroCopy=%u",
+                ( unsigned long ) pFileBody->length,
+                ( pFileBody->sendFile != NULL ) ? 1U : 0U ) );
+
+    /* Loop until all data is sent. */
+    while( ( bytesRemaining > 0U ) && ( returnStatus == HTTPSuccess ) )
+    {
+        if( pFileBody->sendFile != NULL )
+        {
+            status = pFileBody->sendFile( pTransport->pNetworkContext,
+                                          pFileBody->fileDescriptor,
+                                          &offset,
+                                          bytesRemaining );
+
+            if( status < 0 )
+            {
+                LogError( ( "Failed to send HTTP file body: Transport sendFile()"
+                            " returned error: TransportStatus=%d",
+                            ( int ) status ) );
+                returnStatus = HTTPNetworkError;
+            }
+            else if( status == 0 )
+            {
+                zeroSends++;
+
+                if( zeroSends >= HTTP_SEND_FILE_MAX_ZERO_SENDS )
+                {
+                    LogError( ( "Failed to send HTTP file body: Transport sendFile()"
+                                " made no progress: Calls=%lu, BytesRemaining=%lu",
+                                ( unsigned long ) zeroSends,
+                                ( unsigned long ) bytesRemaining ) );
+                    returnStatus = HTTPNetworkError;
+                }
+            }
+            else
+            {
+                /* It is a bug in the transport if more bytes than requested
+                 * are sent. */
+                assert( ( size_t ) status <= bytesRemaining );
+                bytesRemaining -= ( size_t ) status;
+                zeroSends = 0U;
+            }
+        }
+        else
+        {
+            chunkLen = ( bytesRemaining < pFileBody->bufferLen ) ? bytesRemaining : pFileBody->bufferLen;
+            status = pFileBody->readFile( pFileBody->fileDescriptor,
+                                          offset,
+                                          pFileBody->pBuffer,
+                                          chunkLen );
+
+            if( status <= 0 )
+            {
+                LogError( ( "Failed to read HTTP file body: ReadStatus=%d, "
+                            "BytesRemaining=%lu",
+                            ( int ) status,
+                            ( unsigned long ) bytesRemaining ) );
+                returnStatus = HTTPNetworkError;
+            }
+            else
+            {
+                assert( ( size_t ) status <= chunkLen );
+                returnStatus = sendHttpData( pTransport, pFileBody->pBuffer, ( size_t ) status );
+                bytesRemaining -= ( size_t ) status;
+                offset += status;
+            }
+        }
+    }
+
+    return returnStatus;
+}
+
+/*-----------------------------------------------------------*/
+
 static HTTPStatus_t receiveHttpData( const TransportInterface_t * pTransport,
                                      uint8_t * pBuffer,
                                      size_t bufferLen,
@@ -2024,12 +2147,9 @@ static HTTPStatus_t receiveAndParseHttpResponse( const TransportInterface_t * pT
 
 /*-----------------------------------------------------------*/
 
-HTTPStatus_t HTTPClient_Send( const TransportInterface_t * pTransport,
-                              HTTPRequestHeaders_t * pRequestHeaders,
-                              const uint8_t * pRequestBodyBuf,
-                              size_t reqBodyBufLen,
-                              HTTPResponse_t * pResponse,
-                              uint32_t sendFlags )
+static HTTPStatus_t checkRequestParameters( const TransportInterface_t * pTransport,
+                                            const HTTPRequestHeaders_t * pRequestHeaders,
+                                            const HTTPResponse_t * pResponse )
 {
     HTTPStatus_t returnStatus = HTTPSuccess;
 
@@ -2078,6 +2198,31 @@ HTTPStatus_t HTTPClient_Send( const TransportInterface_t * pTransport,
         LogError( ( "Parameter check failed: pResponse->pBuffer is NULL." ) );
         returnStatus = HTTPInvalidParameter;
     }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+
+    return returnStatus;
+}
+
+/*-----------------------------------------------------------*/
+
+HTTPStatus_t HTTPClient_Send( const TransportInterface_t * pTransport,
+                              HTTPRequestHeaders_t * pRequestHeaders,
+                              const uint8_t * pRequestBodyBuf,
+                              size_t reqBodyBufLen,
+                              HTTPResponse_t * pResponse,
+                              uint32_t sendFlags )
+{
+    HTTPStatus_t returnStatus = HTTPSuccess;
+
+    returnStatus = checkRequestParameters( pTransport, pRequestHeaders, pResponse );
+
+    if( returnStatus != HTTPSuccess )
+    {
+        /* Error already logged. */
+    }
     else if( ( pRequestBodyBuf == NULL ) && ( reqBodyBufLen > 0U ) )
     {
         LogError( ( "Parameter check failed: pRequestBodyBuf is NULL, but "
@@ -2143,6 +2288,90 @@ HTTPStatus_t HTTPClient_Send( const TransportInterface_t * pTransport,
 
 /*-----------------------------------------------------------*/
 
+HTTPStatus_t HTTPClient_SendFile( const TransportInterface_t * pTransport,
+                                  HTTPRequestHeaders_t * pRequestHeaders,
+                                  const HTTPFileBody_t * pFileBody,
+                                  HTTPResponse_t * pResponse,
+                                  uint32_t sendFlags )
+{
+    HTTPStatus_t returnStatus = HTTPSuccess;
+
+    returnStatus = checkRequestParameters( pTransport, pRequestHeaders, pResponse );
+
+    if( returnStatus != HTTPSuccess )
+    {
+        /* Error already logged. */
+    }
+    else if( pFileBody == NULL )
+    {
+        LogError( ( "Parameter check failed: pFileBody is NULL." ) );
+        returnStatus = HTTPInvalidParameter;
+    }
+    else if( ( pFileBody->sendFile == NULL ) &&
+             ( ( pFileBody->readFile == NULL ) ||
+               ( pFileBody->pBuffer == NULL ) ||
+               ( pFileBody->bufferLen == 0U ) ) )
+    {
+        LogError( ( "Parameter check failed: pFileBody->sendFile is NULL and "
+                    "pFileBody->readFile, pFileBody->pBuffer, or "
+                    "pFileBody->bufferLen is not set." ) );
+        returnStatus = HTTPInvalidParameter;
+    }
+    else if( pFileBody->offset < 0 )
+    {
+        LogError( ( "Parameter check failed: pFileBody->offset is negative." ) );
+        returnStatus = HTTPInvalidParameter;
+    }
+    else if( pFileBody->length > ( size_t ) ( INT32_MAX ) )
+    {
+        /* This check is needed because convertInt32ToAscii() is used on the
+         * length to create a Content-Length header value string. */
+        LogError( ( "Parameter check failed: pFileBody->length > INT32_MAX."
+                    "pFileBody->length=%lu",
+                    ( unsigned long ) pFileBody->length ) );
+        returnStatus = HTTPInvalidParameter;
+    }
+    else
+    {
+        /* Empty else for MISRA 15.7 compliance. */
+    }
+
+    if( returnStatus == HTTPSuccess )
+    {
+        returnStatus = sendHttpHeaders( pTransport,
+                                        pRequestHeaders,
+                                        pFileBody->length,
+                                        sendFlags );
+    }
+
+    /* The headers are flushed before the body, so the file body can go to
+     * the socket without being copied behind them. */
+    if( returnStatus == HTTPSuccess )
+    {
+        returnStatus = sendHttpFileBody( pTransport, pFileBody );
+    }
+
+    if( returnStatus == HTTPSuccess )
+    {
+        /* If the application chooses to receive a response, then pResponse
+         * will not be NULL. */
+        if( pResponse != NULL )
+        {
+            returnStatus = receiveAndParseHttpResponse( pTransport,
+                                                        pResponse,
+                                                        pRequestHeaders );
+        }
+        else
+        {
+            LogDebug( ( "Response ignored: pResponse is NULL." ) );
+        }
+    }
+
+    return returnStatus;
+}
+
+/*-----------------------------------------------------------*/
+
 static int findHeaderFieldParserCallback( http_parser * pHttpParser,
                                           const char * pFieldLoc,
                                           size_t fieldLen )
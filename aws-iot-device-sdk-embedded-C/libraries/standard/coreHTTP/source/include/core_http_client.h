@@ -502,6 +502,92 @@ typedef struct HTTPResponse
     uint32_t respFlags;
 } HTTPResponse_t;
 
+/**
+ * @ingroup http_callback_types
+ * @brief Transport function that sends part of a file without copying it
+ * into an application buffer, e.g. with sendfile on a plaintext or kernel TLS
+ * socket.
+ *
+ * @param[in] pNetworkContext Implementation-defined network context.
+ * @param[in] fileDescriptor Descriptor of the file to send.
+ * @param[in,out] pOffset Offset in the file to send from; advanced by the
+ * number of bytes sent.
+ * @param[in] bytesToSend Number of bytes to send.
+ *
+ * @return Number of bytes sent, which may be less than @p bytesToSend; 0 if
+ * nothing could be sent for now; negative value on error. The end of the
+ * file before @p bytesToSend bytes is an error, not 0.
+ */
+typedef int32_t ( * HTTPTransportSendFile_t )( NetworkContext_t * pNetworkContext,
+                                               int32_t fileDescriptor,
+                                               int64_t * pOffset,
+                                               size_t bytesToSend );
+
+/**
+ * @ingroup http_callback_types
+ * @brief Function that reads part of a file, like POSIX pread.
+ *
+ * @param[in] fileDescriptor Descriptor of the file to read.
+ * @param[in] offset Offset in the file to read from.
+ * @param[out] pBuffer Buffer to read into.
+ * @param[in] bufferLen Maximum number of bytes to read.
+ *
+ * @return Number of bytes read; 0 at the end of the file; negative value on
+ * error.
+ */
+typedef int32_t ( * HTTPFileRead_t )( int32_t fileDescriptor,
+                                      int64_t offset,
+                                      uint8_t * pBuffer,
+                                      size_t bufferLen );
+
+/**
+ * @ingroup http_struct_types
+ * @brief Represents a request body that is read from a file.
+ *
+ * Either @ref sendFile or the pair of @ref readFile and @ref pBuffer must be
+ * set. When both are set, @ref sendFile is used.
+ */
+typedef struct HTTPFileBody
+{
+    /**
+     * @brief Descriptor of the file containing the body.
+     */
+    int32_t fileDescriptor;
+
+    /**
+     * @brief Offset of the body in the file.
+     */
+    int64_t offset;
+
+    /**
+     * @brief Length of the body in bytes.
+     */
+    size_t length;
+
+    /**
+     * @brief Zero-copy file send function of the transport. Set to NULL if
+     * the transport cannot send from a file.
+     */
+    HTTPTransportSendFile_t sendFile;
+
+    /**
+     * @brief Function that reads the file into @ref pBuffer for a regular
+     * transport send. Only used when @ref sendFile is NULL.
+     */
+    HTTPFileRead_t readFile;
+
+    /**
+     * @brief Staging buffer for @ref readFile. It can be shared between
+     * requests that are not sent concurrently.
+     */
+    uint8_t * pBuffer;
+
+    /**
+     * @brief Length of @ref pBuffer in bytes.
+     */
+    size_t bufferLen;
+} HTTPFileBody_t;
+
 /**
  * @brief Initialize the request headers, stored in
  * #HTTPRequestHeaders_t.pBuffer, with initial configurations from
@@ -799,6 +885,39 @@ HTTPStatus_t HTTPClient_Send( const TransportInterface_t * pTransport,
                               uint32_t sendFlags );
 /* @[declare_httpclient_send] */
 
+/**
+ * @brief Send the request headers in #HTTPRequestHeaders_t.pBuffer and a
+ * request body read from a file over the transport. The response is received
+ * in #HTTPResponse_t.pBuffer.
+ *
+ * This behaves like #HTTPClient_Send, except that the body is taken from
+ * @p pFileBody. When #HTTPFileBody_t.sendFile is set, the body goes from the
+ * file to the network without passing through an application buffer.
+ * Otherwise it is read into #HTTPFileBody_t.pBuffer and sent in chunks.
+ *
+ * @param[in] pTransport Transport interface, see #TransportInterface_t for
+ * more information.
+ * @param[in] pRequestHeaders Request configuration containing the buffer of
+ * headers to send.
+ * @param[in] pFileBody Request entity body to send from a file.
+ * @param[in] pResponse The response message and some notable response
+ * parameters will be returned here on success.
+ * @param[in] sendFlags Flags which modify the behavior of this function. Please
+ * see @ref http_send_flags for more information.
+ *
+ * @return The values returned by #HTTPClient_Send. #HTTPNetworkError is also
+ * returned if the file cannot be read or ends before
+ * #HTTPFileBody_t.length bytes, or if #HTTPFileBody_t.sendFile sends nothing
+ * #HTTP_SEND_FILE_MAX_ZERO_SENDS times in a row.
+ */
+/* @[declare_httpclient_sendfile] */
+HTTPStatus_t HTTPClient_SendFile( const TransportInterface_t * pTransport,
+                                  HTTPRequestHeaders_t * pRequestHeaders,
+                                  const HTTPFileBody_t * pFileBody,
+                                  HTTPResponse_t * pResponse,
+                                  uint32_t sendFlags );
+/* @[declare_httpclient_sendfile] */
+
 /**
  * @brief Read a header from a buffer containing a complete HTTP response.
  * This will return the location of the response header value in the
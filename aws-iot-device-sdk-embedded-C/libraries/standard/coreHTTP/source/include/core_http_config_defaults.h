@@ -64,6 +64,20 @@
     #define HTTP_USER_AGENT_VALUE    "my-platform-name"
 #endif
 
+/**
+ * @brief Number of consecutive calls to #HTTPFileBody_t.sendFile that send
+ * nothing before #HTTPClient_SendFile gives up.
+ *
+ * A transport returns 0 when its send timed out. The limit keeps a transport
+ * that stops making progress from blocking #HTTPClient_SendFile forever.
+ *
+ * <b>Possible values:</b> Any positive 32 bit integer. <br>
+ * <b>Default value:</b> `10`
+ */
+#ifndef HTTP_SEND_FILE_MAX_ZERO_SENDS
+    #define HTTP_SEND_FILE_MAX_ZERO_SENDS    10U
+#endif
+
 /**
  * @brief Macro that is called in the HTTP Client library for logging "Error" level
  * messages.
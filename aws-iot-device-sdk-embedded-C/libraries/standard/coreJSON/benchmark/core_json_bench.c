@@ -0,0 +1,586 @@
+/*
+ * coreJSON v2.0.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_json_bench.c
+ * @brief Throughput and latency benchmark of coreJSON on a host.
+ *
+ * The corpus is generated in memory at several sizes: shadow, jobs and
+ * device defender documents as AWS IoT sends or expects them, large numeric
+ * arrays, deeply nested objects, and strings full of escapes.  For each
+ * document the benchmark reports the throughput of JSON_Validate(), and
+ * the latency of JSON_Search() and JSON_SearchCompiled() for queries of
+ * increasing depth, which end at the last value of the document so that
+ * the search scans as much of it as possible.
+ *
+ * It is not part of the device image.  Build and run it on the host with
+ * optimizations, from the coreJSON directory:
+ *
+ *     cc -O2 -Isource/include benchmark/core_json_bench.c source/core_json.c -o core_json_bench
+ *     ./core_json_bench
+ *
+ * The host build of the repository also builds it as core_json_bench.
+ *
+ * An optional argument is the minimum time in seconds of each measurement,
+ * 0.2 by default.
+ */
+
+/* clock_gettime() is POSIX, not C99. */
+#define _POSIX_C_SOURCE    199309L
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "core_json.h"
+
+/**
+ * @brief The size of the buffer that holds a document.
+ */
+#define DOCUMENT_MAX_LENGTH    ( 4U * 1024U * 1024U )
+
+/**
+ * @brief The number of queries, and their length, available per document.
+ */
+#define QUERY_MAX_COUNT        ( 8U )
+#define QUERY_MAX_LENGTH       ( 160U )
+
+/**
+ * @brief The number of steps a compiled query may have.
+ */
+#define QUERY_MAX_STEPS        ( 32U )
+
+/**
+ * @brief Depth of the nested document; the root is one more level, within
+ * the default JSON_MAX_DEPTH.
+ */
+#define NESTED_DEPTH           ( 31U )
+
+/**
+ * @brief A generated document and the queries to time on it.
+ */
+typedef struct
+{
+    char * buf;
+    size_t length;
+    int truncated;
+    char queries[ QUERY_MAX_COUNT ][ QUERY_MAX_LENGTH ];
+    size_t queryCount;
+} corpus_t;
+
+/**
+ * @brief A function generating a document of a given scale.
+ */
+typedef void ( * generator_t )( corpus_t * c,
+                                size_t scale );
+
+/**
+ * @brief A kind of document and the scales at which it is generated.
+ */
+typedef struct
+{
+    const char * name;
+    generator_t generate;
+    size_t scales[ 3 ];
+} document_t;
+
+/**
+ * @brief The minimum time in seconds of each measurement.
+ */
+static double minSeconds = 0.2;
+
+/**
+ * @brief Results are accumulated here so that no call can be optimized away.
+ */
+static volatile size_t sink;
+
+/*-----------------------------------------------------------*/
+
+static void append( corpus_t * c,
+                    const char * format,
+                    ... )
+{
+    va_list args;
+    int n;
+
+    if( c->truncated == 0 )
+    {
+        va_start( args, format );
+        n = vsnprintf( &c->buf[ c->length ], DOCUMENT_MAX_LENGTH - c->length, format, args );
+        va_end( args );
+
+        if( ( n < 0 ) || ( ( size_t ) n >= ( DOCUMENT_MAX_LENGTH - c->length ) ) )
+        {
+            c->truncated = 1;
+        }
+        else
+        {
+            c->length += ( size_t ) n;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void addQuery( corpus_t * c,
+                      const char * format,
+                      ... )
+{
+    va_list args;
+
+    assert( c->queryCount < QUERY_MAX_COUNT );
+
+    va_start( args, format );
+    ( void ) vsnprintf( c->queries[ c->queryCount ], QUERY_MAX_LENGTH, format, args );
+    va_end( args );
+
+    c->queryCount++;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A shadow /update/delta document with scale desired properties.
+ */
+static void generateShadow( corpus_t * c,
+                            size_t scale )
+{
+    size_t i;
+
+    append( c, "{\"version\":12,\"timestamp\":1595437367,\"state\":{" );
+
+    for( i = 0; i < scale; i++ )
+    {
+        append( c, "%s\"property%lu\":%lu", ( i > 0U ) ? "," : "",
+                ( unsigned long ) i, ( unsigned long ) ( i % 2U ) );
+    }
+
+    append( c, "},\"metadata\":{" );
+
+    for( i = 0; i < scale; i++ )
+    {
+        append( c, "%s\"property%lu\":{\"timestamp\":%lu}", ( i > 0U ) ? "," : "",
+                ( unsigned long ) i, 1595437367UL + ( unsigned long ) i );
+    }
+
+    append( c, "},\"clientToken\":\"388062\"}" );
+
+    addQuery( c, "clientToken" );
+    addQuery( c, "state.property%lu", ( unsigned long ) ( scale - 1U ) );
+    addQuery( c, "metadata.property%lu.timestamp", ( unsigned long ) ( scale - 1U ) );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A jobs GetPendingJobExecutions response with scale queued jobs,
+ * followed by a job execution with its document.
+ */
+static void generateJobs( corpus_t * c,
+                          size_t scale )
+{
+    size_t i;
+
+    append( c, "{\"clientToken\":\"b2c9a1\",\"timestamp\":1596573647,"
+               "\"inProgressJobs\":[],\"queuedJobs\":[" );
+
+    for( i = 0; i < scale; i++ )
+    {
+        append( c, "%s{\"jobId\":\"ota-update-%lu\",\"queuedAt\":%lu,\"lastUpdatedAt\":%lu,"
+                   "\"executionNumber\":%lu,\"versionNumber\":1}",
+                ( i > 0U ) ? "," : "", ( unsigned long ) i,
+                1596570000UL + ( unsigned long ) i, 1596570000UL + ( unsigned long ) i,
+                ( unsigned long ) i + 1UL );
+    }
+
+    append( c, "],\"execution\":{\"jobId\":\"ota-update-%lu\",\"status\":\"QUEUED\","
+               "\"statusDetails\":{\"progress\":\"0%%\",\"step\":\"download\"},"
+               "\"jobDocument\":{\"operation\":\"download\",\"files\":[",
+            ( unsigned long ) scale );
+
+    for( i = 0; i < scale; i++ )
+    {
+        append( c, "%s{\"url\":\"https://example-bucket.s3.amazonaws.com/firmware/part-%lu.bin\","
+                   "\"size\":%lu,\"sha256\":\"9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08\"}",
+                ( i > 0U ) ? "," : "", ( unsigned long ) i, 65536UL + ( unsigned long ) i );
+    }
+
+    append( c, "]},\"queuedAt\":1596570000,\"executionNumber\":1,\"versionNumber\":1}}" );
+
+    addQuery( c, "clientToken" );
+    addQuery( c, "queuedJobs[%lu].jobId", ( unsigned long ) ( scale - 1U ) );
+    addQuery( c, "execution.status" );
+    addQuery( c, "execution.jobDocument.files[%lu].sha256", ( unsigned long ) ( scale - 1U ) );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A device defender report with scale established connections and
+ * scale listening ports of each protocol.
+ */
+static void generateDefender( corpus_t * c,
+                              size_t scale )
+{
+    size_t i;
+
+    append( c, "{\"header\":{\"report_id\":1596573647,\"version\":\"1.0\"},\"metrics\":{"
+               "\"tcp_connections\":{\"established_connections\":{\"connections\":[" );
+
+    for( i = 0; i < scale; i++ )
+    {
+        append( c, "%s{\"local_interface\":\"eth0\",\"local_port\":%lu,"
+                   "\"remote_addr\":\"192.168.%lu.%lu:443\"}",
+                ( i > 0U ) ? "," : "", 40000UL + ( unsigned long ) i,
+                ( unsigned long ) ( ( i / 256U ) % 256U ), ( unsigned long ) ( i % 256U ) );
+    }
+
+    append( c, "],\"total\":%lu}},\"listening_tcp_ports\":{\"ports\":[", ( unsigned long ) scale );
+
+    for( i = 0; i < scale; i++ )
+    {
+        append( c, "%s{\"port\":%lu,\"interface\":\"eth0\"}",
+                ( i > 0U ) ? "," : "", 1024UL + ( unsigned long ) i );
+    }
+
+    append( c, "],\"total\":%lu},\"listening_udp_ports\":{\"ports\":[", ( unsigned long ) scale );
+
+    for( i = 0; i < scale; i++ )
+    {
+        append( c, "%s{\"port\":%lu,\"interface\":\"wlan0\"}",
+                ( i > 0U ) ? "," : "", 5000UL + ( unsigned long ) i );
+    }
+
+    append( c, "],\"total\":%lu},\"network_stats\":{\"bytes_in\":29358693495,"
+               "\"bytes_out\":26485035,\"packets_in\":10013573555,\"packets_out\":11382615}}}",
+            ( unsigned long ) scale );
+
+    addQuery( c, "header.report_id" );
+    addQuery( c, "metrics.tcp_connections.established_connections.connections[%lu].remote_addr",
+              ( unsigned long ) ( scale - 1U ) );
+    addQuery( c, "metrics.network_stats.packets_out" );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief An array of 16 * scale numbers, alternating integers and
+ * decimals with exponents.
+ */
+static void generateNumbers( corpus_t * c,
+                             size_t scale )
+{
+    size_t i, count = 16U * scale;
+
+    append( c, "[" );
+
+    for( i = 0; i < count; i++ )
+    {
+        if( ( i % 2U ) == 0U )
+        {
+            append( c, "%s%ld", ( i > 0U ) ? "," : "", ( long ) ( i * 7919U ) - 1000000L );
+        }
+        else
+        {
+            append( c, ",%.17g", ( ( double ) i * 3.14159265358979 ) * 1e-3 );
+        }
+    }
+
+    append( c, "]" );
+
+    addQuery( c, "[0]" );
+    addQuery( c, "[%lu]", ( unsigned long ) ( count / 2U ) );
+    addQuery( c, "[%lu]", ( unsigned long ) ( count - 1U ) );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Objects nested NESTED_DEPTH deep, each having scale members
+ * before the one that goes deeper.
+ */
+static void generateNested( corpus_t * c,
+                            size_t scale )
+{
+    size_t i, depth;
+    char query[ QUERY_MAX_LENGTH ];
+    size_t queryLength = 0;
+
+    append( c, "{" );
+
+    for( depth = 0; depth < NESTED_DEPTH; depth++ )
+    {
+        for( i = 0; i < scale; i++ )
+        {
+            append( c, "\"sibling%lu\":[%lu,true,null],", ( unsigned long ) i, ( unsigned long ) i );
+        }
+
+        append( c, "\"n\":{" );
+    }
+
+    append( c, "\"leaf\":1" );
+
+    for( depth = 0; depth < NESTED_DEPTH; depth++ )
+    {
+        append( c, "}" );
+    }
+
+    append( c, "}" );
+
+    /* Queries for the values at depths 1, 4, 16 and 31. */
+    for( depth = 1; depth <= NESTED_DEPTH; depth++ )
+    {
+        queryLength += ( size_t ) snprintf( &query[ queryLength ], sizeof( query ) - queryLength,
+                                            ( depth > 1U ) ? ".n" : "n" );
+
+        if( ( depth == 1U ) || ( depth == 4U ) || ( depth == 16U ) || ( depth == NESTED_DEPTH ) )
+        {
+            addQuery( c, "%s", query );
+        }
+    }
+
+    addQuery( c, "%s.leaf", query );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief An object of scale strings full of escapes and multi-byte
+ * characters.
+ */
+static void generateEscapes( corpus_t * c,
+                             size_t scale )
+{
+    size_t i;
+
+    append( c, "{" );
+
+    for( i = 0; i < scale; i++ )
+    {
+        append( c, "%s\"line%lu\":\"tab\\there \\\"quoted\\\" C:\\\\path\\\\to\\\\file\\r\\n"
+                   "caf\\u00e9 \\u20ac \\ud83d\\ude00 na\xc3\xafve \xe2\x82\xac\\/\\b\\f\"",
+                ( i > 0U ) ? "," : "", ( unsigned long ) i );
+    }
+
+    append( c, "}" );
+
+    addQuery( c, "line0" );
+    addQuery( c, "line%lu", ( unsigned long ) ( scale - 1U ) );
+}
+
+/*-----------------------------------------------------------*/
+
+static double now( void )
+{
+    struct timespec t;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &t );
+
+    return ( double ) t.tv_sec + ( ( double ) t.tv_nsec * 1e-9 );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Time JSON_Validate() on a document.
+ *
+ * @return the throughput in MB/s.
+ */
+static double timeValidate( const corpus_t * c )
+{
+    size_t i, iterations = 1;
+    double start, elapsed;
+
+    /* Double the iterations until they take long enough to time. */
+    for( ; ; )
+    {
+        start = now();
+
+        for( i = 0; i < iterations; i++ )
+        {
+            sink += ( size_t ) JSON_Validate( c->buf, c->length );
+        }
+
+        elapsed = now() - start;
+
+        if( elapsed >= minSeconds )
+        {
+            break;
+        }
+
+        iterations *= 2U;
+    }
+
+    return ( ( double ) c->length * ( double ) iterations ) / ( elapsed * 1e6 );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Time JSON_Search(), or JSON_SearchCompiled() with the query
+ * compiled beforehand.
+ *
+ * @return the latency of one search in nanoseconds.
+ */
+static double timeSearch( const corpus_t * c,
+                          const char * query,
+                          const JSONQueryStep_t * steps,
+                          size_t stepCount )
+{
+    size_t i, iterations = 1, queryLength = strlen( query ), valueLength;
+    char * value;
+    double start, elapsed;
+
+    for( ; ; )
+    {
+        start = now();
+
+        for( i = 0; i < iterations; i++ )
+        {
+            if( steps == NULL )
+            {
+                sink += ( size_t ) JSON_Search( c->buf, c->length, query, queryLength,
+                                                &value, &valueLength );
+            }
+            else
+            {
+                sink += ( size_t ) JSON_SearchCompiled( c->buf, c->length, steps, stepCount,
+                                                        &value, &valueLength );
+            }
+        }
+
+        elapsed = now() - start;
+
+        if( elapsed >= minSeconds )
+        {
+            break;
+        }
+
+        iterations *= 2U;
+    }
+
+    return ( elapsed * 1e9 ) / ( double ) iterations;
+}
+
+/*-----------------------------------------------------------*/
+
+static int runDocument( const document_t * d,
+                        size_t scale,
+                        corpus_t * c )
+{
+    int ret = EXIT_SUCCESS;
+    size_t q, stepCount, valueLength;
+    char * value;
+    JSONQueryStep_t steps[ QUERY_MAX_STEPS ];
+
+    c->length = 0;
+    c->truncated = 0;
+    c->queryCount = 0;
+    d->generate( c, scale );
+
+    if( ( c->truncated != 0 ) || ( JSON_Validate( c->buf, c->length ) != JSONSuccess ) )
+    {
+        fprintf( stderr, "%s x%lu: the generated document is invalid.\n",
+                 d->name, ( unsigned long ) scale );
+        ret = EXIT_FAILURE;
+    }
+    else
+    {
+        printf( "%-9s %8lu %10lu   validate %9.1f MB/s\n", d->name, ( unsigned long ) scale,
+                ( unsigned long ) c->length, timeValidate( c ) );
+    }
+
+    for( q = 0; ( ret == EXIT_SUCCESS ) && ( q < c->queryCount ); q++ )
+    {
+        const char * query = c->queries[ q ];
+
+        if( ( JSON_CompileQuery( query, strlen( query ), steps, QUERY_MAX_STEPS,
+                                 &stepCount ) != JSONSuccess ) ||
+            ( JSON_Search( c->buf, c->length, query, strlen( query ),
+                           &value, &valueLength ) != JSONSuccess ) )
+        {
+            fprintf( stderr, "%s x%lu: the query %s is not found.\n",
+                     d->name, ( unsigned long ) scale, query );
+            ret = EXIT_FAILURE;
+        }
+        else
+        {
+            printf( "%30s depth %2lu   search %11.0f ns   compiled %11.0f ns   %.40s%s\n", "",
+                    ( unsigned long ) stepCount,
+                    timeSearch( c, query, NULL, 0 ),
+                    timeSearch( c, query, steps, stepCount ),
+                    query, ( strlen( query ) > 40U ) ? "..." : "" );
+        }
+    }
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static const document_t documents[] =
+    {
+        { "shadow",   generateShadow,   { 1, 32, 1024  } },
+        { "jobs",     generateJobs,     { 1, 32, 1024  } },
+        { "defender", generateDefender, { 1, 32, 1024  } },
+        { "numbers",  generateNumbers,  { 1, 64, 4096  } },
+        { "nested",   generateNested,   { 0, 8,  256   } },
+        { "escapes",  generateEscapes,  { 1, 64, 4096  } }
+    };
+    int ret = EXIT_SUCCESS;
+    size_t d, s;
+    corpus_t c;
+
+    if( argc > 1 )
+    {
+        minSeconds = atof( argv[ 1 ] );
+    }
+
+    c.buf = malloc( DOCUMENT_MAX_LENGTH );
+
+    if( c.buf == NULL )
+    {
+        ret = EXIT_FAILURE;
+    }
+    else
+    {
+        printf( "%-9s %8s %10s\n", "document", "scale", "bytes" );
+    }
+
+    for( d = 0; ( ret == EXIT_SUCCESS ) && ( d < ( sizeof( documents ) / sizeof( documents[ 0 ] ) ) ); d++ )
+    {
+        for( s = 0; ( ret == EXIT_SUCCESS ) && ( s < 3U ); s++ )
+        {
+            ret = runDocument( &documents[ d ], documents[ d ].scales[ s ], &c );
+        }
+    }
+
+    free( c.buf );
+
+    return ret;
+}
@@ -0,0 +1,524 @@
+/*
+ * coreJSON v2.0.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_json_fuzz.c
+ * @brief Input generation shared by the coreJSON differential harnesses.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core_json_fuzz.h"
+
+/**
+ * @brief Past this length, the generator only closes what is open.
+ *
+ * One more element is far shorter than the margin, and the second half of
+ * the buffer is left for fuzzMutate().
+ */
+#define SOFT_LIMIT              ( FUZZ_DOCUMENT_MAX_LENGTH * 3U / 8U )
+
+/**
+ * @brief The most values in one generated document.
+ */
+#define ELEMENT_BUDGET          ( 64U )
+
+/**
+ * @brief The nesting depth of ordinary documents, and the range of the
+ * occasional deep one, which straddles the default JSON_MAX_DEPTH.
+ */
+#define ORDINARY_DEPTH          ( 6U )
+#define DEEP_DEPTH_MIN          ( 28U )
+#define DEEP_DEPTH_RANGE        ( 12U )
+
+/**
+ * @brief The keys that documents and queries share.
+ */
+static const char * const keys[] = { "a", "b", "c", "ab", "b c" };
+
+#define KEY_COUNT               ( sizeof( keys ) / sizeof( keys[ 0 ] ) )
+
+/**
+ * @brief Bytes that fuzzMutate() favors.
+ */
+static const uint8_t significant[] =
+{
+    '"',  '\\', '{',  '}',  '[',  ']',  ',',  ':',  ' ',  '\t', '\n', '0',
+    '-',  '.',  'e',  'u',  't',  'n',  0x00, 0x1F, 0x7F, 0x80, 0xBF, 0xC0,
+    0xC2, 0xE0, 0xED, 0xF0, 0xF4, 0xF5, 0xFF
+};
+
+/**
+ * @brief The state of the generator of one document.
+ */
+typedef struct generator
+{
+    char * buf;
+    size_t length;
+    uint32_t budget;
+} generator_t;
+
+static uint64_t randomState = 1U;
+
+/*-----------------------------------------------------------*/
+
+void fuzzSeed( uint64_t seed )
+{
+    randomState = ( seed != 0U ) ? seed : 0x9E3779B97F4A7C15U;
+}
+
+/*-----------------------------------------------------------*/
+
+uint32_t fuzzRandom( uint32_t bound )
+{
+    /* xorshift64* */
+    randomState ^= randomState >> 12;
+    randomState ^= randomState << 25;
+    randomState ^= randomState >> 27;
+
+    assert( bound > 0U );
+
+    return ( uint32_t ) ( ( randomState * 0x2545F4914F6CDD1DU ) >> 32 ) % bound;
+}
+
+/*-----------------------------------------------------------*/
+
+static void put( generator_t * g,
+                 const char * s,
+                 size_t n )
+{
+    assert( ( g->length + n ) <= ( FUZZ_DOCUMENT_MAX_LENGTH / 2U ) );
+
+    ( void ) memcpy( &g->buf[ g->length ], s, n );
+    g->length += n;
+}
+
+/*-----------------------------------------------------------*/
+
+static void putByte( generator_t * g,
+                     uint32_t c )
+{
+    char c_ = ( char ) c;
+
+    put( g, &c_, 1U );
+}
+
+/*-----------------------------------------------------------*/
+
+static void putWhitespace( generator_t * g )
+{
+    static const char spaces[] = { ' ', '\t', '\n', '\r' };
+    uint32_t roll = fuzzRandom( 10U );
+    uint32_t n = 0U, i;
+
+    /* Mostly compact, sometimes a run longer than a vector block. */
+    if( roll >= 9U )
+    {
+        n = 16U + fuzzRandom( 48U );
+    }
+    else if( roll >= 7U )
+    {
+        n = 1U + fuzzRandom( 3U );
+    }
+
+    for( i = 0U; i < n; i++ )
+    {
+        putByte( g, ( uint32_t ) spaces[ ( roll >= 9U ) ? 0U : fuzzRandom( 4U ) ] );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void putHexEscape( generator_t * g,
+                          uint32_t value )
+{
+    char hex[ 7 ];
+
+    ( void ) snprintf( hex, sizeof( hex ), "\\u%04X", ( unsigned int ) value );
+    put( g, hex, 6U );
+}
+
+/*-----------------------------------------------------------*/
+
+static void putStringContent( generator_t * g )
+{
+    static const char escapes[] = { '"', '\\', '/', 'b', 'f', 'n', 'r', 't' };
+    uint32_t length, i, roll, value;
+
+    /* Mostly short, sometimes longer than a vector block. */
+    length = ( fuzzRandom( 5U ) == 0U ) ? ( 32U + fuzzRandom( 96U ) ) : fuzzRandom( 9U );
+
+    for( i = 0U; i < length; i++ )
+    {
+        roll = fuzzRandom( 100U );
+
+        if( roll < 70U )
+        {
+            /* Printable ASCII other than the quote and the backslash. */
+            value = 0x20U + fuzzRandom( 0x5FU );
+            putByte( g, ( ( value == ( uint32_t ) '"' ) || ( value == ( uint32_t ) '\\' ) ) ? ( uint32_t ) 'x' : value );
+        }
+        else if( roll < 78U )
+        {
+            putByte( g, ( uint32_t ) '\\' );
+            putByte( g, ( uint32_t ) escapes[ fuzzRandom( sizeof( escapes ) ) ] );
+        }
+        else if( roll < 82U )
+        {
+            /* A nonzero code point outside the surrogates. */
+            value = 1U + fuzzRandom( 0xFFFEU );
+            putHexEscape( g, ( ( value >= 0xD800U ) && ( value <= 0xDFFFU ) ) ? 0xE9U : value );
+        }
+        else if( roll < 85U )
+        {
+            putHexEscape( g, 0xD800U + fuzzRandom( 0x400U ) );
+            putHexEscape( g, 0xDC00U + fuzzRandom( 0x400U ) );
+        }
+        else if( roll < 92U )
+        {
+            value = 0x80U + fuzzRandom( 0x780U );
+            putByte( g, 0xC0U | ( value >> 6 ) );
+            putByte( g, 0x80U | ( value & 0x3FU ) );
+        }
+        else if( roll < 97U )
+        {
+            value = 0x800U + fuzzRandom( 0xF800U );
+            value = ( ( value >= 0xD800U ) && ( value <= 0xDFFFU ) ) ? 0x20ACU : value;
+            putByte( g, 0xE0U | ( value >> 12 ) );
+            putByte( g, 0x80U | ( ( value >> 6 ) & 0x3FU ) );
+            putByte( g, 0x80U | ( value & 0x3FU ) );
+        }
+        else
+        {
+            value = 0x10000U + fuzzRandom( 0x100000U );
+            putByte( g, 0xF0U | ( value >> 18 ) );
+            putByte( g, 0x80U | ( ( value >> 12 ) & 0x3FU ) );
+            putByte( g, 0x80U | ( ( value >> 6 ) & 0x3FU ) );
+            putByte( g, 0x80U | ( value & 0x3FU ) );
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void putDigits( generator_t * g,
+                       uint32_t count )
+{
+    uint32_t i;
+
+    for( i = 0U; i < count; i++ )
+    {
+        putByte( g, ( uint32_t ) '0' + fuzzRandom( 10U ) );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void putScalar( generator_t * g )
+{
+    static const char * const literals[] = { "true", "false", "null" };
+    uint32_t roll = fuzzRandom( 10U );
+
+    if( roll < 4U )
+    {
+        putByte( g, ( uint32_t ) '"' );
+        putStringContent( g );
+        putByte( g, ( uint32_t ) '"' );
+    }
+    else if( roll < 8U )
+    {
+        if( fuzzRandom( 3U ) == 0U )
+        {
+            putByte( g, ( uint32_t ) '-' );
+        }
+
+        if( fuzzRandom( 4U ) == 0U )
+        {
+            putByte( g, ( uint32_t ) '0' );
+        }
+        else
+        {
+            putByte( g, ( uint32_t ) '1' + fuzzRandom( 9U ) );
+            putDigits( g, fuzzRandom( ( fuzzRandom( 8U ) == 0U ) ? 24U : 4U ) );
+        }
+
+        if( fuzzRandom( 3U ) == 0U )
+        {
+            putByte( g, ( uint32_t ) '.' );
+            putDigits( g, 1U + fuzzRandom( 6U ) );
+        }
+
+        if( fuzzRandom( 4U ) == 0U )
+        {
+            putByte( g, ( fuzzRandom( 2U ) == 0U ) ? ( uint32_t ) 'e' : ( uint32_t ) 'E' );
+
+            if( fuzzRandom( 2U ) == 0U )
+            {
+                putByte( g, ( fuzzRandom( 2U ) == 0U ) ? ( uint32_t ) '+' : ( uint32_t ) '-' );
+            }
+
+            putDigits( g, 1U + fuzzRandom( 3U ) );
+        }
+    }
+    else
+    {
+        const char * literal = literals[ fuzzRandom( 3U ) ];
+
+        put( g, literal, strlen( literal ) );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void putKey( generator_t * g )
+{
+    putByte( g, ( uint32_t ) '"' );
+
+    if( fuzzRandom( 8U ) == 0U )
+    {
+        putStringContent( g );
+    }
+    else
+    {
+        const char * key = keys[ fuzzRandom( KEY_COUNT ) ];
+
+        put( g, key, strlen( key ) );
+    }
+
+    putByte( g, ( uint32_t ) '"' );
+}
+
+/*-----------------------------------------------------------*/
+
+static void putValue( generator_t * g,
+                      uint32_t depth )
+{
+    uint32_t count, i;
+    uint32_t isObject;
+
+    if( g->budget > 0U )
+    {
+        g->budget--;
+    }
+
+    if( ( depth == 0U ) || ( g->budget == 0U ) || ( g->length > SOFT_LIMIT ) ||
+        ( fuzzRandom( 3U ) == 0U ) )
+    {
+        putScalar( g );
+    }
+    else
+    {
+        isObject = fuzzRandom( 2U );
+        count = fuzzRandom( 6U );
+        putByte( g, ( isObject != 0U ) ? ( uint32_t ) '{' : ( uint32_t ) '[' );
+
+        for( i = 0U; i < count; i++ )
+        {
+            if( i > 0U )
+            {
+                putByte( g, ( uint32_t ) ',' );
+            }
+
+            putWhitespace( g );
+
+            if( isObject != 0U )
+            {
+                putKey( g );
+                putWhitespace( g );
+                putByte( g, ( uint32_t ) ':' );
+                putWhitespace( g );
+            }
+
+            putValue( g, depth - 1U );
+            putWhitespace( g );
+        }
+
+        if( count == 0U )
+        {
+            putWhitespace( g );
+        }
+
+        putByte( g, ( isObject != 0U ) ? ( uint32_t ) '}' : ( uint32_t ) ']' );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void putDeepValue( generator_t * g,
+                          uint32_t depth )
+{
+    uint32_t isObject = fuzzRandom( 2U );
+
+    if( depth == 0U )
+    {
+        putValue( g, 1U );
+    }
+    else
+    {
+        putByte( g, ( isObject != 0U ) ? ( uint32_t ) '{' : ( uint32_t ) '[' );
+
+        if( isObject != 0U )
+        {
+            putKey( g );
+            putByte( g, ( uint32_t ) ':' );
+        }
+
+        putDeepValue( g, depth - 1U );
+        putByte( g, ( isObject != 0U ) ? ( uint32_t ) '}' : ( uint32_t ) ']' );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+size_t fuzzDocument( char * buf )
+{
+    generator_t g = { 0 };
+
+    g.buf = buf;
+    g.budget = 1U + fuzzRandom( ELEMENT_BUDGET );
+
+    putWhitespace( &g );
+
+    if( fuzzRandom( 50U ) == 0U )
+    {
+        putDeepValue( &g, DEEP_DEPTH_MIN + fuzzRandom( DEEP_DEPTH_RANGE ) );
+    }
+    else
+    {
+        /* Mostly a collection at the root, as JSON_VALIDATE_COLLECTIONS_ONLY
+         * would require, sometimes a scalar. */
+        g.budget = ( fuzzRandom( 10U ) == 0U ) ? 0U : g.budget;
+        putValue( &g, ( g.budget == 0U ) ? 0U : ORDINARY_DEPTH );
+    }
+
+    putWhitespace( &g );
+
+    return g.length;
+}
+
+/*-----------------------------------------------------------*/
+
+size_t fuzzMutate( char * buf,
+                   size_t length )
+{
+    uint32_t edits = 1U + fuzzRandom( 4U );
+    uint32_t i, roll;
+    size_t at;
+    uint8_t c;
+
+    for( i = 0U; ( i < edits ) && ( length > 1U ); i++ )
+    {
+        roll = fuzzRandom( 8U );
+        at = ( size_t ) fuzzRandom( ( uint32_t ) length );
+        c = ( fuzzRandom( 4U ) == 0U ) ? ( uint8_t ) fuzzRandom( 256U ) :
+            significant[ fuzzRandom( sizeof( significant ) ) ];
+
+        if( roll < 3U )
+        {
+            buf[ at ] = ( char ) c;
+        }
+        else if( ( roll < 6U ) && ( length < FUZZ_DOCUMENT_MAX_LENGTH ) )
+        {
+            ( void ) memmove( &buf[ at + 1U ], &buf[ at ], length - at );
+            buf[ at ] = ( char ) c;
+            length++;
+        }
+        else if( roll < 7U )
+        {
+            ( void ) memmove( &buf[ at ], &buf[ at + 1U ], length - at - 1U );
+            length--;
+        }
+        else
+        {
+            length = ( at > 0U ) ? at : 1U;
+        }
+    }
+
+    return length;
+}
+
+/*-----------------------------------------------------------*/
+
+size_t fuzzQuery( char * buf )
+{
+    uint32_t parts = 1U + fuzzRandom( 4U );
+    uint32_t i;
+    size_t length = 0U;
+    int n;
+
+    for( i = 0U; i < parts; i++ )
+    {
+        if( fuzzRandom( 10U ) < 7U )
+        {
+            n = snprintf( &buf[ length ], FUZZ_QUERY_MAX_LENGTH - length, "%s%s",
+                          ( i > 0U ) ? "." : "", keys[ fuzzRandom( KEY_COUNT ) ] );
+        }
+        else
+        {
+            n = snprintf( &buf[ length ], FUZZ_QUERY_MAX_LENGTH - length, "[%u]",
+                          ( unsigned int ) fuzzRandom( 5U ) );
+        }
+
+        assert( ( n > 0 ) && ( ( length + ( size_t ) n ) < FUZZ_QUERY_MAX_LENGTH ) );
+        length += ( size_t ) n;
+    }
+
+    return length;
+}
+
+/*-----------------------------------------------------------*/
+
+int fuzzArguments( int argc,
+                   char ** argv,
+                   unsigned long * iterations,
+                   unsigned long * seed )
+{
+    int ret = 0;
+    char * end;
+
+    if( argc > 3 )
+    {
+        ret = -1;
+    }
+
+    if( ( ret == 0 ) && ( argc > 1 ) )
+    {
+        *iterations = strtoul( argv[ 1 ], &end, 10 );
+        ret = ( ( end != argv[ 1 ] ) && ( *end == '\0' ) ) ? 0 : -1;
+    }
+
+    if( ( ret == 0 ) && ( argc > 2 ) )
+    {
+        *seed = strtoul( argv[ 2 ], &end, 10 );
+        ret = ( ( end != argv[ 2 ] ) && ( *end == '\0' ) ) ? 0 : -1;
+    }
+
+    if( ret != 0 )
+    {
+        ( void ) fprintf( stderr, "usage: %s [iterations [seed]]\n", argv[ 0 ] );
+    }
+
+    return ret;
+}
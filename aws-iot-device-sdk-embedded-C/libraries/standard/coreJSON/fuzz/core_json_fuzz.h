@@ -0,0 +1,149 @@
+/*
+ * coreJSON v2.0.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_json_fuzz.h
+ * @brief Input generation shared by the coreJSON differential harnesses.
+ *
+ * The harnesses run on a host, not on the device.  Each one generates
+ * documents from a seeded pseudo-random sequence, so a run is reproduced
+ * by passing the same seed and iteration count.
+ */
+
+#ifndef CORE_JSON_FUZZ_H_
+#define CORE_JSON_FUZZ_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core_json.h"
+
+/**
+ * @brief The size of the buffer that holds one generated input.
+ *
+ * Large enough for any document fuzzDocument() generates, with room left
+ * for fuzzMutate() to insert bytes.
+ */
+#define FUZZ_DOCUMENT_MAX_LENGTH    ( 128U * 1024U )
+
+/**
+ * @brief The size of the buffer that holds one generated query.
+ */
+#define FUZZ_QUERY_MAX_LENGTH       ( 64U )
+
+/**
+ * @brief The functions of one build of core_json.c, as exported by
+ * core_json_fuzz_variant.c.
+ */
+typedef struct fuzzVariant
+{
+    const char * name; /**< @brief The name of the build. */
+    JSONStatus_t ( * validate )( const char * buf,
+                                 size_t max );
+    JSONStatus_t ( * search )( char * buf,
+                               size_t max,
+                               const char * query,
+                               size_t queryLength,
+                               char ** outValue,
+                               size_t * outValueLength );
+    JSONStatus_t ( * buildIndex )( const char * buf,
+                                   size_t max,
+                                   JSONIndexEntry_t * index,
+                                   size_t indexCapacity,
+                                   size_t * outCount );
+    JSONStatus_t ( * searchMany )( char * buf,
+                                   size_t max,
+                                   JSONQuery_t * queries,
+                                   size_t queryCount );
+} fuzzVariant_t;
+
+/**
+ * @brief Seed the pseudo-random sequence.
+ *
+ * @param[in] seed  Any value; 0 is replaced by a fixed nonzero seed.
+ */
+void fuzzSeed( uint64_t seed );
+
+/**
+ * @brief Draw the next value of the pseudo-random sequence.
+ *
+ * @param[in] bound  The number of possible values; must be nonzero.
+ *
+ * @return A value from 0 to bound - 1.
+ */
+uint32_t fuzzRandom( uint32_t bound );
+
+/**
+ * @brief Generate a valid JSON document.
+ *
+ * Documents mix objects, arrays, strings with escapes and multi-byte
+ * UTF-8, numbers, literals and whitespace runs long enough to span vector
+ * blocks.  Keys come mostly from the small set that fuzzQuery() draws on,
+ * so that queries often match, and may repeat within an object.  Some
+ * documents nest deeper than JSON_MAX_DEPTH.
+ *
+ * @param[out] buf  The buffer, of #FUZZ_DOCUMENT_MAX_LENGTH bytes.
+ *
+ * @return The length of the document.
+ */
+size_t fuzzDocument( char * buf );
+
+/**
+ * @brief Damage a document with a few random edits.
+ *
+ * Bytes are replaced, inserted or deleted, favoring bytes that are
+ * significant to JSON, and the document may be truncated.
+ *
+ * @param[in,out] buf  The buffer, of #FUZZ_DOCUMENT_MAX_LENGTH bytes.
+ * @param[in] length  The length of the document.
+ *
+ * @return The new length of the document.
+ */
+size_t fuzzMutate( char * buf,
+                   size_t length );
+
+/**
+ * @brief Generate a well-formed JSON_Search() query.
+ *
+ * @param[out] buf  The buffer, of #FUZZ_QUERY_MAX_LENGTH bytes.
+ *
+ * @return The length of the query.
+ */
+size_t fuzzQuery( char * buf );
+
+/**
+ * @brief Parse the optional arguments of a harness: the iteration count,
+ * then the seed.
+ *
+ * @param[in] argc  The argument count passed to main().
+ * @param[in] argv  The arguments passed to main().
+ * @param[in,out] iterations  The default count, replaced if given.
+ * @param[in,out] seed  The default seed, replaced if given.
+ *
+ * @return 0 if the arguments were valid; -1 otherwise.
+ */
+int fuzzArguments( int argc,
+                   char ** argv,
+                   unsigned long * iterations,
+                   unsigned long * seed );
+
+#endif /* ifndef CORE_JSON_FUZZ_H_ */
@@ -0,0 +1,271 @@
+/*
+ * coreJSON v2.0.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_json_fuzz_search_many.c
+ * @brief Differential harness of JSON_SearchMany() against JSON_Search().
+ *
+ * For each generated valid document, a batch of queries goes through
+ * JSON_SearchMany().  About half are paths to values of the document, taken
+ * from its index, and the rest are random, so queries often share prefixes
+ * and many match.  Each query must get the status and value that
+ * JSON_Search() gives it alone, and the overall status must be that of the
+ * first query not matched.
+ *
+ * Arguments: the iteration count, 100000 by default, then the seed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core_json_fuzz.h"
+
+/**
+ * @brief The most queries in one batch.
+ */
+#define QUERY_MAX_COUNT    ( 8U )
+
+/**
+ * @brief The capacity of the index from which paths are taken.
+ */
+#define INDEX_CAPACITY     ( 256U )
+
+/**
+ * @brief The most mismatches reported before the harness gives up.
+ */
+#define MISMATCH_LIMIT     ( 10U )
+
+static char document[ FUZZ_DOCUMENT_MAX_LENGTH ];
+static char queryText[ QUERY_MAX_COUNT ][ FUZZ_QUERY_MAX_LENGTH ];
+static JSONIndexEntry_t entries[ INDEX_CAPACITY ];
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write the query that leads to an entry of the index.
+ *
+ * @param[in] entry  The entry, which must not be the root.
+ * @param[out] buf  The buffer, of #FUZZ_QUERY_MAX_LENGTH bytes.
+ *
+ * @return The length of the query, or 0 if it does not fit or a key on
+ * the path cannot be written in a query.
+ */
+static size_t pathQuery( size_t entry,
+                         char * buf )
+{
+    char part[ FUZZ_QUERY_MAX_LENGTH ];
+    size_t length = 0U, partLength, position, sibling, i, parent;
+    const JSONIndexEntry_t * e;
+
+    while( ( entry != 0U ) && ( length < FUZZ_QUERY_MAX_LENGTH ) )
+    {
+        e = &entries[ entry ];
+        parent = e->parent;
+
+        if( entries[ parent ].type == JSONObject )
+        {
+            partLength = e->keyLength;
+
+            for( i = 0U; i < e->keyLength; i++ )
+            {
+                if( strchr( ".[]\\", document[ e->key + i ] ) != NULL )
+                {
+                    partLength = FUZZ_QUERY_MAX_LENGTH;
+                }
+            }
+
+            if( partLength < FUZZ_QUERY_MAX_LENGTH )
+            {
+                ( void ) memcpy( part, &document[ e->key ], partLength );
+            }
+        }
+        else
+        {
+            position = 0U;
+
+            for( sibling = parent + 1U; sibling != entry; sibling = entries[ sibling ].nextSibling )
+            {
+                position++;
+            }
+
+            partLength = ( size_t ) snprintf( part, sizeof( part ), "[%u]", ( unsigned int ) position );
+        }
+
+        /* Prepend the part, with a dot after it if a key follows. */
+        if( ( partLength == 0U ) || ( ( partLength + length + 1U ) >= FUZZ_QUERY_MAX_LENGTH ) )
+        {
+            length = FUZZ_QUERY_MAX_LENGTH;
+        }
+        else
+        {
+            if( ( length > 0U ) && ( buf[ 0 ] != '[' ) )
+            {
+                ( void ) memmove( &buf[ 1 ], buf, length );
+                buf[ 0 ] = '.';
+                length++;
+            }
+
+            ( void ) memmove( &buf[ partLength ], buf, length );
+            ( void ) memcpy( buf, part, partLength );
+            length += partLength;
+        }
+
+        entry = parent;
+    }
+
+    return ( length < FUZZ_QUERY_MAX_LENGTH ) ? length : 0U;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Run one batch of queries both ways.
+ *
+ * @param[in] length  The length of the document.
+ * @param[in] count  The number of queries.
+ * @param[in,out] matched  Incremented for each query matched.
+ *
+ * @return NULL if the results agree; what differs otherwise.
+ */
+static const char * compareBatch( size_t length,
+                                  size_t count,
+                                  unsigned long * matched )
+{
+    JSONQuery_t queries[ QUERY_MAX_COUNT ];
+    JSONStatus_t many, status, expected = JSONSuccess;
+    const char * ret = NULL;
+    char * value;
+    size_t valueLength, i, entryCount = 0U;
+
+    ( void ) memset( queries, 0, sizeof( queries ) );
+
+    if( JSON_BuildIndex( document, length, entries, INDEX_CAPACITY, &entryCount ) != JSONSuccess )
+    {
+        entryCount = 0U;
+    }
+
+    for( i = 0U; i < count; i++ )
+    {
+        queries[ i ].query = queryText[ i ];
+
+        if( ( entryCount > 1U ) && ( fuzzRandom( 2U ) == 0U ) )
+        {
+            queries[ i ].queryLength = pathQuery( 1U + fuzzRandom( ( uint32_t ) entryCount - 1U ), queryText[ i ] );
+        }
+
+        if( queries[ i ].queryLength == 0U )
+        {
+            queries[ i ].queryLength = fuzzQuery( queryText[ i ] );
+        }
+    }
+
+    many = JSON_SearchMany( document, length, queries, count );
+
+    for( i = 0U; ( ret == NULL ) && ( i < count ); i++ )
+    {
+        value = NULL;
+        valueLength = 0U;
+        status = JSON_Search( document, length, queries[ i ].query, queries[ i ].queryLength,
+                              &value, &valueLength );
+
+        if( status != queries[ i ].status )
+        {
+            ret = "status";
+        }
+        else if( ( status == JSONSuccess ) &&
+                 ( ( value != queries[ i ].value ) || ( valueLength != queries[ i ].valueLength ) ) )
+        {
+            ret = "value";
+        }
+        else if( status == JSONSuccess )
+        {
+            *matched += 1UL;
+        }
+        else if( expected == JSONSuccess )
+        {
+            expected = status;
+        }
+        else
+        {
+            /* Empty else. */
+        }
+    }
+
+    if( ( ret == NULL ) && ( many != expected ) )
+    {
+        ret = "overall status";
+    }
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    unsigned long iterations = 100000UL, seed = 1UL, n = 0UL;
+    unsigned long valid = 0UL, queryCount = 0UL, matched = 0UL, mismatches = 0UL;
+    size_t length, count;
+    const char * failed;
+    int ret = EXIT_SUCCESS;
+
+    if( fuzzArguments( argc, argv, &iterations, &seed ) != 0 )
+    {
+        ret = EXIT_FAILURE;
+        iterations = 0UL;
+    }
+
+    fuzzSeed( seed );
+
+    for( n = 0UL; ( n < iterations ) && ( mismatches < MISMATCH_LIMIT ); n++ )
+    {
+        length = fuzzDocument( document );
+        count = 1U + fuzzRandom( QUERY_MAX_COUNT );
+
+        /* The contract holds for valid documents; some generated ones nest
+         * too deeply. */
+        if( JSON_Validate( document, length ) == JSONSuccess )
+        {
+            valid++;
+            queryCount += count;
+            failed = compareBatch( length, count, &matched );
+
+            if( failed != NULL )
+            {
+                mismatches++;
+                ( void ) printf( "Iteration %lu, seed %lu: the %s differs from JSON_Search().\n",
+                                 n, seed, failed );
+            }
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        ( void ) printf( "%lu documents, %lu of them valid; %lu queries, %lu of them matched: %lu mismatches.\n",
+                         n, valid, queryCount, matched, mismatches );
+        ret = ( mismatches == 0UL ) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    return ret;
+}
@@ -0,0 +1,266 @@
+/*
+ * coreJSON v2.0.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_json_fuzz_simd.c
+ * @brief Differential harness of the vector and scalar builds of coreJSON.
+ *
+ * core_json.c is built without vector instructions (JSON_DISABLE_SIMD),
+ * for the compiler's default target (SSE2 on x86-64, NEON on AArch64),
+ * and for AVX2 where the compiler supports it, each with both signed and
+ * unsigned char.  Generated documents, half of them damaged, go through
+ * JSON_Validate(), JSON_Search(), JSON_BuildIndex() and JSON_SearchMany()
+ * in every build, which must all give the results of the scalar build.
+ *
+ * Arguments: the iteration count, 100000 by default, then the seed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core_json_fuzz.h"
+
+/**
+ * @brief The number of queries run against each document.
+ */
+#define QUERY_COUNT         ( 4U )
+
+/**
+ * @brief The capacity of the index built of each document.
+ */
+#define INDEX_CAPACITY      ( 256U )
+
+/**
+ * @brief The most mismatches reported before the harness gives up.
+ */
+#define MISMATCH_LIMIT      ( 10U )
+
+extern const fuzzVariant_t scalar_JSON_Variant;
+extern const fuzzVariant_t scalar_uchar_JSON_Variant;
+extern const fuzzVariant_t native_JSON_Variant;
+extern const fuzzVariant_t native_uchar_JSON_Variant;
+
+#ifdef FUZZ_HAVE_AVX2
+    extern const fuzzVariant_t avx2_JSON_Variant;
+    extern const fuzzVariant_t avx2_uchar_JSON_Variant;
+#endif
+
+/**
+ * @brief The results of one build for one input.
+ */
+typedef struct results
+{
+    JSONStatus_t validate;
+    JSONStatus_t search[ QUERY_COUNT ];
+    size_t searchOffset[ QUERY_COUNT ];
+    size_t searchLength[ QUERY_COUNT ];
+    JSONStatus_t index;
+    size_t indexCount;
+    JSONIndexEntry_t entries[ INDEX_CAPACITY ];
+    JSONStatus_t many;
+    JSONQuery_t queries[ QUERY_COUNT ];
+} results_t;
+
+static char document[ FUZZ_DOCUMENT_MAX_LENGTH ];
+static char queries[ QUERY_COUNT ][ FUZZ_QUERY_MAX_LENGTH ];
+static size_t queryLengths[ QUERY_COUNT ];
+static results_t expected, actual;
+
+/*-----------------------------------------------------------*/
+
+static void run( const fuzzVariant_t * variant,
+                 size_t length,
+                 results_t * r )
+{
+    size_t i;
+    char * value;
+
+    ( void ) memset( r, 0, sizeof( *r ) );
+
+    r->validate = variant->validate( document, length );
+
+    for( i = 0U; i < QUERY_COUNT; i++ )
+    {
+        value = NULL;
+        r->search[ i ] = variant->search( document, length, queries[ i ], queryLengths[ i ],
+                                          &value, &r->searchLength[ i ] );
+        r->searchOffset[ i ] = ( value != NULL ) ? ( size_t ) ( value - document ) : 0U;
+
+        r->queries[ i ].query = queries[ i ];
+        r->queries[ i ].queryLength = queryLengths[ i ];
+    }
+
+    r->index = variant->buildIndex( document, length, r->entries, INDEX_CAPACITY, &r->indexCount );
+    r->many = variant->searchMany( document, length, r->queries, QUERY_COUNT );
+}
+
+/*-----------------------------------------------------------*/
+
+static const char * compare( const results_t * a,
+                             const results_t * b )
+{
+    const char * ret = NULL;
+    size_t i, n;
+
+    if( a->validate != b->validate )
+    {
+        ret = "JSON_Validate";
+    }
+
+    for( i = 0U; ( ret == NULL ) && ( i < QUERY_COUNT ); i++ )
+    {
+        if( ( a->search[ i ] != b->search[ i ] ) ||
+            ( ( a->search[ i ] == JSONSuccess ) &&
+              ( ( a->searchOffset[ i ] != b->searchOffset[ i ] ) ||
+                ( a->searchLength[ i ] != b->searchLength[ i ] ) ) ) )
+        {
+            ret = "JSON_Search";
+        }
+    }
+
+    if( ( ret == NULL ) && ( ( a->index != b->index ) || ( a->indexCount != b->indexCount ) ) )
+    {
+        ret = "JSON_BuildIndex";
+    }
+
+    n = ( a->index == JSONSuccess ) ? a->indexCount : 0U;
+
+    for( i = 0U; ( ret == NULL ) && ( i < n ); i++ )
+    {
+        const JSONIndexEntry_t * x = &a->entries[ i ];
+        const JSONIndexEntry_t * y = &b->entries[ i ];
+
+        if( ( x->type != y->type ) || ( x->offset != y->offset ) || ( x->length != y->length ) ||
+            ( x->key != y->key ) || ( x->keyLength != y->keyLength ) ||
+            ( x->parent != y->parent ) || ( x->nextSibling != y->nextSibling ) )
+        {
+            ret = "JSON_BuildIndex entries";
+        }
+    }
+
+    if( ( ret == NULL ) && ( a->many != b->many ) )
+    {
+        ret = "JSON_SearchMany";
+    }
+
+    for( i = 0U; ( ret == NULL ) && ( i < QUERY_COUNT ); i++ )
+    {
+        if( ( a->queries[ i ].status != b->queries[ i ].status ) ||
+            ( ( a->queries[ i ].status == JSONSuccess ) &&
+              ( ( a->queries[ i ].value != b->queries[ i ].value ) ||
+                ( a->queries[ i ].valueLength != b->queries[ i ].valueLength ) ) ) )
+        {
+            ret = "JSON_SearchMany queries";
+        }
+    }
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t listVariants( const fuzzVariant_t ** variants )
+{
+    size_t count = 0U;
+
+    variants[ count++ ] = &scalar_JSON_Variant;
+    variants[ count++ ] = &scalar_uchar_JSON_Variant;
+    variants[ count++ ] = &native_JSON_Variant;
+    variants[ count++ ] = &native_uchar_JSON_Variant;
+
+    #ifdef FUZZ_HAVE_AVX2
+        if( __builtin_cpu_supports( "avx2" ) != 0 )
+        {
+            variants[ count++ ] = &avx2_JSON_Variant;
+            variants[ count++ ] = &avx2_uchar_JSON_Variant;
+        }
+        else
+        {
+            ( void ) printf( "The CPU lacks AVX2: the avx2 builds are skipped.\n" );
+        }
+    #endif
+
+    return count;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    const fuzzVariant_t * variants[ 6 ];
+    size_t variantCount, v, i, length;
+    unsigned long iterations = 100000UL, seed = 1UL, n = 0UL;
+    unsigned long valid = 0UL, mismatches = 0UL;
+    const char * failed;
+    int ret = EXIT_SUCCESS;
+
+    if( fuzzArguments( argc, argv, &iterations, &seed ) != 0 )
+    {
+        ret = EXIT_FAILURE;
+        iterations = 0UL;
+    }
+
+    variantCount = listVariants( variants );
+    fuzzSeed( seed );
+
+    for( n = 0UL; ( n < iterations ) && ( mismatches < MISMATCH_LIMIT ); n++ )
+    {
+        length = fuzzDocument( document );
+
+        if( ( n % 2UL ) == 1UL )
+        {
+            length = fuzzMutate( document, length );
+        }
+
+        for( i = 0U; i < QUERY_COUNT; i++ )
+        {
+            queryLengths[ i ] = fuzzQuery( queries[ i ] );
+        }
+
+        run( variants[ 0 ], length, &expected );
+        valid += ( expected.validate == JSONSuccess ) ? 1UL : 0UL;
+
+        for( v = 1U; v < variantCount; v++ )
+        {
+            run( variants[ v ], length, &actual );
+            failed = compare( &expected, &actual );
+
+            if( failed != NULL )
+            {
+                mismatches++;
+                ( void ) printf( "Iteration %lu, seed %lu: %s differs between the %s and %s builds.\n",
+                                 n, seed, failed, variants[ 0 ]->name, variants[ v ]->name );
+            }
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        ( void ) printf( "%lu inputs, %lu of them valid, through %lu builds: %lu mismatches.\n",
+                         n, valid, ( unsigned long ) variantCount, mismatches );
+        ret = ( mismatches == 0UL ) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    return ret;
+}
@@ -0,0 +1,217 @@
+/*
+ * coreJSON v2.0.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_json_fuzz_stream.c
+ * @brief Differential harness of the incremental validator.
+ *
+ * Generated documents, half of them damaged, are validated whole and then
+ * twice more, split at random into chunks of 1 to 4 bytes.  Every split
+ * must give the same result and the same offset, and an error, once
+ * returned, must be returned for every later chunk.  The result must
+ * agree with JSON_BuildIndex() on the same buffer, except that a document
+ * that JSON_BuildIndex() finds illegal because it ends early may be
+ * #JSONPartial here.
+ *
+ * Arguments: the iteration count, 100000 by default, then the seed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "core_json_fuzz.h"
+
+/**
+ * @brief The capacity of the index built of each document.
+ */
+#define INDEX_CAPACITY     ( 256U )
+
+/**
+ * @brief The most mismatches reported before the harness gives up.
+ */
+#define MISMATCH_LIMIT     ( 10U )
+
+static char document[ FUZZ_DOCUMENT_MAX_LENGTH ];
+static JSONIndexEntry_t entries[ INDEX_CAPACITY ];
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Validate the document in chunks.
+ *
+ * @param[in] length  The length of the document.
+ * @param[in] chunkMax  The largest chunk, or 0 to pass the document whole.
+ * @param[out] offset  Receives the offset that the state reports.
+ * @param[out] sticky  Cleared if an error was not repeated for every chunk.
+ *
+ * @return The result of JSON_ValidateFinish().
+ */
+static JSONStatus_t validateInChunks( size_t length,
+                                      uint32_t chunkMax,
+                                      size_t * offset,
+                                      int * sticky )
+{
+    JSONStreamState_t state;
+    JSONStatus_t status, error = JSONSuccess;
+    size_t i = 0U, chunk;
+
+    ( void ) JSON_ValidateStart( &state );
+
+    while( i < length )
+    {
+        chunk = ( chunkMax == 0U ) ? length : ( size_t ) ( 1U + fuzzRandom( chunkMax ) );
+        chunk = ( chunk < ( length - i ) ) ? chunk : ( length - i );
+        status = JSON_ValidateChunk( &state, &document[ i ], chunk );
+
+        if( ( error != JSONSuccess ) && ( status != error ) )
+        {
+            *sticky = 0;
+        }
+
+        if( ( status != JSONSuccess ) && ( status != JSONPartial ) )
+        {
+            error = status;
+        }
+
+        i += chunk;
+    }
+
+    status = JSON_ValidateFinish( &state );
+    *offset = state.offset;
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Check a result of the incremental validator against that of
+ * JSON_BuildIndex().
+ *
+ * @param[in] stream  The result of the incremental validator.
+ * @param[in] index  The result of JSON_BuildIndex().
+ *
+ * @return 1 if the results agree; 0 otherwise.
+ */
+static int agrees( JSONStatus_t stream,
+                   JSONStatus_t index )
+{
+    int ret;
+
+    if( index == JSONInsufficientMemory )
+    {
+        /* The document has more values than the index can hold. */
+        ret = 1;
+    }
+    else if( stream == JSONPartial )
+    {
+        ret = ( ( index == JSONPartial ) || ( index == JSONIllegalDocument ) ) ? 1 : 0;
+    }
+    else
+    {
+        ret = ( stream == index ) ? 1 : 0;
+    }
+
+    return ret;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    unsigned long iterations = 100000UL, seed = 1UL, n = 0UL;
+    unsigned long counts[ 4 ] = { 0UL }, mismatches = 0UL;
+    size_t length, wholeOffset, offset, entryCount, s;
+    JSONStatus_t whole, split, index;
+    const char * failed;
+    int sticky;
+    int ret = EXIT_SUCCESS;
+
+    if( fuzzArguments( argc, argv, &iterations, &seed ) != 0 )
+    {
+        ret = EXIT_FAILURE;
+        iterations = 0UL;
+    }
+
+    fuzzSeed( seed );
+
+    for( n = 0UL; ( n < iterations ) && ( mismatches < MISMATCH_LIMIT ); n++ )
+    {
+        length = fuzzDocument( document );
+
+        if( ( n % 2UL ) == 1UL )
+        {
+            length = fuzzMutate( document, length );
+        }
+
+        failed = NULL;
+        sticky = 1;
+        whole = validateInChunks( length, 0U, &wholeOffset, &sticky );
+
+        for( s = 0U; ( failed == NULL ) && ( s < 2U ); s++ )
+        {
+            split = validateInChunks( length, 4U, &offset, &sticky );
+
+            if( ( split != whole ) || ( offset != wholeOffset ) )
+            {
+                failed = "a split gave another result or offset";
+            }
+            else if( sticky == 0 )
+            {
+                failed = "an error was not repeated for a later chunk";
+            }
+            else
+            {
+                /* Empty else. */
+            }
+        }
+
+        index = JSON_BuildIndex( document, length, entries, INDEX_CAPACITY, &entryCount );
+
+        if( ( failed == NULL ) && ( agrees( whole, index ) == 0 ) )
+        {
+            failed = "the result disagrees with JSON_BuildIndex()";
+        }
+
+        if( ( size_t ) whole < ( sizeof( counts ) / sizeof( counts[ 0 ] ) ) )
+        {
+            counts[ whole ]++;
+        }
+
+        if( failed != NULL )
+        {
+            mismatches++;
+            ( void ) printf( "Iteration %lu, seed %lu: %s.\n", n, seed, failed );
+        }
+    }
+
+    if( ret == EXIT_SUCCESS )
+    {
+        ( void ) printf( "%lu inputs (%lu complete, %lu partial, %lu illegal, %lu too deep): %lu mismatches.\n",
+                         n, counts[ JSONSuccess ], counts[ JSONPartial ], counts[ JSONIllegalDocument ],
+                         counts[ JSONMaxDepthExceeded ], mismatches );
+        ret = ( mismatches == 0UL ) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    return ret;
+}
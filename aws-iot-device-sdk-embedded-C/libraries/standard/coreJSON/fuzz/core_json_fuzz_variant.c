@@ -0,0 +1,71 @@
+/*
+ * coreJSON v2.0.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_json_fuzz_variant.c
+ * @brief core_json.c with its functions renamed, so that builds of it with
+ * different compiler options can be linked into one harness.
+ *
+ * FUZZ_VARIANT names the build, e.g. scalar, and must be defined on the
+ * command line.  Every function of the library is prefixed with it, and the
+ * build exports its functions as the fuzzVariant_t FUZZ_VARIANT_JSON_Variant.
+ */
+
+#ifndef FUZZ_VARIANT
+    #error "FUZZ_VARIANT must name the build."
+#endif
+
+#define FUZZ_PASTE_( prefix, name )    prefix ## _JSON_ ## name
+#define FUZZ_PASTE( prefix, name )     FUZZ_PASTE_( prefix, name )
+#define FUZZ_NAME( name )              FUZZ_PASTE( FUZZ_VARIANT, name )
+#define FUZZ_STRING_( prefix )         # prefix
+#define FUZZ_STRING( prefix )          FUZZ_STRING_( prefix )
+
+#define JSON_Validate          FUZZ_NAME( Validate )
+#define JSON_Search            FUZZ_NAME( Search )
+#define JSON_CompileQuery      FUZZ_NAME( CompileQuery )
+#define JSON_SearchCompiled    FUZZ_NAME( SearchCompiled )
+#define JSON_BuildIndex        FUZZ_NAME( BuildIndex )
+#define JSON_SearchIndex       FUZZ_NAME( SearchIndex )
+#define JSON_SearchMany        FUZZ_NAME( SearchMany )
+#define JSON_Iterate           FUZZ_NAME( Iterate )
+#define JSON_ValidateStart     FUZZ_NAME( ValidateStart )
+#define JSON_ValidateChunk     FUZZ_NAME( ValidateChunk )
+#define JSON_ValidateFinish    FUZZ_NAME( ValidateFinish )
+#define JSON_Unescape          FUZZ_NAME( Unescape )
+#define JSON_MergePatch        FUZZ_NAME( MergePatch )
+#define JSON_Minify            FUZZ_NAME( Minify )
+
+#include "core_json.c"
+
+#include "core_json_fuzz.h"
+
+extern const fuzzVariant_t FUZZ_NAME( Variant );
+
+const fuzzVariant_t FUZZ_NAME( Variant ) =
+{
+    FUZZ_STRING( FUZZ_VARIANT ),
+    JSON_Validate,
+    JSON_Search,
+    JSON_BuildIndex,
+    JSON_SearchMany
+};
@@ -28,9 +28,32 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #include "core_json.h"
 
 /** @cond DO_NOT_DOCUMENT */
+
+/* Vector instructions are used when the compiler targets them, unless
+ * JSON_DISABLE_SIMD is defined. */
+#ifndef JSON_DISABLE_SIMD
+    #if defined( __AVX2__ )
+        #include <immintrin.h>
+        #define JSON_SIMD_AVX2
+        #define JSON_SIMD_WIDTH            ( 32U )
+        #define JSON_SIMD_BITS_PER_BYTE    ( 1U )
+    #elif defined( __SSE2__ ) || defined( _M_X64 )
+        #include <emmintrin.h>
+        #define JSON_SIMD_SSE2
+        #define JSON_SIMD_WIDTH            ( 16U )
+        #define JSON_SIMD_BITS_PER_BYTE    ( 1U )
+    #elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+        #include <arm_neon.h>
+        #define JSON_SIMD_NEON
+        #define JSON_SIMD_WIDTH            ( 16U )
+        #define JSON_SIMD_BITS_PER_BYTE    ( 4U )
+    #endif
+#endif
+
 typedef enum
 {
     true = 1,
@@ -59,6 +82,178 @@ typedef union
 #define isSquareOpen_( x )            ( ( x ) == '[' )
 #define isSquareClose_( x )           ( ( x ) == ']' )
 
+#ifdef JSON_SIMD_WIDTH
+
+/*
+ * Each of the functions below classifies one block of JSON_SIMD_WIDTH bytes
+ * and outputs a mask with JSON_SIMD_BITS_PER_BYTE bits set for each byte
+ * that stops the scan, the first byte in the lowest bits.
+ *
+ * Within a string, only printable ASCII other than a quote or backslash is
+ * skipped.  Anything else, including every byte of a multi-byte UTF-8 code
+ * point, is left to the scalar code, so the outcome is identical with or
+ * without vector instructions.
+ */
+
+    #if defined( JSON_SIMD_AVX2 )
+
+static uint64_t stringStops( const char * p )
+{
+    __m256i v = _mm256_loadu_si256( ( const __m256i * ) p );
+    __m256i m = _mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '"' ) ),
+                                 _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\\' ) ) );
+
+    /* A signed comparison also catches bytes 0x80 to 0xFF. */
+    m = _mm256_or_si256( m, _mm256_cmpgt_epi8( _mm256_set1_epi8( ' ' ), v ) );
+
+    return ( uint64_t ) ( uint32_t ) _mm256_movemask_epi8( m );
+}
+
+static uint64_t spaceStops( const char * p )
+{
+    __m256i v = _mm256_loadu_si256( ( const __m256i * ) p );
+    __m256i m = _mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( ' ' ) ),
+                                 _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\t' ) ) );
+
+    m = _mm256_or_si256( m, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\n' ) ) );
+    m = _mm256_or_si256( m, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\r' ) ) );
+
+    return ( uint64_t ) ( ~( uint32_t ) _mm256_movemask_epi8( m ) );
+}
+
+    #elif defined( JSON_SIMD_SSE2 )
+
+static uint64_t stringStops( const char * p )
+{
+    __m128i v = _mm_loadu_si128( ( const __m128i * ) p );
+    __m128i m = _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( '"' ) ),
+                              _mm_cmpeq_epi8( v, _mm_set1_epi8( '\\' ) ) );
+
+    /* A signed comparison also catches bytes 0x80 to 0xFF. */
+    m = _mm_or_si128( m, _mm_cmplt_epi8( v, _mm_set1_epi8( ' ' ) ) );
+
+    return ( uint64_t ) ( uint32_t ) _mm_movemask_epi8( m );
+}
+
+static uint64_t spaceStops( const char * p )
+{
+    __m128i v = _mm_loadu_si128( ( const __m128i * ) p );
+    __m128i m = _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( ' ' ) ),
+                              _mm_cmpeq_epi8( v, _mm_set1_epi8( '\t' ) ) );
+
+    m = _mm_or_si128( m, _mm_cmpeq_epi8( v, _mm_set1_epi8( '\n' ) ) );
+    m = _mm_or_si128( m, _mm_cmpeq_epi8( v, _mm_set1_epi8( '\r' ) ) );
+
+    return ( uint64_t ) ( ( ~( uint32_t ) _mm_movemask_epi8( m ) ) & 0xFFFFU );
+}
+
+    #else /* JSON_SIMD_NEON */
+
+/* NEON has no movemask, so narrow each byte of the comparison to a nibble. */
+static uint64_t neonMask( uint8x16_t m )
+{
+    uint8x8_t n = vshrn_n_u16( vreinterpretq_u16_u8( m ), 4 );
+
+    return vget_lane_u64( vreinterpret_u64_u8( n ), 0 );
+}
+
+static uint64_t stringStops( const char * p )
+{
+    uint8x16_t v = vld1q_u8( ( const uint8_t * ) p );
+    uint8x16_t m = vorrq_u8( vceqq_u8( v, vdupq_n_u8( ( uint8_t ) '"' ) ),
+                             vceqq_u8( v, vdupq_n_u8( ( uint8_t ) '\\' ) ) );
+
+    /* A signed comparison also catches bytes 0x80 to 0xFF. */
+    m = vorrq_u8( m, vcltq_s8( vreinterpretq_s8_u8( v ), vdupq_n_s8( ( int8_t ) ' ' ) ) );
+
+    return neonMask( m );
+}
+
+static uint64_t spaceStops( const char * p )
+{
+    uint8x16_t v = vld1q_u8( ( const uint8_t * ) p );
+    uint8x16_t m = vorrq_u8( vceqq_u8( v, vdupq_n_u8( ( uint8_t ) ' ' ) ),
+                             vceqq_u8( v, vdupq_n_u8( ( uint8_t ) '\t' ) ) );
+
+    m = vorrq_u8( m, vceqq_u8( v, vdupq_n_u8( ( uint8_t ) '\n' ) ) );
+    m = vorrq_u8( m, vceqq_u8( v, vdupq_n_u8( ( uint8_t ) '\r' ) ) );
+
+    return neonMask( vmvnq_u8( m ) );
+}
+
+    #endif /* if defined( JSON_SIMD_AVX2 ) */
+
+/**
+ * @brief Count the trailing zero bits of a non-zero mask.
+ */
+static size_t countTrailingZeros( uint64_t mask )
+{
+    size_t n = 0;
+
+    assert( mask != 0U );
+
+    #if defined( __GNUC__ )
+        n = ( size_t ) __builtin_ctzll( mask );
+    #else
+        while( ( mask & ( ( uint64_t ) 1U << n ) ) == 0U )
+        {
+            n++;
+        }
+    #endif
+
+    return n;
+}
+
+#endif /* ifdef JSON_SIMD_WIDTH */
+
+/**
+ * @brief Advance buffer index beyond whole blocks of bytes that do not
+ * stop a scan, and onto the first byte that does.
+ *
+ * The index is left below max, so the caller may inspect buf[ *start ]
+ * whenever it could before.  Without vector instructions this does nothing.
+ *
+ * @param[in] buf  The buffer to parse.
+ * @param[in,out] start  The index at which to begin.
+ * @param[in] max  The size of the buffer.
+ * @param[in] string  true to skip string contents, false to skip whitespace.
+ */
+static void skipBlocks( const char * buf,
+                        size_t * start,
+                        size_t max,
+                        bool_ string )
+{
+    assert( ( buf != NULL ) && ( start != NULL ) && ( *start <= max ) );
+
+    #ifdef JSON_SIMD_WIDTH
+    {
+        size_t i = *start;
+        uint64_t mask = 0U;
+
+        while( ( mask == 0U ) && ( ( max - i ) > JSON_SIMD_WIDTH ) )
+        {
+            mask = ( string == true ) ? stringStops( &buf[ i ] ) : spaceStops( &buf[ i ] );
+
+            if( mask == 0U )
+            {
+                i += JSON_SIMD_WIDTH;
+            }
+            else
+            {
+                i += countTrailingZeros( mask ) / JSON_SIMD_BITS_PER_BYTE;
+            }
+        }
+
+        *start = i;
+    }
+    #else
+        ( void ) buf;
+        ( void ) start;
+        ( void ) max;
+        ( void ) string;
+    #endif
+}
+
 /**
  * @brief Advance buffer index beyond whitespace.
  *
@@ -74,7 +269,15 @@ static void skipSpace( const char * buf,
 
     assert( ( buf != NULL ) && ( start != NULL ) && ( max > 0U ) );
 
-    for( i = *start; i < max; i++ )
+    i = *start;
+
+    /* Runs of indentation are worth a vector scan; single spaces are not. */
+    if( ( ( i + 1U ) < max ) && isspace_( buf[ i ] ) && isspace_( buf[ i + 1U ] ) )
+    {
+        skipBlocks( buf, &i, max, false );
+    }
+
+    for( ; i < max; i++ )
     {
         if( !isspace_( buf[ i ] ) )
         {
@@ -195,9 +398,9 @@ static bool_ skipUTF8MultiByte( const char * buf,
 
     i = *start;
     assert( i < max );
-    assert( buf[ i ] < '\0' );
 
     c.c = buf[ i ];
+    assert( c.u > 0x7FU );
 
     if( ( c.u > 0xC1U ) && ( c.u < 0xF5U ) )
     {
@@ -251,13 +454,16 @@ static bool_ skipUTF8( const char * buf,
                        size_t max )
 {
     bool_ ret = false;
+    char_ c;
 
     assert( ( buf != NULL ) && ( start != NULL ) && ( max > 0U ) );
 
     if( *start < max )
     {
-        /* an ASCII byte */
-        if( buf[ *start ] >= '\0' )
+        c.c = buf[ *start ];
+
+        /* an ASCII byte, whether char is signed or unsigned */
+        if( c.u < 0x80U )
         {
             *start += 1U;
             ret = true;
@@ -518,6 +724,8 @@ static bool_ skipString( const char * buf,
 
         while( i < max )
         {
+            skipBlocks( buf, &i, max, true );
+
             if( buf[ i ] == '"' )
             {
                 ret = true;
@@ -1038,9 +1246,6 @@ static void skipScalars( const char * buf,
  * #JSONMaxDepthExceeded if object and array nesting exceeds a threshold;
  * #JSONPartial if the buffer contents are potentially valid but incomplete.
  */
-#ifndef JSON_MAX_DEPTH
-    #define JSON_MAX_DEPTH    32
-#endif
 static JSONStatus_t skipCollection( const char * buf,
                                     size_t * start,
                                     size_t max )
@@ -1218,36 +1423,31 @@ static bool_ nextValue( const char * buf,
 }
 
 /**
- * @brief Output indexes for the next key-value pair of an object.
+ * @brief Output indexes for an object key.
  *
- * Also advances the buffer index beyond the key-value pair.
- * The value may be a scalar or a collection.
+ * Also advances the buffer index beyond the key, the colon,
+ * and surrounding whitespace.
  *
  * @param[in] buf  The buffer to parse.
  * @param[in,out] start  The index at which to begin.
  * @param[in] max  The size of the buffer.
  * @param[out] key  A pointer to receive the index of the key.
  * @param[out] keyLength  A pointer to receive the length of the key.
- * @param[out] value  A pointer to receive the index of the value.
- * @param[out] valueLength  A pointer to receive the length of the value.
  *
- * @return true if a key-value pair was present;
+ * @return true if a key and colon were present;
  * false otherwise.
  */
-static bool_ nextKeyValuePair( const char * buf,
-                               size_t * start,
-                               size_t max,
-                               size_t * key,
-                               size_t * keyLength,
-                               size_t * value,
-                               size_t * valueLength )
+static bool_ skipKey( const char * buf,
+                      size_t * start,
+                      size_t max,
+                      size_t * key,
+                      size_t * keyLength )
 {
     bool_ ret = true;
     size_t i, keyStart;
 
     assert( ( buf != NULL ) && ( start != NULL ) && ( max > 0U ) );
     assert( ( key != NULL ) && ( keyLength != NULL ) );
-    assert( ( value != NULL ) && ( valueLength != NULL ) );
 
     i = *start;
     keyStart = i;
@@ -1277,6 +1477,50 @@ static bool_ nextKeyValuePair( const char * buf,
         }
     }
 
+    if( ret == true )
+    {
+        *start = i;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Output indexes for the next key-value pair of an object.
+ *
+ * Also advances the buffer index beyond the key-value pair.
+ * The value may be a scalar or a collection.
+ *
+ * @param[in] buf  The buffer to parse.
+ * @param[in,out] start  The index at which to begin.
+ * @param[in] max  The size of the buffer.
+ * @param[out] key  A pointer to receive the index of the key.
+ * @param[out] keyLength  A pointer to receive the length of the key.
+ * @param[out] value  A pointer to receive the index of the value.
+ * @param[out] valueLength  A pointer to receive the length of the value.
+ *
+ * @return true if a key-value pair was present;
+ * false otherwise.
+ */
+static bool_ nextKeyValuePair( const char * buf,
+                               size_t * start,
+                               size_t max,
+                               size_t * key,
+                               size_t * keyLength,
+                               size_t * value,
+                               size_t * valueLength )
+{
+    bool_ ret;
+    size_t i;
+
+    assert( ( buf != NULL ) && ( start != NULL ) && ( max > 0U ) );
+    assert( ( key != NULL ) && ( keyLength != NULL ) );
+    assert( ( value != NULL ) && ( valueLength != NULL ) );
+
+    i = *start;
+
+    ret = skipKey( buf, &i, max, key, keyLength );
+
     if( ret == true )
     {
         ret = nextValue( buf, &i, max, value, valueLength );
@@ -1472,6 +1716,89 @@ static bool_ skipQueryPart( const char * buf,
     return ret;
 }
 
+/**
+ * @brief Parse the next part of a query.
+ *
+ * A part is either an array index in square brackets or an object key.
+ * A separator following the part is also consumed.
+ *
+ * @param[in] query  The object keys and array indexes to search for.
+ * @param[in,out] start  The index at which to begin.
+ * @param[in] queryLength  Length of the key.
+ * @param[out] isIndex  A pointer to receive whether the part is an array index.
+ * @param[out] key  A pointer to receive the index of the key in the query.
+ * @param[out] keyLength  A pointer to receive the length of the key.
+ * @param[out] queryIndex  A pointer to receive the array index.
+ *
+ * @return #JSONSuccess if a part was parsed;
+ * #JSONBadParameter if the part is empty, or a trailing separator follows it,
+ * or an index is too large to convert.
+ */
+static JSONStatus_t nextQueryPart( const char * query,
+                                   size_t * start,
+                                   size_t queryLength,
+                                   bool_ * isIndex,
+                                   size_t * key,
+                                   size_t * keyLength,
+                                   uint32_t * queryIndex )
+{
+    JSONStatus_t ret = JSONSuccess;
+    size_t i;
+
+    assert( ( query != NULL ) && ( start != NULL ) && ( queryLength > 0U ) );
+    assert( ( isIndex != NULL ) && ( key != NULL ) && ( keyLength != NULL ) );
+    assert( queryIndex != NULL );
+
+    i = *start;
+
+    if( isSquareOpen_( query[ i ] ) )
+    {
+        int32_t value = -1;
+        i++;
+
+        ( void ) skipDigits( query, &i, queryLength, &value );
+
+        if( ( value < 0 ) ||
+            ( i >= queryLength ) || !isSquareClose_( query[ i ] ) )
+        {
+            ret = JSONBadParameter;
+        }
+        else
+        {
+            i++;
+            *isIndex = true;
+            *queryIndex = ( uint32_t ) value;
+        }
+    }
+    else
+    {
+        *key = i;
+
+        if( ( skipQueryPart( query, &i, queryLength, keyLength ) != true ) ||
+            /* catch an empty key part or a trailing separator */
+            ( i == ( queryLength - 1U ) ) )
+        {
+            ret = JSONBadParameter;
+        }
+        else
+        {
+            *isIndex = false;
+        }
+    }
+
+    if( ret == JSONSuccess )
+    {
+        if( ( i < queryLength ) && isSeparator_( query[ i ] ) )
+        {
+            i++;
+        }
+
+        *start = i;
+    }
+
+    return ret;
+}
+
 /**
  * @brief Handle a nested search by iterating over the parts of the query.
  *
@@ -1497,7 +1824,9 @@ static JSONStatus_t multiSearch( char * buf,
                                  size_t * outValueLength )
 {
     JSONStatus_t ret = JSONSuccess;
-    size_t i = 0, start = 0;
+    size_t i = 0, key = 0, keyLength = 0;
+    uint32_t queryIndex = 0;
+    bool_ isIndex = false, found;
     char * p = buf;
     size_t tmp = max;
 
@@ -1507,41 +1836,21 @@ static JSONStatus_t multiSearch( char * buf,
 
     while( i < queryLength )
     {
-        bool_ found = false;
+        ret = nextQueryPart( query, &i, queryLength, &isIndex,
+                             &key, &keyLength, &queryIndex );
 
-        if( isSquareOpen_( query[ i ] ) )
+        if( ret != JSONSuccess )
         {
-            int32_t queryIndex = -1;
-            i++;
-
-            ( void ) skipDigits( query, &i, queryLength, &queryIndex );
-
-            if( ( queryIndex < 0 ) ||
-                ( i >= queryLength ) || !isSquareClose_( query[ i ] ) )
-            {
-                ret = JSONBadParameter;
-                break;
-            }
-
-            i++;
+            break;
+        }
 
-            found = arraySearch( p, tmp, ( uint32_t ) queryIndex, &p, &tmp );
+        if( isIndex == true )
+        {
+            found = arraySearch( p, tmp, queryIndex, &p, &tmp );
         }
         else
         {
-            size_t keyLength = 0;
-
-            start = i;
-
-            if( ( skipQueryPart( query, &i, queryLength, &keyLength ) != true ) ||
-                /* catch an empty key part or a trailing separator */
-                ( i == ( queryLength - 1U ) ) )
-            {
-                ret = JSONBadParameter;
-                break;
-            }
-
-            found = objectSearch( p, tmp, &query[ start ], keyLength, &p, &tmp );
+            found = objectSearch( p, tmp, &query[ key ], keyLength, &p, &tmp );
         }
 
         if( found == false )
@@ -1549,11 +1858,6 @@ static JSONStatus_t multiSearch( char * buf,
             ret = JSONNotFound;
             break;
         }
-
-        if( ( i < queryLength ) && isSeparator_( query[ i ] ) )
-        {
-            i++;
-        }
     }
 
     if( ret == JSONSuccess )
@@ -1606,3 +1910,2877 @@ JSONStatus_t JSON_Search( char * buf,
 
     return ret;
 }
+
+/**
+ * See core_json.h for docs.
+ */
+JSONStatus_t JSON_CompileQuery( const char * query,
+                                size_t queryLength,
+                                JSONQueryStep_t * steps,
+                                size_t stepCapacity,
+                                size_t * outStepCount )
+{
+    JSONStatus_t ret = JSONSuccess;
+    size_t i = 0, count = 0, key = 0, keyLength = 0;
+    uint32_t queryIndex = 0;
+    bool_ isIndex = false;
+
+    if( ( query == NULL ) || ( outStepCount == NULL ) ||
+        ( ( steps == NULL ) && ( stepCapacity > 0U ) ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else if( queryLength == 0U )
+    {
+        ret = JSONBadParameter;
+    }
+    else
+    {
+        while( i < queryLength )
+        {
+            ret = nextQueryPart( query, &i, queryLength, &isIndex,
+                                 &key, &keyLength, &queryIndex );
+
+            if( ret != JSONSuccess )
+            {
+                break;
+            }
+
+            /* Keep counting past the capacity to report the size needed. */
+            if( count < stepCapacity )
+            {
+                if( isIndex == true )
+                {
+                    steps[ count ].type = JSONArray;
+                    steps[ count ].key = NULL;
+                    steps[ count ].keyLength = 0U;
+                    steps[ count ].index = queryIndex;
+                }
+                else
+                {
+                    steps[ count ].type = JSONObject;
+                    steps[ count ].key = &query[ key ];
+                    steps[ count ].keyLength = keyLength;
+                    steps[ count ].index = 0U;
+                }
+            }
+
+            count++;
+        }
+
+        if( ( ret == JSONSuccess ) && ( count > stepCapacity ) )
+        {
+            ret = JSONInsufficientMemory;
+        }
+
+        if( ( ret == JSONSuccess ) || ( ret == JSONInsufficientMemory ) )
+        {
+            *outStepCount = count;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json.h for docs.
+ */
+JSONStatus_t JSON_SearchCompiled( char * buf,
+                                  size_t max,
+                                  const JSONQueryStep_t * steps,
+                                  size_t stepCount,
+                                  char ** outValue,
+                                  size_t * outValueLength )
+{
+    JSONStatus_t ret = JSONSuccess;
+    size_t s;
+    bool_ found = true;
+    char * p = buf;
+    size_t tmp = max;
+
+    if( ( buf == NULL ) || ( steps == NULL ) ||
+        ( outValue == NULL ) || ( outValueLength == NULL ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else if( ( max == 0U ) || ( stepCount == 0U ) )
+    {
+        ret = JSONBadParameter;
+    }
+    else
+    {
+        for( s = 0U; s < stepCount; s++ )
+        {
+            if( steps[ s ].type == JSONArray )
+            {
+                found = arraySearch( p, tmp, steps[ s ].index, &p, &tmp );
+            }
+            else if( ( steps[ s ].type == JSONObject ) && ( steps[ s ].key != NULL ) )
+            {
+                found = objectSearch( p, tmp, steps[ s ].key, steps[ s ].keyLength, &p, &tmp );
+            }
+            else
+            {
+                ret = JSONBadParameter;
+                break;
+            }
+
+            if( found == false )
+            {
+                ret = JSONNotFound;
+                break;
+            }
+        }
+    }
+
+    if( ret == JSONSuccess )
+    {
+        *outValue = p;
+        *outValueLength = tmp;
+
+        /* As for JSON_Search(), strip the quotes of a string value. */
+        if( *outValue[ 0 ] == '"' )
+        {
+            ( *outValue )++;
+            *outValueLength -= 2U;
+        }
+    }
+
+    return ret;
+}
+
+/** @cond DO_NOT_DOCUMENT */
+
+/**
+ * @brief The token expected next while building an index.
+ */
+typedef enum
+{
+    expectValue = 0, /* at the root, after '[' or ':', or after ',' in an array */
+    expectKey,       /* after '{', or after ',' in an object */
+    expectSeparator  /* after a value, a ',' or closing bracket */
+} indexState_t;
+
+/**
+ * @brief Working state of JSON_BuildIndex().
+ *
+ * Entries beyond the capacity of the index are counted but not stored,
+ * so that the required capacity can be reported.
+ */
+typedef struct
+{
+    JSONIndexEntry_t * index;
+    size_t capacity;
+    size_t count;
+    size_t entries[ JSON_MAX_DEPTH ]; /* entry of each open collection */
+    size_t offsets[ JSON_MAX_DEPTH ]; /* offset of each open collection */
+    int16_t depth;
+    size_t previous;                  /* last value in the innermost collection */
+    size_t key;
+    size_t keyLength;
+} indexBuilder_t;
+
+/**
+ * @brief Advance buffer index beyond a scalar value and output its type.
+ *
+ * @param[in] buf  The buffer to parse.
+ * @param[in,out] start  The index at which to begin.
+ * @param[in] max  The size of the buffer.
+ *
+ * @return the type of the scalar value;
+ * #JSONInvalid if a scalar value was not present.
+ */
+static JSONTypes_t skipTypedScalar( const char * buf,
+                                    size_t * start,
+                                    size_t max )
+{
+    JSONTypes_t ret = JSONInvalid;
+    size_t i;
+
+    assert( ( buf != NULL ) && ( start != NULL ) && ( max > 0U ) );
+
+    i = *start;
+
+    if( i < max )
+    {
+        switch( buf[ i ] )
+        {
+            case '"':
+                ret = ( skipString( buf, &i, max ) == true ) ? JSONString : JSONInvalid;
+                break;
+
+            case 't':
+                ret = ( skipLiteral( buf, &i, max, "true", 4U ) == true ) ? JSONTrue : JSONInvalid;
+                break;
+
+            case 'f':
+                ret = ( skipLiteral( buf, &i, max, "false", 5U ) == true ) ? JSONFalse : JSONInvalid;
+                break;
+
+            case 'n':
+                ret = ( skipLiteral( buf, &i, max, "null", 4U ) == true ) ? JSONNull : JSONInvalid;
+                break;
+
+            default:
+                ret = ( skipNumber( buf, &i, max ) == true ) ? JSONNumber : JSONInvalid;
+                break;
+        }
+    }
+
+    if( ret != JSONInvalid )
+    {
+        *start = i;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Append an entry to the index and link it to its previous sibling.
+ *
+ * The pending key, if any, is attributed to the new entry.
+ *
+ * @param[in,out] b  The index builder.
+ * @param[in] type  The type of the value.
+ * @param[in] offset  The offset of the value in the buffer.
+ *
+ * @return the number of the new entry.
+ */
+static size_t addIndexEntry( indexBuilder_t * b,
+                             JSONTypes_t type,
+                             size_t offset )
+{
+    size_t entry;
+
+    assert( b != NULL );
+
+    entry = b->count;
+
+    if( entry < b->capacity )
+    {
+        b->index[ entry ].type = type;
+        b->index[ entry ].offset = offset;
+        b->index[ entry ].length = 0U;
+        b->index[ entry ].key = b->key;
+        b->index[ entry ].keyLength = b->keyLength;
+        b->index[ entry ].parent = ( b->depth >= 0 ) ? b->entries[ b->depth ] : JSON_INDEX_NONE;
+        b->index[ entry ].nextSibling = JSON_INDEX_NONE;
+    }
+
+    if( b->previous < b->capacity )
+    {
+        b->index[ b->previous ].nextSibling = entry;
+    }
+
+    b->count++;
+    b->key = 0U;
+    b->keyLength = 0U;
+
+    return entry;
+}
+
+/**
+ * @brief Record the length of a completed value.
+ *
+ * The value becomes the previous sibling of the next value
+ * in the same collection.
+ *
+ * @param[in,out] b  The index builder.
+ * @param[in] entry  The number of the entry.
+ * @param[in] length  The length of the value.
+ */
+static void endIndexEntry( indexBuilder_t * b,
+                           size_t entry,
+                           size_t length )
+{
+    assert( b != NULL );
+
+    if( entry < b->capacity )
+    {
+        b->index[ entry ].length = length;
+    }
+
+    b->previous = entry;
+}
+
+/**
+ * @brief Index an object key and advance beyond it and the colon.
+ *
+ * @param[in] buf  The buffer to parse.
+ * @param[in,out] start  The index at which to begin.
+ * @param[in] max  The size of the buffer.
+ * @param[in,out] b  The index builder.
+ *
+ * @return #JSONPartial if the key was present;
+ * #JSONIllegalDocument otherwise.
+ */
+static JSONStatus_t indexKey( const char * buf,
+                              size_t * start,
+                              size_t max,
+                              indexBuilder_t * b )
+{
+    JSONStatus_t ret = JSONPartial;
+    size_t i;
+
+    assert( ( buf != NULL ) && ( start != NULL ) && ( max > 0U ) );
+    assert( b != NULL );
+
+    i = *start;
+
+    if( skipString( buf, &i, max ) != true )
+    {
+        ret = JSONIllegalDocument;
+    }
+    else
+    {
+        b->key = *start + 1U;
+        b->keyLength = i - *start - 2U;
+
+        skipSpace( buf, &i, max );
+
+        if( i < max )
+        {
+            if( buf[ i ] == ':' )
+            {
+                i++;
+            }
+            else
+            {
+                ret = JSONIllegalDocument;
+            }
+        }
+
+        *start = i;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Index a value and advance beyond it.
+ *
+ * A scalar or an empty collection is indexed completely.  Otherwise the
+ * opening bracket of a collection is consumed and the collection is pushed.
+ *
+ * @param[in] buf  The buffer to parse.
+ * @param[in,out] start  The index at which to begin.
+ * @param[in] max  The size of the buffer.
+ * @param[in,out] b  The index builder.
+ * @param[out] state  A pointer to receive the token expected next.
+ *
+ * @return #JSONPartial if the value was present;
+ * #JSONIllegalDocument if it was not;
+ * #JSONMaxDepthExceeded if object and array nesting exceeds a threshold.
+ */
+static JSONStatus_t indexValue( const char * buf,
+                                size_t * start,
+                                size_t max,
+                                indexBuilder_t * b,
+                                indexState_t * state )
+{
+    JSONStatus_t ret = JSONPartial;
+    JSONTypes_t type;
+    size_t i, entry;
+    char c;
+
+    assert( ( buf != NULL ) && ( start != NULL ) && ( max > 0U ) );
+    assert( ( b != NULL ) && ( state != NULL ) );
+
+    i = *start;
+    c = buf[ i ];
+
+    if( isOpenBracket_( c ) )
+    {
+        if( b->depth == ( JSON_MAX_DEPTH - 1 ) )
+        {
+            ret = JSONMaxDepthExceeded;
+        }
+        else
+        {
+            entry = addIndexEntry( b, ( c == '{' ) ? JSONObject : JSONArray, i );
+            i++;
+            skipSpace( buf, &i, max );
+
+            if( ( i < max ) && isMatchingBracket_( c, buf[ i ] ) )
+            {
+                i++;
+                endIndexEntry( b, entry, i - *start );
+                *state = expectSeparator;
+            }
+            else
+            {
+                b->depth++;
+                b->entries[ b->depth ] = entry;
+                b->offsets[ b->depth ] = *start;
+                b->previous = JSON_INDEX_NONE;
+                *state = ( c == '{' ) ? expectKey : expectValue;
+            }
+        }
+    }
+    else
+    {
+        type = skipTypedScalar( buf, &i, max );
+
+        if( type == JSONInvalid )
+        {
+            ret = JSONIllegalDocument;
+        }
+        else
+        {
+            entry = addIndexEntry( b, type, *start );
+            endIndexEntry( b, entry, i - *start );
+            *state = expectSeparator;
+        }
+    }
+
+    *start = i;
+
+    return ret;
+}
+
+/**
+ * @brief Advance buffer index beyond a comma or the closing bracket
+ * of the innermost collection.
+ *
+ * @param[in] buf  The buffer to parse.
+ * @param[in,out] start  The index at which to begin, within the buffer.
+ * @param[in,out] b  The index builder.
+ * @param[out] state  A pointer to receive the token expected next.
+ *
+ * @return #JSONPartial if a comma or matching bracket was present;
+ * #JSONIllegalDocument otherwise.
+ */
+static JSONStatus_t indexSeparator( const char * buf,
+                                    size_t * start,
+                                    indexBuilder_t * b,
+                                    indexState_t * state )
+{
+    JSONStatus_t ret = JSONPartial;
+    size_t i, offset;
+    char mode;
+
+    assert( ( buf != NULL ) && ( start != NULL ) );
+    assert( ( b != NULL ) && ( state != NULL ) && ( b->depth >= 0 ) );
+
+    i = *start;
+    offset = b->offsets[ b->depth ];
+    mode = buf[ offset ];
+
+    if( buf[ i ] == ',' )
+    {
+        i++;
+        *state = ( mode == '{' ) ? expectKey : expectValue;
+    }
+    else if( isMatchingBracket_( mode, buf[ i ] ) )
+    {
+        i++;
+        endIndexEntry( b, b->entries[ b->depth ], i - offset );
+        b->depth--;
+    }
+    else
+    {
+        ret = JSONIllegalDocument;
+    }
+
+    *start = i;
+
+    return ret;
+}
+
+/**
+ * @brief Validate a buffer and record its values in one pass.
+ *
+ * @param[in] buf  The buffer to parse.
+ * @param[in] max  The size of the buffer.
+ * @param[in,out] b  The index builder.
+ *
+ * @return #JSONSuccess if the buffer contents are valid JSON;
+ * #JSONIllegalDocument if the buffer contents are NOT valid JSON;
+ * #JSONMaxDepthExceeded if object and array nesting exceeds a threshold;
+ * #JSONPartial if the buffer contents are potentially valid but incomplete.
+ */
+static JSONStatus_t buildIndex( const char * buf,
+                                size_t max,
+                                indexBuilder_t * b )
+{
+    JSONStatus_t ret = JSONPartial;
+    indexState_t state = expectValue;
+    size_t i = 0;
+    bool_ dangling = false;
+
+    assert( ( buf != NULL ) && ( max > 0U ) && ( b != NULL ) );
+
+    skipSpace( buf, &i, max );
+
+    #ifdef JSON_VALIDATE_COLLECTIONS_ONLY
+        if( ( i < max ) && !isOpenBracket_( buf[ i ] ) )
+        {
+            ret = JSONIllegalDocument;
+        }
+    #endif
+
+    while( ( ret == JSONPartial ) && ( i < max ) )
+    {
+        if( state == expectKey )
+        {
+            ret = indexKey( buf, &i, max, b );
+            state = expectValue;
+            dangling = true;
+        }
+        else if( state == expectValue )
+        {
+            ret = indexValue( buf, &i, max, b, &state );
+            dangling = false;
+        }
+        else
+        {
+            ret = indexSeparator( buf, &i, b, &state );
+            /* A comma leaves a key or value to come; a bracket does not. */
+            dangling = ( state != expectSeparator ) ? true : false;
+        }
+
+        if( ret == JSONPartial )
+        {
+            skipSpace( buf, &i, max );
+
+            if( ( state == expectSeparator ) && ( b->depth < 0 ) )
+            {
+                ret = ( i == max ) ? JSONSuccess : JSONIllegalDocument;
+            }
+        }
+    }
+
+    /* As JSON_Validate() does, reject a document that ends after a comma,
+     * a key or a colon, rather than report it as partial. */
+    if( ( ret == JSONPartial ) && ( dangling == true ) )
+    {
+        ret = JSONIllegalDocument;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Output the first child of an indexed collection.
+ *
+ * @param[in] index  The index to search.
+ * @param[in] indexCount  The number of entries in the index.
+ * @param[in] entry  The entry of the collection.
+ *
+ * @return the entry of the first child;
+ * #JSON_INDEX_NONE if the collection is empty.
+ */
+static size_t firstChild( const JSONIndexEntry_t * index,
+                          size_t indexCount,
+                          size_t entry )
+{
+    size_t ret = JSON_INDEX_NONE;
+
+    assert( ( index != NULL ) && ( entry < indexCount ) );
+
+    if( ( ( entry + 1U ) < indexCount ) && ( index[ entry + 1U ].parent == entry ) )
+    {
+        ret = entry + 1U;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Find a key in an indexed object.
+ *
+ * @param[in] buf  The buffer that was indexed.
+ * @param[in] index  The index to search.
+ * @param[in] indexCount  The number of entries in the index.
+ * @param[in] entry  The entry of the object.
+ * @param[in] query  The key to search for.
+ * @param[in] queryLength  Length of the key.
+ *
+ * @return the entry of the value;
+ * #JSON_INDEX_NONE if the entry is not an object or the key is not present.
+ */
+static size_t indexObjectSearch( const char * buf,
+                                 const JSONIndexEntry_t * index,
+                                 size_t indexCount,
+                                 size_t entry,
+                                 const char * query,
+                                 size_t queryLength )
+{
+    size_t child = JSON_INDEX_NONE;
+
+    assert( ( buf != NULL ) && ( index != NULL ) && ( query != NULL ) );
+
+    if( index[ entry ].type == JSONObject )
+    {
+        child = firstChild( index, indexCount, entry );
+
+        while( child < indexCount )
+        {
+            if( ( queryLength == index[ child ].keyLength ) &&
+                ( strnEq( query, &buf[ index[ child ].key ], queryLength ) == true ) )
+            {
+                break;
+            }
+
+            child = index[ child ].nextSibling;
+        }
+    }
+
+    return ( child < indexCount ) ? child : JSON_INDEX_NONE;
+}
+
+/**
+ * @brief Find an index in an indexed array.
+ *
+ * @param[in] index  The index to search.
+ * @param[in] indexCount  The number of entries in the index.
+ * @param[in] entry  The entry of the array.
+ * @param[in] queryIndex  The array index to search for.
+ *
+ * @return the entry of the value;
+ * #JSON_INDEX_NONE if the entry is not an array or is too short.
+ */
+static size_t indexArraySearch( const JSONIndexEntry_t * index,
+                                size_t indexCount,
+                                size_t entry,
+                                uint32_t queryIndex )
+{
+    size_t child = JSON_INDEX_NONE;
+    uint32_t currentIndex = 0;
+
+    assert( index != NULL );
+
+    if( index[ entry ].type == JSONArray )
+    {
+        child = firstChild( index, indexCount, entry );
+
+        while( ( child < indexCount ) && ( currentIndex < queryIndex ) )
+        {
+            child = index[ child ].nextSibling;
+            currentIndex++;
+        }
+    }
+
+    return ( child < indexCount ) ? child : JSON_INDEX_NONE;
+}
+
+/**
+ * @brief Resolve a query by walking an index.
+ *
+ * @param[in] buf  The buffer that was indexed.
+ * @param[in] index  The index to search.
+ * @param[in] indexCount  The number of entries in the index.
+ * @param[in] query  The object keys and array indexes to search for.
+ * @param[in] queryLength  Length of the key.
+ * @param[out] outEntry  A pointer to receive the entry of the value found.
+ *
+ * @return #JSONSuccess if the query is matched and the entry output;
+ * #JSONBadParameter if the query is empty, or any part is empty,
+ * or an index is too large to convert;
+ * #JSONNotFound if the query is NOT found.
+ */
+static JSONStatus_t indexSearch( const char * buf,
+                                 const JSONIndexEntry_t * index,
+                                 size_t indexCount,
+                                 const char * query,
+                                 size_t queryLength,
+                                 size_t * outEntry )
+{
+    JSONStatus_t ret = JSONSuccess;
+    size_t i = 0, entry = 0, key = 0, keyLength = 0;
+    uint32_t queryIndex = 0;
+    bool_ isIndex = false;
+
+    assert( ( buf != NULL ) && ( index != NULL ) && ( query != NULL ) );
+    assert( ( indexCount > 0U ) && ( queryLength > 0U ) && ( outEntry != NULL ) );
+
+    while( i < queryLength )
+    {
+        ret = nextQueryPart( query, &i, queryLength, &isIndex,
+                             &key, &keyLength, &queryIndex );
+
+        if( ret != JSONSuccess )
+        {
+            break;
+        }
+
+        if( isIndex == true )
+        {
+            entry = indexArraySearch( index, indexCount, entry, queryIndex );
+        }
+        else
+        {
+            entry = indexObjectSearch( buf, index, indexCount, entry,
+                                       &query[ key ], keyLength );
+        }
+
+        if( entry == JSON_INDEX_NONE )
+        {
+            ret = JSONNotFound;
+            break;
+        }
+    }
+
+    if( ret == JSONSuccess )
+    {
+        *outEntry = entry;
+    }
+
+    return ret;
+}
+
+/** @endcond */
+
+/**
+ * See core_json.h for docs.
+ */
+JSONStatus_t JSON_BuildIndex( const char * buf,
+                              size_t max,
+                              JSONIndexEntry_t * index,
+                              size_t indexCapacity,
+                              size_t * outCount )
+{
+    JSONStatus_t ret;
+    indexBuilder_t b;
+
+    if( ( buf == NULL ) || ( outCount == NULL ) ||
+        ( ( index == NULL ) && ( indexCapacity > 0U ) ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else if( max == 0U )
+    {
+        ret = JSONBadParameter;
+    }
+    else
+    {
+        b.index = index;
+        b.capacity = indexCapacity;
+        b.count = 0U;
+        b.depth = -1;
+        b.previous = JSON_INDEX_NONE;
+        b.key = 0U;
+        b.keyLength = 0U;
+
+        ret = buildIndex( buf, max, &b );
+
+        if( ( ret == JSONSuccess ) && ( b.count > indexCapacity ) )
+        {
+            ret = JSONInsufficientMemory;
+        }
+
+        if( ( ret == JSONSuccess ) || ( ret == JSONInsufficientMemory ) )
+        {
+            *outCount = b.count;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json.h for docs.
+ */
+JSONStatus_t JSON_SearchIndex( char * buf,
+                               const JSONIndexEntry_t * index,
+                               size_t indexCount,
+                               const char * query,
+                               size_t queryLength,
+                               char ** outValue,
+                               size_t * outValueLength )
+{
+    JSONStatus_t ret;
+    size_t entry = 0;
+
+    if( ( buf == NULL ) || ( index == NULL ) || ( query == NULL ) ||
+        ( outValue == NULL ) || ( outValueLength == NULL ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else if( ( indexCount == 0U ) || ( queryLength == 0U ) )
+    {
+        ret = JSONBadParameter;
+    }
+    else
+    {
+        ret = indexSearch( buf, index, indexCount, query, queryLength, &entry );
+    }
+
+    if( ret == JSONSuccess )
+    {
+        *outValue = &buf[ index[ entry ].offset ];
+        *outValueLength = index[ entry ].length;
+
+        /* As for JSON_Search(), strip the quotes of a string value. */
+        if( index[ entry ].type == JSONString )
+        {
+            ( *outValue )++;
+            *outValueLength -= 2U;
+        }
+    }
+
+    return ret;
+}
+
+/** @cond DO_NOT_DOCUMENT */
+
+/**
+ * @brief Check every query of JSON_SearchMany() and start it at the root.
+ *
+ * @param[in,out] queries  The queries.
+ * @param[in] queryCount  The number of queries.
+ *
+ * @return the number of queries that are well formed.
+ */
+static size_t startQueries( JSONQuery_t * queries,
+                            size_t queryCount )
+{
+    size_t q, i, key, keyLength, pending = 0U;
+    uint32_t queryIndex;
+    bool_ isIndex;
+    JSONStatus_t status;
+
+    assert( queries != NULL );
+
+    for( q = 0U; q < queryCount; q++ )
+    {
+        status = JSONNotFound;
+
+        if( queries[ q ].query == NULL )
+        {
+            status = JSONNullParameter;
+        }
+        else if( queries[ q ].queryLength == 0U )
+        {
+            status = JSONBadParameter;
+        }
+        else
+        {
+            i = 0U;
+
+            while( ( status == JSONNotFound ) && ( i < queries[ q ].queryLength ) )
+            {
+                if( nextQueryPart( queries[ q ].query, &i, queries[ q ].queryLength,
+                                   &isIndex, &key, &keyLength, &queryIndex ) != JSONSuccess )
+                {
+                    status = JSONBadParameter;
+                }
+            }
+        }
+
+        queries[ q ].status = status;
+        queries[ q ].value = NULL;
+        queries[ q ].valueLength = 0U;
+        queries[ q ].next = 0U;
+        queries[ q ].depth = ( status == JSONNotFound ) ? 0 : -1;
+
+        if( status == JSONNotFound )
+        {
+            pending++;
+        }
+    }
+
+    return pending;
+}
+
+/**
+ * @brief Advance the queries waiting at a depth past a collection member
+ * that matches their next part.
+ *
+ * A query whose last part matches is marked #JSONPartial until the extent
+ * of the value is known.
+ *
+ * @param[in] buf  The buffer to search.
+ * @param[in,out] queries  The queries.
+ * @param[in] queryCount  The number of queries.
+ * @param[in] depth  The depth of the collection.
+ * @param[in] isObject  true if the collection is an object.
+ * @param[in] key  The index of the member's key, if isObject.
+ * @param[in] keyLength  The length of the member's key, if isObject.
+ * @param[in] memberIndex  The position of the member in the collection.
+ * @param[in] value  The index of the member's value.
+ *
+ * @return true if a query continues below the member's value;
+ * false otherwise.
+ */
+static bool_ matchMember( char * buf,
+                          JSONQuery_t * queries,
+                          size_t queryCount,
+                          int16_t depth,
+                          bool_ isObject,
+                          size_t key,
+                          size_t keyLength,
+                          uint32_t memberIndex,
+                          size_t value )
+{
+    bool_ ret = false, isIndex = false, matched;
+    size_t q, i, part = 0U, partLength = 0U;
+    uint32_t queryIndex = 0U;
+
+    assert( ( buf != NULL ) && ( queries != NULL ) );
+
+    for( q = 0U; q < queryCount; q++ )
+    {
+        if( ( queries[ q ].status == JSONNotFound ) && ( queries[ q ].depth == depth ) )
+        {
+            i = queries[ q ].next;
+
+            /* The query was checked by startQueries(). */
+            ( void ) nextQueryPart( queries[ q ].query, &i, queries[ q ].queryLength,
+                                    &isIndex, &part, &partLength, &queryIndex );
+
+            if( isObject == true )
+            {
+                matched = ( ( isIndex == false ) && ( partLength == keyLength ) &&
+                            ( strnEq( &queries[ q ].query[ part ], &buf[ key ], keyLength ) == true ) ) ? true : false;
+            }
+            else
+            {
+                matched = ( ( isIndex == true ) && ( queryIndex == memberIndex ) ) ? true : false;
+            }
+
+            if( matched == true )
+            {
+                queries[ q ].next = i;
+                queries[ q ].depth = depth + 1;
+
+                if( i == queries[ q ].queryLength )
+                {
+                    queries[ q ].status = JSONPartial;
+                    queries[ q ].value = &buf[ value ];
+                }
+                else
+                {
+                    ret = true;
+                }
+            }
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Resolve the queries that depend on a value once its extent is known.
+ *
+ * Queries that end at the value receive its length.  Queries still waiting
+ * inside it did not find their next part and can no longer match.
+ *
+ * @param[in,out] queries  The queries.
+ * @param[in] queryCount  The number of queries.
+ * @param[in] depth  The depth of the value's contents.
+ * @param[in] valueLength  The length of the value.
+ *
+ * @return the number of queries resolved.
+ */
+static size_t finishValue( JSONQuery_t * queries,
+                           size_t queryCount,
+                           int16_t depth,
+                           size_t valueLength )
+{
+    size_t q, resolved = 0U;
+
+    assert( queries != NULL );
+
+    for( q = 0U; q < queryCount; q++ )
+    {
+        if( queries[ q ].depth == depth )
+        {
+            if( queries[ q ].status == JSONPartial )
+            {
+                queries[ q ].status = JSONSuccess;
+                queries[ q ].valueLength = valueLength;
+                resolved++;
+            }
+            else if( queries[ q ].status == JSONNotFound )
+            {
+                resolved++;
+            }
+            else
+            {
+                /* Empty else. */
+            }
+
+            queries[ q ].depth = -1;
+        }
+    }
+
+    return resolved;
+}
+
+/**
+ * @brief Count the next member of a collection, if a comma introduces one.
+ *
+ * @param[in] buf  The buffer to parse.
+ * @param[in,out] start  The index at which to begin.
+ * @param[in] max  The size of the buffer.
+ * @param[in,out] memberIndex  The position of the member in the collection.
+ *
+ * @return true if another member follows;
+ * false if the collection should end.
+ */
+static bool_ nextMember( const char * buf,
+                         size_t * start,
+                         size_t max,
+                         uint32_t * memberIndex )
+{
+    bool_ ret = false;
+
+    assert( memberIndex != NULL );
+
+    if( skipSpaceAndComma( buf, start, max ) == true )
+    {
+        ( *memberIndex )++;
+        ret = true;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Enter a collection.
+ *
+ * @param[in] buf  The buffer to parse.
+ * @param[in,out] start  The index of the opening bracket.
+ * @param[in] max  The size of the buffer.
+ *
+ * @return true if the collection has a member;
+ * false if it is empty or incomplete.
+ */
+static bool_ enterCollection( const char * buf,
+                              size_t * start,
+                              size_t max )
+{
+    char c;
+
+    assert( ( buf != NULL ) && ( start != NULL ) && ( *start < max ) );
+
+    c = buf[ *start ];
+    ( *start )++;
+    skipSpace( buf, start, max );
+
+    return ( ( *start < max ) && !isMatchingBracket_( c, buf[ *start ] ) ) ? true : false;
+}
+
+/**
+ * @brief Walk a document once on behalf of all the queries.
+ *
+ * Members of the collections that some query waits in are matched
+ * against the queries; every other value is skipped whole.
+ *
+ * @param[in] buf  The buffer to search.
+ * @param[in] max  size of the buffer.
+ * @param[in,out] queries  The queries.
+ * @param[in] queryCount  The number of queries.
+ * @param[in] pending  The number of queries to resolve.
+ */
+static void searchMany( char * buf,
+                        size_t max,
+                        JSONQuery_t * queries,
+                        size_t queryCount,
+                        size_t pending )
+{
+    size_t starts[ JSON_MAX_DEPTH ];
+    uint32_t counters[ JSON_MAX_DEPTH ];
+    int16_t depth = -1;
+    size_t i = 0, key = 0, keyLength = 0, value, remaining = pending;
+    bool_ ok = false, isObject, expectMember = false;
+
+    assert( ( buf != NULL ) && ( max > 0U ) && ( queries != NULL ) );
+
+    skipSpace( buf, &i, max );
+
+    if( ( i < max ) && isOpenBracket_( buf[ i ] ) )
+    {
+        depth = 0;
+        starts[ 0 ] = i;
+        counters[ 0 ] = 0U;
+        expectMember = enterCollection( buf, &i, max );
+        ok = true;
+    }
+
+    while( ( ok == true ) && ( depth >= 0 ) && ( remaining > 0U ) )
+    {
+        isObject = ( buf[ starts[ depth ] ] == '{' ) ? true : false;
+
+        if( expectMember == false )
+        {
+            if( ( i < max ) && isMatchingBracket_( buf[ starts[ depth ] ], buf[ i ] ) )
+            {
+                /* The end of a collection is the end of a value in its parent. */
+                i++;
+                remaining -= finishValue( queries, queryCount, depth, i - starts[ depth ] );
+                depth--;
+
+                if( depth >= 0 )
+                {
+                    expectMember = nextMember( buf, &i, max, &counters[ depth ] );
+                }
+            }
+            else
+            {
+                ok = false;
+            }
+        }
+        else
+        {
+            if( isObject == true )
+            {
+                ok = skipKey( buf, &i, max, &key, &keyLength );
+            }
+
+            value = i;
+
+            if( ok != true )
+            {
+                /* Empty else. */
+            }
+            else if( ( matchMember( buf, queries, queryCount, depth, isObject, key,
+                                    keyLength, counters[ depth ], value ) == true ) &&
+                     ( i < max ) && isOpenBracket_( buf[ i ] ) &&
+                     ( depth < ( JSON_MAX_DEPTH - 1 ) ) )
+            {
+                depth++;
+                starts[ depth ] = i;
+                counters[ depth ] = 0U;
+                expectMember = enterCollection( buf, &i, max );
+            }
+            else if( ( skipAnyScalar( buf, &i, max ) == true ) ||
+                     ( skipCollection( buf, &i, max ) == JSONSuccess ) )
+            {
+                remaining -= finishValue( queries, queryCount, depth + 1, i - value );
+                expectMember = nextMember( buf, &i, max, &counters[ depth ] );
+            }
+            else
+            {
+                ok = false;
+            }
+        }
+    }
+}
+
+/** @endcond */
+
+/**
+ * See core_json.h for docs.
+ */
+JSONStatus_t JSON_SearchMany( char * buf,
+                              size_t max,
+                              JSONQuery_t * queries,
+                              size_t queryCount )
+{
+    JSONStatus_t ret = JSONSuccess;
+    size_t q, pending;
+
+    if( ( buf == NULL ) || ( queries == NULL ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else if( ( max == 0U ) || ( queryCount == 0U ) )
+    {
+        ret = JSONBadParameter;
+    }
+    else
+    {
+        pending = startQueries( queries, queryCount );
+
+        if( pending > 0U )
+        {
+            searchMany( buf, max, queries, queryCount, pending );
+        }
+
+        for( q = 0U; q < queryCount; q++ )
+        {
+            /* A value left incomplete by an illegal document is not a match. */
+            if( queries[ q ].status == JSONPartial )
+            {
+                queries[ q ].status = JSONNotFound;
+            }
+
+            /* As for JSON_Search(), strip the quotes of a string value. */
+            if( ( queries[ q ].status == JSONSuccess ) && ( queries[ q ].value[ 0 ] == '"' ) )
+            {
+                queries[ q ].value++;
+                queries[ q ].valueLength -= 2U;
+            }
+
+            if( ( ret == JSONSuccess ) && ( queries[ q ].status != JSONSuccess ) )
+            {
+                ret = queries[ q ].status;
+            }
+        }
+    }
+
+    return ret;
+}
+
+/** @cond DO_NOT_DOCUMENT */
+
+/**
+ * @brief Output the type of a value from its first character.
+ *
+ * @param[in] c  The first character of a valid value.
+ *
+ * @return the type of the value.
+ */
+static JSONTypes_t getType( char c )
+{
+    JSONTypes_t t;
+
+    switch( c )
+    {
+        case '"':
+            t = JSONString;
+            break;
+
+        case '{':
+            t = JSONObject;
+            break;
+
+        case '[':
+            t = JSONArray;
+            break;
+
+        case 't':
+            t = JSONTrue;
+            break;
+
+        case 'f':
+            t = JSONFalse;
+            break;
+
+        case 'n':
+            t = JSONNull;
+            break;
+
+        default:
+            t = JSONNumber;
+            break;
+    }
+
+    return t;
+}
+
+/**
+ * @brief Output the next key-value pair or value from a collection.
+ *
+ * @param[in] buf  The buffer to search.
+ * @param[in] max  size of the buffer.
+ * @param[in] start  The index at which the collection begins.
+ * @param[in,out] next  The index at which to seek the next value.
+ * @param[out] key  A pointer to receive the index of the key.
+ * @param[out] keyLength  A pointer to receive the length of the key.
+ * @param[out] value  A pointer to receive the index of the value.
+ * @param[out] valueLength  A pointer to receive the length of the value.
+ *
+ * @return #JSONSuccess if a value is output;
+ * #JSONIllegalDocument if the buffer does not begin with '[' or '{';
+ * #JSONNotFound if there are no further values in the collection.
+ */
+static JSONStatus_t iterate( const char * buf,
+                             size_t max,
+                             size_t start,
+                             size_t * next,
+                             size_t * key,
+                             size_t * keyLength,
+                             size_t * value,
+                             size_t * valueLength )
+{
+    JSONStatus_t ret = JSONNotFound;
+    bool_ found = false;
+
+    assert( ( buf != NULL ) && ( max > 0U ) && ( next != NULL ) );
+    assert( ( key != NULL ) && ( keyLength != NULL ) );
+    assert( ( value != NULL ) && ( valueLength != NULL ) );
+
+    if( start < max )
+    {
+        switch( buf[ start ] )
+        {
+            case '[':
+                found = nextValue( buf, next, max, value, valueLength );
+
+                if( found == true )
+                {
+                    *key = 0;
+                    *keyLength = 0;
+                }
+
+                break;
+
+            case '{':
+                found = nextKeyValuePair( buf, next, max, key, keyLength,
+                                          value, valueLength );
+                break;
+
+            default:
+                ret = JSONIllegalDocument;
+                break;
+        }
+    }
+
+    if( found == true )
+    {
+        ret = JSONSuccess;
+        ( void ) skipSpaceAndComma( buf, next, max );
+    }
+
+    return ret;
+}
+
+/** @endcond */
+
+/**
+ * See core_json.h for docs.
+ */
+JSONStatus_t JSON_Iterate( const char * buf,
+                           size_t max,
+                           size_t * start,
+                           size_t * next,
+                           JSONPair_t * outPair )
+{
+    JSONStatus_t ret;
+    size_t key = 0, keyLength = 0, value = 0, valueLength = 0;
+
+    if( ( buf == NULL ) || ( start == NULL ) || ( next == NULL ) ||
+        ( outPair == NULL ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else if( ( max == 0U ) || ( *start >= max ) || ( *next > max ) )
+    {
+        ret = JSONBadParameter;
+    }
+    else
+    {
+        skipSpace( buf, start, max );
+
+        /* On the first call, step inside the collection. */
+        if( *next <= *start )
+        {
+            *next = *start + 1U;
+            skipSpace( buf, next, max );
+        }
+
+        ret = iterate( buf, max, *start, next, &key, &keyLength,
+                       &value, &valueLength );
+    }
+
+    if( ret == JSONSuccess )
+    {
+        JSONTypes_t t = getType( buf[ value ] );
+
+        if( t == JSONString )
+        {
+            /* strip the surrounding quotes */
+            value++;
+            valueLength -= 2U;
+        }
+
+        outPair->key = ( key == 0U ) ? NULL : &buf[ key ];
+        outPair->keyLength = keyLength;
+        outPair->value = &buf[ value ];
+        outPair->valueLength = valueLength;
+        outPair->jsonType = t;
+    }
+
+    return ret;
+}
+
+/** @cond DO_NOT_DOCUMENT */
+
+/* Structural tokens expected by an incremental validation. */
+#define STREAM_VALUE             ( 0U ) /* at the root, after ':', or after ',' in an array */
+#define STREAM_VALUE_OR_CLOSE    ( 1U ) /* after '[' */
+#define STREAM_KEY               ( 2U ) /* after ',' in an object */
+#define STREAM_KEY_OR_CLOSE      ( 3U ) /* after '{' */
+#define STREAM_COLON             ( 4U ) /* after a key */
+#define STREAM_COMMA_OR_CLOSE    ( 5U ) /* after a value in a collection */
+#define STREAM_END               ( 6U ) /* after the root value */
+
+/* Positions within a scalar split between chunks. */
+#define LEX_NONE                 ( 0U )
+#define LEX_STRING               ( 1U )
+#define LEX_ESCAPE               ( 2U )  /* after a backslash */
+#define LEX_HEX                  ( 3U )  /* within the digits of \uXXXX */
+#define LEX_LOW_BACKSLASH        ( 4U )  /* after a high surrogate */
+#define LEX_LOW_U                ( 5U )  /* after the backslash of a low surrogate */
+#define LEX_LOW_HEX              ( 6U )  /* within the digits of a low surrogate */
+#define LEX_UTF8                 ( 7U )  /* within the trailing bytes of a code point */
+#define LEX_LITERAL              ( 8U )
+#define LEX_MINUS                ( 9U )  /* after a leading minus sign */
+#define LEX_ZERO                 ( 10U ) /* after a leading zero */
+#define LEX_INTEGER              ( 11U )
+#define LEX_POINT                ( 12U ) /* after a decimal point */
+#define LEX_FRACTION             ( 13U )
+#define LEX_E                    ( 14U ) /* after 'e' or 'E' */
+#define LEX_EXPONENT_SIGN        ( 15U )
+#define LEX_EXPONENT             ( 16U )
+
+/* A number may end in these positions. */
+#define isNumberEnd_( x )                                   \
+    ( ( ( x ) == LEX_ZERO ) || ( ( x ) == LEX_INTEGER ) ||  \
+      ( ( x ) == LEX_FRACTION ) || ( ( x ) == LEX_EXPONENT ) )
+
+static const char * const streamLiterals[] = { "true", "false", "null" };
+
+/**
+ * @brief Conclude a value and expect what follows it.
+ *
+ * @param[in,out] s  The state of the validation.
+ */
+static void streamValueEnd( JSONStreamState_t * s )
+{
+    assert( s != NULL );
+
+    s->lexer = LEX_NONE;
+    s->expect = ( s->depth < 0 ) ? STREAM_END : STREAM_COMMA_OR_CLOSE;
+}
+
+/**
+ * @brief Validate the next four bits of a \u escape sequence.
+ *
+ * @param[in,out] s  The state of the validation.
+ * @param[in] c  The next character.
+ *
+ * @return true if the escape sequence is valid so far;
+ * false otherwise.
+ */
+static bool_ streamHexDigit( JSONStreamState_t * s,
+                             char c )
+{
+    bool_ ret = false;
+    uint8_t n = hexToInt( c );
+
+    assert( s != NULL );
+
+    if( n != NOT_A_HEX_CHAR )
+    {
+        s->value = ( s->value << 4U ) | n;
+        s->remaining--;
+        ret = true;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Validate the next byte of an escape sequence.
+ *
+ * @param[in,out] s  The state of the validation.
+ * @param[in] c  The next character.
+ *
+ * @return #JSONPartial if the string is valid so far;
+ * #JSONIllegalDocument otherwise.
+ *
+ * @note As for skipEscape(), \NUL and \u0000 are disallowed, and
+ * surrogates must occur as a high and low pair.
+ */
+static JSONStatus_t streamEscape( JSONStreamState_t * s,
+                                  char c )
+{
+    JSONStatus_t ret = JSONPartial;
+
+    assert( s != NULL );
+
+    switch( s->lexer )
+    {
+        case LEX_ESCAPE:
+
+            if( c == 'u' )
+            {
+                s->lexer = LEX_HEX;
+                s->remaining = 4U;
+                s->value = 0U;
+            }
+            else if( ( c == '"' ) || ( c == '\\' ) || ( c == '/' ) || ( c == 'b' ) ||
+                     ( c == 'f' ) || ( c == 'n' ) || ( c == 'r' ) || ( c == 't' ) ||
+                     ( ( c != '\0' ) && iscntrl_( c ) ) )
+            {
+                s->lexer = LEX_STRING;
+            }
+            else
+            {
+                ret = JSONIllegalDocument;
+            }
+
+            break;
+
+        case LEX_HEX:
+
+            if( streamHexDigit( s, c ) != true )
+            {
+                ret = JSONIllegalDocument;
+            }
+            else if( s->remaining > 0U )
+            {
+                /* Empty else. */
+            }
+            else if( ( s->value == 0U ) || isLowSurrogate( s->value ) )
+            {
+                ret = JSONIllegalDocument;
+            }
+            else
+            {
+                s->lexer = isHighSurrogate( s->value ) ? LEX_LOW_BACKSLASH : LEX_STRING;
+            }
+
+            break;
+
+        case LEX_LOW_BACKSLASH:
+            s->lexer = LEX_LOW_U;
+            ret = ( c == '\\' ) ? JSONPartial : JSONIllegalDocument;
+            break;
+
+        case LEX_LOW_U:
+            s->lexer = LEX_LOW_HEX;
+            s->remaining = 4U;
+            s->value = 0U;
+            ret = ( c == 'u' ) ? JSONPartial : JSONIllegalDocument;
+            break;
+
+        default: /* LEX_LOW_HEX */
+
+            if( streamHexDigit( s, c ) != true )
+            {
+                ret = JSONIllegalDocument;
+            }
+            else if( s->remaining > 0U )
+            {
+                /* Empty else. */
+            }
+            else if( isLowSurrogate( s->value ) )
+            {
+                s->lexer = LEX_STRING;
+            }
+            else
+            {
+                ret = JSONIllegalDocument;
+            }
+
+            break;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Validate the next byte of a string.
+ *
+ * @param[in,out] s  The state of the validation.
+ * @param[in] c  The next character.
+ *
+ * @return #JSONPartial if the string is valid so far;
+ * #JSONIllegalDocument otherwise.
+ */
+static JSONStatus_t streamString( JSONStreamState_t * s,
+                                  char c )
+{
+    JSONStatus_t ret = JSONPartial;
+    char_ b;
+
+    assert( s != NULL );
+
+    b.c = c;
+
+    if( s->lexer == LEX_UTF8 )
+    {
+        /* Additional bytes must match 10xxxxxx. */
+        if( ( b.u & 0xC0U ) != 0x80U )
+        {
+            ret = JSONIllegalDocument;
+        }
+        else
+        {
+            s->value = ( s->value << 6U ) | ( b.u & 0x3FU );
+            s->remaining--;
+
+            if( s->remaining == 0U )
+            {
+                s->lexer = LEX_STRING;
+                ret = ( shortestUTF8( s->length, s->value ) == true ) ? JSONPartial : JSONIllegalDocument;
+            }
+        }
+    }
+    else if( s->lexer != LEX_STRING )
+    {
+        ret = streamEscape( s, c );
+    }
+    else if( c == '"' )
+    {
+        if( ( s->expect == STREAM_KEY ) || ( s->expect == STREAM_KEY_OR_CLOSE ) )
+        {
+            s->lexer = LEX_NONE;
+            s->expect = STREAM_COLON;
+        }
+        else
+        {
+            streamValueEnd( s );
+        }
+    }
+    else if( c == '\\' )
+    {
+        s->lexer = LEX_ESCAPE;
+    }
+    else if( b.u < 0x20U )
+    {
+        /* An unescaped control character is not allowed. */
+        ret = JSONIllegalDocument;
+    }
+    else if( b.u < 0x80U )
+    {
+        /* Empty else. */
+    }
+    else if( ( b.u > 0xC1U ) && ( b.u < 0xF5U ) )
+    {
+        s->lexer = LEX_UTF8;
+        s->length = ( uint8_t ) countHighBits( b.u );
+        s->remaining = ( uint8_t ) ( s->length - 1U );
+        s->value = ( ( uint32_t ) b.u ) & ( ( ( uint32_t ) 1 << ( 7U - s->length ) ) - 1U );
+    }
+    else
+    {
+        ret = JSONIllegalDocument;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Validate the next byte of a number.
+ *
+ * A byte that cannot extend the number ends it, if it may end there,
+ * and is then left for the structural check.
+ *
+ * @param[in,out] s  The state of the validation.
+ * @param[in] c  The next character.
+ * @param[out] consumed  A pointer to receive whether the byte was consumed.
+ *
+ * @return #JSONPartial if the number is valid so far;
+ * #JSONIllegalDocument otherwise.
+ */
+static JSONStatus_t streamNumber( JSONStreamState_t * s,
+                                  char c,
+                                  bool_ * consumed )
+{
+    JSONStatus_t ret = JSONPartial;
+    uint8_t next = LEX_NONE;
+
+    assert( ( s != NULL ) && ( consumed != NULL ) );
+
+    switch( s->lexer )
+    {
+        case LEX_MINUS:
+            next = ( c == '0' ) ? LEX_ZERO : ( isdigit_( c ) ? LEX_INTEGER : LEX_NONE );
+            break;
+
+        case LEX_ZERO:
+        case LEX_INTEGER:
+        case LEX_FRACTION:
+
+            if( ( s->lexer != LEX_ZERO ) && isdigit_( c ) )
+            {
+                next = s->lexer;
+            }
+            else if( ( c == '.' ) && ( s->lexer != LEX_FRACTION ) )
+            {
+                next = LEX_POINT;
+            }
+            else if( ( c == 'e' ) || ( c == 'E' ) )
+            {
+                next = LEX_E;
+            }
+            else
+            {
+                /* Empty else. */
+            }
+
+            break;
+
+        case LEX_POINT:
+            next = isdigit_( c ) ? LEX_FRACTION : LEX_NONE;
+            break;
+
+        case LEX_E:
+            next = ( ( c == '+' ) || ( c == '-' ) ) ? LEX_EXPONENT_SIGN : ( isdigit_( c ) ? LEX_EXPONENT : LEX_NONE );
+            break;
+
+        default: /* LEX_EXPONENT_SIGN or LEX_EXPONENT */
+            next = isdigit_( c ) ? LEX_EXPONENT : LEX_NONE;
+            break;
+    }
+
+    if( next != LEX_NONE )
+    {
+        s->lexer = next;
+        *consumed = true;
+    }
+    else if( isNumberEnd_( s->lexer ) )
+    {
+        streamValueEnd( s );
+        *consumed = false;
+    }
+    else
+    {
+        ret = JSONIllegalDocument;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Validate the first byte of a value.
+ *
+ * @param[in,out] s  The state of the validation.
+ * @param[in] c  The next character.
+ *
+ * @return #JSONPartial if the value is valid so far;
+ * #JSONIllegalDocument if a value cannot begin with the byte;
+ * #JSONMaxDepthExceeded if object and array nesting exceeds a threshold.
+ */
+static JSONStatus_t streamValue( JSONStreamState_t * s,
+                                 char c )
+{
+    JSONStatus_t ret = JSONPartial;
+    char first = c;
+
+    assert( s != NULL );
+
+    #ifdef JSON_VALIDATE_COLLECTIONS_ONLY
+        if( ( s->depth < 0 ) && !isOpenBracket_( c ) )
+        {
+            /* No value begins with NUL. */
+            first = '\0';
+        }
+    #endif
+
+    switch( first )
+    {
+        case '{':
+        case '[':
+
+            if( s->depth == ( JSON_MAX_DEPTH - 1 ) )
+            {
+                ret = JSONMaxDepthExceeded;
+            }
+            else
+            {
+                s->depth++;
+                s->stack[ s->depth ] = c;
+                s->expect = ( c == '{' ) ? STREAM_KEY_OR_CLOSE : STREAM_VALUE_OR_CLOSE;
+            }
+
+            break;
+
+        case '"':
+            s->lexer = LEX_STRING;
+            break;
+
+        case 't':
+        case 'f':
+        case 'n':
+            s->lexer = LEX_LITERAL;
+            s->length = ( c == 't' ) ? 0U : ( ( c == 'f' ) ? 1U : 2U );
+            s->remaining = 1U;
+            break;
+
+        case '-':
+            s->lexer = LEX_MINUS;
+            break;
+
+        case '0':
+            s->lexer = LEX_ZERO;
+            break;
+
+        default:
+
+            if( isdigit_( c ) )
+            {
+                s->lexer = LEX_INTEGER;
+            }
+            else
+            {
+                ret = JSONIllegalDocument;
+            }
+
+            break;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Validate a structural byte between tokens.
+ *
+ * @param[in,out] s  The state of the validation.
+ * @param[in] c  The next character.
+ *
+ * @return #JSONPartial if the document is valid so far;
+ * #JSONIllegalDocument if it is not;
+ * #JSONMaxDepthExceeded if object and array nesting exceeds a threshold.
+ */
+static JSONStatus_t streamStructure( JSONStreamState_t * s,
+                                     char c )
+{
+    JSONStatus_t ret = JSONPartial;
+
+    assert( s != NULL );
+
+    if( isspace_( c ) )
+    {
+        /* Empty if. */
+    }
+    else if( ( ( s->expect == STREAM_COMMA_OR_CLOSE ) ||
+               ( s->expect == STREAM_KEY_OR_CLOSE ) ||
+               ( s->expect == STREAM_VALUE_OR_CLOSE ) ) &&
+             isMatchingBracket_( s->stack[ s->depth ], c ) )
+    {
+        s->depth--;
+        streamValueEnd( s );
+    }
+    else
+    {
+        switch( s->expect )
+        {
+            case STREAM_VALUE:
+            case STREAM_VALUE_OR_CLOSE:
+                ret = streamValue( s, c );
+                break;
+
+            case STREAM_KEY:
+            case STREAM_KEY_OR_CLOSE:
+
+                if( c == '"' )
+                {
+                    s->lexer = LEX_STRING;
+                }
+                else
+                {
+                    ret = JSONIllegalDocument;
+                }
+
+                break;
+
+            case STREAM_COLON:
+
+                if( c == ':' )
+                {
+                    s->expect = STREAM_VALUE;
+                }
+                else
+                {
+                    ret = JSONIllegalDocument;
+                }
+
+                break;
+
+            case STREAM_COMMA_OR_CLOSE:
+
+                if( c == ',' )
+                {
+                    s->expect = ( s->stack[ s->depth ] == '{' ) ? STREAM_KEY : STREAM_VALUE;
+                }
+                else
+                {
+                    ret = JSONIllegalDocument;
+                }
+
+                break;
+
+            default: /* STREAM_END */
+                ret = JSONIllegalDocument;
+                break;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Validate the next byte of a document.
+ *
+ * @param[in,out] s  The state of the validation.
+ * @param[in] c  The next character.
+ *
+ * @return #JSONPartial if the document is valid so far;
+ * #JSONIllegalDocument if it is not;
+ * #JSONMaxDepthExceeded if object and array nesting exceeds a threshold.
+ */
+static JSONStatus_t streamByte( JSONStreamState_t * s,
+                                char c )
+{
+    JSONStatus_t ret = JSONPartial;
+    bool_ consumed = true;
+
+    assert( s != NULL );
+
+    if( s->lexer >= LEX_MINUS )
+    {
+        ret = streamNumber( s, c, &consumed );
+    }
+    else if( s->lexer == LEX_LITERAL )
+    {
+        if( c == streamLiterals[ s->length ][ s->remaining ] )
+        {
+            s->remaining++;
+
+            if( streamLiterals[ s->length ][ s->remaining ] == '\0' )
+            {
+                streamValueEnd( s );
+            }
+        }
+        else
+        {
+            ret = JSONIllegalDocument;
+        }
+    }
+    else if( s->lexer != LEX_NONE )
+    {
+        ret = streamString( s, c );
+    }
+    else
+    {
+        consumed = false;
+    }
+
+    if( ( ret == JSONPartial ) && ( consumed == false ) )
+    {
+        ret = streamStructure( s, c );
+    }
+
+    return ret;
+}
+
+/** @endcond */
+
+/**
+ * See core_json.h for docs.
+ */
+JSONStatus_t JSON_ValidateStart( JSONStreamState_t * state )
+{
+    JSONStatus_t ret = JSONSuccess;
+
+    if( state == NULL )
+    {
+        ret = JSONNullParameter;
+    }
+    else
+    {
+        state->offset = 0U;
+        state->status = JSONPartial;
+        state->depth = -1;
+        state->expect = STREAM_VALUE;
+        state->lexer = LEX_NONE;
+        state->remaining = 0U;
+        state->length = 0U;
+        state->value = 0U;
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json.h for docs.
+ */
+JSONStatus_t JSON_ValidateChunk( JSONStreamState_t * state,
+                                 const char * buf,
+                                 size_t max )
+{
+    JSONStatus_t ret;
+    size_t i;
+
+    if( ( state == NULL ) || ( buf == NULL ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else if( ( state->status != JSONPartial ) && ( state->status != JSONSuccess ) )
+    {
+        ret = state->status;
+    }
+    else
+    {
+        ret = JSONPartial;
+
+        for( i = 0; i < max; i++ )
+        {
+            ret = streamByte( state, buf[ i ] );
+
+            if( ret != JSONPartial )
+            {
+                break;
+            }
+        }
+
+        state->offset += i;
+
+        if( ( ret == JSONPartial ) &&
+            ( state->expect == STREAM_END ) && ( state->lexer == LEX_NONE ) )
+        {
+            ret = JSONSuccess;
+        }
+
+        state->status = ret;
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json.h for docs.
+ */
+JSONStatus_t JSON_ValidateFinish( JSONStreamState_t * state )
+{
+    JSONStatus_t ret;
+
+    if( state == NULL )
+    {
+        ret = JSONNullParameter;
+    }
+    else
+    {
+        /* Only a number at the root can end with the input. */
+        if( ( state->status == JSONPartial ) && ( state->depth < 0 ) &&
+            isNumberEnd_( state->lexer ) )
+        {
+            streamValueEnd( state );
+            state->status = JSONSuccess;
+        }
+
+        ret = state->status;
+    }
+
+    return ret;
+}
+
+/** @cond DO_NOT_DOCUMENT */
+
+/**
+ * @brief Read the four hex digits of a \u escape sequence.
+ *
+ * @param[in] buf  The buffer to parse.
+ * @param[in] start  The index of the backslash.
+ * @param[in] max  The size of the buffer.
+ * @param[out] outValue  The value of the hex digits.
+ *
+ * @return true if a complete, nonzero \u escape sequence was present;
+ * false otherwise.
+ *
+ * @note Unlike skipOneHexEscape(), the sequence may end the buffer, since
+ * the buffer holds a string value without its closing quote.
+ */
+static bool_ readHexEscape( const char * buf,
+                            size_t start,
+                            size_t max,
+                            uint16_t * outValue )
+{
+    bool_ ret = false;
+    size_t i;
+    uint8_t n = 0U;
+    uint16_t value = 0U;
+
+    assert( ( buf != NULL ) && ( outValue != NULL ) );
+
+    if( ( ( max - start ) >= HEX_ESCAPE_LENGTH ) &&
+        ( buf[ start ] == '\\' ) && ( buf[ start + 1U ] == 'u' ) )
+    {
+        for( i = start + 2U; i < ( start + HEX_ESCAPE_LENGTH ); i++ )
+        {
+            n = hexToInt( buf[ i ] );
+
+            if( n == NOT_A_HEX_CHAR )
+            {
+                break;
+            }
+
+            value = ( uint16_t ) ( ( uint16_t ) ( value << 4U ) | n );
+        }
+
+        /* For the sake of security, \u0000 is disallowed. */
+        if( ( n != NOT_A_HEX_CHAR ) && ( value > 0U ) )
+        {
+            ret = true;
+            *outValue = value;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Decode an escape sequence into UTF-8.
+ *
+ * Accepts what skipEscape() accepts, including a backslash before a
+ * control character, which stands for that character.
+ *
+ * @param[in] buf  The buffer to parse.
+ * @param[in,out] start  The index of the backslash; on return, the index
+ * after the escape sequence.
+ * @param[in] max  The size of the buffer.
+ * @param[out] out  The decoded bytes, at most 4.
+ *
+ * @return The number of decoded bytes, which is fewer than the length of
+ * the escape sequence; 0 if the escape sequence is invalid.
+ */
+static size_t decodeEscape( const char * buf,
+                            size_t * start,
+                            size_t max,
+                            char * out )
+{
+    size_t i, n = 0U;
+    uint16_t high = 0U, low = 0U;
+    uint32_t codePoint = 0U;
+    char c;
+
+    assert( ( buf != NULL ) && ( start != NULL ) && ( out != NULL ) );
+
+    i = *start;
+    assert( ( i < max ) && ( buf[ i ] == '\\' ) );
+
+    c = ( ( i + 1U ) < max ) ? buf[ i + 1U ] : '\0';
+
+    switch( c )
+    {
+        case '\0':
+            break;
+
+        case 'u':
+
+            if( readHexEscape( buf, i, max, &high ) == true )
+            {
+                i += HEX_ESCAPE_LENGTH;
+
+                if( isHighSurrogate( high ) )
+                {
+                    if( ( readHexEscape( buf, i, max, &low ) == true ) && isLowSurrogate( low ) )
+                    {
+                        i += HEX_ESCAPE_LENGTH;
+                        codePoint = 0x10000U + ( ( ( uint32_t ) high - 0xD800U ) << 10U ) +
+                                    ( ( uint32_t ) low - 0xDC00U );
+                    }
+                }
+                else if( isLowSurrogate( high ) )
+                {
+                    /* premature low surrogate */
+                }
+                else
+                {
+                    codePoint = high;
+                }
+            }
+
+            break;
+
+        case 'b':
+            codePoint = ( uint32_t ) '\b';
+            i += 2U;
+            break;
+
+        case 'f':
+            codePoint = ( uint32_t ) '\f';
+            i += 2U;
+            break;
+
+        case 'n':
+            codePoint = ( uint32_t ) '\n';
+            i += 2U;
+            break;
+
+        case 'r':
+            codePoint = ( uint32_t ) '\r';
+            i += 2U;
+            break;
+
+        case 't':
+            codePoint = ( uint32_t ) '\t';
+            i += 2U;
+            break;
+
+        default:
+
+            /* '"', '\\', '/' or a control character: (NUL,SPACE) */
+            if( ( c == '"' ) || ( c == '\\' ) || ( c == '/' ) || iscntrl_( c ) )
+            {
+                codePoint = ( uint32_t ) ( uint8_t ) c;
+                i += 2U;
+            }
+
+            break;
+    }
+
+    if( codePoint == 0U )
+    {
+        /* Invalid; codePoint is never 0 for a valid escape. */
+    }
+    else if( codePoint < 0x80U )
+    {
+        out[ 0 ] = ( char ) codePoint;
+        n = 1U;
+    }
+    else if( codePoint < 0x800U )
+    {
+        out[ 0 ] = ( char ) ( 0xC0U | ( codePoint >> 6U ) );
+        out[ 1 ] = ( char ) ( 0x80U | ( codePoint & 0x3FU ) );
+        n = 2U;
+    }
+    else if( codePoint < 0x10000U )
+    {
+        out[ 0 ] = ( char ) ( 0xE0U | ( codePoint >> 12U ) );
+        out[ 1 ] = ( char ) ( 0x80U | ( ( codePoint >> 6U ) & 0x3FU ) );
+        out[ 2 ] = ( char ) ( 0x80U | ( codePoint & 0x3FU ) );
+        n = 3U;
+    }
+    else
+    {
+        out[ 0 ] = ( char ) ( 0xF0U | ( codePoint >> 18U ) );
+        out[ 1 ] = ( char ) ( 0x80U | ( ( codePoint >> 12U ) & 0x3FU ) );
+        out[ 2 ] = ( char ) ( 0x80U | ( ( codePoint >> 6U ) & 0x3FU ) );
+        out[ 3 ] = ( char ) ( 0x80U | ( codePoint & 0x3FU ) );
+        n = 4U;
+    }
+
+    *start = i;
+
+    return n;
+}
+
+/**
+ * @brief Advance buffer index to the next backslash, or to max.
+ *
+ * @param[in] buf  The buffer to parse.
+ * @param[in,out] start  The index at which to begin.
+ * @param[in] max  The size of the buffer.
+ */
+static void skipToBackslash( const char * buf,
+                             size_t * start,
+                             size_t max )
+{
+    size_t i;
+
+    assert( ( buf != NULL ) && ( start != NULL ) );
+
+    i = *start;
+
+    while( ( i < max ) && ( buf[ i ] != '\\' ) )
+    {
+        /* The vector scan also stops on quotes, controls and non-ASCII. */
+        skipBlocks( buf, &i, max, true );
+
+        if( buf[ i ] != '\\' )
+        {
+            i++;
+        }
+    }
+
+    *start = i;
+}
+
+/**
+ * @brief Decode the escape sequences of a string value.
+ *
+ * Output is written only while it fits, but is always measured.  Since
+ * the output never overtakes the input, buf may be value.
+ *
+ * @param[in] value  The string value.
+ * @param[in] valueLength  The length of the value.
+ * @param[in] first  The index of the first backslash.
+ * @param[out] buf  The buffer for the output.
+ * @param[in] bufSize  The size of the buffer.
+ * @param[out] outLength  The length of the output.
+ *
+ * @return #JSONSuccess if the value was decoded into buf;
+ * #JSONInsufficientMemory if the output did not fit;
+ * #JSONIllegalDocument if an escape sequence is invalid.
+ */
+static JSONStatus_t unescape( const char * value,
+                              size_t valueLength,
+                              size_t first,
+                              char * buf,
+                              size_t bufSize,
+                              size_t * outLength )
+{
+    JSONStatus_t ret = JSONSuccess;
+    size_t i = first, start = 0U, n = 0U, k, decodedLength;
+    char decoded[ 4 ];
+
+    assert( ( value != NULL ) && ( outLength != NULL ) );
+    assert( ( buf != NULL ) || ( bufSize == 0U ) );
+
+    while( ( start < valueLength ) && ( ret != JSONIllegalDocument ) )
+    {
+        for( k = start; k < i; k++ )
+        {
+            /* In place, bytes before the first escape stay where they are. */
+            if( ( n < bufSize ) && ( &buf[ n ] != &value[ k ] ) )
+            {
+                buf[ n ] = value[ k ];
+            }
+
+            n++;
+        }
+
+        if( i < valueLength )
+        {
+            decodedLength = decodeEscape( value, &i, valueLength, decoded );
+
+            if( decodedLength == 0U )
+            {
+                ret = JSONIllegalDocument;
+            }
+
+            for( k = 0U; k < decodedLength; k++ )
+            {
+                if( n < bufSize )
+                {
+                    buf[ n ] = decoded[ k ];
+                }
+
+                n++;
+            }
+        }
+
+        start = i;
+        skipToBackslash( value, &i, valueLength );
+    }
+
+    if( ( ret == JSONSuccess ) && ( n > bufSize ) )
+    {
+        ret = JSONInsufficientMemory;
+    }
+
+    *outLength = n;
+
+    return ret;
+}
+
+/** @endcond */
+
+/**
+ * See core_json.h for docs.
+ */
+JSONStatus_t JSON_Unescape( const char * value,
+                            size_t valueLength,
+                            char * buf,
+                            size_t bufSize,
+                            const char ** outValue,
+                            size_t * outValueLength )
+{
+    JSONStatus_t ret;
+    size_t i = 0U, length = 0U;
+
+    if( ( value == NULL ) || ( outValue == NULL ) || ( outValueLength == NULL ) ||
+        ( ( buf == NULL ) && ( bufSize > 0U ) ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else
+    {
+        skipToBackslash( value, &i, valueLength );
+
+        if( i == valueLength )
+        {
+            /* No escapes: the value is its own result. */
+            ret = JSONSuccess;
+            *outValue = value;
+            *outValueLength = valueLength;
+        }
+        else
+        {
+            ret = unescape( value, valueLength, i, buf, bufSize, &length );
+
+            if( ret == JSONSuccess )
+            {
+                *outValue = buf;
+            }
+
+            if( ret != JSONIllegalDocument )
+            {
+                *outValueLength = length;
+            }
+        }
+    }
+
+    return ret;
+}
+
+/** @cond DO_NOT_DOCUMENT */
+
+/**
+ * @brief An object being output by JSON_MergePatch().
+ *
+ * The object is either a target object merged with a patch object, or a
+ * patch object added to the target, whose null members are left out.
+ */
+typedef struct
+{
+    size_t entry;    /* entry of the target object, or JSON_INDEX_NONE */
+    size_t child;    /* next member of the target object to output */
+    size_t patch;    /* offset of the patch object */
+    size_t next;     /* cursor within the patch object */
+    bool_ existing;  /* false while adding members, true while merging the target's */
+    bool_ empty;     /* true until a member is output */
+} mergeFrame_t;
+
+/**
+ * @brief Working state of JSON_MergePatch().
+ *
+ * With no buffer, output is only measured.  To merge in place, the target
+ * is moved up in the buffer by the largest lead that the output takes over
+ * the reads of the target, so that no byte is overwritten before it is read.
+ */
+typedef struct
+{
+    const char * target;
+    const JSONIndexEntry_t * index;
+    size_t indexCount;
+    const char * patch;
+    size_t patchLength;
+    char * buf;       /* output, or NULL to measure */
+    size_t length;    /* bytes output */
+    size_t read;      /* offset below which the target is not read again */
+    size_t lead;      /* largest excess of length over read */
+    mergeFrame_t stack[ JSON_MAX_DEPTH ];
+    int16_t depth;
+} merger_t;
+
+/**
+ * @brief Record the output of bytes against the reads of the target.
+ *
+ * @param[in,out] m  The merge state.
+ * @param[in] length  The number of bytes output.
+ */
+static void mergeAdvance( merger_t * m,
+                          size_t length )
+{
+    m->length += length;
+
+    if( ( m->length > m->read ) && ( ( m->length - m->read ) > m->lead ) )
+    {
+        m->lead = m->length - m->read;
+    }
+}
+
+/**
+ * @brief Output bytes of the patch, or punctuation.
+ *
+ * @param[in,out] m  The merge state.
+ * @param[in] src  The bytes to output.
+ * @param[in] length  The number of bytes.
+ */
+static void mergeEmit( merger_t * m,
+                       const char * src,
+                       size_t length )
+{
+    if( m->buf != NULL )
+    {
+        ( void ) memcpy( &m->buf[ m->length ], src, length );
+    }
+
+    mergeAdvance( m, length );
+}
+
+/**
+ * @brief Output bytes of the target, which may lie in the output buffer.
+ *
+ * @param[in,out] m  The merge state.
+ * @param[in] offset  The offset of the bytes in the target.
+ * @param[in] length  The number of bytes.
+ */
+static void mergeCopy( merger_t * m,
+                       size_t offset,
+                       size_t length )
+{
+    if( m->buf != NULL )
+    {
+        ( void ) memmove( &m->buf[ m->length ], &m->target[ offset ], length );
+    }
+
+    m->read = offset + length;
+    mergeAdvance( m, length );
+}
+
+/**
+ * @brief Output the separator before a member of the innermost object.
+ *
+ * @param[in,out] m  The merge state.
+ */
+static void mergeSeparator( merger_t * m )
+{
+    mergeFrame_t * f = &m->stack[ m->depth ];
+
+    if( f->empty == false )
+    {
+        mergeEmit( m, ",", 1U );
+    }
+
+    f->empty = false;
+}
+
+/**
+ * @brief Open an object of the output.
+ *
+ * @param[in,out] m  The merge state.
+ * @param[in] entry  The target object to merge, or #JSON_INDEX_NONE.
+ * @param[in] patch  The offset of the patch object.
+ */
+static void mergePush( merger_t * m,
+                       size_t entry,
+                       size_t patch )
+{
+    mergeFrame_t * f;
+
+    /* The patch was validated, and each frame is one of its objects. */
+    assert( m->depth < ( JSON_MAX_DEPTH - 1 ) );
+
+    m->depth++;
+    f = &m->stack[ m->depth ];
+    f->entry = entry;
+    f->child = JSON_INDEX_NONE;
+    f->patch = patch;
+    f->next = patch + 1U;
+    skipSpace( m->patch, &f->next, m->patchLength );
+    f->existing = false;
+    f->empty = true;
+
+    if( entry != JSON_INDEX_NONE )
+    {
+        /* The target is read only beyond the opening brace. */
+        m->read = m->index[ entry ].offset + 1U;
+    }
+
+    mergeEmit( m, "{", 1U );
+}
+
+/**
+ * @brief Output a patch value for a member whose key was just output.
+ *
+ * @param[in,out] m  The merge state.
+ * @param[in] entry  The target value it replaces, if it may be merged with
+ * it, or #JSON_INDEX_NONE.
+ * @param[in] value  The offset of the patch value.
+ * @param[in] valueLength  The length of the patch value.
+ */
+static void mergeValue( merger_t * m,
+                        size_t entry,
+                        size_t value,
+                        size_t valueLength )
+{
+    if( m->patch[ value ] == '{' )
+    {
+        mergePush( m, ( ( entry != JSON_INDEX_NONE ) &&
+                        ( m->index[ entry ].type == JSONObject ) ) ? entry : JSON_INDEX_NONE,
+                   value );
+    }
+    else
+    {
+        mergeEmit( m, &m->patch[ value ], valueLength );
+    }
+}
+
+/**
+ * @brief Find a key in a patch object.
+ *
+ * @param[in] m  The merge state.
+ * @param[in] object  The offset of the patch object.
+ * @param[in] key  The key to find, without quotes.
+ * @param[in] keyLength  The length of the key.
+ * @param[out] value  A pointer to receive the offset of the value.
+ * @param[out] valueLength  A pointer to receive the length of the value.
+ *
+ * @return true if the key was found;
+ * false otherwise.
+ */
+static bool_ findPatchMember( const merger_t * m,
+                              size_t object,
+                              const char * key,
+                              size_t keyLength,
+                              size_t * value,
+                              size_t * valueLength )
+{
+    bool_ ret = false;
+    size_t next = object + 1U, k = 0, kLength = 0;
+
+    skipSpace( m->patch, &next, m->patchLength );
+
+    while( iterate( m->patch, m->patchLength, object, &next, &k, &kLength,
+                    value, valueLength ) == JSONSuccess )
+    {
+        if( ( kLength == keyLength ) && ( strnEq( &m->patch[ k ], key, keyLength ) == true ) )
+        {
+            ret = true;
+            break;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Output the next member of the innermost object, or close it.
+ *
+ * Members that the patch adds come first, then the members of the target
+ * object in their order, each kept, replaced, merged or removed.  Adding
+ * members first means that every key of the target object is compared
+ * before any of the object is output.
+ *
+ * @param[in,out] m  The merge state.
+ */
+static void mergeStep( merger_t * m )
+{
+    mergeFrame_t * f = &m->stack[ m->depth ];
+    const JSONIndexEntry_t * c;
+    size_t key = 0, keyLength = 0, value = 0, valueLength = 0;
+
+    if( f->existing == false )
+    {
+        if( iterate( m->patch, m->patchLength, f->patch, &f->next, &key, &keyLength,
+                     &value, &valueLength ) != JSONSuccess )
+        {
+            if( f->entry == JSON_INDEX_NONE )
+            {
+                mergeEmit( m, "}", 1U );
+                m->depth--;
+            }
+            else
+            {
+                f->existing = true;
+                f->child = firstChild( m->index, m->indexCount, f->entry );
+            }
+        }
+        /* null removes a member, and is never output. */
+        else if( ( getType( m->patch[ value ] ) != JSONNull ) &&
+                 ( ( f->entry == JSON_INDEX_NONE ) ||
+                   ( indexObjectSearch( m->target, m->index, m->indexCount, f->entry,
+                                        &m->patch[ key ], keyLength ) == JSON_INDEX_NONE ) ) )
+        {
+            mergeSeparator( m );
+            mergeEmit( m, &m->patch[ key - 1U ], keyLength + 2U );
+            mergeEmit( m, ":", 1U );
+            mergeValue( m, JSON_INDEX_NONE, value, valueLength );
+        }
+        else
+        {
+            /* Empty else. */
+        }
+    }
+    else if( f->child >= m->indexCount )
+    {
+        mergeEmit( m, "}", 1U );
+        m->depth--;
+    }
+    else
+    {
+        c = &m->index[ f->child ];
+
+        if( findPatchMember( m, f->patch, &m->target[ c->key ], c->keyLength,
+                             &value, &valueLength ) == false )
+        {
+            /* Keep the member as it is, from its key to the end of its value. */
+            mergeSeparator( m );
+            mergeCopy( m, c->key - 1U, ( c->offset + c->length ) - ( c->key - 1U ) );
+        }
+        else if( getType( m->patch[ value ] ) != JSONNull )
+        {
+            mergeSeparator( m );
+            mergeCopy( m, c->key - 1U, c->keyLength + 2U );
+            mergeEmit( m, ":", 1U );
+            mergeValue( m, f->child, value, valueLength );
+        }
+        else
+        {
+            /* Empty else. */
+        }
+
+        /* f may have been pushed down the stack, but not overwritten. */
+        f->child = c->nextSibling;
+    }
+}
+
+/**
+ * @brief Output the target with the patch applied.
+ *
+ * @param[in,out] m  The merge state.
+ */
+static void mergePatch( merger_t * m )
+{
+    size_t i = 0, value = 0, valueLength = 0;
+
+    skipSpace( m->patch, &i, m->patchLength );
+    ( void ) nextValue( m->patch, &i, m->patchLength, &value, &valueLength );
+
+    m->length = 0U;
+    m->lead = 0U;
+    m->depth = -1;
+
+    /* Unless both are objects, the target is not read. */
+    m->read = m->index[ 0 ].offset + m->index[ 0 ].length;
+    mergeValue( m, 0U, value, valueLength );
+
+    while( m->depth >= 0 )
+    {
+        mergeStep( m );
+    }
+}
+
+/** @endcond */
+
+/**
+ * See core_json.h for docs.
+ */
+JSONStatus_t JSON_MergePatch( const char * target,
+                              size_t targetLength,
+                              const JSONIndexEntry_t * targetIndex,
+                              size_t targetIndexCount,
+                              const char * patch,
+                              size_t patchLength,
+                              char * buf,
+                              size_t bufSize,
+                              size_t * outLength )
+{
+    JSONStatus_t ret;
+    merger_t m;
+    size_t required = 0U;
+    bool_ inPlace = ( ( buf != NULL ) && ( buf == target ) ) ? true : false;
+
+    if( ( target == NULL ) || ( targetIndex == NULL ) || ( patch == NULL ) ||
+        ( outLength == NULL ) || ( ( buf == NULL ) && ( bufSize > 0U ) ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else if( ( targetLength == 0U ) || ( targetIndexCount == 0U ) || ( patchLength == 0U ) ||
+             ( ( inPlace == true ) && ( bufSize < targetLength ) ) )
+    {
+        ret = JSONBadParameter;
+    }
+    else
+    {
+        ret = JSON_Validate( patch, patchLength );
+    }
+
+    if( ret == JSONSuccess )
+    {
+        m.target = target;
+        m.index = targetIndex;
+        m.indexCount = targetIndexCount;
+        m.patch = patch;
+        m.patchLength = patchLength;
+
+        /* Measure, then output if there is room. */
+        m.buf = NULL;
+        mergePatch( &m );
+
+        required = ( inPlace == true ) ? ( targetLength + m.lead ) : m.length;
+
+        if( required > bufSize )
+        {
+            ret = JSONInsufficientMemory;
+            *outLength = required;
+        }
+    }
+
+    if( ret == JSONSuccess )
+    {
+        if( inPlace == true )
+        {
+            ( void ) memmove( &buf[ m.lead ], target, targetLength );
+            m.target = &buf[ m.lead ];
+        }
+
+        m.buf = buf;
+        mergePatch( &m );
+        *outLength = m.length;
+    }
+
+    return ret;
+}
+
+/** @cond DO_NOT_DOCUMENT */
+
+/**
+ * @brief Advance buffer index beyond a string, without checking its contents.
+ *
+ * @param[in] buf  The buffer to parse.
+ * @param[in,out] start  The index of the opening quote.
+ * @param[in] max  The size of the buffer.
+ */
+static void skipStringUnchecked( const char * buf,
+                                 size_t * start,
+                                 size_t max )
+{
+    size_t i;
+
+    assert( ( buf != NULL ) && ( start != NULL ) && ( *start < max ) );
+    assert( buf[ *start ] == '"' );
+
+    i = *start + 1U;
+
+    while( i < max )
+    {
+        skipBlocks( buf, &i, max, true );
+
+        if( buf[ i ] == '"' )
+        {
+            i++;
+            break;
+        }
+
+        /* Step over an escaped character, which may be a quote. */
+        i += ( buf[ i ] == '\\' ) ? 2U : 1U;
+    }
+
+    *start = ( i < max ) ? i : max;
+}
+
+/** @endcond */
+
+/**
+ * See core_json.h for docs.
+ */
+JSONStatus_t JSON_Minify( char * buf,
+                          size_t max,
+                          size_t * outLength )
+{
+    JSONStatus_t ret = JSONSuccess;
+    size_t i = 0, length = 0, run;
+
+    if( ( buf == NULL ) || ( outLength == NULL ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else if( max == 0U )
+    {
+        ret = JSONBadParameter;
+    }
+    else
+    {
+        while( i < max )
+        {
+            skipSpace( buf, &i, max );
+            run = i;
+
+            /* Find the end of a run of tokens with no whitespace between them. */
+            while( ( i < max ) && !isspace_( buf[ i ] ) )
+            {
+                if( buf[ i ] == '"' )
+                {
+                    skipStringUnchecked( buf, &i, max );
+                }
+                else
+                {
+                    i++;
+                }
+            }
+
+            /* Until the first whitespace, the run is already in place. */
+            if( length != run )
+            {
+                ( void ) memmove( &buf[ length ], &buf[ run ], i - run );
+            }
+
+            length += i - run;
+        }
+
+        *outLength = length;
+    }
+
+    return ret;
+}
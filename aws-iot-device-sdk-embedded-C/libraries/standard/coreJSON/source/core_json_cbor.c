@@ -0,0 +1,1465 @@
+/*
+ * coreJSON v2.0.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_json_cbor.c
+ * @brief The source file that implements the user-facing functions in core_json_cbor.h.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "core_json_cbor.h"
+#include "core_json_number.h"
+
+/** @cond DO_NOT_DOCUMENT */
+
+typedef enum
+{
+    true = 1,
+    false = 0
+} bool_;
+
+/* Major types of a CBOR data item. */
+#define CBOR_UNSIGNED       ( 0U )
+#define CBOR_NEGATIVE       ( 1U )
+#define CBOR_BYTES          ( 2U )
+#define CBOR_TEXT           ( 3U )
+#define CBOR_ARRAY          ( 4U )
+#define CBOR_MAP            ( 5U )
+#define CBOR_TAG            ( 6U )
+#define CBOR_SIMPLE         ( 7U )
+
+/* Additional information in the initial byte of a data item. */
+#define CBOR_ONE_BYTE       ( 24U )
+#define CBOR_EIGHT_BYTES    ( 27U )
+#define CBOR_INDEFINITE     ( 31U )
+
+/* Initial bytes of simple values and floats. */
+#define CBOR_FALSE          ( 0xF4U )
+#define CBOR_TRUE           ( 0xF5U )
+#define CBOR_NULL           ( 0xF6U )
+#define CBOR_HALF           ( 0xF9U )
+#define CBOR_FLOAT          ( 0xFAU )
+#define CBOR_DOUBLE         ( 0xFBU )
+#define CBOR_BREAK          ( 0xFFU )
+
+/* Simple values of the additional information. */
+#define SIMPLE_FALSE        ( 20U )
+#define SIMPLE_TRUE         ( 21U )
+#define SIMPLE_NULL         ( 22U )
+#define SIMPLE_HALF         ( 25U )
+#define SIMPLE_FLOAT        ( 26U )
+#define SIMPLE_DOUBLE       ( 27U )
+
+/* The longest head: an initial byte and an 8-byte argument. */
+#define HEAD_MAX_LENGTH     ( 9U )
+
+/* The magnitude of the least CBOR integer, -2^64. */
+#define MAGNITUDE_2_64      "18446744073709551616"
+
+/* Room for the longest integer key: a sign and 20 digits. */
+#define INTEGER_MAX_LENGTH  ( 21U )
+
+/* Fields of an IEEE 754 double. */
+#define DOUBLE_MANTISSA_BITS    ( 52U )
+#define DOUBLE_MANTISSA_MASK    ( ( ( uint64_t ) 1U << DOUBLE_MANTISSA_BITS ) - 1U )
+#define DOUBLE_EXPONENT_MASK    ( 0x7FFU )
+#define DOUBLE_EXPONENT_BIAS    ( 1023 )
+
+/**
+ * @brief CBOR output to a caller's buffer.
+ *
+ * Once the buffer is too small, output is only measured.
+ */
+typedef struct
+{
+    uint8_t * buf;
+    size_t size;
+    size_t length; /* bytes of CBOR so far, whether stored or not */
+    bool_ full;    /* true once output no longer fits in buf */
+} cborOutput_t;
+
+/**
+ * @brief A collection being transcoded by JSON_ToCbor().
+ */
+typedef struct
+{
+    size_t head;     /* offset of the head of the collection in the output */
+    size_t count;    /* members so far */
+    bool_ isObject;
+} encodeFrame_t;
+
+/**
+ * @brief A collection being transcoded by JSON_WriteCbor().
+ */
+typedef struct
+{
+    uint64_t remaining; /* data items left, for a definite length */
+    bool_ indefinite;
+    bool_ isMap;
+    bool_ isKey;        /* true if the next data item is a key */
+} decodeFrame_t;
+
+/**
+ * @brief The state of JSON_WriteCbor().
+ */
+typedef struct
+{
+    const uint8_t * cbor;
+    size_t length;
+    size_t i;                             /* offset of the next data item */
+    JSONWriter_t * writer;                /* NULL to only check the data item */
+    int16_t depth;                        /* index of the innermost collection, or -1 */
+    decodeFrame_t stack[ JSON_MAX_DEPTH ];
+    bool_ tagged;                         /* true if a tag awaits its content */
+    bool_ done;                           /* true once the root is complete */
+} cborReader_t;
+
+/**
+ * @brief Append bytes to the output, or only measure them if they do
+ * not fit.
+ *
+ * @param[in,out] output  The output.
+ * @param[in] bytes  The bytes.
+ * @param[in] length  The number of bytes.
+ */
+static void emitBytes( cborOutput_t * output,
+                       const uint8_t * bytes,
+                       size_t length )
+{
+    assert( output != NULL );
+
+    if( ( output->full == false ) && ( length <= ( output->size - output->length ) ) )
+    {
+        if( length > 0U )
+        {
+            ( void ) memcpy( &output->buf[ output->length ], bytes, length );
+        }
+    }
+    else
+    {
+        output->full = true;
+    }
+
+    output->length += length;
+}
+
+/**
+ * @brief Append a byte to the output.
+ *
+ * @param[in,out] output  The output.
+ * @param[in] byte  The byte.
+ */
+static void emitByte( cborOutput_t * output,
+                      uint8_t byte )
+{
+    emitBytes( output, &byte, 1U );
+}
+
+/**
+ * @brief Encode the shortest head of a data item.
+ *
+ * @param[out] head  The head; HEAD_MAX_LENGTH bytes.
+ * @param[in] major  The major type.
+ * @param[in] argument  The argument: a value, length or count.
+ *
+ * @return The length of the head.
+ */
+static size_t encodeHead( uint8_t * head,
+                          uint8_t major,
+                          uint64_t argument )
+{
+    size_t length, i;
+    uint8_t info;
+    uint64_t value = argument;
+
+    if( value < CBOR_ONE_BYTE )
+    {
+        info = ( uint8_t ) value;
+        length = 1U;
+    }
+    else if( value <= UINT8_MAX )
+    {
+        info = CBOR_ONE_BYTE;
+        length = 2U;
+    }
+    else if( value <= UINT16_MAX )
+    {
+        info = CBOR_ONE_BYTE + 1U;
+        length = 3U;
+    }
+    else if( value <= UINT32_MAX )
+    {
+        info = CBOR_ONE_BYTE + 2U;
+        length = 5U;
+    }
+    else
+    {
+        info = CBOR_EIGHT_BYTES;
+        length = 9U;
+    }
+
+    head[ 0 ] = ( uint8_t ) ( major << 5 ) | info;
+
+    for( i = length - 1U; i > 0U; i-- )
+    {
+        head[ i ] = ( uint8_t ) value;
+        value >>= 8;
+    }
+
+    return length;
+}
+
+/**
+ * @brief Append the head of a data item to the output.
+ *
+ * @param[in,out] output  The output.
+ * @param[in] major  The major type.
+ * @param[in] argument  The argument: a value, length or count.
+ */
+static void emitHead( cborOutput_t * output,
+                      uint8_t major,
+                      uint64_t argument )
+{
+    uint8_t head[ HEAD_MAX_LENGTH ];
+    size_t length;
+
+    length = encodeHead( head, major, argument );
+    emitBytes( output, head, length );
+}
+
+/**
+ * @brief Append the bits of a float, most significant first.
+ *
+ * @param[in,out] output  The output.
+ * @param[in] initial  The initial byte, which gives the precision.
+ * @param[in] bits  The bits.
+ * @param[in] length  The number of bytes of the float.
+ */
+static void emitFloat( cborOutput_t * output,
+                       uint8_t initial,
+                       uint64_t bits,
+                       size_t length )
+{
+    uint8_t bytes[ HEAD_MAX_LENGTH ];
+    uint64_t value = bits;
+    size_t i;
+
+    bytes[ 0 ] = initial;
+
+    for( i = length; i > 0U; i-- )
+    {
+        bytes[ i ] = ( uint8_t ) value;
+        value >>= 8;
+    }
+
+    emitBytes( output, bytes, length + 1U );
+}
+
+/**
+ * @brief Narrow a double to a binary float of fewer bits, if it is exact.
+ *
+ * @param[in] bits  The bits of the double; not an infinity or NaN.
+ * @param[in] exponentBits  The exponent bits of the narrow float.
+ * @param[in] mantissaBits  The mantissa bits of the narrow float.
+ * @param[out] outBits  The bits of the narrow float.
+ *
+ * @return true if the narrow float holds the double exactly;
+ * false otherwise.
+ */
+static bool_ narrowDouble( uint64_t bits,
+                           uint32_t exponentBits,
+                           uint32_t mantissaBits,
+                           uint64_t * outBits )
+{
+    bool_ ret = false;
+    uint64_t mantissa = bits & DOUBLE_MANTISSA_MASK;
+    int32_t biased = ( int32_t ) ( ( bits >> DOUBLE_MANTISSA_BITS ) & DOUBLE_EXPONENT_MASK );
+    int32_t exponent = biased - DOUBLE_EXPONENT_BIAS;
+    int32_t bias = ( ( int32_t ) 1 << ( exponentBits - 1U ) ) - 1;
+    int32_t minNormal = 1 - bias;
+    uint64_t sign = ( bits >> 63 ) << ( exponentBits + mantissaBits );
+    uint32_t drop;
+
+    if( ( biased == 0 ) && ( mantissa == 0U ) )
+    {
+        /* Zero, of either sign. */
+        ret = true;
+        *outBits = sign;
+    }
+    else if( biased == 0 )
+    {
+        /* A subnormal double is too small for any narrower float. */
+    }
+    else if( ( exponent >= minNormal ) && ( exponent <= bias ) )
+    {
+        drop = DOUBLE_MANTISSA_BITS - mantissaBits;
+
+        if( ( mantissa & ( ( ( uint64_t ) 1U << drop ) - 1U ) ) == 0U )
+        {
+            ret = true;
+            *outBits = sign |
+                       ( ( uint64_t ) ( exponent + bias ) << mantissaBits ) |
+                       ( mantissa >> drop );
+        }
+    }
+    else if( ( exponent < minNormal ) &&
+             ( exponent >= ( minNormal - ( int32_t ) mantissaBits ) ) )
+    {
+        /* A subnormal of the narrow float, with the implicit bit made explicit. */
+        mantissa |= ( uint64_t ) 1U << DOUBLE_MANTISSA_BITS;
+        drop = DOUBLE_MANTISSA_BITS - mantissaBits + ( uint32_t ) ( minNormal - exponent );
+
+        if( ( mantissa & ( ( ( uint64_t ) 1U << drop ) - 1U ) ) == 0U )
+        {
+            ret = true;
+            *outBits = sign | ( mantissa >> drop );
+        }
+    }
+    else
+    {
+        /* Empty else. */
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Append a double in the shortest precision that holds it exactly.
+ *
+ * @param[in,out] output  The output.
+ * @param[in] value  The double; not an infinity or NaN.
+ */
+static void emitDouble( cborOutput_t * output,
+                        double value )
+{
+    uint64_t bits, narrow = 0U;
+
+    ( void ) memcpy( &bits, &value, sizeof( bits ) );
+
+    if( narrowDouble( bits, 5U, 10U, &narrow ) == true )
+    {
+        emitFloat( output, CBOR_HALF, narrow, 2U );
+    }
+    else if( narrowDouble( bits, 8U, 23U, &narrow ) == true )
+    {
+        emitFloat( output, CBOR_FLOAT, narrow, 4U );
+    }
+    else
+    {
+        emitFloat( output, CBOR_DOUBLE, bits, 8U );
+    }
+}
+
+/**
+ * @brief Append a JSON number, as an integer if it is written as one and
+ * fits, and as a float otherwise.
+ *
+ * @param[in,out] output  The output.
+ * @param[in] value  The number.
+ * @param[in] valueLength  The length of the number.
+ *
+ * @return #JSONSuccess if the number was appended;
+ * #JSONOutOfRange if it is beyond the range of a double.
+ */
+static JSONStatus_t emitNumber( cborOutput_t * output,
+                                const char * value,
+                                size_t valueLength )
+{
+    JSONStatus_t ret;
+    uint64_t magnitude = 0U;
+    double number = 0.0;
+    bool_ negative = ( value[ 0 ] == '-' ) ? true : false;
+
+    /* A negative integer is read by its magnitude, so that the whole range
+     * of CBOR, -2^64 to -1, is kept exact. */
+    if( negative == true )
+    {
+        ret = JSON_GetUint64( &value[ 1 ], valueLength - 1U, &magnitude );
+    }
+    else
+    {
+        ret = JSON_GetUint64( value, valueLength, &magnitude );
+    }
+
+    if( ret == JSONSuccess )
+    {
+        if( ( negative == true ) && ( magnitude > 0U ) )
+        {
+            emitHead( output, CBOR_NEGATIVE, magnitude - 1U );
+        }
+        else
+        {
+            emitHead( output, CBOR_UNSIGNED, magnitude );
+        }
+    }
+    else if( ( negative == true ) && ( ret == JSONOutOfRange ) &&
+             ( ( valueLength - 1U ) == ( sizeof( MAGNITUDE_2_64 ) - 1U ) ) &&
+             ( memcmp( &value[ 1 ], MAGNITUDE_2_64, valueLength - 1U ) == 0 ) )
+    {
+        /* -2^64, the one negative integer whose magnitude is not a uint64_t. */
+        ret = JSONSuccess;
+        emitHead( output, CBOR_NEGATIVE, UINT64_MAX );
+    }
+    else
+    {
+        ret = JSON_GetDouble( value, valueLength, &number );
+
+        if( ret == JSONSuccess )
+        {
+            emitDouble( output, number );
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Append a JSON string as a text string, decoding its escapes.
+ *
+ * @param[in,out] output  The output.
+ * @param[in] value  The string, without quotes.
+ * @param[in] valueLength  The length of the string.
+ *
+ * @return #JSONSuccess if the string was appended;
+ * #JSONIllegalDocument if an escape sequence is invalid.
+ */
+static JSONStatus_t emitText( cborOutput_t * output,
+                              const char * value,
+                              size_t valueLength )
+{
+    JSONStatus_t ret;
+    const char * text = NULL;
+    size_t textLength = 0U;
+
+    /* Measure the text; with no escapes, the string is its own text. */
+    ret = JSON_Unescape( value, valueLength, NULL, 0U, &text, &textLength );
+
+    if( ret == JSONSuccess )
+    {
+        emitHead( output, CBOR_TEXT, textLength );
+        emitBytes( output, ( const uint8_t * ) text, textLength );
+    }
+    else if( ret == JSONInsufficientMemory )
+    {
+        ret = JSONSuccess;
+        emitHead( output, CBOR_TEXT, textLength );
+
+        /* Decode the escapes straight into the output. */
+        if( ( output->full == false ) && ( textLength <= ( output->size - output->length ) ) )
+        {
+            ( void ) JSON_Unescape( value, valueLength,
+                                    ( char * ) &output->buf[ output->length ], textLength,
+                                    &text, &textLength );
+        }
+        else
+        {
+            output->full = true;
+        }
+
+        output->length += textLength;
+    }
+    else
+    {
+        /* Empty else. */
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Finish the head of a collection, now that its count is known.
+ *
+ * The collection was opened with a head of one byte; a longer head moves
+ * its members up.
+ *
+ * @param[in,out] output  The output.
+ * @param[in] frame  The collection.
+ */
+static void closeCollection( cborOutput_t * output,
+                             const encodeFrame_t * frame )
+{
+    uint8_t head[ HEAD_MAX_LENGTH ];
+    size_t length;
+
+    length = encodeHead( head,
+                         ( frame->isObject == true ) ? CBOR_MAP : CBOR_ARRAY,
+                         frame->count );
+
+    if( ( output->full == false ) && ( ( length - 1U ) <= ( output->size - output->length ) ) )
+    {
+        if( length > 1U )
+        {
+            ( void ) memmove( &output->buf[ frame->head + length ],
+                              &output->buf[ frame->head + 1U ],
+                              output->length - frame->head - 1U );
+        }
+
+        ( void ) memcpy( &output->buf[ frame->head ], head, length );
+    }
+    else
+    {
+        output->full = true;
+    }
+
+    output->length += length - 1U;
+}
+
+/**
+ * @brief Find the closing quote of a string.
+ *
+ * @param[in] buf  The validated JSON document.
+ * @param[in] max  The size of the document.
+ * @param[in] start  The offset of the opening quote.
+ *
+ * @return The offset of the closing quote.
+ */
+static size_t stringEnd( const char * buf,
+                         size_t max,
+                         size_t start )
+{
+    size_t i = start + 1U;
+    const char * quote = NULL;
+    const char * backslash;
+
+    while( quote == NULL )
+    {
+        quote = memchr( &buf[ i ], '"', max - i );
+        assert( quote != NULL );
+
+        backslash = memchr( &buf[ i ], '\\', ( size_t ) ( quote - &buf[ i ] ) );
+
+        if( backslash != NULL )
+        {
+            /* The quote may be escaped; go on after the escaped character. */
+            i = ( size_t ) ( backslash - buf ) + 2U;
+            quote = NULL;
+        }
+    }
+
+    return ( size_t ) ( quote - buf );
+}
+
+/**
+ * @brief Check whether a character may be part of a number.
+ *
+ * @param[in] c  The character.
+ *
+ * @return true if it may; false otherwise.
+ */
+static bool_ isNumberChar( char c )
+{
+    return ( ( ( c >= '0' ) && ( c <= '9' ) ) ||
+             ( c == '-' ) || ( c == '+' ) || ( c == '.' ) ||
+             ( c == 'e' ) || ( c == 'E' ) ) ? true : false;
+}
+
+/**
+ * @brief Transcode a validated JSON document to CBOR.
+ *
+ * @param[in] buf  The validated JSON document.
+ * @param[in] max  The size of the document.
+ * @param[in,out] output  The output.
+ *
+ * @return #JSONSuccess if the document was transcoded;
+ * #JSONIllegalDocument if a string has an invalid escape;
+ * #JSONOutOfRange if a number is beyond the range of a double.
+ */
+static JSONStatus_t encode( const char * buf,
+                            size_t max,
+                            cborOutput_t * output )
+{
+    JSONStatus_t ret = JSONSuccess;
+    encodeFrame_t stack[ JSON_MAX_DEPTH ];
+    int16_t depth = -1;
+    bool_ isKey = false;
+    size_t i = 0U, end;
+    char c;
+
+    while( ( i < max ) && ( ret == JSONSuccess ) )
+    {
+        c = buf[ i ];
+
+        switch( c )
+        {
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+            case ':':
+                i++;
+                break;
+
+            case ',':
+                /* The next string of an object is a key. */
+                isKey = stack[ depth ].isObject;
+                i++;
+                break;
+
+            case '{':
+            case '[':
+                assert( depth < ( JSON_MAX_DEPTH - 1 ) );
+
+                if( depth >= 0 )
+                {
+                    stack[ depth ].count++;
+                }
+
+                depth++;
+                stack[ depth ].head = output->length;
+                stack[ depth ].count = 0U;
+                stack[ depth ].isObject = ( c == '{' ) ? true : false;
+                isKey = stack[ depth ].isObject;
+                emitByte( output, 0U );
+                i++;
+                break;
+
+            case '}':
+            case ']':
+                closeCollection( output, &stack[ depth ] );
+                depth--;
+                i++;
+                break;
+
+            case '"':
+
+                if( ( depth >= 0 ) && ( isKey == false ) )
+                {
+                    stack[ depth ].count++;
+                }
+
+                end = stringEnd( buf, max, i );
+                ret = emitText( output, &buf[ i + 1U ], end - i - 1U );
+                isKey = false;
+                i = end + 1U;
+                break;
+
+            default:
+
+                if( depth >= 0 )
+                {
+                    stack[ depth ].count++;
+                }
+
+                if( c == 't' )
+                {
+                    emitByte( output, CBOR_TRUE );
+                    i += sizeof( "true" ) - 1U;
+                }
+                else if( c == 'f' )
+                {
+                    emitByte( output, CBOR_FALSE );
+                    i += sizeof( "false" ) - 1U;
+                }
+                else if( c == 'n' )
+                {
+                    emitByte( output, CBOR_NULL );
+                    i += sizeof( "null" ) - 1U;
+                }
+                else
+                {
+                    end = i + 1U;
+
+                    while( ( end < max ) && ( isNumberChar( buf[ end ] ) == true ) )
+                    {
+                        end++;
+                    }
+
+                    ret = emitNumber( output, &buf[ i ], end - i );
+                    i = end;
+                }
+
+                break;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Map a status of the writer to the result of a transcoding step.
+ *
+ * A writer out of space goes on measuring, so transcoding goes on.
+ *
+ * @param[in] status  The status of the writer.
+ *
+ * @return #JSONSuccess if the writer accepts more calls; status otherwise.
+ */
+static JSONStatus_t written( JSONStatus_t status )
+{
+    return ( status == JSONInsufficientMemory ) ? JSONSuccess : status;
+}
+
+/**
+ * @brief Check that a text string is UTF-8 with no NUL.
+ *
+ * @param[in] text  The text string.
+ * @param[in] length  The length of the text string.
+ *
+ * @return true if it is; false otherwise.
+ */
+static bool_ isText( const uint8_t * text,
+                     size_t length )
+{
+    bool_ ret = true;
+    size_t i = 0U, n, k;
+    uint32_t codePoint, min;
+    uint8_t c;
+
+    while( ( i < length ) && ( ret == true ) )
+    {
+        c = text[ i ];
+        n = 0U;
+        codePoint = c;
+        min = 0U;
+
+        if( c == 0U )
+        {
+            ret = false;
+        }
+        else if( c < 0x80U )
+        {
+            /* ASCII. */
+        }
+        else if( ( c & 0xE0U ) == 0xC0U )
+        {
+            n = 1U;
+            codePoint = c & 0x1FU;
+            min = 0x80U;
+        }
+        else if( ( c & 0xF0U ) == 0xE0U )
+        {
+            n = 2U;
+            codePoint = c & 0x0FU;
+            min = 0x800U;
+        }
+        else if( ( c & 0xF8U ) == 0xF0U )
+        {
+            n = 3U;
+            codePoint = c & 0x07U;
+            min = 0x10000U;
+        }
+        else
+        {
+            ret = false;
+        }
+
+        if( ( ret == true ) && ( n >= ( length - i ) ) )
+        {
+            ret = false;
+        }
+
+        for( k = 1U; ( ret == true ) && ( k <= n ); k++ )
+        {
+            if( ( text[ i + k ] & 0xC0U ) != 0x80U )
+            {
+                ret = false;
+            }
+            else
+            {
+                codePoint = ( codePoint << 6 ) | ( text[ i + k ] & 0x3FU );
+            }
+        }
+
+        /* Reject overlong forms, surrogates and code points above U+10FFFF. */
+        if( ( ret == true ) && ( n > 0U ) &&
+            ( ( codePoint < min ) || ( codePoint > 0x10FFFFU ) ||
+              ( ( codePoint >= 0xD800U ) && ( codePoint <= 0xDFFFU ) ) ) )
+        {
+            ret = false;
+        }
+
+        i += n + 1U;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Format a CBOR integer in decimal.
+ *
+ * A negative integer is -1 - argument, whose magnitude may need 65 bits,
+ * so 1 is added to the digits of the argument.
+ *
+ * @param[in] major  #CBOR_UNSIGNED or #CBOR_NEGATIVE.
+ * @param[in] argument  The argument of the integer.
+ * @param[out] buf  The digits; INTEGER_MAX_LENGTH bytes.
+ *
+ * @return The length of the digits.
+ */
+static size_t formatInteger( uint8_t major,
+                             uint64_t argument,
+                             char * buf )
+{
+    char digits[ INTEGER_MAX_LENGTH ];
+    size_t count = 0U, length = 0U;
+    uint64_t value = argument;
+    uint32_t digit, carry = ( major == CBOR_NEGATIVE ) ? 1U : 0U;
+
+    do
+    {
+        digit = ( uint32_t ) ( value % 10U ) + carry;
+        carry = ( digit == 10U ) ? 1U : 0U;
+        digits[ count ] = ( char ) ( '0' + ( digit % 10U ) );
+        count++;
+        value /= 10U;
+    } while( value > 0U );
+
+    if( carry == 1U )
+    {
+        digits[ count ] = '1';
+        count++;
+    }
+
+    if( major == CBOR_NEGATIVE )
+    {
+        buf[ length ] = '-';
+        length++;
+    }
+
+    while( count > 0U )
+    {
+        count--;
+        buf[ length ] = digits[ count ];
+        length++;
+    }
+
+    return length;
+}
+
+/**
+ * @brief Convert the bits of a CBOR float to a double.
+ *
+ * @param[in] info  #SIMPLE_HALF, #SIMPLE_FLOAT or #SIMPLE_DOUBLE.
+ * @param[in] bits  The bits of the float.
+ * @param[out] outValue  The double.
+ *
+ * @return true if the float is finite; false for an infinity or NaN.
+ */
+static bool_ widenFloat( uint8_t info,
+                         uint64_t bits,
+                         double * outValue )
+{
+    bool_ ret = true;
+    uint32_t exponent, single;
+    uint64_t mantissa, wide;
+    float narrow;
+
+    if( info == SIMPLE_HALF )
+    {
+        exponent = ( uint32_t ) ( bits >> 10 ) & 0x1FU;
+        mantissa = bits & 0x3FFU;
+
+        if( exponent == 0x1FU )
+        {
+            ret = false;
+        }
+        else if( exponent == 0U )
+        {
+            /* A subnormal: mantissa * 2^-24, which is exact. */
+            *outValue = ( double ) mantissa / 16777216.0;
+        }
+        else
+        {
+            wide = ( uint64_t ) ( ( int32_t ) exponent - 15 + DOUBLE_EXPONENT_BIAS ) << DOUBLE_MANTISSA_BITS;
+            wide |= mantissa << 42;
+            ( void ) memcpy( outValue, &wide, sizeof( wide ) );
+        }
+
+        if( ( ret == true ) && ( ( bits & 0x8000U ) != 0U ) )
+        {
+            *outValue = -*outValue;
+        }
+    }
+    else if( info == SIMPLE_FLOAT )
+    {
+        single = ( uint32_t ) bits;
+        ( void ) memcpy( &narrow, &single, sizeof( single ) );
+        ret = ( ( ( single >> 23 ) & 0xFFU ) != 0xFFU ) ? true : false;
+        *outValue = ( double ) narrow;
+    }
+    else
+    {
+        ret = ( ( ( bits >> DOUBLE_MANTISSA_BITS ) & DOUBLE_EXPONENT_MASK ) != DOUBLE_EXPONENT_MASK ) ? true : false;
+        ( void ) memcpy( outValue, &bits, sizeof( bits ) );
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Read the head of a data item.
+ *
+ * @param[in,out] reader  The reader, at the head.
+ * @param[out] major  The major type.
+ * @param[out] info  The additional information.
+ * @param[out] argument  The argument; 0 for an indefinite length.
+ *
+ * @return #JSONSuccess if the head was read;
+ * #JSONBadParameter if it is truncated or reserved.
+ */
+static JSONStatus_t readHead( cborReader_t * reader,
+                              uint8_t * major,
+                              uint8_t * info,
+                              uint64_t * argument )
+{
+    JSONStatus_t ret = JSONSuccess;
+    uint8_t initial;
+    size_t length, k;
+    uint64_t value = 0U;
+
+    assert( reader->i < reader->length );
+
+    initial = reader->cbor[ reader->i ];
+    reader->i++;
+    *major = initial >> 5;
+    *info = initial & 0x1FU;
+
+    if( *info < CBOR_ONE_BYTE )
+    {
+        value = *info;
+    }
+    else if( *info <= CBOR_EIGHT_BYTES )
+    {
+        length = ( size_t ) 1U << ( *info - CBOR_ONE_BYTE );
+
+        if( length > ( reader->length - reader->i ) )
+        {
+            ret = JSONBadParameter;
+        }
+        else
+        {
+            for( k = 0U; k < length; k++ )
+            {
+                value = ( value << 8 ) | reader->cbor[ reader->i + k ];
+            }
+
+            reader->i += length;
+        }
+    }
+    else if( *info != CBOR_INDEFINITE )
+    {
+        /* Additional information 28 to 30 is reserved. */
+        ret = JSONBadParameter;
+    }
+    else
+    {
+        /* Empty else. */
+    }
+
+    *argument = value;
+
+    return ret;
+}
+
+/**
+ * @brief Account for a complete data item in its collection.
+ *
+ * @param[in,out] reader  The reader.
+ */
+static void itemDone( cborReader_t * reader )
+{
+    decodeFrame_t * frame;
+
+    if( reader->depth < 0 )
+    {
+        reader->done = true;
+    }
+    else
+    {
+        frame = &reader->stack[ reader->depth ];
+
+        if( frame->indefinite == false )
+        {
+            frame->remaining--;
+        }
+
+        if( frame->isMap == true )
+        {
+            frame->isKey = ( frame->isKey == true ) ? false : true;
+        }
+    }
+}
+
+/**
+ * @brief Transcode an integer.
+ *
+ * @param[in,out] reader  The reader.
+ * @param[in] major  #CBOR_UNSIGNED or #CBOR_NEGATIVE.
+ * @param[in] argument  The argument of the integer.
+ * @param[in] isKey  true if the integer is a map key.
+ *
+ * @return #JSONSuccess, or the error of the writer.
+ */
+static JSONStatus_t readInteger( cborReader_t * reader,
+                                 uint8_t major,
+                                 uint64_t argument,
+                                 bool_ isKey )
+{
+    JSONStatus_t ret = JSONSuccess;
+    char digits[ INTEGER_MAX_LENGTH ];
+    size_t length;
+
+    if( reader->writer != NULL )
+    {
+        if( ( isKey == true ) ||
+            ( ( major == CBOR_NEGATIVE ) && ( argument > ( uint64_t ) INT64_MAX ) ) )
+        {
+            length = formatInteger( major, argument, digits );
+            ret = ( isKey == true ) ?
+                  written( JSON_WriteKey( reader->writer, digits, length ) ) :
+                  written( JSON_WriteRaw( reader->writer, digits, length ) );
+        }
+        else if( major == CBOR_NEGATIVE )
+        {
+            ret = written( JSON_WriteInt64( reader->writer, -1 - ( int64_t ) argument ) );
+        }
+        else
+        {
+            ret = written( JSON_WriteUint64( reader->writer, argument ) );
+        }
+    }
+
+    itemDone( reader );
+
+    return ret;
+}
+
+/**
+ * @brief Transcode a definite-length text string.
+ *
+ * @param[in,out] reader  The reader, after the head.
+ * @param[in] length  The length of the text string.
+ * @param[in] isKey  true if the text string is a map key.
+ *
+ * @return #JSONSuccess if the text string was transcoded;
+ * #JSONBadParameter if it is truncated, not UTF-8 or contains NUL;
+ * or the error of the writer.
+ */
+static JSONStatus_t readText( cborReader_t * reader,
+                              uint64_t length,
+                              bool_ isKey )
+{
+    JSONStatus_t ret = JSONSuccess;
+    const char * text = ( const char * ) &reader->cbor[ reader->i ];
+
+    if( length > ( reader->length - reader->i ) )
+    {
+        ret = JSONBadParameter;
+    }
+    else if( reader->writer == NULL )
+    {
+        if( isText( &reader->cbor[ reader->i ], ( size_t ) length ) == false )
+        {
+            ret = JSONBadParameter;
+        }
+    }
+    else if( isKey == true )
+    {
+        ret = written( JSON_WriteKey( reader->writer, text, ( size_t ) length ) );
+    }
+    else
+    {
+        ret = written( JSON_WriteString( reader->writer, text, ( size_t ) length ) );
+    }
+
+    if( ret == JSONSuccess )
+    {
+        reader->i += ( size_t ) length;
+        itemDone( reader );
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Transcode a simple value or float.
+ *
+ * @param[in,out] reader  The reader.
+ * @param[in] info  The additional information.
+ * @param[in] argument  The argument.
+ *
+ * @return #JSONSuccess if the value was transcoded;
+ * #JSONBadParameter if it is a malformed simple value;
+ * or the error of the writer.
+ */
+static JSONStatus_t readSimple( cborReader_t * reader,
+                                uint8_t info,
+                                uint64_t argument )
+{
+    JSONStatus_t ret = JSONSuccess;
+    double value = 0.0;
+
+    /* Simple values below 32 must not take an extra byte. */
+    if( ( info == CBOR_ONE_BYTE ) && ( argument < 32U ) )
+    {
+        ret = JSONBadParameter;
+    }
+    else if( reader->writer == NULL )
+    {
+        /* Only checking. */
+    }
+    else if( info == SIMPLE_FALSE )
+    {
+        ret = written( JSON_WriteLiteral( reader->writer, JSONFalse ) );
+    }
+    else if( info == SIMPLE_TRUE )
+    {
+        ret = written( JSON_WriteLiteral( reader->writer, JSONTrue ) );
+    }
+    else if( ( info >= SIMPLE_HALF ) && ( info <= SIMPLE_DOUBLE ) &&
+             ( widenFloat( info, argument, &value ) == true ) )
+    {
+        ret = written( JSON_WriteDouble( reader->writer, value ) );
+    }
+    else
+    {
+        /* null, and the substitute for what JSON cannot represent. */
+        ret = written( JSON_WriteLiteral( reader->writer, JSONNull ) );
+    }
+
+    if( ret == JSONSuccess )
+    {
+        itemDone( reader );
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Start transcoding an array or map.
+ *
+ * @param[in,out] reader  The reader.
+ * @param[in] major  #CBOR_ARRAY or #CBOR_MAP.
+ * @param[in] info  The additional information.
+ * @param[in] argument  The count of the collection.
+ *
+ * @return #JSONSuccess if the collection was started;
+ * #JSONBadParameter if its count exceeds what is left of the data item;
+ * #JSONMaxDepthExceeded if it nests too deep;
+ * or the error of the writer.
+ */
+static JSONStatus_t beginCollection( cborReader_t * reader,
+                                     uint8_t major,
+                                     uint8_t info,
+                                     uint64_t argument )
+{
+    JSONStatus_t ret = JSONSuccess;
+    decodeFrame_t * frame;
+    bool_ isMap = ( major == CBOR_MAP ) ? true : false;
+    uint64_t perItem = ( isMap == true ) ? 2U : 1U;
+
+    if( reader->depth >= ( JSON_MAX_DEPTH - 1 ) )
+    {
+        ret = JSONMaxDepthExceeded;
+    }
+    /* Each data item takes at least a byte. */
+    else if( ( info != CBOR_INDEFINITE ) &&
+             ( argument > ( ( reader->length - reader->i ) / perItem ) ) )
+    {
+        ret = JSONBadParameter;
+    }
+    else if( reader->writer != NULL )
+    {
+        ret = ( isMap == true ) ?
+              written( JSON_WriteObjectStart( reader->writer ) ) :
+              written( JSON_WriteArrayStart( reader->writer ) );
+    }
+    else
+    {
+        /* Empty else. */
+    }
+
+    if( ret == JSONSuccess )
+    {
+        reader->depth++;
+        frame = &reader->stack[ reader->depth ];
+        frame->remaining = argument * perItem;
+        frame->indefinite = ( info == CBOR_INDEFINITE ) ? true : false;
+        frame->isMap = isMap;
+        frame->isKey = isMap;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Finish transcoding the innermost array or map.
+ *
+ * @param[in,out] reader  The reader.
+ *
+ * @return #JSONSuccess, or the error of the writer.
+ */
+static JSONStatus_t endCollection( cborReader_t * reader )
+{
+    JSONStatus_t ret = JSONSuccess;
+
+    if( reader->writer != NULL )
+    {
+        ret = ( reader->stack[ reader->depth ].isMap == true ) ?
+              written( JSON_WriteObjectEnd( reader->writer ) ) :
+              written( JSON_WriteArrayEnd( reader->writer ) );
+    }
+
+    reader->depth--;
+    itemDone( reader );
+
+    return ret;
+}
+
+/**
+ * @brief Transcode the data item that starts at the reader.
+ *
+ * @param[in,out] reader  The reader.
+ *
+ * @return #JSONSuccess if the data item was transcoded, or started if it
+ * is a collection; #JSONBadParameter if it is malformed or not supported;
+ * #JSONMaxDepthExceeded if it nests too deep; or the error of the writer.
+ */
+static JSONStatus_t readItem( cborReader_t * reader )
+{
+    JSONStatus_t ret;
+    uint8_t major = 0U, info = 0U;
+    uint64_t argument = 0U;
+    const decodeFrame_t * frame = ( reader->depth >= 0 ) ? &reader->stack[ reader->depth ] : NULL;
+    bool_ isKey = ( ( frame != NULL ) && ( frame->isKey == true ) ) ? true : false;
+
+    ret = readHead( reader, &major, &info, &argument );
+
+    if( ret != JSONSuccess )
+    {
+        /* Malformed head. */
+    }
+    else if( major == CBOR_TAG )
+    {
+        /* Tags are ignored; their content stands for them. */
+        if( info == CBOR_INDEFINITE )
+        {
+            ret = JSONBadParameter;
+        }
+        else
+        {
+            reader->tagged = true;
+        }
+    }
+    else
+    {
+        reader->tagged = false;
+
+        if( ( info == CBOR_INDEFINITE ) &&
+            ( major != CBOR_ARRAY ) && ( major != CBOR_MAP ) )
+        {
+            /* Indefinite-length strings are not supported, and a break
+             * outside an indefinite-length collection is malformed. */
+            ret = JSONBadParameter;
+        }
+        else if( ( major == CBOR_UNSIGNED ) || ( major == CBOR_NEGATIVE ) )
+        {
+            ret = readInteger( reader, major, argument, isKey );
+        }
+        else if( major == CBOR_TEXT )
+        {
+            ret = readText( reader, argument, isKey );
+        }
+        else if( isKey == true )
+        {
+            /* JSON keys are strings; only text and integers convert. */
+            ret = JSONBadParameter;
+        }
+        else if( ( major == CBOR_ARRAY ) || ( major == CBOR_MAP ) )
+        {
+            ret = beginCollection( reader, major, info, argument );
+        }
+        else if( major == CBOR_SIMPLE )
+        {
+            ret = readSimple( reader, info, argument );
+        }
+        else
+        {
+            /* Byte strings are not supported. */
+            ret = JSONBadParameter;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Transcode, or only check, a CBOR data item.
+ *
+ * @param[in,out] reader  The reader, at the start of the data item.
+ *
+ * @return #JSONSuccess if the data item is complete and well formed;
+ * #JSONBadParameter if it is not, or is not supported;
+ * #JSONMaxDepthExceeded if it nests too deep; or the error of the writer.
+ */
+static JSONStatus_t decode( cborReader_t * reader )
+{
+    JSONStatus_t ret = JSONSuccess;
+    const decodeFrame_t * frame;
+
+    while( ( ret == JSONSuccess ) && ( reader->done == false ) )
+    {
+        frame = ( reader->depth >= 0 ) ? &reader->stack[ reader->depth ] : NULL;
+
+        if( ( frame != NULL ) && ( frame->indefinite == false ) && ( frame->remaining == 0U ) )
+        {
+            ret = endCollection( reader );
+        }
+        else if( reader->i >= reader->length )
+        {
+            ret = JSONBadParameter;
+        }
+        else if( reader->cbor[ reader->i ] == CBOR_BREAK )
+        {
+            /* A break ends an indefinite-length collection, but not between
+             * a key and its value, nor between a tag and its content. */
+            if( ( frame != NULL ) && ( frame->indefinite == true ) &&
+                ( ( frame->isMap == false ) || ( frame->isKey == true ) ) &&
+                ( reader->tagged == false ) )
+            {
+                reader->i++;
+                ret = endCollection( reader );
+            }
+            else
+            {
+                ret = JSONBadParameter;
+            }
+        }
+        else
+        {
+            ret = readItem( reader );
+        }
+    }
+
+    if( ( ret == JSONSuccess ) && ( reader->i != reader->length ) )
+    {
+        /* More than one data item. */
+        ret = JSONBadParameter;
+    }
+
+    return ret;
+}
+
+/** @endcond */
+
+/**
+ * See core_json_cbor.h for docs.
+ */
+JSONStatus_t JSON_ToCbor( const char * buf,
+                          size_t max,
+                          uint8_t * out,
+                          size_t outSize,
+                          size_t * outLength )
+{
+    JSONStatus_t ret;
+    cborOutput_t output;
+
+    if( ( buf == NULL ) || ( outLength == NULL ) ||
+        ( ( out == NULL ) && ( outSize > 0U ) ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else if( max == 0U )
+    {
+        ret = JSONBadParameter;
+    }
+    else
+    {
+        ret = JSON_Validate( buf, max );
+    }
+
+    if( ret == JSONSuccess )
+    {
+        output.buf = out;
+        output.size = outSize;
+        output.length = 0U;
+        output.full = false;
+
+        ret = encode( buf, max, &output );
+
+        if( ret == JSONSuccess )
+        {
+            ret = ( output.full == true ) ? JSONInsufficientMemory : JSONSuccess;
+            *outLength = output.length;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_cbor.h for docs.
+ */
+JSONStatus_t JSON_WriteCbor( JSONWriter_t * writer,
+                             const uint8_t * cbor,
+                             size_t cborLength )
+{
+    JSONStatus_t ret = JSONNullParameter;
+    JSONStatus_t checked;
+    cborReader_t reader;
+
+    if( writer != NULL )
+    {
+        if( ( writer->status != JSONSuccess ) && ( writer->status != JSONInsufficientMemory ) )
+        {
+            /* Stopped by an earlier error. */
+        }
+        else if( cbor == NULL )
+        {
+            writer->status = JSONNullParameter;
+        }
+        else
+        {
+            reader.cbor = cbor;
+            reader.length = cborLength;
+            reader.i = 0U;
+            reader.writer = NULL;
+            reader.depth = -1;
+            reader.tagged = false;
+            reader.done = false;
+
+            /* Check the whole data item first, so that a malformed one
+             * stops the writer, as JSON_WriteRaw() does, rather than
+             * leaving part of a value. */
+            checked = decode( &reader );
+
+            if( checked == JSONSuccess )
+            {
+                reader.i = 0U;
+                reader.writer = writer;
+                reader.done = false;
+                ( void ) decode( &reader );
+            }
+            else
+            {
+                writer->status = checked;
+            }
+        }
+
+        ret = writer->status;
+    }
+
+    return ret;
+}
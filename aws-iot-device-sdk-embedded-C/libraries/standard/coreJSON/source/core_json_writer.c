@@ -0,0 +1,1366 @@
+/*
+ * coreJSON v2.0.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_json_writer.c
+ * @brief The source file that implements the user-facing functions in core_json_writer.h.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "core_json_writer.h"
+
+/** @cond DO_NOT_DOCUMENT */
+
+typedef enum
+{
+    true = 1,
+    false = 0
+} bool_;
+
+/* What a writer may accept next. */
+#define WRITE_FIRST    ( 0U ) /* the root, or the first member of a collection */
+#define WRITE_NEXT     ( 1U ) /* a further member, after a comma */
+#define WRITE_VALUE    ( 2U ) /* the value of a key */
+#define WRITE_END      ( 3U ) /* nothing; the root is complete */
+
+/* Room for the longest double: a sign, 17 digits, 5 leading zeros and "0.". */
+#define DOUBLE_MAX_LENGTH     ( 32U )
+
+/* Room for the longest 64-bit integer: a sign and 20 digits. */
+#define INTEGER_MAX_LENGTH    ( 21U )
+
+/* Fields of an IEEE 754 double. */
+#define DOUBLE_MANTISSA_BITS      ( 52U )
+#define DOUBLE_MANTISSA_MASK      ( ( ( uint64_t ) 1U << DOUBLE_MANTISSA_BITS ) - 1U )
+#define DOUBLE_EXPONENT_MASK      ( 0x7FFU )
+#define DOUBLE_EXPONENT_BIAS      ( 1075 ) /* bias plus mantissa bits */
+#define DOUBLE_INTEGER_EXPONENT   ( 1075U ) /* biased exponent of 2^52 */
+#define DOUBLE_ONE_EXPONENT       ( 1023U ) /* biased exponent of 1 */
+
+/* The longest shortest representation of a double. */
+#define DOUBLE_MAX_DIGITS         ( 17U )
+
+/* Enough 32-bit words for the scaled values of any double, ~1140 bits. */
+#define BIGNUM_WORDS              ( 40U )
+
+/* An unsigned integer of up to BIGNUM_WORDS words, least significant first. */
+typedef struct
+{
+    uint32_t word[ BIGNUM_WORDS ];
+    size_t count; /* words in use; 0 for zero */
+} bignum_t;
+
+/* The decimal digit pairs 00 to 99. */
+static const char digitPairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Powers of ten up to one billion. */
+static const uint32_t powersOfTen[] =
+{
+    1U, 10U, 100U, 1000U, 10000U, 100000U, 1000000U,
+    10000000U, 100000000U, 1000000000U
+};
+
+/**
+ * @brief Check whether a writer accepts more calls.
+ *
+ * A writer out of space goes on measuring the document.
+ *
+ * @param[in] writer  The writer.
+ *
+ * @return true if the writer is not stopped by an error;
+ * false otherwise.
+ */
+static bool_ isWriting( const JSONWriter_t * writer )
+{
+    assert( writer != NULL );
+
+    return ( ( writer->status == JSONSuccess ) ||
+             ( writer->status == JSONInsufficientMemory ) ) ? true : false;
+}
+
+/**
+ * @brief Stop a writer with an error.
+ *
+ * @param[in,out] writer  The writer.
+ * @param[in] status  The error.
+ */
+static void stopWriting( JSONWriter_t * writer,
+                         JSONStatus_t status )
+{
+    assert( writer != NULL );
+
+    if( isWriting( writer ) == true )
+    {
+        writer->status = status;
+    }
+}
+
+/**
+ * @brief Pass the contents of the buffer to the sink.
+ *
+ * Without a sink, the output is out of space.
+ *
+ * @param[in,out] writer  The writer.
+ */
+static void flush( JSONWriter_t * writer )
+{
+    int32_t taken;
+
+    assert( writer != NULL );
+
+    if( writer->sink == NULL )
+    {
+        writer->status = JSONInsufficientMemory;
+    }
+    else if( writer->length > 0U )
+    {
+        taken = writer->sink( writer->context, writer->buf, writer->length );
+
+        if( ( taken < 0 ) || ( ( size_t ) taken != writer->length ) )
+        {
+            writer->status = JSONInsufficientMemory;
+        }
+        else
+        {
+            writer->length = 0U;
+        }
+    }
+    else
+    {
+        /* Empty else. */
+    }
+}
+
+/**
+ * @brief Add bytes to the output.
+ *
+ * Once out of space, the bytes are only counted.
+ *
+ * @param[in,out] writer  The writer.
+ * @param[in] s  The bytes to add.
+ * @param[in] n  The number of bytes.
+ */
+static void emit( JSONWriter_t * writer,
+                  const char * s,
+                  size_t n )
+{
+    size_t i = 0U, room;
+
+    assert( writer != NULL );
+    assert( ( s != NULL ) || ( n == 0U ) );
+
+    writer->total += n;
+
+    while( ( i < n ) && ( writer->status == JSONSuccess ) )
+    {
+        room = writer->size - writer->length;
+
+        if( room == 0U )
+        {
+            flush( writer );
+        }
+        else
+        {
+            if( room > ( n - i ) )
+            {
+                room = n - i;
+            }
+
+            ( void ) memcpy( &writer->buf[ writer->length ], &s[ i ], room );
+            writer->length += room;
+            i += room;
+        }
+    }
+}
+
+/**
+ * @brief Add a single byte to the output.
+ *
+ * @param[in,out] writer  The writer.
+ * @param[in] c  The byte to add.
+ */
+static void emitByte( JSONWriter_t * writer,
+                      char c )
+{
+    emit( writer, &c, 1U );
+}
+
+/**
+ * @brief Prepare to write a value, adding a comma when one is due.
+ *
+ * @param[in,out] writer  The writer.
+ *
+ * @return true if a value may be written;
+ * false otherwise.
+ */
+static bool_ beginValue( JSONWriter_t * writer )
+{
+    bool_ ret = false;
+
+    assert( writer != NULL );
+
+    if( isWriting( writer ) == false )
+    {
+        /* Stopped by an earlier error. */
+    }
+    else if( ( writer->expect == WRITE_END ) ||
+             ( ( writer->depth >= 0 ) &&
+               ( writer->stack[ writer->depth ] == '{' ) &&
+               ( writer->expect != WRITE_VALUE ) ) )
+    {
+        /* The root is complete, or a key is missing. */
+        stopWriting( writer, JSONIllegalDocument );
+    }
+    else
+    {
+        if( writer->expect == WRITE_NEXT )
+        {
+            emitByte( writer, ',' );
+        }
+
+        ret = true;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Record that a value was written.
+ *
+ * @param[in,out] writer  The writer.
+ */
+static void endValue( JSONWriter_t * writer )
+{
+    assert( writer != NULL );
+
+    writer->expect = ( writer->depth < 0 ) ? WRITE_END : WRITE_NEXT;
+}
+
+/**
+ * @brief Open an object or array.
+ *
+ * @param[in,out] writer  The writer.
+ * @param[in] c  The opening bracket.
+ */
+static void openCollection( JSONWriter_t * writer,
+                            char c )
+{
+    assert( writer != NULL );
+
+    if( beginValue( writer ) == true )
+    {
+        if( writer->depth >= ( ( int16_t ) JSON_MAX_DEPTH - 1 ) )
+        {
+            stopWriting( writer, JSONMaxDepthExceeded );
+        }
+        else
+        {
+            writer->depth++;
+            writer->stack[ writer->depth ] = c;
+            writer->expect = WRITE_FIRST;
+            emitByte( writer, c );
+        }
+    }
+}
+
+/**
+ * @brief Close the innermost object or array.
+ *
+ * @param[in,out] writer  The writer.
+ * @param[in] c  The opening bracket of the collection to close.
+ */
+static void closeCollection( JSONWriter_t * writer,
+                             char c )
+{
+    assert( writer != NULL );
+
+    if( isWriting( writer ) == false )
+    {
+        /* Stopped by an earlier error. */
+    }
+    else if( ( writer->depth < 0 ) ||
+             ( writer->stack[ writer->depth ] != c ) ||
+             ( writer->expect == WRITE_VALUE ) )
+    {
+        /* Nothing to close, the wrong kind, or a key without a value. */
+        stopWriting( writer, JSONIllegalDocument );
+    }
+    else
+    {
+        writer->depth--;
+        emitByte( writer, ( c == '{' ) ? '}' : ']' );
+        endValue( writer );
+    }
+}
+
+/**
+ * @brief Write a quoted string, escaping what JSON requires.
+ *
+ * Runs of bytes needing no escape are copied at once.
+ *
+ * @param[in,out] writer  The writer.
+ * @param[in] s  The string.
+ * @param[in] n  The length of the string.
+ */
+static void writeEscaped( JSONWriter_t * writer,
+                          const char * s,
+                          size_t n )
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    size_t i, run = 0U;
+    uint8_t c;
+    char escape[ 6 ] = { '\\', 'u', '0', '0', '0', '0' };
+    size_t escapeLength;
+
+    assert( ( writer != NULL ) && ( s != NULL ) );
+
+    emitByte( writer, '"' );
+
+    for( i = 0U; ( i < n ) && ( isWriting( writer ) == true ); i++ )
+    {
+        c = ( uint8_t ) s[ i ];
+
+        if( ( c >= ( uint8_t ) ' ' ) && ( c != ( uint8_t ) '"' ) && ( c != ( uint8_t ) '\\' ) )
+        {
+            continue;
+        }
+
+        emit( writer, &s[ run ], i - run );
+        run = i + 1U;
+        escapeLength = 2U;
+
+        switch( c )
+        {
+            case '"':
+            case '\\':
+                escape[ 1 ] = ( char ) c;
+                break;
+
+            case '\b':
+                escape[ 1 ] = 'b';
+                break;
+
+            case '\f':
+                escape[ 1 ] = 'f';
+                break;
+
+            case '\n':
+                escape[ 1 ] = 'n';
+                break;
+
+            case '\r':
+                escape[ 1 ] = 'r';
+                break;
+
+            case '\t':
+                escape[ 1 ] = 't';
+                break;
+
+            default:
+                escape[ 1 ] = 'u';
+                escape[ 4 ] = hexDigits[ c >> 4 ];
+                escape[ 5 ] = hexDigits[ c & 0x0FU ];
+                escapeLength = sizeof( escape );
+                break;
+        }
+
+        if( c == 0U )
+        {
+            stopWriting( writer, JSONBadParameter );
+        }
+        else
+        {
+            emit( writer, escape, escapeLength );
+        }
+    }
+
+    if( isWriting( writer ) == true )
+    {
+        emit( writer, &s[ run ], n - run );
+        emitByte( writer, '"' );
+    }
+}
+
+/**
+ * @brief Format an unsigned integer, two digits at a time.
+ *
+ * The digits are placed at the end of the buffer.
+ *
+ * @param[in] value  The integer.
+ * @param[out] buf  The buffer, with room for 20 digits before end.
+ * @param[in] end  The index just past the last digit.
+ *
+ * @return The index of the first digit.
+ */
+static size_t formatUnsigned( uint64_t value,
+                              char * buf,
+                              size_t end )
+{
+    size_t i = end;
+    uint64_t v = value;
+    uint32_t pair;
+
+    assert( ( buf != NULL ) && ( end >= 20U ) );
+
+    while( v >= 100U )
+    {
+        pair = ( uint32_t ) ( v % 100U ) * 2U;
+        v /= 100U;
+        i -= 2U;
+        buf[ i ] = digitPairs[ pair ];
+        buf[ i + 1U ] = digitPairs[ pair + 1U ];
+    }
+
+    if( v >= 10U )
+    {
+        pair = ( uint32_t ) v * 2U;
+        i -= 2U;
+        buf[ i ] = digitPairs[ pair ];
+        buf[ i + 1U ] = digitPairs[ pair + 1U ];
+    }
+    else
+    {
+        i--;
+        buf[ i ] = ( char ) ( '0' + ( char ) v );
+    }
+
+    return i;
+}
+
+/**
+ * @brief Write an integer value.
+ *
+ * @param[in,out] writer  The writer.
+ * @param[in] magnitude  The absolute value of the integer.
+ * @param[in] negative  Whether the integer is negative.
+ */
+static void writeInteger( JSONWriter_t * writer,
+                          uint64_t magnitude,
+                          bool_ negative )
+{
+    char buf[ INTEGER_MAX_LENGTH ];
+    size_t i;
+
+    assert( writer != NULL );
+
+    if( beginValue( writer ) == true )
+    {
+        i = formatUnsigned( magnitude, buf, sizeof( buf ) );
+
+        if( negative == true )
+        {
+            i--;
+            buf[ i ] = '-';
+        }
+
+        emit( writer, &buf[ i ], sizeof( buf ) - i );
+        endValue( writer );
+    }
+}
+
+/**
+ * @brief Set a bignum to a 64-bit value.
+ *
+ * @param[out] b  The bignum.
+ * @param[in] value  The value.
+ */
+static void bigSet( bignum_t * b,
+                    uint64_t value )
+{
+    assert( b != NULL );
+
+    b->word[ 0 ] = ( uint32_t ) value;
+    b->word[ 1 ] = ( uint32_t ) ( value >> 32 );
+    b->count = ( b->word[ 1 ] != 0U ) ? 2U : ( ( b->word[ 0 ] != 0U ) ? 1U : 0U );
+}
+
+/**
+ * @brief Multiply a bignum by a power of two.
+ *
+ * @param[in,out] b  The bignum.
+ * @param[in] bits  The power of two.
+ */
+static void bigShiftLeft( bignum_t * b,
+                          uint32_t bits )
+{
+    size_t words = bits / 32U, i;
+    uint32_t shift = bits % 32U;
+
+    assert( b != NULL );
+
+    if( b->count > 0U )
+    {
+        assert( ( b->count + words + 1U ) <= BIGNUM_WORDS );
+
+        if( shift == 0U )
+        {
+            for( i = b->count; i > 0U; i-- )
+            {
+                b->word[ i - 1U + words ] = b->word[ i - 1U ];
+            }
+
+            b->count += words;
+        }
+        else
+        {
+            b->word[ b->count + words ] = b->word[ b->count - 1U ] >> ( 32U - shift );
+
+            for( i = b->count - 1U; i > 0U; i-- )
+            {
+                b->word[ i + words ] = ( b->word[ i ] << shift ) |
+                                       ( b->word[ i - 1U ] >> ( 32U - shift ) );
+            }
+
+            b->word[ words ] = b->word[ 0 ] << shift;
+            b->count += words + 1U;
+
+            if( b->word[ b->count - 1U ] == 0U )
+            {
+                b->count--;
+            }
+        }
+
+        for( i = 0U; i < words; i++ )
+        {
+            b->word[ i ] = 0U;
+        }
+    }
+}
+
+/**
+ * @brief Multiply a bignum by a 32-bit value.
+ *
+ * @param[in,out] b  The bignum.
+ * @param[in] factor  The value.
+ */
+static void bigMultiply( bignum_t * b,
+                         uint32_t factor )
+{
+    uint64_t carry = 0U;
+    size_t i;
+
+    assert( b != NULL );
+
+    for( i = 0U; i < b->count; i++ )
+    {
+        carry += ( uint64_t ) b->word[ i ] * factor;
+        b->word[ i ] = ( uint32_t ) carry;
+        carry >>= 32;
+    }
+
+    if( carry != 0U )
+    {
+        assert( b->count < BIGNUM_WORDS );
+        b->word[ b->count ] = ( uint32_t ) carry;
+        b->count++;
+    }
+}
+
+/**
+ * @brief Multiply a bignum by a power of ten.
+ *
+ * @param[in,out] b  The bignum.
+ * @param[in] exponent  The power of ten.
+ */
+static void bigMultiplyPow10( bignum_t * b,
+                              uint32_t exponent )
+{
+    uint32_t e = exponent;
+
+    while( e >= 9U )
+    {
+        bigMultiply( b, powersOfTen[ 9 ] );
+        e -= 9U;
+    }
+
+    if( e > 0U )
+    {
+        bigMultiply( b, powersOfTen[ e ] );
+    }
+}
+
+/**
+ * @brief Compare two bignums.
+ *
+ * @param[in] a  The first bignum.
+ * @param[in] b  The second bignum.
+ *
+ * @return Less than, equal to or greater than 0 as a is less than,
+ * equal to or greater than b.
+ */
+static int32_t bigCompare( const bignum_t * a,
+                           const bignum_t * b )
+{
+    int32_t ret = 0;
+    size_t i;
+
+    assert( ( a != NULL ) && ( b != NULL ) );
+
+    if( a->count != b->count )
+    {
+        ret = ( a->count > b->count ) ? 1 : -1;
+    }
+    else
+    {
+        for( i = a->count; i > 0U; i-- )
+        {
+            if( a->word[ i - 1U ] != b->word[ i - 1U ] )
+            {
+                ret = ( a->word[ i - 1U ] > b->word[ i - 1U ] ) ? 1 : -1;
+                break;
+            }
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Add two bignums.
+ *
+ * @param[out] sum  The sum.
+ * @param[in] a  The first bignum.
+ * @param[in] b  The second bignum.
+ */
+static void bigAdd( bignum_t * sum,
+                    const bignum_t * a,
+                    const bignum_t * b )
+{
+    uint64_t carry = 0U;
+    size_t i, count;
+
+    assert( ( sum != NULL ) && ( a != NULL ) && ( b != NULL ) );
+
+    count = ( a->count > b->count ) ? a->count : b->count;
+
+    for( i = 0U; i < count; i++ )
+    {
+        carry += ( i < a->count ) ? a->word[ i ] : 0U;
+        carry += ( i < b->count ) ? b->word[ i ] : 0U;
+        sum->word[ i ] = ( uint32_t ) carry;
+        carry >>= 32;
+    }
+
+    if( carry != 0U )
+    {
+        assert( count < BIGNUM_WORDS );
+        sum->word[ count ] = ( uint32_t ) carry;
+        count++;
+    }
+
+    sum->count = count;
+}
+
+/**
+ * @brief Subtract a bignum from a larger or equal one.
+ *
+ * @param[in,out] a  The bignum to subtract from.
+ * @param[in] b  The bignum to subtract.
+ */
+static void bigSubtract( bignum_t * a,
+                         const bignum_t * b )
+{
+    uint64_t borrow = 0U, difference;
+    size_t i;
+
+    assert( ( a != NULL ) && ( b != NULL ) && ( a->count >= b->count ) );
+
+    for( i = 0U; i < a->count; i++ )
+    {
+        difference = ( uint64_t ) a->word[ i ] - ( ( i < b->count ) ? b->word[ i ] : 0U ) - borrow;
+        a->word[ i ] = ( uint32_t ) difference;
+        borrow = ( difference >> 63 );
+    }
+
+    assert( borrow == 0U );
+
+    while( ( a->count > 0U ) && ( a->word[ a->count - 1U ] == 0U ) )
+    {
+        a->count--;
+    }
+}
+
+/**
+ * @brief Check whether a digit string has reached the upper bound of the
+ * values that read back as the double.
+ *
+ * @param[in] r  The remainder.
+ * @param[in] high  The distance to the upper bound.
+ * @param[in] s  The scale.
+ * @param[in] inclusive  Whether the bound itself reads back as the double.
+ *
+ * @return true if r + high reaches s;
+ * false otherwise.
+ */
+static bool_ reachesHigh( const bignum_t * r,
+                          const bignum_t * high,
+                          const bignum_t * s,
+                          bool_ inclusive )
+{
+    bignum_t sum;
+    int32_t cmp;
+
+    bigAdd( &sum, r, high );
+    cmp = bigCompare( &sum, s );
+
+    return ( ( cmp > 0 ) || ( ( cmp == 0 ) && ( inclusive == true ) ) ) ? true : false;
+}
+
+/**
+ * @brief Find the shortest digits that read back as a finite, nonzero
+ * double.
+ *
+ * This is the free-format algorithm of Steele and White, as refined by
+ * Burger and Dybvig, in exact integer arithmetic: the double v is scaled
+ * to r / s, with the distances to the midpoints to its neighbors as
+ * low / s and high / s, and digits are produced until the remainder falls
+ * within those distances.
+ *
+ * @param[in] mantissa  The stored mantissa bits.
+ * @param[in] exponent  The stored, biased exponent.
+ * @param[out] digits  The digits, with room for #DOUBLE_MAX_DIGITS.
+ * @param[out] outK  The decimal exponent: the value is 0.digits * 10^outK.
+ *
+ * @return The number of digits.
+ */
+static size_t shortestDigits( uint64_t mantissa,
+                              uint32_t exponent,
+                              char * digits,
+                              int32_t * outK )
+{
+    bignum_t r, s, high, low, twice;
+    uint64_t f;
+    int32_t e, k, bits = 0;
+    uint32_t unequal, d;
+    bool_ even, tooLow, tooHigh;
+    double estimate;
+    size_t count = 0U;
+
+    assert( ( digits != NULL ) && ( outK != NULL ) );
+
+    if( exponent == 0U )
+    {
+        f = mantissa;
+        e = 1 - DOUBLE_EXPONENT_BIAS;
+    }
+    else
+    {
+        f = mantissa | ( ( uint64_t ) 1U << DOUBLE_MANTISSA_BITS );
+        e = ( int32_t ) exponent - DOUBLE_EXPONENT_BIAS;
+    }
+
+    assert( f != 0U );
+
+    /* Round-half-even reading accepts the midpoints of an even mantissa.
+     * The gap below a power of two is half the gap above it. */
+    even = ( ( f & 1U ) == 0U ) ? true : false;
+    unequal = ( ( mantissa == 0U ) && ( exponent > 1U ) ) ? 1U : 0U;
+
+    bigSet( &r, f );
+    bigSet( &s, 1U );
+    bigSet( &high, 1U );
+    bigSet( &low, 1U );
+
+    if( e >= 0 )
+    {
+        bigShiftLeft( &r, ( uint32_t ) e + 1U + unequal );
+        bigShiftLeft( &s, 1U + unequal );
+        bigShiftLeft( &high, ( uint32_t ) e + unequal );
+        bigShiftLeft( &low, ( uint32_t ) e );
+    }
+    else
+    {
+        bigShiftLeft( &r, 1U + unequal );
+        bigShiftLeft( &s, ( uint32_t ) ( 1 - e ) + unequal );
+        bigShiftLeft( &high, unequal );
+    }
+
+    /* Estimate k = ceil( log10( v ) ) from the position of the leading bit;
+     * the estimate may be one too low, which the loop below corrects. */
+    while( ( f >> bits ) > 1U )
+    {
+        bits++;
+    }
+
+    estimate = ( ( double ) ( e + bits ) * 0.30102999566398114 ) - 1e-10;
+    k = ( int32_t ) estimate;
+
+    if( estimate > ( double ) k )
+    {
+        k++;
+    }
+
+    if( k >= 0 )
+    {
+        bigMultiplyPow10( &s, ( uint32_t ) k );
+    }
+    else
+    {
+        bigMultiplyPow10( &r, ( uint32_t ) -k );
+        bigMultiplyPow10( &high, ( uint32_t ) -k );
+        bigMultiplyPow10( &low, ( uint32_t ) -k );
+    }
+
+    while( reachesHigh( &r, &high, &s, even ) == true )
+    {
+        bigMultiply( &s, 10U );
+        k++;
+    }
+
+    do
+    {
+        bigMultiply( &r, 10U );
+        bigMultiply( &high, 10U );
+        bigMultiply( &low, 10U );
+
+        for( d = 0U; bigCompare( &r, &s ) >= 0; d++ )
+        {
+            bigSubtract( &r, &s );
+        }
+
+        tooLow = ( ( bigCompare( &r, &low ) < 0 ) ||
+                   ( ( even == true ) && ( bigCompare( &r, &low ) == 0 ) ) ) ? true : false;
+        tooHigh = reachesHigh( &r, &high, &s, even );
+
+        if( ( tooLow == true ) && ( tooHigh == true ) )
+        {
+            /* Either digit reads back; take the nearer. */
+            bigAdd( &twice, &r, &r );
+
+            if( bigCompare( &twice, &s ) >= 0 )
+            {
+                d++;
+            }
+        }
+        else if( tooHigh == true )
+        {
+            d++;
+        }
+        else
+        {
+            /* Empty else. */
+        }
+
+        assert( ( d <= 9U ) && ( count < DOUBLE_MAX_DIGITS ) );
+        digits[ count ] = ( char ) ( '0' + ( char ) d );
+        count++;
+    } while( ( tooLow == false ) && ( tooHigh == false ) );
+
+    *outK = k;
+
+    return count;
+}
+
+/**
+ * @brief Lay out digits in the notation of JavaScript's Number.toString().
+ *
+ * @param[in] digits  The significant digits.
+ * @param[in] count  The number of digits.
+ * @param[in] k  The decimal exponent: the value is 0.digits * 10^k.
+ * @param[out] out  The text, with room for #DOUBLE_MAX_LENGTH.
+ *
+ * @return The length of the text.
+ */
+static size_t layoutDecimal( const char * digits,
+                             size_t count,
+                             int32_t k,
+                             char * out )
+{
+    size_t n = 0U, i, point;
+    int32_t places = ( int32_t ) count;
+    char exponent[ INTEGER_MAX_LENGTH ];
+
+    assert( ( digits != NULL ) && ( out != NULL ) );
+
+    if( ( k >= places ) && ( k <= 21 ) )
+    {
+        /* An integer, padded with zeros. */
+        ( void ) memcpy( out, digits, count );
+        n = count;
+
+        for( ; n < ( size_t ) k; n++ )
+        {
+            out[ n ] = '0';
+        }
+    }
+    else if( ( k > 0 ) && ( k <= 21 ) )
+    {
+        point = ( size_t ) k;
+        ( void ) memcpy( out, digits, point );
+        out[ point ] = '.';
+        ( void ) memcpy( &out[ point + 1U ], &digits[ point ], count - point );
+        n = count + 1U;
+    }
+    else if( ( k > -6 ) && ( k <= 0 ) )
+    {
+        out[ n++ ] = '0';
+        out[ n++ ] = '.';
+
+        for( i = 0U; i < ( size_t ) -k; i++ )
+        {
+            out[ n++ ] = '0';
+        }
+
+        ( void ) memcpy( &out[ n ], digits, count );
+        n += count;
+    }
+    else
+    {
+        out[ n++ ] = digits[ 0 ];
+
+        if( count > 1U )
+        {
+            out[ n++ ] = '.';
+            ( void ) memcpy( &out[ n ], &digits[ 1 ], count - 1U );
+            n += count - 1U;
+        }
+
+        out[ n++ ] = 'e';
+        out[ n++ ] = ( k > 0 ) ? '+' : '-';
+        i = formatUnsigned( ( uint64_t ) ( ( k > 0 ) ? ( k - 1 ) : ( 1 - k ) ),
+                            exponent,
+                            sizeof( exponent ) );
+        ( void ) memcpy( &out[ n ], &exponent[ i ], sizeof( exponent ) - i );
+        n += sizeof( exponent ) - i;
+    }
+
+    assert( n <= ( DOUBLE_MAX_LENGTH - 1U ) );
+
+    return n;
+}
+
+/**
+ * @brief Write a floating point value with the fewest digits that read back
+ * as the same value.
+ *
+ * Integers below 2^53 are formatted directly.
+ *
+ * @param[in,out] writer  The writer.
+ * @param[in] value  The value.
+ */
+static void writeDouble( JSONWriter_t * writer,
+                         double value )
+{
+    uint64_t bits, mantissa, integer;
+    uint32_t exponent, shift;
+    char out[ DOUBLE_MAX_LENGTH ];
+    char digits[ DOUBLE_MAX_DIGITS ];
+    char integerDigits[ INTEGER_MAX_LENGTH ];
+    size_t n = 0U, i, count;
+    int32_t k;
+
+    assert( writer != NULL );
+
+    ( void ) memcpy( &bits, &value, sizeof( bits ) );
+    mantissa = bits & DOUBLE_MANTISSA_MASK;
+    exponent = ( uint32_t ) ( bits >> DOUBLE_MANTISSA_BITS ) & DOUBLE_EXPONENT_MASK;
+
+    if( exponent == DOUBLE_EXPONENT_MASK )
+    {
+        /* Infinities and NaNs have no JSON form. */
+        stopWriting( writer, JSONBadParameter );
+    }
+    else if( beginValue( writer ) == true )
+    {
+        if( ( bits >> 63 ) != 0U )
+        {
+            out[ n++ ] = '-';
+        }
+
+        shift = DOUBLE_INTEGER_EXPONENT - exponent;
+        integer = mantissa | ( ( uint64_t ) 1U << DOUBLE_MANTISSA_BITS );
+
+        if( ( exponent == 0U ) && ( mantissa == 0U ) )
+        {
+            out[ n++ ] = '0';
+        }
+        else if( ( exponent >= DOUBLE_ONE_EXPONENT ) &&
+                 ( exponent <= DOUBLE_INTEGER_EXPONENT ) &&
+                 ( ( integer & ( ( ( uint64_t ) 1U << shift ) - 1U ) ) == 0U ) )
+        {
+            i = formatUnsigned( integer >> shift, integerDigits, sizeof( integerDigits ) );
+            ( void ) memcpy( &out[ n ], &integerDigits[ i ], sizeof( integerDigits ) - i );
+            n += sizeof( integerDigits ) - i;
+        }
+        else
+        {
+            count = shortestDigits( mantissa, exponent, digits, &k );
+            n += layoutDecimal( digits, count, k, &out[ n ] );
+        }
+
+        emit( writer, out, n );
+        endValue( writer );
+    }
+    else
+    {
+        /* Empty else. */
+    }
+}
+
+/** @endcond */
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSON_WriterInit( JSONWriter_t * writer,
+                              char * buf,
+                              size_t size,
+                              JSONWriterSink_t sink,
+                              void * context )
+{
+    JSONStatus_t ret = JSONSuccess;
+
+    if( ( writer == NULL ) || ( ( buf == NULL ) && ( size > 0U ) ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else if( ( sink != NULL ) && ( size == 0U ) )
+    {
+        ret = JSONBadParameter;
+    }
+    else
+    {
+        writer->buf = buf;
+        writer->size = size;
+        writer->length = 0U;
+        writer->total = 0U;
+        writer->sink = sink;
+        writer->context = context;
+        writer->status = JSONSuccess;
+        writer->depth = -1;
+        writer->expect = WRITE_FIRST;
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSON_WriterFinish( JSONWriter_t * writer,
+                                size_t * outLength )
+{
+    JSONStatus_t ret;
+
+    if( ( writer == NULL ) || ( outLength == NULL ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else if( ( isWriting( writer ) == true ) && ( writer->expect != WRITE_END ) )
+    {
+        ret = JSONPartial;
+    }
+    else
+    {
+        if( ( writer->status == JSONSuccess ) && ( writer->sink != NULL ) )
+        {
+            flush( writer );
+        }
+
+        if( isWriting( writer ) == true )
+        {
+            *outLength = writer->total;
+        }
+
+        ret = writer->status;
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSON_WriteObjectStart( JSONWriter_t * writer )
+{
+    JSONStatus_t ret = JSONNullParameter;
+
+    if( writer != NULL )
+    {
+        openCollection( writer, '{' );
+        ret = writer->status;
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSON_WriteObjectEnd( JSONWriter_t * writer )
+{
+    JSONStatus_t ret = JSONNullParameter;
+
+    if( writer != NULL )
+    {
+        closeCollection( writer, '{' );
+        ret = writer->status;
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSON_WriteArrayStart( JSONWriter_t * writer )
+{
+    JSONStatus_t ret = JSONNullParameter;
+
+    if( writer != NULL )
+    {
+        openCollection( writer, '[' );
+        ret = writer->status;
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSON_WriteArrayEnd( JSONWriter_t * writer )
+{
+    JSONStatus_t ret = JSONNullParameter;
+
+    if( writer != NULL )
+    {
+        closeCollection( writer, '[' );
+        ret = writer->status;
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSON_WriteKey( JSONWriter_t * writer,
+                            const char * key,
+                            size_t keyLength )
+{
+    JSONStatus_t ret = JSONNullParameter;
+
+    if( writer != NULL )
+    {
+        if( isWriting( writer ) == false )
+        {
+            /* Stopped by an earlier error. */
+        }
+        else if( key == NULL )
+        {
+            stopWriting( writer, JSONNullParameter );
+        }
+        else if( ( writer->depth < 0 ) ||
+                 ( writer->stack[ writer->depth ] != '{' ) ||
+                 ( writer->expect == WRITE_VALUE ) )
+        {
+            stopWriting( writer, JSONIllegalDocument );
+        }
+        else
+        {
+            if( writer->expect == WRITE_NEXT )
+            {
+                emitByte( writer, ',' );
+            }
+
+            writeEscaped( writer, key, keyLength );
+            emitByte( writer, ':' );
+            writer->expect = WRITE_VALUE;
+        }
+
+        ret = writer->status;
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSON_WriteString( JSONWriter_t * writer,
+                               const char * value,
+                               size_t valueLength )
+{
+    JSONStatus_t ret = JSONNullParameter;
+
+    if( writer != NULL )
+    {
+        if( value == NULL )
+        {
+            stopWriting( writer, JSONNullParameter );
+        }
+        else if( beginValue( writer ) == true )
+        {
+            writeEscaped( writer, value, valueLength );
+            endValue( writer );
+        }
+        else
+        {
+            /* Empty else. */
+        }
+
+        ret = writer->status;
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSON_WriteInt64( JSONWriter_t * writer,
+                              int64_t value )
+{
+    JSONStatus_t ret = JSONNullParameter;
+
+    if( writer != NULL )
+    {
+        /* Negate in unsigned arithmetic, which also holds INT64_MIN. */
+        writeInteger( writer,
+                      ( value < 0 ) ? ( ( uint64_t ) 0U - ( uint64_t ) value ) : ( uint64_t ) value,
+                      ( value < 0 ) ? true : false );
+        ret = writer->status;
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSON_WriteUint64( JSONWriter_t * writer,
+                               uint64_t value )
+{
+    JSONStatus_t ret = JSONNullParameter;
+
+    if( writer != NULL )
+    {
+        writeInteger( writer, value, false );
+        ret = writer->status;
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSON_WriteDouble( JSONWriter_t * writer,
+                               double value )
+{
+    JSONStatus_t ret = JSONNullParameter;
+
+    if( writer != NULL )
+    {
+        writeDouble( writer, value );
+        ret = writer->status;
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSON_WriteLiteral( JSONWriter_t * writer,
+                                JSONTypes_t literal )
+{
+    JSONStatus_t ret = JSONNullParameter;
+
+    if( writer != NULL )
+    {
+        if( ( literal != JSONTrue ) && ( literal != JSONFalse ) && ( literal != JSONNull ) )
+        {
+            stopWriting( writer, JSONBadParameter );
+        }
+        else if( beginValue( writer ) == true )
+        {
+            if( literal == JSONTrue )
+            {
+                emit( writer, "true", sizeof( "true" ) - 1U );
+            }
+            else if( literal == JSONFalse )
+            {
+                emit( writer, "false", sizeof( "false" ) - 1U );
+            }
+            else
+            {
+                emit( writer, "null", sizeof( "null" ) - 1U );
+            }
+
+            endValue( writer );
+        }
+        else
+        {
+            /* Empty else. */
+        }
+
+        ret = writer->status;
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSON_WriteRaw( JSONWriter_t * writer,
+                            const char * value,
+                            size_t valueLength )
+{
+    JSONStatus_t ret = JSONNullParameter;
+
+    if( writer != NULL )
+    {
+        if( value == NULL )
+        {
+            stopWriting( writer, JSONNullParameter );
+        }
+        else if( ( isWriting( writer ) == true ) &&
+                 ( JSON_Validate( value, valueLength ) != JSONSuccess ) )
+        {
+            stopWriting( writer, JSONBadParameter );
+        }
+        else if( beginValue( writer ) == true )
+        {
+            emit( writer, value, valueLength );
+            endValue( writer );
+        }
+        else
+        {
+            /* Empty else. */
+        }
+
+        ret = writer->status;
+    }
+
+    return ret;
+}
@@ -29,6 +29,7 @@
 #define CORE_JSON_H_
 
 #include <stddef.h>
+#include <stdint.h>
 
 /**
  * @ingroup json_enum_types
@@ -36,15 +37,58 @@
  */
 typedef enum
 {
-    JSONPartial = 0,      /**< @brief JSON document is valid so far but incomplete. */
-    JSONSuccess,          /**< @brief JSON document is valid and complete. */
-    JSONIllegalDocument,  /**< @brief JSON document is invalid or malformed. */
-    JSONMaxDepthExceeded, /**< @brief JSON document has nesting that exceeds JSON_MAX_DEPTH. */
-    JSONNotFound,         /**< @brief Query key could not be found in the JSON document. */
-    JSONNullParameter,    /**< @brief Pointer parameter passed to a function is NULL. */
-    JSONBadParameter      /**< @brief Query key is empty, or any subpart is empty, or max is 0. */
+    JSONPartial = 0,        /**< @brief JSON document is valid so far but incomplete. */
+    JSONSuccess,            /**< @brief JSON document is valid and complete. */
+    JSONIllegalDocument,    /**< @brief JSON document is invalid or malformed. */
+    JSONMaxDepthExceeded,   /**< @brief JSON document has nesting that exceeds JSON_MAX_DEPTH. */
+    JSONNotFound,           /**< @brief Query key could not be found in the JSON document. */
+    JSONNullParameter,      /**< @brief Pointer parameter passed to a function is NULL. */
+    JSONBadParameter,       /**< @brief Query key is empty, or any subpart is empty, or max is 0. */
+    JSONInsufficientMemory, /**< @brief Caller-provided storage is too small for the result. */
+    JSONOutOfRange          /**< @brief Number does not fit in the requested type. */
 } JSONStatus_t;
 
+/**
+ * @ingroup json_enum_types
+ * @brief Value types from the JSON standard.
+ */
+typedef enum
+{
+    JSONInvalid = 0, /**< @brief Not a valid JSON type. */
+    JSONString,      /**< @brief A quote delimited sequence of Unicode characters. */
+    JSONNumber,      /**< @brief A rational number. */
+    JSONTrue,        /**< @brief The literal value true. */
+    JSONFalse,       /**< @brief The literal value false. */
+    JSONNull,        /**< @brief The literal value null. */
+    JSONObject,      /**< @brief A collection of zero or more key-value pairs. */
+    JSONArray        /**< @brief A collection of zero or more values. */
+} JSONTypes_t;
+
+/**
+ * @brief Value of #JSONIndexEntry_t.parent and #JSONIndexEntry_t.nextSibling
+ * when there is no such entry.
+ */
+#define JSON_INDEX_NONE    ( ( size_t ) ~( ( size_t ) 0U ) )
+
+/**
+ * @ingroup json_struct_types
+ * @brief One value of a JSON document, as recorded by JSON_BuildIndex().
+ *
+ * Entries are stored in document order, so the first child of an object
+ * or array, if it has any, is the entry immediately following its own.
+ * Offsets are relative to the start of the indexed buffer.
+ */
+typedef struct JSONIndexEntry
+{
+    JSONTypes_t type;   /**< @brief Type of the value. */
+    size_t offset;      /**< @brief Offset of the value, including any quotes or brackets. */
+    size_t length;      /**< @brief Length of the value, including any quotes or brackets. */
+    size_t key;         /**< @brief Offset of the key, without quotes; 0 outside an object. */
+    size_t keyLength;   /**< @brief Length of the key, without quotes; 0 outside an object. */
+    size_t parent;      /**< @brief Entry of the enclosing collection, or #JSON_INDEX_NONE. */
+    size_t nextSibling; /**< @brief Entry of the next value in the collection, or #JSON_INDEX_NONE. */
+} JSONIndexEntry_t;
+
 /**
  * @brief Parse a buffer to determine if it contains a valid JSON document.
  *
@@ -58,6 +102,11 @@ typedef enum
  * (e.g., string, boolean, number).  To require that a valid document
  * contain an object or array, define JSON_VALIDATE_COLLECTIONS_ONLY.
  *
+ * @note When the compiler targets SSE2, AVX2 or NEON, whitespace and the
+ * ASCII contents of strings are scanned a vector at a time.  The results are
+ * the same as those of the scalar code, which may be selected by defining
+ * JSON_DISABLE_SIMD.
+ *
  * @return #JSONSuccess if the buffer contents are valid JSON;
  * #JSONNullParameter if buf is NULL;
  * #JSONBadParameter if max is 0;
@@ -168,6 +217,708 @@ JSONStatus_t JSON_Search( char * buf,
                           size_t * outValueLength );
 /* @[declare_json_search] */
 
+/**
+ * @ingroup json_struct_types
+ * @brief One object key or array index of a query, as output by
+ * JSON_CompileQuery().
+ *
+ * A key points into the query it was compiled from, which must outlive
+ * the step.  Steps for constant queries may also be written directly with
+ * JSON_QUERY_KEY() and JSON_QUERY_INDEX().
+ */
+typedef struct JSONQueryStep
+{
+    JSONTypes_t type;   /**< @brief #JSONObject for a key, #JSONArray for an array index. */
+    const char * key;   /**< @brief The key, without quotes; NULL for an array index. */
+    size_t keyLength;   /**< @brief Length of the key; 0 for an array index. */
+    uint32_t index;     /**< @brief The array index; 0 for a key. */
+} JSONQueryStep_t;
+
+/**
+ * @brief Initializer of a #JSONQueryStep_t for the key @p k, a string literal.
+ */
+#define JSON_QUERY_KEY( k )      { JSONObject, ( k ), sizeof( k ) - 1U, 0U }
+
+/**
+ * @brief Initializer of a #JSONQueryStep_t for the array index @p n.
+ */
+#define JSON_QUERY_INDEX( n )    { JSONArray, NULL, 0U, ( n ) }
+
+/**
+ * @brief Split a query into the steps that JSON_SearchCompiled() follows.
+ *
+ * The query syntax is that of JSON_Search().  Compiling a query once lets
+ * repeated searches skip parsing it.
+ *
+ * @param[in] query  The object keys and array indexes to search for.
+ * @param[in] queryLength  Length of the query.
+ * @param[out] steps  The array to receive the steps; may be NULL if
+ * @p stepCapacity is 0.
+ * @param[in] stepCapacity  The number of steps available in @p steps.
+ * @param[out] outStepCount  A pointer to receive the number of steps.
+ *
+ * @return #JSONSuccess if the query was compiled;
+ * #JSONNullParameter if query or outStepCount is NULL, or steps is NULL
+ * while stepCapacity is not 0;
+ * #JSONBadParameter if the query is empty, or the portion after a separator
+ * is empty, or an index is too large to convert to a signed 32-bit integer;
+ * #JSONInsufficientMemory if the query has more parts than @p stepCapacity,
+ * in which case @p outStepCount receives the number of steps required.
+ */
+/* @[declare_json_compilequery] */
+JSONStatus_t JSON_CompileQuery( const char * query,
+                                size_t queryLength,
+                                JSONQueryStep_t * steps,
+                                size_t stepCapacity,
+                                size_t * outStepCount );
+/* @[declare_json_compilequery] */
+
+/**
+ * @brief Find the value reached by a compiled query in a JSON document.
+ *
+ * The search and its output are those of JSON_Search() for the query the
+ * steps were compiled from.
+ *
+ * @param[in] buf  The buffer to search.
+ * @param[in] max  size of the buffer.
+ * @param[in] steps  The steps of the query.
+ * @param[in] stepCount  The number of steps.
+ * @param[out] outValue  A pointer to receive the address of the value found.
+ * @param[out] outValueLength  A pointer to receive the length of the value found.
+ *
+ * @return #JSONSuccess if the query is matched and the value output;
+ * #JSONNullParameter if any pointer parameters are NULL;
+ * #JSONBadParameter if max or stepCount is 0, or a step is neither a key
+ * nor an array index;
+ * #JSONNotFound if the query has no match.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *     // Variables used in this example.
+ *     static const JSONQueryStep_t powerOnQuery[] =
+ *     {
+ *         JSON_QUERY_KEY( "state" ),
+ *         JSON_QUERY_KEY( "powerOn" )
+ *     };
+ *     char buffer[] = "{\"state\":{\"powerOn\":1}}";
+ *     size_t bufferLength = sizeof( buffer ) - 1;
+ *     char * value;
+ *     size_t valueLength;
+ *
+ *     if( JSON_SearchCompiled( buffer, bufferLength, powerOnQuery, 2,
+ *                              &value, &valueLength ) == JSONSuccess )
+ *     {
+ *         // "value" points to 1 in "buffer", as for a search for
+ *         // "state.powerOn".
+ *     }
+ * @endcode
+ */
+/* @[declare_json_searchcompiled] */
+JSONStatus_t JSON_SearchCompiled( char * buf,
+                                  size_t max,
+                                  const JSONQueryStep_t * steps,
+                                  size_t stepCount,
+                                  char ** outValue,
+                                  size_t * outValueLength );
+/* @[declare_json_searchcompiled] */
+
+/**
+ * @brief Validate a JSON document and record every value in it.
+ *
+ * A single pass over the buffer fills @p index with one #JSONIndexEntry_t
+ * per value (the root, every member of every object and every element of
+ * every array), linked to its parent and next sibling.  The index can then
+ * serve any number of JSON_SearchIndex() calls without rescanning the buffer.
+ *
+ * @param[in] buf  The buffer to index.
+ * @param[in] max  The size of the buffer.
+ * @param[out] index  The array to receive the entries; may be NULL if
+ * @p indexCapacity is 0.
+ * @param[in] indexCapacity  The number of entries available in @p index.
+ * @param[out] outCount  A pointer to receive the number of entries.
+ *
+ * @note The maximum nesting depth may be specified by defining the macro
+ * JSON_MAX_DEPTH.  The default is 32 of sizeof(char).
+ *
+ * @note As for JSON_Validate(), defining JSON_VALIDATE_COLLECTIONS_ONLY
+ * requires the document to be an object or array.
+ *
+ * @return #JSONSuccess if the buffer contents are valid JSON and the index
+ * is complete;
+ * #JSONNullParameter if buf or outCount is NULL, or index is NULL while
+ * indexCapacity is not 0;
+ * #JSONBadParameter if max is 0;
+ * #JSONInsufficientMemory if the buffer contents are valid JSON but there
+ * are more values than @p indexCapacity, in which case @p outCount receives
+ * the number of entries required;
+ * #JSONIllegalDocument if the buffer contents are NOT valid JSON;
+ * #JSONMaxDepthExceeded if object and array nesting exceeds a threshold;
+ * #JSONPartial if the buffer contents are potentially valid but incomplete.
+ * As for JSON_Validate(), a buffer that ends after a comma, key or colon, or
+ * within a string or literal, is illegal rather than partial.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *     // Variables used in this example.
+ *     JSONStatus_t result;
+ *     char buffer[] = "{\"foo\":\"abc\",\"bar\":{\"foo\":\"xyz\"}}";
+ *     size_t bufferLength = sizeof( buffer ) - 1;
+ *     JSONIndexEntry_t index[ 8 ];
+ *     size_t indexCount;
+ *
+ *     result = JSON_BuildIndex( buffer, bufferLength,
+ *                               index, sizeof( index ) / sizeof( index[ 0 ] ),
+ *                               &indexCount );
+ *
+ *     // The root object, "foo", "bar" and "bar.foo" were recorded.
+ *     assert( result == JSONSuccess );
+ *     assert( indexCount == 4 );
+ * @endcode
+ */
+/* @[declare_json_buildindex] */
+JSONStatus_t JSON_BuildIndex( const char * buf,
+                              size_t max,
+                              JSONIndexEntry_t * index,
+                              size_t indexCapacity,
+                              size_t * outCount );
+/* @[declare_json_buildindex] */
+
+/**
+ * @brief Find a key or array index using an index built by JSON_BuildIndex()
+ * and output the pointer @p outValue to its value.
+ *
+ * The query syntax and the output are the same as for JSON_Search(), but
+ * the query is resolved by following the links of the index instead of
+ * parsing the buffer, so the cost depends only on the number of siblings
+ * visited along the query path.
+ *
+ * @param[in] buf  The buffer that was indexed.
+ * @param[in] index  The entries output by JSON_BuildIndex().
+ * @param[in] indexCount  The number of entries output by JSON_BuildIndex().
+ * @param[in] query  The object keys and array indexes to search for.
+ * @param[in] queryLength  Length of the key.
+ * @param[out] outValue  A pointer to receive the address of the value found.
+ * @param[out] outValueLength  A pointer to receive the length of the value found.
+ *
+ * @note The buffer must not be modified between building the index and
+ * searching it.
+ *
+ * @return #JSONSuccess if the query is matched and the value output;
+ * #JSONNullParameter if any pointer parameters are NULL;
+ * #JSONBadParameter if the query is empty, or the portion after a separator is empty,
+ * or indexCount is 0, or an index is too large to convert to a signed 32-bit integer;
+ * #JSONNotFound if the query has no match.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *     // Variables used in this example.
+ *     JSONStatus_t result;
+ *     char buffer[] = "{\"foo\":\"abc\",\"bar\":{\"foo\":\"xyz\"}}";
+ *     size_t bufferLength = sizeof( buffer ) - 1;
+ *     JSONIndexEntry_t index[ 8 ];
+ *     size_t indexCount;
+ *     char * value;
+ *     size_t valueLength;
+ *
+ *     result = JSON_BuildIndex( buffer, bufferLength,
+ *                               index, sizeof( index ) / sizeof( index[ 0 ] ),
+ *                               &indexCount );
+ *
+ *     if( result == JSONSuccess )
+ *     {
+ *         result = JSON_SearchIndex( buffer, index, indexCount, "bar.foo",
+ *                                    sizeof( "bar.foo" ) - 1, &value, &valueLength );
+ *     }
+ *
+ *     if( result == JSONSuccess )
+ *     {
+ *         // "value" points to xyz in "buffer", and further searches
+ *         // do not need to parse the buffer again.
+ *         result = JSON_SearchIndex( buffer, index, indexCount, "foo",
+ *                                    sizeof( "foo" ) - 1, &value, &valueLength );
+ *     }
+ * @endcode
+ */
+/* @[declare_json_searchindex] */
+JSONStatus_t JSON_SearchIndex( char * buf,
+                               const JSONIndexEntry_t * index,
+                               size_t indexCount,
+                               const char * query,
+                               size_t queryLength,
+                               char ** outValue,
+                               size_t * outValueLength );
+/* @[declare_json_searchindex] */
+
+/**
+ * @ingroup json_struct_types
+ * @brief One query of JSON_SearchMany() and its result.
+ */
+typedef struct JSONQuery
+{
+    const char * query;  /**< @brief The object keys and array indexes to search for. */
+    size_t queryLength;  /**< @brief Length of the query. */
+    char * value;        /**< @brief Receives the address of the value found. */
+    size_t valueLength;  /**< @brief Receives the length of the value found. */
+    JSONStatus_t status; /**< @brief Receives the result of this query. */
+
+    /** @cond DO_NOT_DOCUMENT */
+    size_t next;         /* Offset in the query of the next part to match. */
+    int16_t depth;       /* Nesting depth at which that part may match. */
+    /** @endcond */
+} JSONQuery_t;
+
+/**
+ * @brief Find several keys or array indexes in a JSON document with a single
+ * pass over it.
+ *
+ * Each query uses the syntax of JSON_Search() and receives the same value,
+ * but the document is walked only once for all of them.  Queries with a
+ * common prefix share the work of matching it, and the walk descends only
+ * into objects and arrays that lie on the path of some query.  It stops as
+ * soon as every query is resolved.
+ *
+ * @param[in] buf  The buffer to search.
+ * @param[in] max  size of the buffer.
+ * @param[in,out] queries  The queries; the query and queryLength of each
+ * must be set, the other members are outputs.
+ * @param[in] queryCount  The number of queries.
+ *
+ * @note The status of each query is #JSONSuccess, #JSONNotFound,
+ * #JSONNullParameter or #JSONBadParameter.  For a valid document, the status
+ * and value are those JSON_Search() would output for the query alone, except
+ * that every query is checked before the walk, so a malformed query is
+ * always reported as #JSONBadParameter.  The value and valueLength of a
+ * query are only meaningful when its status is #JSONSuccess.
+ *
+ * @note Like JSON_Search(), JSON_SearchMany() validates only what it walks.
+ * To validate the entire JSON document, use JSON_Validate().
+ *
+ * @note The maximum nesting depth may be specified by defining the macro
+ * JSON_MAX_DEPTH.  The default is 32 of sizeof(char).
+ *
+ * @return #JSONSuccess if every query is matched;
+ * #JSONNullParameter if buf or queries is NULL;
+ * #JSONBadParameter if max or queryCount is 0;
+ * otherwise the status of the first query that was not matched.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *     // Variables used in this example.
+ *     char buffer[] = "{\"version\":12,\"state\":{\"powerOn\":1,\"color\":\"red\"}}";
+ *     size_t bufferLength = sizeof( buffer ) - 1;
+ *     JSONQuery_t queries[ 3 ] =
+ *     {
+ *         { .query = "version",       .queryLength = sizeof( "version" ) - 1       },
+ *         { .query = "state.powerOn", .queryLength = sizeof( "state.powerOn" ) - 1 },
+ *         { .query = "state.color",   .queryLength = sizeof( "state.color" ) - 1   }
+ *     };
+ *
+ *     if( JSON_SearchMany( buffer, bufferLength, queries, 3 ) == JSONSuccess )
+ *     {
+ *         // queries[ 2 ].value points to red in "buffer",
+ *         // and queries[ 2 ].valueLength is 3.
+ *     }
+ * @endcode
+ */
+/* @[declare_json_searchmany] */
+JSONStatus_t JSON_SearchMany( char * buf,
+                              size_t max,
+                              JSONQuery_t * queries,
+                              size_t queryCount );
+/* @[declare_json_searchmany] */
+
+/**
+ * @ingroup json_struct_types
+ * @brief Structure to represent a key-value pair.
+ */
+typedef struct
+{
+    const char * key;     /**< @brief Pointer to the code point sequence for key. */
+    size_t keyLength;     /**< @brief Length of the code point sequence for key. */
+    const char * value;   /**< @brief Pointer to the code point sequence for value. */
+    size_t valueLength;   /**< @brief Length of the code point sequence for value. */
+    JSONTypes_t jsonType; /**< @brief JSON-specific type of the value. */
+} JSONPair_t;
+
+/**
+ * @brief Output the next key-value pair or value from a collection.
+ *
+ * This function may be used in a loop to output each key-value pair from an object,
+ * or each value from an array.  For the first invocation, the integers pointed to by
+ * start and next should be initialized to 0.  These will be updated by the function.
+ * If another key-value pair or value is present, the output structure is populated
+ * and #JSONSuccess is returned; otherwise the structure is unchanged and #JSONNotFound
+ * is returned.
+ *
+ * Each call resumes from the saved cursor, so visiting every member of a
+ * collection is linear in its size, whereas searching for '[0]', '[1]', ...
+ * rescans the array for every element.  The collection may be a value output
+ * by JSON_Search() or JSON_SearchIndex(), passing the value and its length as
+ * buf and max.
+ *
+ * @param[in] buf  The buffer to search.
+ * @param[in] max  size of the buffer.
+ * @param[in,out] start  The index at which the collection begins.
+ * @param[in,out] next  The index at which to seek the next value.
+ * @param[out] outPair  A pointer to receive the next key-value pair.
+ *
+ * @note This function expects a valid JSON document; run JSON_Validate() first.
+ *
+ * @note For an object, the outPair structure will reference a key and its value.
+ * For an array, only the value will be referenced (i.e., outPair.key will be NULL).
+ *
+ * @return #JSONSuccess if a value is output;
+ * #JSONIllegalDocument if the buffer does not begin with '[' or '{';
+ * #JSONNotFound if there are no further values in the collection;
+ * #JSONNullParameter if any pointer parameters are NULL;
+ * #JSONBadParameter if max is 0, or start or next lie beyond the buffer.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *     // Variables used in this example.
+ *     static char * json_types[] =
+ *     {
+ *         "invalid",
+ *         "string",
+ *         "number",
+ *         "true",
+ *         "false",
+ *         "null",
+ *         "object",
+ *         "array"
+ *     };
+ *
+ *     void show( const char * json,
+ *                size_t length )
+ *     {
+ *         size_t start = 0, next = 0;
+ *         JSONPair_t pair = { 0 };
+ *         JSONStatus_t result;
+ *
+ *         result = JSON_Validate( json, length );
+ *         if( result == JSONSuccess )
+ *         {
+ *             result = JSON_Iterate( json, length, &start, &next, &pair );
+ *         }
+ *
+ *         while( result == JSONSuccess )
+ *         {
+ *             if( pair.key != NULL )
+ *             {
+ *                 printf( "key: %.*s\t", ( int ) pair.keyLength, pair.key );
+ *             }
+ *
+ *             printf( "value: (%s) %.*s\n", json_types[ pair.jsonType ],
+ *                     ( int ) pair.valueLength, pair.value );
+ *
+ *             result = JSON_Iterate( json, length, &start, &next, &pair );
+ *         }
+ *     }
+ * @endcode
+ */
+/* @[declare_json_iterate] */
+JSONStatus_t JSON_Iterate( const char * buf,
+                           size_t max,
+                           size_t * start,
+                           size_t * next,
+                           JSONPair_t * outPair );
+/* @[declare_json_iterate] */
+
+/**
+ * @brief The maximum nesting depth of objects and arrays.
+ *
+ * May be overridden by defining JSON_MAX_DEPTH before this header is
+ * included, and must then be defined the same way for the library.
+ */
+#ifndef JSON_MAX_DEPTH
+    #define JSON_MAX_DEPTH    32
+#endif
+
+/**
+ * @ingroup json_struct_types
+ * @brief The state of an incremental validation.
+ *
+ * The state is owned by the caller, initialized by JSON_ValidateStart(),
+ * and carried from one JSON_ValidateChunk() call to the next.  It holds the
+ * stack of open objects and arrays, and the position within a string,
+ * escape sequence, UTF-8 code point, literal or number that is split
+ * between chunks.  Apart from offset, its members are private.
+ */
+typedef struct JSONStreamState
+{
+    size_t offset; /**< @brief Bytes accepted so far; after an error, the offset of the offending byte. */
+
+    /** @cond DO_NOT_DOCUMENT */
+    JSONStatus_t status;          /* result so far; errors are sticky */
+    int16_t depth;                /* index of the innermost open collection, or -1 */
+    char stack[ JSON_MAX_DEPTH ]; /* opening bracket of each open collection */
+    uint8_t expect;               /* structural token expected next */
+    uint8_t lexer;                /* position within a scalar */
+    uint8_t remaining;            /* bytes left in a code point or escape; progress in a literal */
+    uint8_t length;               /* length of a code point; which literal */
+    uint32_t value;               /* code point or escape value decoded so far */
+    /** @endcond */
+} JSONStreamState_t;
+
+/**
+ * @brief Initialize the state of an incremental validation.
+ *
+ * @param[out] state  The state to initialize.
+ *
+ * @return #JSONSuccess if the state was initialized;
+ * #JSONNullParameter if state is NULL.
+ */
+/* @[declare_json_validatestart] */
+JSONStatus_t JSON_ValidateStart( JSONStreamState_t * state );
+/* @[declare_json_validatestart] */
+
+/**
+ * @brief Validate the next chunk of a JSON document.
+ *
+ * A document may be split between chunks at any byte, including within a
+ * string, an escape sequence, a UTF-8 code point, a literal or a number, so
+ * chunks can be validated as they arrive and then discarded.  The rules are
+ * those of JSON_BuildIndex(), which accepts the same complete documents in
+ * one buffer.  The two differ on an incomplete document: one that ends
+ * within a string or literal, or after a comma, key or colon, is #JSONPartial
+ * here, as more chunks may follow, but #JSONIllegalDocument there.
+ *
+ * @param[in,out] state  The state, initialized by JSON_ValidateStart().
+ * @param[in] buf  The chunk to validate.
+ * @param[in] max  The size of the chunk; may be 0.
+ *
+ * @note The maximum nesting depth may be specified by defining the macro
+ * JSON_MAX_DEPTH.  The default is 32 of sizeof(char).
+ *
+ * @note As for JSON_Validate(), defining JSON_VALIDATE_COLLECTIONS_ONLY
+ * requires the document to be an object or array.
+ *
+ * @return #JSONSuccess if the bytes so far form a complete document
+ * (trailing whitespace may follow);
+ * #JSONPartial if the bytes so far are valid but the document is incomplete,
+ * or is a number that more digits could extend;
+ * #JSONNullParameter if state or buf is NULL;
+ * #JSONIllegalDocument if the bytes so far are NOT valid JSON;
+ * #JSONMaxDepthExceeded if object and array nesting exceeds a threshold.
+ * Once an error is returned, it is returned for every further chunk.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *     // Variables used in this example.
+ *     JSONStreamState_t state;
+ *     JSONStatus_t result;
+ *     char chunk1[] = "{\"foo\":\"ab";
+ *     char chunk2[] = "c\",\"bar\":12";
+ *     char chunk3[] = "3}";
+ *
+ *     ( void ) JSON_ValidateStart( &state );
+ *     result = JSON_ValidateChunk( &state, chunk1, sizeof( chunk1 ) - 1 );
+ *     // result is JSONPartial.
+ *     result = JSON_ValidateChunk( &state, chunk2, sizeof( chunk2 ) - 1 );
+ *     // result is JSONPartial.
+ *     result = JSON_ValidateChunk( &state, chunk3, sizeof( chunk3 ) - 1 );
+ *     // result is JSONSuccess.
+ *     result = JSON_ValidateFinish( &state );
+ *     // result is JSONSuccess.
+ * @endcode
+ */
+/* @[declare_json_validatechunk] */
+JSONStatus_t JSON_ValidateChunk( JSONStreamState_t * state,
+                                 const char * buf,
+                                 size_t max );
+/* @[declare_json_validatechunk] */
+
+/**
+ * @brief Conclude an incremental validation at the end of the input.
+ *
+ * This completes a document that is a number at the root, which
+ * JSON_ValidateChunk() cannot judge complete since more digits might follow.
+ *
+ * @param[in,out] state  The state, initialized by JSON_ValidateStart().
+ *
+ * @return #JSONSuccess if the input was exactly one valid JSON document;
+ * #JSONPartial if the document is incomplete, wherever the input ended
+ * (JSON_Validate() reports some such documents as #JSONIllegalDocument);
+ * #JSONNullParameter if state is NULL;
+ * #JSONIllegalDocument or #JSONMaxDepthExceeded if an earlier chunk was invalid.
+ */
+/* @[declare_json_validatefinish] */
+JSONStatus_t JSON_ValidateFinish( JSONStreamState_t * state );
+/* @[declare_json_validatefinish] */
+
+/**
+ * @brief Decode the escape sequences of a string value.
+ *
+ * The value is typically one output by JSON_Search(), without its quotes.
+ * Escape sequences, including \\uXXXX and surrogate pairs, are decoded
+ * into UTF-8 in a single pass; other bytes are copied as they are.
+ *
+ * A value with no backslash is its own result: outValue is set to value,
+ * and nothing is copied.  Otherwise the result is written to buf.  Since
+ * the result is never longer than the value, buf may be the value itself,
+ * decoding it in place.
+ *
+ * @param[in] value  The string value, without quotes.
+ * @param[in] valueLength  The length of the value.
+ * @param[out] buf  The buffer for the result; may be value, or NULL if
+ * bufSize is 0.
+ * @param[in] bufSize  The size of the buffer.
+ * @param[out] outValue  The result: value, or buf.
+ * @param[out] outValueLength  The length of the result.
+ *
+ * @return #JSONSuccess if the value was decoded;
+ * #JSONNullParameter if value, outValue or outValueLength is NULL, or buf
+ * is NULL and bufSize is not 0;
+ * #JSONIllegalDocument if an escape sequence is invalid, which includes
+ * \\u0000 and unpaired surrogates;
+ * #JSONInsufficientMemory if the result does not fit in buf;
+ * outValueLength is then the size needed.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *     // Variables used in this example.
+ *     char buffer[] = "{\"name\":\"caf\\u00e9\\n\"}";
+ *     size_t bufferLength = sizeof( buffer ) - 1;
+ *     char * value;
+ *     size_t valueLength;
+ *     const char * name;
+ *     size_t nameLength;
+ *
+ *     if( ( JSON_Search( buffer, bufferLength, "name", sizeof( "name" ) - 1,
+ *                        &value, &valueLength ) == JSONSuccess ) &&
+ *         ( JSON_Unescape( value, valueLength, value, valueLength,
+ *                          &name, &nameLength ) == JSONSuccess ) )
+ *     {
+ *         // name points to the UTF-8 bytes of "café\n" in buffer,
+ *         // and nameLength is 6.
+ *     }
+ * @endcode
+ */
+/* @[declare_json_unescape] */
+JSONStatus_t JSON_Unescape( const char * value,
+                            size_t valueLength,
+                            char * buf,
+                            size_t bufSize,
+                            const char ** outValue,
+                            size_t * outValueLength );
+/* @[declare_json_unescape] */
+
+/**
+ * @brief Apply a JSON merge patch (RFC 7396) to a document.
+ *
+ * Each member of a patch object replaces the member of the target object
+ * with the same key, or is added to it; a member whose value is null
+ * removes it; and a member whose value is an object is merged with the
+ * target member, if that is an object too.  A patch that is not an object
+ * replaces the whole target.
+ *
+ * The target is read through an index built by JSON_BuildIndex(), so only
+ * the objects that the patch reaches are visited, and the other members
+ * are copied as they are.  Members added by the patch come first in their
+ * object; the members kept from the target follow in their order.  Keys are
+ * compared as they are written, as by JSON_Search().
+ *
+ * The output is written to buf, which may be the target itself to patch
+ * it in place.  The buffer must then be large enough to hold the target
+ * while it is overwritten: the size needed, reported when it is too small,
+ * is never more than the sum of the lengths of the target and of the output.
+ *
+ * @param[in] target  The document to patch.
+ * @param[in] targetLength  The length of the document.
+ * @param[in] targetIndex  The entries output by JSON_BuildIndex() for it.
+ * @param[in] targetIndexCount  The number of entries.
+ * @param[in] patch  The patch, which must not overlap buf.
+ * @param[in] patchLength  The length of the patch.
+ * @param[out] buf  The buffer to receive the output; may be target, or
+ * NULL if bufSize is 0.
+ * @param[in] bufSize  The size of the buffer.
+ * @param[out] outLength  A pointer to receive the length of the output.
+ *
+ * @note When patching in place, the index no longer matches the buffer.
+ *
+ * @return #JSONSuccess if the patch was applied;
+ * #JSONNullParameter if target, targetIndex, patch or outLength is NULL,
+ * or buf is NULL while bufSize is not 0;
+ * #JSONBadParameter if targetLength, targetIndexCount or patchLength is 0,
+ * or buf is target and bufSize is less than targetLength;
+ * #JSONInsufficientMemory if the buffer is too small, in which case
+ * outLength receives the size needed;
+ * otherwise the status of JSON_Validate() for the patch.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *     // Variables used in this example.
+ *     char state[ 128 ] = "{\"powerOn\":0,\"color\":\"red\",\"mode\":\"auto\"}";
+ *     size_t stateLength = strlen( state );
+ *     const char delta[] = "{\"powerOn\":1,\"mode\":null,\"level\":3}";
+ *     JSONIndexEntry_t index[ 8 ];
+ *     size_t indexCount;
+ *     JSONStatus_t result;
+ *
+ *     result = JSON_BuildIndex( state, stateLength, index, 8, &indexCount );
+ *
+ *     if( result == JSONSuccess )
+ *     {
+ *         result = JSON_MergePatch( state, stateLength, index, indexCount,
+ *                                   delta, sizeof( delta ) - 1,
+ *                                   state, sizeof( state ), &stateLength );
+ *     }
+ *
+ *     // state now begins with {"level":3,"powerOn":1,"color":"red"}
+ * @endcode
+ */
+/* @[declare_json_mergepatch] */
+JSONStatus_t JSON_MergePatch( const char * target,
+                              size_t targetLength,
+                              const JSONIndexEntry_t * targetIndex,
+                              size_t targetIndexCount,
+                              const char * patch,
+                              size_t patchLength,
+                              char * buf,
+                              size_t bufSize,
+                              size_t * outLength );
+/* @[declare_json_mergepatch] */
+
+/**
+ * @brief Remove the whitespace between the tokens of a JSON document, in
+ * place.
+ *
+ * Strings are kept as they are, including any whitespace and escapes in
+ * them, and the document is compacted towards the start of the buffer in
+ * a single pass.  Indentation and the plain ASCII contents of strings are
+ * scanned a vector at a time, as by JSON_Validate().
+ *
+ * @param[in,out] buf  The buffer holding the document.
+ * @param[in] max  The size of the document.
+ * @param[out] outLength  A pointer to receive the length of the document
+ * without whitespace.
+ *
+ * @note This function expects a valid JSON document; run JSON_Validate() first.
+ * Its output for any other input stays within the buffer, but is not
+ * otherwise specified.
+ *
+ * @return #JSONSuccess if the whitespace was removed;
+ * #JSONNullParameter if buf or outLength is NULL;
+ * #JSONBadParameter if max is 0.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *     // Variables used in this example.
+ *     char buffer[] = "{\n  \"state\": {\n    \"reported\": { \"color\": \"dark red\" }\n  }\n}";
+ *     size_t length;
+ *
+ *     if( JSON_Minify( buffer, sizeof( buffer ) - 1, &length ) == JSONSuccess )
+ *     {
+ *         // The first length bytes of buffer hold
+ *         // {"state":{"reported":{"color":"dark red"}}}
+ *     }
+ * @endcode
+ */
+/* @[declare_json_minify] */
+JSONStatus_t JSON_Minify( char * buf,
+                          size_t max,
+                          size_t * outLength );
+/* @[declare_json_minify] */
 
 /**
  * @brief The largest value usable as an array index in a query
@@ -0,0 +1,141 @@
+/*
+ * coreJSON v2.0.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_json_cbor.h
+ * @brief Include this header file to transcode between JSON and CBOR
+ * (RFC 8949) with coreJSON.
+ */
+
+#ifndef CORE_JSON_CBOR_H_
+#define CORE_JSON_CBOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "core_json.h"
+#include "core_json_writer.h"
+
+/**
+ * @brief Transcode a JSON document to CBOR.
+ *
+ * The document is checked with JSON_Validate() and then transcoded in one
+ * pass, with no memory beyond a stack of #JSON_MAX_DEPTH entries.  The
+ * output uses the preferred serialization of RFC 8949: definite lengths,
+ * the shortest head for every integer and length, and the shortest of
+ * half, single and double precision that holds a number exactly.
+ *
+ * - Objects become maps and arrays become arrays, in document order.
+ * - Strings become text strings, with their escapes decoded.
+ * - Numbers written as integers become integers when they fit in 64 bits
+ * (down to -2^64 for negative numbers); all others become floats.
+ * - true, false and null become the simple values of the same names.
+ *
+ * @param[in] buf  The JSON document.
+ * @param[in] max  The size of the document.
+ * @param[out] out  The buffer for the CBOR; may be NULL if outSize is 0.
+ * @param[in] outSize  The size of out.
+ * @param[out] outLength  The length of the CBOR, or the size needed if
+ * out is too small.
+ *
+ * @return #JSONSuccess if the document was transcoded;
+ * #JSONNullParameter if buf or outLength is NULL, or out is NULL and
+ * outSize is not 0;
+ * #JSONBadParameter if max is 0;
+ * #JSONIllegalDocument, #JSONMaxDepthExceeded or #JSONPartial as
+ * JSON_Validate() reports them;
+ * #JSONOutOfRange if a number is beyond the range of a double;
+ * #JSONInsufficientMemory if out is too small.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *     // Variables used in this example.
+ *     char json[] = "{\"temperature\":21.5,\"state\":\"on\"}";
+ *     uint8_t cbor[ 32 ];
+ *     size_t cborLength;
+ *
+ *     if( JSON_ToCbor( json, sizeof( json ) - 1, cbor, sizeof( cbor ),
+ *                      &cborLength ) == JSONSuccess )
+ *     {
+ *         // cbor holds the 25 bytes A2 6B "temperature" F9 4D 60
+ *         // 65 "state" 62 "on".
+ *     }
+ * @endcode
+ */
+/* @[declare_json_tocbor] */
+JSONStatus_t JSON_ToCbor( const char * buf,
+                          size_t max,
+                          uint8_t * out,
+                          size_t outSize,
+                          size_t * outLength );
+/* @[declare_json_tocbor] */
+
+/**
+ * @brief Write a CBOR data item as a JSON value.
+ *
+ * The item is transcoded as RFC 8949 section 6.1 describes, into the
+ * writer, so the JSON may go to a buffer or a sink, and may be nested in
+ * a larger document.  The item is checked before anything is written.
+ *
+ * - Maps become objects and arrays become arrays; both may have
+ * indefinite lengths.  Map keys must be text strings or integers;
+ * integers become their decimal representation.
+ * - Text strings become strings.
+ * - Integers and finite floats become numbers.
+ * - false, true and null become the literals of the same names.  Other
+ * simple values, infinities and NaN become null.
+ * - Tags are ignored; their content is transcoded.
+ *
+ * Byte strings and indefinite-length text strings are not supported.
+ *
+ * @param[in,out] writer  The writer.
+ * @param[in] cbor  The CBOR data item.
+ * @param[in] cborLength  The length of the item.
+ *
+ * @return The status of the writer; #JSONBadParameter if cbor is not a
+ * single, complete, well-formed data item, contains a text string that
+ * is not UTF-8 or contains NUL, or uses a feature that is not supported;
+ * #JSONMaxDepthExceeded if it nests deeper than #JSON_MAX_DEPTH.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *     // Variables used in this example.
+ *     JSONWriter_t writer;
+ *     char json[ 64 ];
+ *     size_t jsonLength;
+ *     const uint8_t cbor[] = { 0xA1U, 0x62U, 'o', 'n', 0xF5U };
+ *
+ *     ( void ) JSON_WriterInit( &writer, json, sizeof( json ), NULL, NULL );
+ *     ( void ) JSON_WriteCbor( &writer, cbor, sizeof( cbor ) );
+ *
+ *     if( JSON_WriterFinish( &writer, &jsonLength ) == JSONSuccess )
+ *     {
+ *         // json holds {"on":true}.
+ *     }
+ * @endcode
+ */
+/* @[declare_json_writecbor] */
+JSONStatus_t JSON_WriteCbor( JSONWriter_t * writer,
+                             const uint8_t * cbor,
+                             size_t cborLength );
+/* @[declare_json_writecbor] */
+
+#endif /* ifndef CORE_JSON_CBOR_H_ */
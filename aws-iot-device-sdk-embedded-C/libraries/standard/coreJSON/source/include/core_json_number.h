@@ -0,0 +1,125 @@
+/*
+ * coreJSON v2.0.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_json_number.h
+ * @brief Include this header file to convert JSON numbers with coreJSON.
+ */
+
+#ifndef CORE_JSON_NUMBER_H_
+#define CORE_JSON_NUMBER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "core_json.h"
+
+/**
+ * @brief Convert a JSON integer to a signed 64-bit value.
+ *
+ * The value is typically one output by JSON_Search().  It is read in place,
+ * without a terminating NUL, and must be exactly a JSON number with no
+ * fraction or exponent, e.g. -42.
+ *
+ * @param[in] value  The JSON number.
+ * @param[in] valueLength  The length of the number.
+ * @param[out] outValue  The converted value.
+ *
+ * @return #JSONSuccess if the number was converted;
+ * #JSONNullParameter if value or outValue is NULL;
+ * #JSONBadParameter if valueLength is 0;
+ * #JSONIllegalDocument if value is not a JSON integer;
+ * #JSONOutOfRange if the number is below INT64_MIN or above INT64_MAX.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *     // Variables used in this example.
+ *     char buffer[] = "{\"version\":12}";
+ *     size_t bufferLength = sizeof( buffer ) - 1;
+ *     char * value;
+ *     size_t valueLength;
+ *     int64_t version;
+ *
+ *     if( ( JSON_Search( buffer, bufferLength, "version", sizeof( "version" ) - 1,
+ *                        &value, &valueLength ) == JSONSuccess ) &&
+ *         ( JSON_GetInt64( value, valueLength, &version ) == JSONSuccess ) )
+ *     {
+ *         // version is 12.
+ *     }
+ * @endcode
+ */
+/* @[declare_json_getint64] */
+JSONStatus_t JSON_GetInt64( const char * value,
+                            size_t valueLength,
+                            int64_t * outValue );
+/* @[declare_json_getint64] */
+
+/**
+ * @brief Convert a JSON integer to an unsigned 64-bit value.
+ *
+ * As JSON_GetInt64(), but for the range of uint64_t; -0 is accepted as 0.
+ *
+ * @param[in] value  The JSON number.
+ * @param[in] valueLength  The length of the number.
+ * @param[out] outValue  The converted value.
+ *
+ * @return #JSONSuccess if the number was converted;
+ * #JSONNullParameter if value or outValue is NULL;
+ * #JSONBadParameter if valueLength is 0;
+ * #JSONIllegalDocument if value is not a JSON integer;
+ * #JSONOutOfRange if the number is negative or above UINT64_MAX.
+ */
+/* @[declare_json_getuint64] */
+JSONStatus_t JSON_GetUint64( const char * value,
+                             size_t valueLength,
+                             uint64_t * outValue );
+/* @[declare_json_getuint64] */
+
+/**
+ * @brief Convert a JSON number to the nearest double.
+ *
+ * The number is read in place, without a terminating NUL, independent of
+ * the locale, and correctly rounded (to even on a tie) whatever its number
+ * of digits.  Numbers too small for a double become zero of the same sign.
+ *
+ * @note Most numbers are converted with a few integer multiplications by
+ * the Eisel-Lemire algorithm, using a table of 651 128-bit powers of five
+ * (about 10 KB).  Only a number with more than 19 significant digits that
+ * is within a rounding error of halfway between two doubles is compared
+ * digit by digit, with about 1 KB of stack.
+ *
+ * @param[in] value  The JSON number.
+ * @param[in] valueLength  The length of the number.
+ * @param[out] outValue  The converted value.
+ *
+ * @return #JSONSuccess if the number was converted;
+ * #JSONNullParameter if value or outValue is NULL;
+ * #JSONBadParameter if valueLength is 0;
+ * #JSONIllegalDocument if value is not a JSON number;
+ * #JSONOutOfRange if the magnitude of the number rounds above DBL_MAX.
+ */
+/* @[declare_json_getdouble] */
+JSONStatus_t JSON_GetDouble( const char * value,
+                             size_t valueLength,
+                             double * outValue );
+/* @[declare_json_getdouble] */
+
+#endif /* ifndef CORE_JSON_NUMBER_H_ */
@@ -0,0 +1,310 @@
+/*
+ * coreJSON v2.0.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_json_writer.h
+ * @brief Include this header file to produce JSON documents with coreJSON.
+ */
+
+#ifndef CORE_JSON_WRITER_H_
+#define CORE_JSON_WRITER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "core_json.h"
+
+/**
+ * @brief Function that receives output when the buffer of a writer is full,
+ * and when the document is finished.
+ *
+ * @param[in] context  The context given to JSON_WriterInit().
+ * @param[in] buf  The output to take.
+ * @param[in] length  The length of the output.
+ *
+ * @return The number of bytes taken, which must be length for the writer
+ * to continue.
+ */
+typedef int32_t ( * JSONWriterSink_t )( void * context,
+                                        const char * buf,
+                                        size_t length );
+
+/**
+ * @ingroup json_struct_types
+ * @brief The state of a JSON writer.
+ *
+ * The state is owned by the caller and initialized by JSON_WriterInit().
+ * Its members are private.
+ */
+typedef struct JSONWriter
+{
+    /** @cond DO_NOT_DOCUMENT */
+    char * buf;                   /* output buffer */
+    size_t size;                  /* size of the output buffer */
+    size_t length;                /* bytes in the output buffer */
+    size_t total;                 /* bytes of the document so far, whether stored or not */
+    JSONWriterSink_t sink;        /* optional sink, flushed when the buffer is full */
+    void * context;               /* context of the sink */
+    JSONStatus_t status;          /* result so far; errors are sticky */
+    int16_t depth;                /* index of the innermost open collection, or -1 */
+    char stack[ JSON_MAX_DEPTH ]; /* opening bracket of each open collection */
+    uint8_t expect;               /* what may be written next */
+    /** @endcond */
+} JSONWriter_t;
+
+/**
+ * @brief Initialize a writer.
+ *
+ * Output is stored in buf.  When buf is full, it is passed to sink, if
+ * there is one, and reused; otherwise the writer stops storing output, but
+ * goes on checking and measuring the document, so that JSON_WriterFinish()
+ * can report the exact size needed.  With no sink, buf may be NULL and size
+ * 0 to measure a document without storing it.
+ *
+ * @param[out] writer  The writer to initialize.
+ * @param[in] buf  The buffer to hold the output.
+ * @param[in] size  The size of the buffer.
+ * @param[in] sink  An optional function to take the output; may be NULL.
+ * @param[in] context  The context passed to sink.
+ *
+ * @return #JSONSuccess if the writer was initialized;
+ * #JSONNullParameter if writer is NULL, or buf is NULL and size is not 0;
+ * #JSONBadParameter if there is a sink and size is 0.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *     // Variables used in this example.
+ *     JSONWriter_t writer;
+ *     char buffer[ 64 ];
+ *     size_t length;
+ *
+ *     ( void ) JSON_WriterInit( &writer, buffer, sizeof( buffer ), NULL, NULL );
+ *     ( void ) JSON_WriteObjectStart( &writer );
+ *     ( void ) JSON_WriteKey( &writer, "powerOn", sizeof( "powerOn" ) - 1 );
+ *     ( void ) JSON_WriteUint64( &writer, 1 );
+ *     ( void ) JSON_WriteKey( &writer, "temp", sizeof( "temp" ) - 1 );
+ *     ( void ) JSON_WriteDouble( &writer, 21.5 );
+ *     ( void ) JSON_WriteObjectEnd( &writer );
+ *
+ *     if( JSON_WriterFinish( &writer, &length ) == JSONSuccess )
+ *     {
+ *         // buffer holds {"powerOn":1,"temp":21.5}, and length is 25.
+ *     }
+ * @endcode
+ */
+/* @[declare_json_writerinit] */
+JSONStatus_t JSON_WriterInit( JSONWriter_t * writer,
+                              char * buf,
+                              size_t size,
+                              JSONWriterSink_t sink,
+                              void * context );
+/* @[declare_json_writerinit] */
+
+/**
+ * @brief Conclude a document, and pass any output left in the buffer to
+ * the sink.
+ *
+ * @param[in,out] writer  The writer.
+ * @param[out] outLength  The length of the document.
+ *
+ * @return #JSONSuccess if the document is complete and was output in full;
+ * #JSONNullParameter if writer or outLength is NULL;
+ * #JSONPartial if the document is incomplete;
+ * #JSONInsufficientMemory if the buffer was too small and there is no sink,
+ * or the sink did not take all of the output; outLength is then the length
+ * of the whole document, and the output is incomplete;
+ * otherwise the error that stopped the writer.
+ */
+/* @[declare_json_writerfinish] */
+JSONStatus_t JSON_WriterFinish( JSONWriter_t * writer,
+                                size_t * outLength );
+/* @[declare_json_writerfinish] */
+
+/*
+ * The functions below add to the document.  A value inside an object must
+ * follow its key.  Each returns the status of the writer: #JSONSuccess so
+ * far; #JSONNullParameter if writer, or a pointer argument, is NULL;
+ * #JSONBadParameter if the argument cannot be written; #JSONIllegalDocument
+ * if the call does not fit the document at this point; #JSONMaxDepthExceeded
+ * if objects and arrays are nested deeper than JSON_MAX_DEPTH; or
+ * #JSONInsufficientMemory if output did not fit, in which case the writer
+ * goes on measuring.  Any other error is sticky: the writer ignores further
+ * calls, and returns that error.
+ */
+
+/**
+ * @brief Open an object.
+ *
+ * @param[in,out] writer  The writer.
+ *
+ * @return The status of the writer.
+ */
+/* @[declare_json_writeobjectstart] */
+JSONStatus_t JSON_WriteObjectStart( JSONWriter_t * writer );
+/* @[declare_json_writeobjectstart] */
+
+/**
+ * @brief Close the innermost object.
+ *
+ * @param[in,out] writer  The writer.
+ *
+ * @return The status of the writer.
+ */
+/* @[declare_json_writeobjectend] */
+JSONStatus_t JSON_WriteObjectEnd( JSONWriter_t * writer );
+/* @[declare_json_writeobjectend] */
+
+/**
+ * @brief Open an array.
+ *
+ * @param[in,out] writer  The writer.
+ *
+ * @return The status of the writer.
+ */
+/* @[declare_json_writearraystart] */
+JSONStatus_t JSON_WriteArrayStart( JSONWriter_t * writer );
+/* @[declare_json_writearraystart] */
+
+/**
+ * @brief Close the innermost array.
+ *
+ * @param[in,out] writer  The writer.
+ *
+ * @return The status of the writer.
+ */
+/* @[declare_json_writearrayend] */
+JSONStatus_t JSON_WriteArrayEnd( JSONWriter_t * writer );
+/* @[declare_json_writearrayend] */
+
+/**
+ * @brief Write the key of the next member of the innermost object.
+ *
+ * The key is escaped as JSON_WriteString() does.
+ *
+ * @param[in,out] writer  The writer.
+ * @param[in] key  The key, as UTF-8 without quotes or escapes.
+ * @param[in] keyLength  The length of the key.
+ *
+ * @return The status of the writer.
+ */
+/* @[declare_json_writekey] */
+JSONStatus_t JSON_WriteKey( JSONWriter_t * writer,
+                            const char * key,
+                            size_t keyLength );
+/* @[declare_json_writekey] */
+
+/**
+ * @brief Write a string value.
+ *
+ * Quotes, backslashes and control characters are escaped, and other bytes
+ * are copied as they are, so the string must be valid UTF-8.  A NUL byte is
+ * rejected with #JSONBadParameter since coreJSON does not accept \\u0000.
+ *
+ * @param[in,out] writer  The writer.
+ * @param[in] value  The string, as UTF-8 without quotes or escapes.
+ * @param[in] valueLength  The length of the string.
+ *
+ * @return The status of the writer.
+ */
+/* @[declare_json_writestring] */
+JSONStatus_t JSON_WriteString( JSONWriter_t * writer,
+                               const char * value,
+                               size_t valueLength );
+/* @[declare_json_writestring] */
+
+/**
+ * @brief Write a signed integer value.
+ *
+ * @param[in,out] writer  The writer.
+ * @param[in] value  The value.
+ *
+ * @return The status of the writer.
+ */
+/* @[declare_json_writeint64] */
+JSONStatus_t JSON_WriteInt64( JSONWriter_t * writer,
+                              int64_t value );
+/* @[declare_json_writeint64] */
+
+/**
+ * @brief Write an unsigned integer value.
+ *
+ * @param[in,out] writer  The writer.
+ * @param[in] value  The value.
+ *
+ * @return The status of the writer.
+ */
+/* @[declare_json_writeuint64] */
+JSONStatus_t JSON_WriteUint64( JSONWriter_t * writer,
+                               uint64_t value );
+/* @[declare_json_writeuint64] */
+
+/**
+ * @brief Write a floating point value.
+ *
+ * The value is written with the fewest significant digits that read back
+ * as the same double, in the notation of JavaScript's Number.toString(),
+ * e.g. 21.5, 1e+21 or 5e-324; negative zero is written as -0.
+ *
+ * @param[in,out] writer  The writer.
+ * @param[in] value  The value.
+ *
+ * @return The status of the writer; #JSONBadParameter if value is an
+ * infinity or NaN, which JSON cannot represent.
+ */
+/* @[declare_json_writedouble] */
+JSONStatus_t JSON_WriteDouble( JSONWriter_t * writer,
+                               double value );
+/* @[declare_json_writedouble] */
+
+/**
+ * @brief Write true, false or null.
+ *
+ * @param[in,out] writer  The writer.
+ * @param[in] literal  #JSONTrue, #JSONFalse or #JSONNull.
+ *
+ * @return The status of the writer; #JSONBadParameter if literal is
+ * another type.
+ */
+/* @[declare_json_writeliteral] */
+JSONStatus_t JSON_WriteLiteral( JSONWriter_t * writer,
+                                JSONTypes_t literal );
+/* @[declare_json_writeliteral] */
+
+/**
+ * @brief Write a value that is already JSON, such as one found by
+ * JSON_Search().
+ *
+ * The value is checked with JSON_Validate() and copied as it is.
+ *
+ * @param[in,out] writer  The writer.
+ * @param[in] value  The JSON value; a string must include its quotes.
+ * @param[in] valueLength  The length of the value.
+ *
+ * @return The status of the writer; #JSONBadParameter if value is not
+ * a single, complete JSON value.
+ */
+/* @[declare_json_writeraw] */
+JSONStatus_t JSON_WriteRaw( JSONWriter_t * writer,
+                            const char * value,
+                            size_t valueLength );
+/* @[declare_json_writeraw] */
+
+#endif /* ifndef CORE_JSON_WRITER_H_ */
@@ -0,0 +1,664 @@
+#!/usr/bin/env python3
+
+"""
+Generate a C struct for a JSON document, with a decoder that fills it in a
+single pass over the document and an encoder that writes it back.
+
+The schema is a JSON file naming the struct and listing its fields:
+
+    {
+        "name": "ShadowDelta",
+        "fields": [
+            { "path": "version", "type": "uint32_t" },
+            { "path": "state.powerOn", "type": "uint32_t", "required": false },
+            { "path": "clientToken", "type": "char[16]", "required": false }
+        ]
+    }
+
+A path is a chain of object keys separated by '.'.  The type is one of
+bool, int32_t, int64_t, uint32_t, uint64_t, double, or char[N] for a string
+of at most N - 1 bytes, stored with its escapes decoded and a terminating
+NUL.  Fields are required unless "required" is false; an optional field is
+paired with a bool member, named after it with the suffix Present, which
+tells whether it is in the document.  The member is named after the last
+key of the path, unless "member" gives another name.
+
+    python3 core_json_codegen.py shadow_delta.json -o shadow_delta
+
+writes shadow_delta.h and shadow_delta.c, declaring:
+
+    JSONStatus_t ShadowDelta_Decode( char * buf, size_t max, ShadowDelta_t * out );
+    JSONStatus_t ShadowDelta_Encode( const ShadowDelta_t * in, char * buf,
+                                     size_t size, size_t * outLength );
+
+The decoder checks the document with JSON_Validate(), then finds every
+field with a single JSON_SearchMany() call and converts it with the
+accessors of core_json_number.h and JSON_Unescape().
+The encoder writes the fields, in schema order, with core_json_writer.h.
+Compile the generated source with core_json.c, core_json_number.c and
+core_json_writer.c.
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+IDENTIFIER = re.compile(r"^[A-Za-z_][A-Za-z0-9_]*$")
+STRING_TYPE = re.compile(r"^char\[([1-9][0-9]*)\]$")
+
+# C type -> (decoder helper, JSON accessor, accessor type, range check, writer)
+SCALAR_TYPES = {
+    "bool": ("decodeBool", None, None, None, None),
+    "int32_t": ("decodeInt32", "JSON_GetInt64", "int64_t",
+                "( number < INT32_MIN ) || ( number > INT32_MAX )", "JSON_WriteInt64"),
+    "int64_t": ("decodeInt64", "JSON_GetInt64", "int64_t", None, "JSON_WriteInt64"),
+    "uint32_t": ("decodeUint32", "JSON_GetUint64", "uint64_t",
+                 "number > UINT32_MAX", "JSON_WriteUint64"),
+    "uint64_t": ("decodeUint64", "JSON_GetUint64", "uint64_t", None, "JSON_WriteUint64"),
+    "double": ("decodeDouble", "JSON_GetDouble", "double", None, "JSON_WriteDouble"),
+}
+
+
+class SchemaError(Exception):
+    pass
+
+
+class Field:
+    def __init__(self, spec, index):
+        if not isinstance(spec, dict) or "path" not in spec or "type" not in spec:
+            raise SchemaError("field %d needs a path and a type" % index)
+
+        self.path = spec["path"]
+        self.keys = self.path.split(".")
+
+        if any((key == "") or any(c in key for c in '"\\[]') or (not key.isprintable())
+               for key in self.keys):
+            raise SchemaError("field %d: path '%s' has an empty or unsupported key" % (index, self.path))
+
+        self.type = spec["type"]
+        self.member = spec.get("member", self.keys[-1])
+        self.required = spec.get("required", True)
+        self.index = index
+        self.size = None
+
+        match = STRING_TYPE.match(self.type)
+
+        if match is not None:
+            self.size = int(match.group(1))
+        elif self.type not in SCALAR_TYPES:
+            raise SchemaError("field %d: unsupported type '%s'" % (index, self.type))
+
+        if IDENTIFIER.match(self.member) is None:
+            raise SchemaError("field %d: '%s' is not a C identifier; set \"member\"" % (index, self.member))
+
+        if not isinstance(self.required, bool):
+            raise SchemaError("field %d: required must be true or false" % index)
+
+    @property
+    def helper(self):
+        return "decodeString" if self.size is not None else SCALAR_TYPES[self.type][0]
+
+
+class Node:
+    """An object of the document, holding fields and nested objects in schema order."""
+
+    def __init__(self):
+        self.children = {}
+
+    def add(self, field, depth=0):
+        key = field.keys[depth]
+        child = self.children.get(key)
+
+        if depth == len(field.keys) - 1:
+            if child is not None:
+                raise SchemaError("path '%s' is given twice, or is also an object" % field.path)
+            self.children[key] = field
+        else:
+            if child is None:
+                child = Node()
+                self.children[key] = child
+            elif isinstance(child, Field):
+                raise SchemaError("path '%s' goes through the value of '%s'" % (field.path, child.path))
+            child.add(field, depth + 1)
+
+    def fields(self):
+        for child in self.children.values():
+            if isinstance(child, Field):
+                yield child
+            else:
+                yield from child.fields()
+
+
+def load_schema(path):
+    with open(path, "r") as f:
+        schema = json.load(f)
+
+    name = schema.get("name") if isinstance(schema, dict) else None
+
+    if not isinstance(name, str) or IDENTIFIER.match(name) is None:
+        raise SchemaError("the schema needs a name that is a C identifier")
+
+    specs = schema.get("fields")
+
+    if not isinstance(specs, list) or len(specs) == 0:
+        raise SchemaError("the schema needs a list of fields")
+
+    fields = [Field(spec, index) for index, spec in enumerate(specs)]
+    members = set()
+    root = Node()
+
+    for field in fields:
+        for member in [field.member] + ([] if field.required else [field.member + "Present"]):
+            if member in members:
+                raise SchemaError("member '%s' is defined twice" % member)
+            members.add(member)
+
+        root.add(field)
+
+    return name, fields, root
+
+
+def literal(text):
+    return '"' + text + '"'
+
+
+def generate_header(name, fields, guard):
+    out = []
+    out.append("/* Generated by core_json_codegen.py; do not edit. */")
+    out.append("")
+    out.append("#ifndef %s" % guard)
+    out.append("#define %s" % guard)
+    out.append("")
+    out.append("#include <stdbool.h>")
+    out.append("#include <stddef.h>")
+    out.append("#include <stdint.h>")
+    out.append("")
+    out.append('#include "core_json.h"')
+    out.append("")
+    out.append("typedef struct %s" % name)
+    out.append("{")
+
+    for field in fields:
+        if field.size is not None:
+            out.append("    char %s[ %d ];" % (field.member, field.size))
+        else:
+            out.append("    %s %s;" % (field.type, field.member))
+
+        if not field.required:
+            out.append("    bool %sPresent;" % field.member)
+
+    out.append("} %s_t;" % name)
+    out.append("")
+    out.append("/**")
+    out.append(" * @brief Fill a %s_t from a JSON document." % name)
+    out.append(" *")
+    out.append(" * @param[in] buf  The buffer holding the document.")
+    out.append(" * @param[in] max  The size of the buffer.")
+    out.append(" * @param[out] out  The struct to fill; members of absent fields are 0.")
+    out.append(" * Left untouched if the document is not valid.")
+    out.append(" *")
+    out.append(" * @return #JSONSuccess if every required field was found and converted;")
+    out.append(" * #JSONNullParameter if buf or out is NULL;")
+    out.append(" * #JSONBadParameter if max is 0;")
+    out.append(" * #JSONIllegalDocument, #JSONMaxDepthExceeded or #JSONPartial as")
+    out.append(" * JSON_Validate() reports them for the document;")
+    out.append(" * #JSONNotFound if a required field is not in the document;")
+    out.append(" * #JSONIllegalDocument if a value does not have the type of its field;")
+    out.append(" * #JSONOutOfRange if a number does not fit in its field;")
+    out.append(" * #JSONInsufficientMemory if a string does not fit in its field.")
+    out.append(" */")
+    out.append("JSONStatus_t %s_Decode( char * buf," % name)
+    out.append("%s size_t max," % (" " * len("JSONStatus_t %s_Decode(" % name)))
+    out.append("%s %s_t * out );" % (" " * len("JSONStatus_t %s_Decode(" % name), name))
+    out.append("")
+    out.append("/**")
+    out.append(" * @brief Write a %s_t as a JSON document." % name)
+    out.append(" *")
+    out.append(" * @param[in] in  The struct to write.")
+    out.append(" * @param[out] buf  The buffer to receive the document; may be NULL if size is 0.")
+    out.append(" * @param[in] size  The size of the buffer.")
+    out.append(" * @param[out] outLength  The length of the document.")
+    out.append(" *")
+    out.append(" * @return #JSONSuccess if the document was written;")
+    out.append(" * #JSONNullParameter if in or outLength is NULL, or buf is NULL and size is not 0;")
+    out.append(" * #JSONBadParameter if a value cannot be written, such as a NaN;")
+    out.append(" * #JSONInsufficientMemory if the buffer is too small, in which case")
+    out.append(" * outLength receives the size needed.")
+    out.append(" */")
+    indent = " " * len("JSONStatus_t %s_Encode(" % name)
+    out.append("JSONStatus_t %s_Encode( const %s_t * in," % (name, name))
+    out.append("%s char * buf," % indent)
+    out.append("%s size_t size," % indent)
+    out.append("%s size_t * outLength );" % indent)
+    out.append("")
+    out.append("#endif /* ifndef %s */" % guard)
+
+    return "\n".join(out) + "\n"
+
+
+def function_head(out, result, name, params):
+    """Emit a function head with one parameter per line, aligned as in coreJSON."""
+    head = "%s %s( " % (result, name)
+    for i, param in enumerate(params):
+        prefix = head if i == 0 else " " * len(head)
+        suffix = " )" if i == len(params) - 1 else ","
+        out.append(prefix + param + suffix)
+
+
+def generate_helpers(fields):
+    out = []
+    used = set(field.helper for field in fields)
+
+    out.append("/**")
+    out.append(" * @brief Check the result of the search for a field.")
+    out.append(" *")
+    out.append(" * @return #JSONSuccess if the field was found, or is optional;")
+    out.append(" * otherwise the status of the search.")
+    out.append(" */")
+    function_head(out, "static JSONStatus_t", "fieldStatus",
+                  ["const JSONQuery_t * query", "bool required", "bool * present"])
+    out.append("{")
+    out.append("    JSONStatus_t ret = query->status;")
+    out.append("")
+    out.append("    *present = ( ret == JSONSuccess ) ? true : false;")
+    out.append("")
+    out.append("    if( ( ret == JSONNotFound ) && ( required == false ) )")
+    out.append("    {")
+    out.append("        ret = JSONSuccess;")
+    out.append("    }")
+    out.append("")
+    out.append("    return ret;")
+    out.append("}")
+    out.append("")
+    out.append("/*-----------------------------------------------------------*/")
+    out.append("")
+    out.append("/**")
+    out.append(" * @brief Tell whether a value found by JSON_SearchMany() was a string,")
+    out.append(" * whose quotes were stripped.")
+    out.append(" */")
+    function_head(out, "static bool", "isString",
+                  ["const char * buf", "const JSONQuery_t * query"])
+    out.append("{")
+    out.append("    return ( ( query->value > buf ) && ( query->value[ -1 ] == '\"' ) ) ? true : false;")
+    out.append("}")
+
+    if "decodeBool" in used:
+        out.append("")
+        out.append("/*-----------------------------------------------------------*/")
+        out.append("")
+        out.append("/**")
+        out.append(" * @brief Convert a field found by JSON_SearchMany() to a bool.")
+        out.append(" */")
+        function_head(out, "static JSONStatus_t", "decodeBool",
+                      ["const char * buf", "const JSONQuery_t * query", "bool required",
+                       "bool * value", "bool * present"])
+        out.append("{")
+        out.append("    JSONStatus_t ret = fieldStatus( query, required, present );")
+        out.append("")
+        out.append("    if( ( ret == JSONSuccess ) && ( *present == true ) )")
+        out.append("    {")
+        out.append("        if( isString( buf, query ) == true )")
+        out.append("        {")
+        out.append("            ret = JSONIllegalDocument;")
+        out.append("        }")
+        out.append("        else if( ( query->valueLength == ( sizeof( \"true\" ) - 1U ) ) &&")
+        out.append("                 ( memcmp( query->value, \"true\", query->valueLength ) == 0 ) )")
+        out.append("        {")
+        out.append("            *value = true;")
+        out.append("        }")
+        out.append("        else if( ( query->valueLength == ( sizeof( \"false\" ) - 1U ) ) &&")
+        out.append("                 ( memcmp( query->value, \"false\", query->valueLength ) == 0 ) )")
+        out.append("        {")
+        out.append("            *value = false;")
+        out.append("        }")
+        out.append("        else")
+        out.append("        {")
+        out.append("            ret = JSONIllegalDocument;")
+        out.append("        }")
+        out.append("    }")
+        out.append("")
+        out.append("    return ret;")
+        out.append("}")
+
+    for ctype, (helper, accessor, accessorType, rangeCheck, _) in SCALAR_TYPES.items():
+        if (helper not in used) or (accessor is None):
+            continue
+
+        out.append("")
+        out.append("/*-----------------------------------------------------------*/")
+        out.append("")
+        out.append("/**")
+        out.append(" * @brief Convert a field found by JSON_SearchMany() to %s %s." % ("an" if ctype[0] in "aeio" else "a", ctype))
+        out.append(" */")
+        function_head(out, "static JSONStatus_t", helper,
+                      ["const char * buf", "const JSONQuery_t * query", "bool required",
+                       "%s * value" % ctype, "bool * present"])
+        out.append("{")
+        out.append("    JSONStatus_t ret = fieldStatus( query, required, present );")
+        out.append("    %s number = 0;" % accessorType)
+        out.append("")
+        out.append("    if( ( ret == JSONSuccess ) && ( *present == true ) )")
+        out.append("    {")
+        out.append("        if( isString( buf, query ) == true )")
+        out.append("        {")
+        out.append("            ret = JSONIllegalDocument;")
+        out.append("        }")
+        out.append("        else")
+        out.append("        {")
+        out.append("            ret = %s( query->value, query->valueLength, &number );" % accessor)
+        out.append("        }")
+
+        if rangeCheck is not None:
+            out.append("")
+            out.append("        if( ( ret == JSONSuccess ) && ( %s ) )" % rangeCheck)
+            out.append("        {")
+            out.append("            ret = JSONOutOfRange;")
+            out.append("        }")
+
+        out.append("")
+        out.append("        if( ret == JSONSuccess )")
+        out.append("        {")
+        if accessorType == ctype:
+            out.append("            *value = number;")
+        else:
+            out.append("            *value = ( %s ) number;" % ctype)
+        out.append("        }")
+        out.append("    }")
+        out.append("")
+        out.append("    return ret;")
+        out.append("}")
+
+    if "decodeString" in used:
+        out.append("")
+        out.append("/*-----------------------------------------------------------*/")
+        out.append("")
+        out.append("/**")
+        out.append(" * @brief Decode a string found by JSON_SearchMany() into a char array.")
+        out.append(" */")
+        function_head(out, "static JSONStatus_t", "decodeString",
+                      ["const char * buf", "const JSONQuery_t * query", "bool required",
+                       "char * value", "size_t size", "bool * present"])
+        out.append("{")
+        out.append("    JSONStatus_t ret = fieldStatus( query, required, present );")
+        out.append("    const char * decoded = NULL;")
+        out.append("    size_t decodedLength = 0U;")
+        out.append("")
+        out.append("    if( ( ret == JSONSuccess ) && ( *present == true ) )")
+        out.append("    {")
+        out.append("        if( isString( buf, query ) == false )")
+        out.append("        {")
+        out.append("            ret = JSONIllegalDocument;")
+        out.append("        }")
+        out.append("        else")
+        out.append("        {")
+        out.append("            /* Keep the last byte for the terminating NUL. */")
+        out.append("            ret = JSON_Unescape( query->value, query->valueLength, value, size - 1U,")
+        out.append("                                 &decoded, &decodedLength );")
+        out.append("        }")
+        out.append("")
+        out.append("        /* A string without escapes is not copied, nor checked against size. */")
+        out.append("        if( ( ret == JSONSuccess ) && ( decodedLength >= size ) )")
+        out.append("        {")
+        out.append("            ret = JSONInsufficientMemory;")
+        out.append("        }")
+        out.append("")
+        out.append("        if( ret == JSONSuccess )")
+        out.append("        {")
+        out.append("            if( decoded != value )")
+        out.append("            {")
+        out.append("                ( void ) memcpy( value, decoded, decodedLength );")
+        out.append("            }")
+        out.append("")
+        out.append("            value[ decodedLength ] = '\\0';")
+        out.append("        }")
+        out.append("    }")
+        out.append("")
+        out.append("    return ret;")
+        out.append("}")
+        out.append("")
+        out.append("/*-----------------------------------------------------------*/")
+        out.append("")
+        out.append("/**")
+        out.append(" * @brief The length of a string member, which may fill its array.")
+        out.append(" */")
+        function_head(out, "static size_t", "stringLength",
+                      ["const char * value", "size_t size"])
+        out.append("{")
+        out.append("    size_t i = 0U;")
+        out.append("")
+        out.append("    while( ( i < size ) && ( value[ i ] != '\\0' ) )")
+        out.append("    {")
+        out.append("        i++;")
+        out.append("    }")
+        out.append("")
+        out.append("    return i;")
+        out.append("}")
+
+    return out
+
+
+def generate_decoder(name, fields):
+    out = []
+    count = len(fields)
+
+    function_head(out, "JSONStatus_t", "%s_Decode" % name,
+                  ["char * buf", "size_t max", "%s_t * out" % name])
+    out.append("{")
+    out.append("    JSONStatus_t ret = JSONSuccess;")
+
+    if any(field.required for field in fields):
+        out.append("    bool present = false;")
+
+
+    out.append("    JSONQuery_t queries[ %d ] =" % count)
+    out.append("    {")
+
+    for i, field in enumerate(fields):
+        separator = "," if i < count - 1 else ""
+        out.append("        { .query = %s, .queryLength = sizeof( %s ) - 1U }%s"
+                   % (literal(field.path), literal(field.path), separator))
+
+    out.append("    };")
+    out.append("")
+    out.append("    if( ( buf == NULL ) || ( out == NULL ) )")
+    out.append("    {")
+    out.append("        ret = JSONNullParameter;")
+    out.append("    }")
+    out.append("    else if( max == 0U )")
+    out.append("    {")
+    out.append("        ret = JSONBadParameter;")
+    out.append("    }")
+    out.append("    else")
+    out.append("    {")
+    out.append("        /* JSON_SearchMany() only validates what it walks, which would")
+    out.append("         * accept a truncated document holding every field. */")
+    out.append("        ret = JSON_Validate( buf, max );")
+    out.append("    }")
+    out.append("")
+    out.append("    if( ret == JSONSuccess )")
+    out.append("    {")
+    out.append("        ( void ) memset( out, 0, sizeof( *out ) );")
+    out.append("")
+    out.append("        /* A single pass finds every field; each is checked below. */")
+    out.append("        ( void ) JSON_SearchMany( buf, max, queries, %dU );" % count)
+    out.append("    }")
+
+    for i, field in enumerate(fields):
+        present = "&present" if field.required else "&out->%sPresent" % field.member
+        required = "true" if field.required else "false"
+        if field.size is not None:
+            call = "decodeString( buf, &queries[ %d ], %s, out->%s, sizeof( out->%s ), %s );" % (
+                i, required, field.member, field.member, present)
+        else:
+            call = "%s( buf, &queries[ %d ], %s, &out->%s, %s );" % (
+                field.helper, i, required, field.member, present)
+
+        out.append("")
+        out.append("    if( ret == JSONSuccess )")
+        out.append("    {")
+        out.append("        ret = " + call)
+        out.append("    }")
+
+    out.append("")
+    out.append("    return ret;")
+    out.append("}")
+
+    return out
+
+
+def emit_object(out, node, indent, guarded=None):
+    """Emit the members of an object; guarded is a field whose presence the caller checked."""
+    pad = " " * indent
+
+    for key, child in node.children.items():
+        out.append("")
+
+        if isinstance(child, Field):
+            inner = indent
+            if (not child.required) and (child is not guarded):
+                out.append("%sif( in->%sPresent == true )" % (pad, child.member))
+                out.append("%s{" % pad)
+                inner = indent + 4
+
+            ipad = " " * inner
+            out.append("%s( void ) JSON_WriteKey( &writer, %s, sizeof( %s ) - 1U );"
+                       % (ipad, literal(key), literal(key)))
+
+            if child.size is not None:
+                out.append("%s( void ) JSON_WriteString( &writer, in->%s, stringLength( in->%s, sizeof( in->%s ) ) );"
+                           % (ipad, child.member, child.member, child.member))
+            elif child.type == "bool":
+                out.append("%s( void ) JSON_WriteLiteral( &writer, ( in->%s == true ) ? JSONTrue : JSONFalse );"
+                           % (ipad, child.member))
+            else:
+                writer = SCALAR_TYPES[child.type][4]
+                argType = SCALAR_TYPES[child.type][2]
+                value = "in->%s" % child.member
+                if argType != child.type:
+                    value = "( %s ) %s" % (argType, value)
+                out.append("%s( void ) %s( &writer, %s );" % (ipad, writer, value))
+
+            if inner != indent:
+                out.append("%s}" % pad)
+        else:
+            leaves = list(child.fields())
+            inner = indent
+
+            # Leave out an object all of whose fields are absent.
+            if all(not leaf.required for leaf in leaves):
+                conditions = ["( in->%sPresent == true )" % leaf.member for leaf in leaves]
+                if len(conditions) == 1:
+                    out.append("%sif( in->%sPresent == true )" % (pad, leaves[0].member))
+                else:
+                    out.append("%sif( %s ||" % (pad, conditions[0]))
+                    for i, condition in enumerate(conditions[1:]):
+                        end = " )" if i == len(conditions) - 2 else " ||"
+                        out.append("%s    %s%s" % (pad, condition, end))
+                out.append("%s{" % pad)
+                inner = indent + 4
+
+            ipad = " " * inner
+            out.append("%s( void ) JSON_WriteKey( &writer, %s, sizeof( %s ) - 1U );"
+                       % (ipad, literal(key), literal(key)))
+            out.append("%s( void ) JSON_WriteObjectStart( &writer );" % ipad)
+            emit_object(out, child, inner, leaves[0] if len(leaves) == 1 else None)
+            out.append("")
+            out.append("%s( void ) JSON_WriteObjectEnd( &writer );" % ipad)
+
+            if inner != indent:
+                out.append("%s}" % pad)
+
+
+def generate_encoder(name, root):
+    out = []
+
+    function_head(out, "JSONStatus_t", "%s_Encode" % name,
+                  ["const %s_t * in" % name, "char * buf", "size_t size", "size_t * outLength"])
+    out.append("{")
+    out.append("    JSONStatus_t ret;")
+    out.append("    JSONWriter_t writer;")
+    out.append("")
+    out.append("    if( ( in == NULL ) || ( outLength == NULL ) )")
+    out.append("    {")
+    out.append("        ret = JSONNullParameter;")
+    out.append("    }")
+    out.append("    else")
+    out.append("    {")
+    out.append("        ret = JSON_WriterInit( &writer, buf, size, NULL, NULL );")
+    out.append("    }")
+    out.append("")
+    out.append("    /* Errors of the writer are sticky, and reported by JSON_WriterFinish(). */")
+    out.append("    if( ret == JSONSuccess )")
+    out.append("    {")
+    out.append("        ( void ) JSON_WriteObjectStart( &writer );")
+    emit_object(out, root, 8)
+    out.append("")
+    out.append("        ( void ) JSON_WriteObjectEnd( &writer );")
+    out.append("")
+    out.append("        ret = JSON_WriterFinish( &writer, outLength );")
+    out.append("    }")
+    out.append("")
+    out.append("    return ret;")
+    out.append("}")
+
+    return out
+
+
+def generate_source(name, fields, root, header):
+    out = []
+    out.append("/* Generated by core_json_codegen.py; do not edit. */")
+    out.append("")
+    out.append("#include <string.h>")
+    out.append("")
+    out.append('#include "%s"' % header)
+    out.append('#include "core_json_number.h"')
+    out.append('#include "core_json_writer.h"')
+    out.append("")
+    out.extend(generate_helpers(fields))
+    out.append("")
+    out.append("/*-----------------------------------------------------------*/")
+    out.append("")
+    out.extend(generate_decoder(name, fields))
+    out.append("")
+    out.append("/*-----------------------------------------------------------*/")
+    out.append("")
+    out.extend(generate_encoder(name, root))
+
+    return "\n".join(out) + "\n"
+
+
+def main():
+    """
+    Generate <output>.h and <output>.c from a schema.
+    """
+    parser = argparse.ArgumentParser(description="Generate a coreJSON decoder and encoder for a C struct.")
+    parser.add_argument("schema", help="The schema, a JSON file.")
+    parser.add_argument(
+        "-o",
+        "--output",
+        action="store",
+        required=True,
+        dest="output",
+        help="The path of the generated files, without the .h or .c extension.",
+    )
+    args = parser.parse_args()
+
+    try:
+        name, fields, root = load_schema(args.schema)
+    except (OSError, ValueError, SchemaError) as e:
+        sys.exit("%s: %s" % (args.schema, e))
+
+    header = os.path.basename(args.output) + ".h"
+    guard = re.sub(r"[^A-Za-z0-9]", "_", header).upper() + "_"
+
+    with open(args.output + ".h", "w") as f:
+        f.write(generate_header(name, fields, guard))
+
+    with open(args.output + ".c", "w") as f:
+        f.write(generate_source(name, fields, root, header))
+
+
+if __name__ == "__main__":
+    main()
@@ -58,6 +58,19 @@
  *
  * > sleep_seconds = random_between( 0, min( 2<sup>attempts_count</sup> * base_seconds, maximum_seconds ) )
  *
+ * @section retryutils_scheduler Retry Scheduler
+ * The retry scheduler computes backoff delays in milliseconds with decorrelated
+ * jitter, where every delay is drawn relative to the previous one:
+ *
+ * > delay_ms = min( maximum_ms, random_between( base_ms, 3 * previous_delay_ms ) )
+ *
+ * It does not sleep. @ref RetryScheduler_NextAttempt returns the deadline of
+ * the next attempt, so that an event loop can wait for it together with other
+ * events. Each @ref RetryScheduler_t has its own random number generator state,
+ * so schedulers can be used from several threads without sharing global state.
+ * The POSIX @ref RetryUtils_BackoffAndSleep is a blocking wrapper around the
+ * scheduler for existing callers.
+ *
  * @section retryutils_implementation Implementing Retry Utils
  *
  * The functions that must be implemented are:<br>
@@ -198,6 +211,22 @@ typedef enum RetryUtilsStatus
     RetryUtilsRetriesExhausted /**< @brief The function exhausted all retry attempts. */
 } RetryUtilsStatus_t;
 
+/**
+ * @brief State of a millisecond retry scheduler with decorrelated jitter.
+ *
+ * @note This structure is managed by the scheduler functions and should not
+ * be modified by the application.
+ */
+typedef struct RetryScheduler
+{
+    uint32_t baseDelayMs;     /**< @brief Smallest delay between two attempts. */
+    uint32_t maxDelayMs;      /**< @brief Largest delay between two attempts. */
+    uint32_t maxAttempts;     /**< @brief Retries before #RetryUtilsRetriesExhausted, 0 to retry forever. */
+    uint32_t attemptsDone;    /**< @brief Retries scheduled since the last reset. */
+    uint32_t previousDelayMs; /**< @brief Delay of the last scheduled retry. */
+    uint64_t rngState;        /**< @brief Per-instance random number generator state. */
+} RetryScheduler_t;
+
 /**
  * @brief Represents parameters required for retry logic.
  */
@@ -213,6 +242,12 @@ typedef struct RetryUtilsParams
      * @brief The max jitter value for backoff time in retry attempt.
      */
     uint32_t nextJitterMax;
+
+    /**
+     * @brief Scheduler computing the delays, when the implementation is a
+     * wrapper around the retry scheduler.
+     */
+    RetryScheduler_t scheduler;
 } RetryUtilsParams_t;
 
 
@@ -232,6 +267,9 @@ void RetryUtils_ParamsReset( RetryUtilsParams_t * pRetryParams );
  * must use this function between retry failures to add exponential delay.
  * This function will block the calling task for the current timeout value.
  *
+ * @note Event loops should use @ref RetryScheduler_NextAttempt instead, which
+ * returns the deadline of the next attempt without blocking.
+ *
  * @param[in, out] pRetryParams Structure containing retry parameters.
  *
  * @return #RetryUtilsSuccess after a successful sleep, #RetryUtilsRetriesExhausted
@@ -241,4 +279,56 @@ void RetryUtils_ParamsReset( RetryUtilsParams_t * pRetryParams );
 RetryUtilsStatus_t RetryUtils_BackoffAndSleep( RetryUtilsParams_t * pRetryParams );
 /* @[define_retryutils_backoffandsleep] */
 
+/**
+ * @brief Initializes a retry scheduler.
+ *
+ * @param[out] pScheduler Scheduler to initialize.
+ * @param[in] baseDelayMs Smallest delay between two attempts; at least 1.
+ * @param[in] maxDelayMs Largest delay between two attempts.
+ * @param[in] maxAttempts Number of retries before
+ * #RetryUtilsRetriesExhausted is returned. Set to 0 to retry forever.
+ * @param[in] seed Seed of the random number generator of this scheduler.
+ * Schedulers of different devices or connections should use different seeds.
+ */
+void RetryScheduler_Init( RetryScheduler_t * pScheduler,
+                          uint32_t baseDelayMs,
+                          uint32_t maxDelayMs,
+                          uint32_t maxAttempts,
+                          uint64_t seed );
+
+/**
+ * @brief Restarts the backoff after a successful attempt. The random number
+ * generator state is kept.
+ *
+ * @param[in, out] pScheduler Scheduler to reset.
+ */
+void RetryScheduler_Reset( RetryScheduler_t * pScheduler );
+
+/**
+ * @brief Schedules the next retry after a failed attempt.
+ *
+ * @param[in, out] pScheduler Scheduler of the failed action.
+ * @param[in] nowMs Current time in milliseconds, e.g. from Clock_GetTimeMs.
+ * @param[out] pDeadlineMs Time at which the next attempt should be made. The
+ * time wraps like @p nowMs; see @ref RetryScheduler_RemainingMs.
+ *
+ * @return #RetryUtilsSuccess if a retry was scheduled;
+ * #RetryUtilsRetriesExhausted when all attempts are exhausted.
+ */
+RetryUtilsStatus_t RetryScheduler_NextAttempt( RetryScheduler_t * pScheduler,
+                                               uint32_t nowMs,
+                                               uint32_t * pDeadlineMs );
+
+/**
+ * @brief Computes the time left until a deadline returned by
+ * @ref RetryScheduler_NextAttempt, for use as an event loop timeout.
+ *
+ * @param[in] deadlineMs Deadline of the next attempt.
+ * @param[in] nowMs Current time in milliseconds.
+ *
+ * @return Milliseconds until the deadline; 0 if the deadline has passed.
+ */
+uint32_t RetryScheduler_RemainingMs( uint32_t deadlineMs,
+                                     uint32_t nowMs );
+
 #endif /* ifndef RETRY_UTILS_H_ */
@@ -26,51 +26,172 @@
  */
 
 /* Standard includes. */
-#include <unistd.h>
-#include <stdlib.h>
+#include <stddef.h>
 #include <time.h>
 
+/* Platform clock include. */
+#include "clock.h"
+
 #include "retry_utils.h"
 
 /*-----------------------------------------------------------*/
 
-RetryUtilsStatus_t RetryUtils_BackoffAndSleep( RetryUtilsParams_t * pRetryParams )
+/**
+ * @brief Number of milliseconds in a second.
+ */
+#define MILLISECONDS_PER_SECOND    1000U
+
+/**
+ * @brief Factor by which the upper bound of a delay grows over the previous
+ * delay in decorrelated jitter.
+ */
+#define DECORRELATED_GROWTH        3U
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Advance a SplitMix64 generator and return its next output.
+ *
+ * @param[in, out] pState Generator state.
+ *
+ * @return Next pseudo random number.
+ */
+static uint64_t nextRandom( uint64_t * pState );
+
+/**
+ * @brief Upper bound of the next delay of a scheduler.
+ *
+ * @param[in] pScheduler Scheduler to query.
+ *
+ * @return Largest delay the next call to @ref RetryScheduler_NextAttempt can
+ * return, in milliseconds.
+ */
+static uint32_t nextDelayUpperBound( const RetryScheduler_t * pScheduler );
+
+/*-----------------------------------------------------------*/
+
+static uint64_t nextRandom( uint64_t * pState )
+{
+    uint64_t z = ( *pState += 0x9E3779B97F4A7C15ULL );
+
+    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+
+    return z ^ ( z >> 31 );
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t nextDelayUpperBound( const RetryScheduler_t * pScheduler )
+{
+    uint64_t upperBound = ( uint64_t ) pScheduler->previousDelayMs * DECORRELATED_GROWTH;
+
+    if( upperBound < pScheduler->baseDelayMs )
+    {
+        upperBound = pScheduler->baseDelayMs;
+    }
+
+    if( upperBound > pScheduler->maxDelayMs )
+    {
+        upperBound = pScheduler->maxDelayMs;
+    }
+
+    return ( uint32_t ) upperBound;
+}
+
+/*-----------------------------------------------------------*/
+
+void RetryScheduler_Init( RetryScheduler_t * pScheduler,
+                          uint32_t baseDelayMs,
+                          uint32_t maxDelayMs,
+                          uint32_t maxAttempts,
+                          uint64_t seed )
+{
+    pScheduler->baseDelayMs = ( baseDelayMs == 0U ) ? 1U : baseDelayMs;
+    pScheduler->maxDelayMs = ( maxDelayMs < pScheduler->baseDelayMs ) ? pScheduler->baseDelayMs : maxDelayMs;
+    pScheduler->maxAttempts = maxAttempts;
+    pScheduler->rngState = seed;
+    RetryScheduler_Reset( pScheduler );
+}
+
+/*-----------------------------------------------------------*/
+
+void RetryScheduler_Reset( RetryScheduler_t * pScheduler )
+{
+    pScheduler->attemptsDone = 0U;
+
+    /* The first delay is drawn from [ base, 3 * base ]. */
+    pScheduler->previousDelayMs = pScheduler->baseDelayMs;
+}
+
+/*-----------------------------------------------------------*/
+
+RetryUtilsStatus_t RetryScheduler_NextAttempt( RetryScheduler_t * pScheduler,
+                                               uint32_t nowMs,
+                                               uint32_t * pDeadlineMs )
 {
     RetryUtilsStatus_t status = RetryUtilsRetriesExhausted;
-    int backOffDelay = 0;
+    uint32_t upperBound = 0U;
+    uint32_t delayMs = 0U;
 
-    /* If MAX_RETRY_ATTEMPTS is set to 0, try forever. */
-    if( ( pRetryParams->attemptsDone < MAX_RETRY_ATTEMPTS ) ||
-        ( 0 == MAX_RETRY_ATTEMPTS ) )
+    /* If maxAttempts is set to 0, try forever. */
+    if( ( pScheduler->attemptsDone < pScheduler->maxAttempts ) ||
+        ( pScheduler->maxAttempts == 0U ) )
     {
-        /* Choose a random value for back-off time between 0 and the max jitter value. */
-        backOffDelay = rand() % pRetryParams->nextJitterMax;
+        /* Decorrelated jitter: a random delay between the base delay and
+         * three times the previous delay, capped at the maximum. */
+        upperBound = nextDelayUpperBound( pScheduler );
+        delayMs = pScheduler->baseDelayMs +
+                  ( uint32_t ) ( nextRandom( &pScheduler->rngState ) %
+                                 ( ( uint64_t ) upperBound - pScheduler->baseDelayMs + 1U ) );
+
+        pScheduler->previousDelayMs = delayMs;
+        pScheduler->attemptsDone++;
+
+        /* Unsigned addition wraps like the millisecond clock. */
+        *pDeadlineMs = nowMs + delayMs;
+        status = RetryUtilsSuccess;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
 
+uint32_t RetryScheduler_RemainingMs( uint32_t deadlineMs,
+                                     uint32_t nowMs )
+{
+    /* The signed difference stays correct across a wrap of the clock as long
+     * as the deadline is less than 2^31 milliseconds away. */
+    int32_t remainingMs = ( int32_t ) ( deadlineMs - nowMs );
+
+    return ( remainingMs > 0 ) ? ( uint32_t ) remainingMs : 0U;
+}
+
+/*-----------------------------------------------------------*/
+
+RetryUtilsStatus_t RetryUtils_BackoffAndSleep( RetryUtilsParams_t * pRetryParams )
+{
+    RetryUtilsStatus_t status = RetryUtilsRetriesExhausted;
+    uint32_t nowMs = Clock_GetTimeMs();
+    uint32_t deadlineMs = 0U;
+
+    status = RetryScheduler_NextAttempt( &pRetryParams->scheduler, nowMs, &deadlineMs );
+
+    if( status == RetryUtilsSuccess )
+    {
         /*  Wait for backoff time to expire for the next retry. */
-        ( void ) sleep( backOffDelay );
-
-        /* Increment backoff counts. */
-        pRetryParams->attemptsDone++;
-
-        /* Double the max jitter value for the next retry attempt, only
-         * if the new value will be less than the max backoff time value. */
-        if( pRetryParams->nextJitterMax < ( MAX_RETRY_BACKOFF_SECONDS / 2U ) )
-        {
-            pRetryParams->nextJitterMax += pRetryParams->nextJitterMax;
-        }
-        else
-        {
-            pRetryParams->nextJitterMax = MAX_RETRY_BACKOFF_SECONDS;
-        }
+        Clock_SleepMs( RetryScheduler_RemainingMs( deadlineMs, nowMs ) );
 
-        status = RetryUtilsSuccess;
+        pRetryParams->attemptsDone = pRetryParams->scheduler.attemptsDone;
+        pRetryParams->nextJitterMax = ( nextDelayUpperBound( &pRetryParams->scheduler ) +
+                                        MILLISECONDS_PER_SECOND - 1U ) / MILLISECONDS_PER_SECOND;
     }
     else
     {
         /* When max retry attempts are exhausted, let application know by
          * returning RetryUtilsRetriesExhausted. Application may choose to
          * restart the retry process after calling RetryUtils_ParamsReset(). */
-        status = RetryUtilsRetriesExhausted;
         RetryUtils_ParamsReset( pRetryParams );
     }
 
@@ -81,23 +202,26 @@ RetryUtilsStatus_t RetryUtils_BackoffAndSleep( RetryUtilsParams_t * pRetryParams
 
 void RetryUtils_ParamsReset( RetryUtilsParams_t * pRetryParams )
 {
-    uint32_t jitter = 0;
     struct timespec tp;
+    uint64_t seed = 0U;
 
-    /* Reset attempts done to zero so that the next retry cycle can start. */
-    pRetryParams->attemptsDone = 0;
+    /* Seed the generator of this instance from the current time and its
+     * address, so that devices and connections that reset at the same time
+     * still draw different delays. The global rand() state is not used. */
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &tp );
+    seed = ( ( uint64_t ) tp.tv_sec * 1000000000ULL ) + ( uint64_t ) tp.tv_nsec;
+    seed ^= ( uint64_t ) ( uintptr_t ) pRetryParams;
 
-    /* Get current time to seed pseudo random number generator. */
-    ( void ) clock_gettime( CLOCK_REALTIME, &tp );
+    RetryScheduler_Init( &pRetryParams->scheduler,
+                         INITIAL_RETRY_BACKOFF_SECONDS * MILLISECONDS_PER_SECOND,
+                         MAX_RETRY_BACKOFF_SECONDS * MILLISECONDS_PER_SECOND,
+                         MAX_RETRY_ATTEMPTS,
+                         seed );
 
-    /* Seed pseudo random number generator with nanoseconds. */
-    srand( tp.tv_nsec );
-
-    /* Calculate jitter value using picking a random number. */
-    jitter = ( rand() % MAX_JITTER_VALUE_SECONDS );
-
-    /* Reset the backoff value to the initial time out value plus jitter. */
-    pRetryParams->nextJitterMax = INITIAL_RETRY_BACKOFF_SECONDS + jitter;
+    /* Reset attempts done to zero so that the next retry cycle can start. */
+    pRetryParams->attemptsDone = 0;
+    pRetryParams->nextJitterMax = ( nextDelayUpperBound( &pRetryParams->scheduler ) +
+                                    MILLISECONDS_PER_SECOND - 1U ) / MILLISECONDS_PER_SECOND;
 }
 
 /*-----------------------------------------------------------*/
@@ -0,0 +1,234 @@
+/*
+ * AWS IoT Device SDK for Embedded C V202011.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ENDPOINT_SET_POSIX_H_
+#define ENDPOINT_SET_POSIX_H_
+
+/**************************************************/
+/******* DO NOT CHANGE the following order ********/
+/**************************************************/
+
+/* Logging related header files are required to be included in the following order:
+ * 1. Include the header file "logging_levels.h".
+ * 2. Define LIBRARY_LOG_NAME and  LIBRARY_LOG_LEVEL.
+ * 3. Include the header file "logging_stack.h".
+ */
+
+/* Include header that defines log levels. */
+#include "logging_levels.h"
+
+/* Logging configuration for the endpoint selection utility. */
+#ifndef LIBRARY_LOG_NAME
+    #define LIBRARY_LOG_NAME     "Transport_EndpointSet"
+#endif
+#ifndef LIBRARY_LOG_LEVEL
+    #define LIBRARY_LOG_LEVEL    LOG_INFO
+#endif
+
+#include "logging_stack.h"
+
+/************ End of logging configuration ****************/
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Socket include. */
+#include "sockets_posix.h"
+
+/**
+ * @brief Maximum number of endpoints in an #EndpointSet_t.
+ */
+#ifndef ENDPOINT_SET_MAX_ENDPOINTS
+    #define ENDPOINT_SET_MAX_ENDPOINTS    8U
+#endif
+
+/**
+ * @brief Latency in milliseconds added to the score of an endpoint for each
+ * undecayed failure.
+ */
+#ifndef ENDPOINT_SET_FAILURE_PENALTY_MS
+    #define ENDPOINT_SET_FAILURE_PENALTY_MS    10000U
+#endif
+
+/**
+ * @brief Default time in milliseconds after which half of the failure penalty
+ * of an endpoint is forgiven.
+ */
+#ifndef ENDPOINT_SET_DEFAULT_HALF_LIFE_MS
+    #define ENDPOINT_SET_DEFAULT_HALF_LIFE_MS    60000U
+#endif
+
+/**
+ * @brief Fixed-point scale of #EndpointHealth_t.failureScore; one failure
+ * adds this amount.
+ */
+#define ENDPOINT_SET_FAILURE_SCALE    1024U
+
+/**
+ * @brief Endpoint set return status.
+ */
+typedef enum EndpointSetStatus
+{
+    ENDPOINT_SET_SUCCESS = 0,       /**< Function successfully completed. */
+    ENDPOINT_SET_INVALID_PARAMETER, /**< At least one parameter was invalid. */
+    ENDPOINT_SET_FULL,              /**< The set already holds #ENDPOINT_SET_MAX_ENDPOINTS endpoints. */
+    ENDPOINT_SET_ALL_FAILED         /**< Every endpoint failed to connect. */
+} EndpointSetStatus_t;
+
+/**
+ * @brief Connects to one endpoint of an #EndpointSet_t, including any TLS
+ * handshake.
+ *
+ * @param[in] pConnectContext Context passed to #EndpointSet_Connect.
+ * @param[in] pServerInfo Endpoint to connect to.
+ *
+ * @return 0 on success; any other value on failure.
+ */
+typedef int32_t ( * EndpointSetConnectFunc_t )( void * pConnectContext,
+                                                const ServerInfo_t * pServerInfo );
+
+/**
+ * @brief Health of one endpoint.
+ */
+typedef struct EndpointHealth
+{
+    ServerInfo_t serverInfo;      /**< @brief Endpoint address; the host name must outlive the set. */
+    uint32_t latencyMs;           /**< @brief Smoothed connect and handshake latency, 0 until measured. */
+    uint32_t failureScore;        /**< @brief Decaying failure count in units of #ENDPOINT_SET_FAILURE_SCALE. */
+    uint32_t lastDecayMs;         /**< @brief Time at which @ref failureScore was last decayed. */
+    uint32_t consecutiveFailures; /**< @brief Failures since the last success. */
+    uint32_t successCount;        /**< @brief Successful connections. */
+    uint32_t failureCount;        /**< @brief Failed connections. */
+} EndpointHealth_t;
+
+/**
+ * @brief A set of equivalent endpoints, such as brokers in several regions or
+ * the ATS and legacy endpoints of the same account.
+ *
+ * Every endpoint is scored by its smoothed connect latency plus a failure
+ * penalty that halves every @ref halfLifeMs. The endpoint with the lowest
+ * score is preferred, so a failed endpoint is retried once its penalty has
+ * decayed below the latency difference to the others. An endpoint that has
+ * not been measured yet is scored with the highest latency measured in the
+ * set.
+ *
+ * @note This structure is managed by the endpoint set functions and should
+ * not be modified by the application.
+ */
+typedef struct EndpointSet
+{
+    EndpointHealth_t endpoints[ ENDPOINT_SET_MAX_ENDPOINTS ]; /**< @brief The endpoints in order of preference on ties. */
+    size_t endpointCount;                                     /**< @brief Number of valid entries in @ref endpoints. */
+    uint32_t halfLifeMs;                                      /**< @brief Half-life of the failure penalty. */
+} EndpointSet_t;
+
+/**
+ * @brief Initializes an empty endpoint set.
+ *
+ * @param[out] pEndpointSet Endpoint set to initialize.
+ * @param[in] halfLifeMs Half-life of the failure penalty. 0 selects
+ * #ENDPOINT_SET_DEFAULT_HALF_LIFE_MS.
+ *
+ * @return #ENDPOINT_SET_SUCCESS on success; #ENDPOINT_SET_INVALID_PARAMETER
+ * on failure.
+ */
+EndpointSetStatus_t EndpointSet_Init( EndpointSet_t * pEndpointSet,
+                                      uint32_t halfLifeMs );
+
+/**
+ * @brief Adds an endpoint to the set.
+ *
+ * Endpoints added first are preferred while their scores are equal, so the
+ * primary endpoint should be added first.
+ *
+ * @param[in] pEndpointSet Endpoint set to add to.
+ * @param[in] pServerInfo Endpoint to add. The structure is copied but the
+ * host name is not.
+ *
+ * @return #ENDPOINT_SET_SUCCESS on success; #ENDPOINT_SET_INVALID_PARAMETER
+ * or #ENDPOINT_SET_FULL on failure.
+ */
+EndpointSetStatus_t EndpointSet_Add( EndpointSet_t * pEndpointSet,
+                                     const ServerInfo_t * pServerInfo );
+
+/**
+ * @brief Returns the endpoint with the lowest score.
+ *
+ * @param[in] pEndpointSet Endpoint set to select from.
+ * @param[out] pIndex Index of the selected endpoint.
+ *
+ * @return #ENDPOINT_SET_SUCCESS on success; #ENDPOINT_SET_INVALID_PARAMETER
+ * if the set is empty.
+ */
+EndpointSetStatus_t EndpointSet_Select( EndpointSet_t * pEndpointSet,
+                                        size_t * pIndex );
+
+/**
+ * @brief Records a successful connection to an endpoint.
+ *
+ * @param[in] pEndpointSet Endpoint set of the endpoint.
+ * @param[in] index Index of the endpoint.
+ * @param[in] latencyMs Measured connect and handshake latency.
+ *
+ * @return #ENDPOINT_SET_SUCCESS on success; #ENDPOINT_SET_INVALID_PARAMETER
+ * on failure.
+ */
+EndpointSetStatus_t EndpointSet_ReportSuccess( EndpointSet_t * pEndpointSet,
+                                               size_t index,
+                                               uint32_t latencyMs );
+
+/**
+ * @brief Records a failed connection to, or a lost connection with, an
+ * endpoint.
+ *
+ * @param[in] pEndpointSet Endpoint set of the endpoint.
+ * @param[in] index Index of the endpoint.
+ *
+ * @return #ENDPOINT_SET_SUCCESS on success; #ENDPOINT_SET_INVALID_PARAMETER
+ * on failure.
+ */
+EndpointSetStatus_t EndpointSet_ReportFailure( EndpointSet_t * pEndpointSet,
+                                               size_t index );
+
+/**
+ * @brief Connects to the best endpoint, failing over to the next best one
+ * immediately when a connection fails.
+ *
+ * Every endpoint is tried at most once, in order of score, and each attempt
+ * is timed and reported. Backing off is left to the caller and is only
+ * needed when #ENDPOINT_SET_ALL_FAILED is returned.
+ *
+ * @param[in] pEndpointSet Endpoint set to connect to.
+ * @param[in] connectFunction Function establishing the connection.
+ * @param[in] pConnectContext Context passed to @p connectFunction.
+ * @param[out] pIndex Index of the connected endpoint.
+ *
+ * @return #ENDPOINT_SET_SUCCESS on success; #ENDPOINT_SET_INVALID_PARAMETER
+ * or #ENDPOINT_SET_ALL_FAILED on failure.
+ */
+EndpointSetStatus_t EndpointSet_Connect( EndpointSet_t * pEndpointSet,
+                                         EndpointSetConnectFunc_t connectFunction,
+                                         void * pConnectContext,
+                                         size_t * pIndex );
+
+#endif /* ifndef ENDPOINT_SET_POSIX_H_ */
@@ -0,0 +1,226 @@
+/*
+ * AWS IoT Device SDK for Embedded C V202011.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INSTRUMENTED_POSIX_H_
+#define INSTRUMENTED_POSIX_H_
+
+/**************************************************/
+/******* DO NOT CHANGE the following order ********/
+/**************************************************/
+
+/* Logging related header files are required to be included in the following order:
+ * 1. Include the header file "logging_levels.h".
+ * 2. Define LIBRARY_LOG_NAME and  LIBRARY_LOG_LEVEL.
+ * 3. Include the header file "logging_stack.h".
+ */
+
+/* Include header that defines log levels. */
+#include "logging_levels.h"
+
+/* Logging configuration for the instrumenting transport decorator. */
+#ifndef LIBRARY_LOG_NAME
+    #define LIBRARY_LOG_NAME     "Transport_Instrumented"
+#endif
+#ifndef LIBRARY_LOG_LEVEL
+    #define LIBRARY_LOG_LEVEL    LOG_ERROR
+#endif
+
+#include "logging_stack.h"
+
+/************ End of logging configuration ****************/
+
+/* POSIX thread include. */
+#include <pthread.h>
+
+/* Transport includes. */
+#include "transport_interface.h"
+
+/**
+ * @brief Number of buckets of an #InstrumentedHistogram_t.
+ *
+ * Bucket 0 counts the value 0 and bucket i counts values in
+ * [2^(i-1), 2^i). The last bucket also counts all larger values.
+ */
+#define INSTRUMENTED_HISTOGRAM_BUCKETS    ( 32U )
+
+/**
+ * @brief Number of distinct error codes counted per direction. Further
+ * codes are only counted in #InstrumentedDirectionStats_t.errorCount.
+ */
+#ifndef INSTRUMENTED_MAX_ERROR_CODES
+    #define INSTRUMENTED_MAX_ERROR_CODES    ( 8U )
+#endif
+
+/**
+ * @brief Instrumenting transport return status.
+ */
+typedef enum InstrumentedStatus
+{
+    INSTRUMENTED_SUCCESS = 0,       /**< Function successfully completed. */
+    INSTRUMENTED_INVALID_PARAMETER, /**< At least one parameter was invalid. */
+    INSTRUMENTED_API_ERROR          /**< A call to a system API resulted in an internal error. */
+} InstrumentedStatus_t;
+
+/**
+ * @brief A histogram with power-of-2 buckets.
+ */
+typedef struct InstrumentedHistogram
+{
+    uint64_t buckets[ INSTRUMENTED_HISTOGRAM_BUCKETS ]; /**< @brief Sample count per bucket. */
+    uint64_t count;                                     /**< @brief Number of samples. */
+    uint64_t sum;                                       /**< @brief Sum of all samples. */
+    uint64_t max;                                       /**< @brief Largest sample. */
+} InstrumentedHistogram_t;
+
+/**
+ * @brief Number of calls that returned one error code.
+ */
+typedef struct InstrumentedErrorCount
+{
+    int32_t code;   /**< @brief The negative value returned by the inner transport. */
+    uint64_t count; /**< @brief Number of calls that returned it. */
+} InstrumentedErrorCount_t;
+
+/**
+ * @brief Statistics of the send or the receive direction.
+ */
+typedef struct InstrumentedDirectionStats
+{
+    InstrumentedHistogram_t latencyUs; /**< @brief Duration of each call in microseconds. */
+    InstrumentedHistogram_t bytes;     /**< @brief Bytes transferred by each successful call. */
+    uint64_t calls;                    /**< @brief Number of calls. */
+    uint64_t totalBytes;               /**< @brief Bytes transferred by all calls. */
+    uint64_t partialCount;             /**< @brief Calls that transferred fewer bytes than requested. */
+    uint64_t zeroCount;                /**< @brief Calls that transferred no bytes. */
+    uint64_t errorCount;               /**< @brief Calls that returned a negative value. */
+    InstrumentedErrorCount_t errorCodes[ INSTRUMENTED_MAX_ERROR_CODES ]; /**< @brief Count per error code. */
+} InstrumentedDirectionStats_t;
+
+/**
+ * @brief Statistics of an instrumented transport.
+ */
+typedef struct InstrumentedStats
+{
+    InstrumentedDirectionStats_t send; /**< @brief Statistics of #TransportInterface.send. */
+    InstrumentedDirectionStats_t recv; /**< @brief Statistics of #TransportInterface.recv. */
+} InstrumentedStats_t;
+
+/**
+ * @brief A transport decorator that measures every call of the transport it
+ * wraps.
+ *
+ * @note This structure is managed by the decorator and should not be
+ * modified by the application.
+ */
+typedef struct InstrumentedTransport
+{
+    TransportInterface_t inner; /**< @brief The wrapped transport. */
+    InstrumentedStats_t stats;  /**< @brief Statistics collected so far. */
+    pthread_mutex_t lock;       /**< @brief Guards @ref stats against concurrent snapshots. */
+} InstrumentedTransport_t;
+
+/**
+ * @brief Wrap a transport with the instrumenting decorator.
+ *
+ * @p pOuter is filled in with the decorator's send and receive functions and
+ * can be passed to coreMQTT or coreHTTP in place of @p pInner. Decorators can
+ * be stacked, e.g. over the transport of Netem_Init() to measure the traffic
+ * as impaired by the emulated link. A TLS transport cannot be measured at
+ * its socket, since it reads and writes the socket directly.
+ *
+ * @param[out] pInstrumented The decorator state. Must outlive @p pOuter.
+ * @param[in] pInner The transport to measure.
+ * @param[out] pOuter The transport interface to hand to the protocol library.
+ *
+ * @return #INSTRUMENTED_SUCCESS on success; #INSTRUMENTED_INVALID_PARAMETER,
+ * #INSTRUMENTED_API_ERROR on failure.
+ */
+InstrumentedStatus_t Instrumented_Init( InstrumentedTransport_t * pInstrumented,
+                                        const TransportInterface_t * pInner,
+                                        TransportInterface_t * pOuter );
+
+/**
+ * @brief Release the resources of the decorator.
+ *
+ * @param[in] pInstrumented The decorator state set up with #Instrumented_Init.
+ */
+void Instrumented_Deinit( InstrumentedTransport_t * pInstrumented );
+
+/**
+ * @brief Copy the statistics collected so far. Safe to call from another
+ * thread while the transport is in use.
+ *
+ * @param[in] pInstrumented The decorator state set up with #Instrumented_Init.
+ * @param[out] pSnapshot The copied statistics.
+ * @param[in] reset Clear the statistics after copying them if non-zero.
+ *
+ * @return #INSTRUMENTED_SUCCESS on success; #INSTRUMENTED_INVALID_PARAMETER on failure.
+ */
+InstrumentedStatus_t Instrumented_Snapshot( InstrumentedTransport_t * pInstrumented,
+                                            InstrumentedStats_t * pSnapshot,
+                                            uint8_t reset );
+
+/**
+ * @brief Estimate a percentile of a histogram.
+ *
+ * @param[in] pHistogram The histogram.
+ * @param[in] percentile The percentile in [0, 100].
+ *
+ * @return The upper bound of the bucket that holds the percentile, capped at
+ * the largest sample; 0 if the histogram is empty.
+ */
+uint64_t Instrumented_Percentile( const InstrumentedHistogram_t * pHistogram,
+                                  uint32_t percentile );
+
+/**
+ * @brief Receives data through the wrapped transport and measures the call.
+ *
+ * This is set as #TransportInterface.recv by #Instrumented_Init.
+ *
+ * @param[in] pNetworkContext The decorator state, as set by #Instrumented_Init.
+ * @param[out] pBuffer Buffer to receive network data into.
+ * @param[in] bytesToRecv Number of bytes requested from the network.
+ *
+ * @return The value returned by the wrapped transport; negative value if
+ * @p pNetworkContext is NULL.
+ */
+int32_t Instrumented_Recv( NetworkContext_t * pNetworkContext,
+                           void * pBuffer,
+                           size_t bytesToRecv );
+
+/**
+ * @brief Sends data through the wrapped transport and measures the call.
+ *
+ * This is set as #TransportInterface.send by #Instrumented_Init.
+ *
+ * @param[in] pNetworkContext The decorator state, as set by #Instrumented_Init.
+ * @param[in] pBuffer Buffer containing the bytes to send over the network stack.
+ * @param[in] bytesToSend Number of bytes to send over the network.
+ *
+ * @return The value returned by the wrapped transport; negative value if
+ * @p pNetworkContext is NULL.
+ */
+int32_t Instrumented_Send( NetworkContext_t * pNetworkContext,
+                           const void * pBuffer,
+                           size_t bytesToSend );
+
+#endif /* ifndef INSTRUMENTED_POSIX_H_ */
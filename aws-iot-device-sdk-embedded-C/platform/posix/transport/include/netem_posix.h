@@ -0,0 +1,275 @@
+/*
+ * AWS IoT Device SDK for Embedded C V202011.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef NETEM_POSIX_H_
+#define NETEM_POSIX_H_
+
+/**************************************************/
+/******* DO NOT CHANGE the following order ********/
+/**************************************************/
+
+/* Logging related header files are required to be included in the following order:
+ * 1. Include the header file "logging_levels.h".
+ * 2. Define LIBRARY_LOG_NAME and  LIBRARY_LOG_LEVEL.
+ * 3. Include the header file "logging_stack.h".
+ */
+
+/* Include header that defines log levels. */
+#include "logging_levels.h"
+
+/* Logging configuration for the network emulation transport decorator. */
+#ifndef LIBRARY_LOG_NAME
+    #define LIBRARY_LOG_NAME     "Transport_Netem"
+#endif
+#ifndef LIBRARY_LOG_LEVEL
+    #define LIBRARY_LOG_LEVEL    LOG_ERROR
+#endif
+
+#include "logging_stack.h"
+
+/************ End of logging configuration ****************/
+
+/* Transport includes. */
+#include "transport_interface.h"
+
+/**
+ * @brief Bytes that can be on the emulated link in each direction.
+ */
+#ifndef NETEM_LINK_BUFFER_SIZE
+    #define NETEM_LINK_BUFFER_SIZE     ( 16384U )
+#endif
+
+/**
+ * @brief Transfers that can be on the emulated link in each direction.
+ *
+ * Once this many are in transit, a new transfer joins the newest one and
+ * leaves the link with it.
+ */
+#ifndef NETEM_LINK_MAX_SEGMENTS
+    #define NETEM_LINK_MAX_SEGMENTS    ( 64U )
+#endif
+
+/**
+ * @brief Network emulation transport return status.
+ */
+typedef enum NetemStatus
+{
+    NETEM_SUCCESS = 0,       /**< Function successfully completed. */
+    NETEM_INVALID_PARAMETER, /**< At least one parameter was invalid. */
+    NETEM_SEND_FAILED        /**< The wrapped transport failed or stopped taking data. */
+} NetemStatus_t;
+
+/**
+ * @brief Link conditions to emulate. A zero field disables its impairment.
+ */
+typedef struct NetemConfig
+{
+    /**
+     * @brief Seed of the random number generator. The same seed gives the
+     * same sequence of random draws. A call draws at most once for a stall
+     * and once for fragmentation, and each transfer entering the link once
+     * for jitter. Which calls deliver bytes depends on when they complete
+     * their transit, so a run repeats exactly when its timing does.
+     */
+    uint32_t seed;
+
+    /**
+     * @brief One-way delay in milliseconds of the emulated link, applied
+     * once to every byte in each direction.
+     */
+    uint32_t latencyMs;
+
+    /**
+     * @brief Maximum deviation in milliseconds added to or subtracted from
+     * @ref latencyMs, drawn uniformly per transfer. Bytes are never
+     * reordered.
+     */
+    uint32_t jitterMs;
+
+    /**
+     * @brief Link capacity in bytes per second in each direction.
+     */
+    uint32_t bandwidthBytesPerSec;
+
+    /**
+     * @brief Largest number of bytes passed to the inner transport per send.
+     * Each send is cut to a random size in [1, maxSendChunk].
+     */
+    size_t maxSendChunk;
+
+    /**
+     * @brief Largest number of bytes requested from the inner transport per
+     * receive. Each receive is cut to a random size in [1, maxRecvChunk].
+     */
+    size_t maxRecvChunk;
+
+    /**
+     * @brief Probability in parts per million that a call stalls for
+     * @ref stallMs and then returns 0 without reaching the inner transport.
+     */
+    uint32_t stallPpm;
+
+    /**
+     * @brief Duration of a stall in milliseconds.
+     */
+    uint32_t stallMs;
+} NetemConfig_t;
+
+/**
+ * @brief Impairments applied so far.
+ */
+typedef struct NetemStats
+{
+    uint64_t delayedUs;       /**< @brief Total time transfers spent on the emulated link. */
+    uint64_t fragmentedSends; /**< @brief Sends cut shorter than requested. */
+    uint64_t fragmentedRecvs; /**< @brief Receives cut shorter than requested. */
+    uint64_t stalls;          /**< @brief Calls that stalled. */
+} NetemStats_t;
+
+/**
+ * @brief Bytes of one transfer on the emulated link.
+ */
+typedef struct NetemSegment
+{
+    uint64_t releaseUs; /**< @brief Time at which the bytes leave the link. */
+    size_t length;      /**< @brief Number of bytes. */
+} NetemSegment_t;
+
+/**
+ * @brief One direction of the emulated link: the bytes in transit, in a
+ * ring, and the transfers they belong to.
+ */
+typedef struct NetemLink
+{
+    uint8_t buffer[ NETEM_LINK_BUFFER_SIZE ];           /**< @brief Ring of bytes in transit. */
+    size_t head;                                        /**< @brief Offset of the oldest byte. */
+    size_t count;                                       /**< @brief Number of bytes in transit. */
+    NetemSegment_t segments[ NETEM_LINK_MAX_SEGMENTS ]; /**< @brief Ring of transfers in transit. */
+    size_t segmentHead;                                 /**< @brief Index of the oldest transfer. */
+    size_t segmentCount;                                /**< @brief Number of transfers in transit. */
+    uint64_t nextFreeUs;                                /**< @brief Time at which the link has serialized all bytes. */
+    uint64_t lastReleaseUs;                             /**< @brief Release time of the newest transfer. */
+} NetemLink_t;
+
+/**
+ * @brief A transport decorator that impairs the transport it wraps like a
+ * slow or lossy link would.
+ *
+ * @note This structure is managed by the decorator and should not be
+ * modified by the application.
+ */
+typedef struct NetemTransport
+{
+    TransportInterface_t inner; /**< @brief The wrapped transport. */
+    NetemConfig_t config;       /**< @brief The emulated link conditions. */
+    uint64_t rngState;          /**< @brief State of the random number generator. */
+    NetemLink_t sendLink;       /**< @brief Bytes sent, on their way to the wrapped transport. */
+    NetemLink_t recvLink;       /**< @brief Bytes received, on their way to the caller. */
+    NetemStats_t stats;         /**< @brief Impairments applied so far. */
+} NetemTransport_t;
+
+/**
+ * @brief Wrap a transport with the network emulation decorator.
+ *
+ * @p pOuter is filled in with the decorator's send and receive functions and
+ * can be passed to coreMQTT or coreHTTP in place of @p pInner.
+ *
+ * Each direction is a delay line. Bytes are stamped when they enter the
+ * emulated link: sent bytes when #Netem_Send accepts them, received bytes
+ * when the wrapped transport returns them. They leave the link once it
+ * has serialized them at @ref NetemConfig_t.bandwidthBytesPerSec and
+ * they have spent @ref NetemConfig_t.latencyMs, plus jitter, in transit.
+ * Calls do not sleep for the delay. Each call forwards the sent bytes that
+ * are due to the wrapped transport. Received bytes are returned only after
+ * their transit. Short reads and writes therefore do not add delay.
+ *
+ * The link is only serviced during calls. #Netem_Recv reads the wrapped
+ * transport on every call, so give the wrapped transport a receive timeout
+ * well below the latency, e.g. 1 ms. A longer timeout delays both
+ * directions by up to that timeout. Call #Netem_Flush before
+ * disconnecting, so that the last bytes sent reach the peer.
+ *
+ * @note #NetemTransport_t holds both delay lines, about
+ * 2 * #NETEM_LINK_BUFFER_SIZE bytes.
+ *
+ * @param[out] pNetem The decorator state. Must outlive @p pOuter.
+ * @param[in] pInner The transport to impair.
+ * @param[in] pConfig The link conditions to emulate.
+ * @param[out] pOuter The transport interface to hand to the protocol library.
+ *
+ * @return #NETEM_SUCCESS on success; #NETEM_INVALID_PARAMETER on failure.
+ */
+NetemStatus_t Netem_Init( NetemTransport_t * pNetem,
+                          const TransportInterface_t * pInner,
+                          const NetemConfig_t * pConfig,
+                          TransportInterface_t * pOuter );
+
+/**
+ * @brief Receives data through the wrapped transport under the emulated
+ * link conditions.
+ *
+ * This is set as #TransportInterface.recv by #Netem_Init.
+ *
+ * @param[in] pNetworkContext The decorator state, as set by #Netem_Init.
+ * @param[out] pBuffer Buffer to receive network data into.
+ * @param[in] bytesToRecv Number of bytes requested from the network.
+ *
+ * @return The number of bytes that completed their transit, up to
+ * @p bytesToRecv; 0 if none has, or on a stall; a negative value if
+ * @p pNetworkContext is NULL or the wrapped transport failed.
+ */
+int32_t Netem_Recv( NetworkContext_t * pNetworkContext,
+                    void * pBuffer,
+                    size_t bytesToRecv );
+
+/**
+ * @brief Sends data through the wrapped transport under the emulated link
+ * conditions.
+ *
+ * This is set as #TransportInterface.send by #Netem_Init.
+ *
+ * @param[in] pNetworkContext The decorator state, as set by #Netem_Init.
+ * @param[in] pBuffer Buffer containing the bytes to send over the network stack.
+ * @param[in] bytesToSend Number of bytes to send over the network.
+ *
+ * @return The number of bytes accepted onto the emulated link, which is
+ * fewer than @p bytesToSend when the send is fragmented or the link is
+ * full; 0 on a stall; a negative value if @p pNetworkContext is NULL or
+ * the wrapped transport failed.
+ */
+int32_t Netem_Send( NetworkContext_t * pNetworkContext,
+                    const void * pBuffer,
+                    size_t bytesToSend );
+
+/**
+ * @brief Wait until every byte sent has crossed the emulated link, and
+ * pass it to the wrapped transport.
+ *
+ * @param[in] pNetem The decorator state.
+ *
+ * @return #NETEM_SUCCESS once the send direction is empty;
+ * #NETEM_INVALID_PARAMETER if @p pNetem is NULL; #NETEM_SEND_FAILED if the
+ * wrapped transport failed or did not take the bytes.
+ */
+NetemStatus_t Netem_Flush( NetemTransport_t * pNetem );
+
+#endif /* ifndef NETEM_POSIX_H_ */
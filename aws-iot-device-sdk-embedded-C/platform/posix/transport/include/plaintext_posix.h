@@ -0,0 +1,230 @@
+/*
+ * AWS IoT Device SDK for Embedded C V202011.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLAINTEXT_POSIX_H_
+#define PLAINTEXT_POSIX_H_
+
+/**************************************************/
+/******* DO NOT CHANGE the following order ********/
+/**************************************************/
+
+/* Logging related header files are required to be included in the following order:
+ * 1. Include the header file "logging_levels.h".
+ * 2. Define LIBRARY_LOG_NAME and  LIBRARY_LOG_LEVEL.
+ * 3. Include the header file "logging_stack.h".
+ */
+
+/* Include header that defines log levels. */
+#include "logging_levels.h"
+
+/* Logging configuration for the transport interface implementation which uses
+ * plaintext sockets. */
+#ifndef LIBRARY_LOG_NAME
+    #define LIBRARY_LOG_NAME     "Transport_Plaintext_Sockets"
+#endif
+#ifndef LIBRARY_LOG_LEVEL
+    #define LIBRARY_LOG_LEVEL    LOG_ERROR
+#endif
+
+#include "logging_stack.h"
+
+/************ End of logging configuration ****************/
+
+/* Transport includes. */
+#include "transport_interface.h"
+
+/* Socket include. */
+#include "sockets_posix.h"
+
+/**
+ * @brief State of the optional MSG_ZEROCOPY send path of a plaintext
+ * connection.
+ *
+ * @note This structure is managed by the plaintext transport and should not
+ * be modified by the application.
+ */
+typedef struct PlaintextZeroCopy
+{
+    /**
+     * @brief Sends of at least this many bytes use MSG_ZEROCOPY.
+     * 0 disables the zero-copy path.
+     *
+     * Each such send waits until the peer acknowledges the data, so it
+     * costs at least one round trip.
+     */
+    size_t thresholdBytes;
+
+    /**
+     * @brief Timeout in milliseconds to wait for the kernel to release the
+     * buffer of a zero-copy send. Never 0 once zero-copy is enabled.
+     */
+    uint32_t completionTimeoutMs;
+
+    /**
+     * @brief Identifier the kernel assigns to the next zero-copy send.
+     */
+    uint32_t nextSendId;
+
+    /**
+     * @brief All zero-copy sends with an identifier lower than this one
+     * have completed.
+     */
+    uint32_t completedId;
+
+    /**
+     * @brief Number of zero-copy sends for which the kernel copied the data
+     * anyway, e.g. on a loopback device.
+     */
+    uint32_t copiedCount;
+} PlaintextZeroCopy_t;
+
+/**
+ * @brief Definition of the network context for the transport interface
+ * implementation that uses plaintext POSIX sockets.
+ *
+ * @note For this transport implementation, the socket descriptor and the
+ * zero-copy send state are used.
+ */
+struct NetworkContext
+{
+    int32_t socketDescriptor;
+    PlaintextZeroCopy_t zeroCopy;
+};
+
+/**
+ * @brief Establish a TCP connection to server.
+ *
+ * @param[out] pNetworkContext The output parameter to return the created network context.
+ * @param[in] pServerInfo Server connection info.
+ * @param[in] sendTimeoutMs Timeout for transport send.
+ * @param[in] recvTimeoutMs Timeout for transport recv.
+ *
+ * @note A timeout of 0 means infinite timeout.
+ *
+ * @return #SOCKETS_SUCCESS if successful;
+ * #SOCKETS_INVALID_PARAMETER, #SOCKETS_DNS_FAILURE, #SOCKETS_CONNECT_FAILURE on error.
+ */
+SocketStatus_t Plaintext_Connect( NetworkContext_t * pNetworkContext,
+                                  const ServerInfo_t * pServerInfo,
+                                  uint32_t sendTimeoutMs,
+                                  uint32_t recvTimeoutMs );
+
+/**
+ * @brief Close TCP connection to server.
+ *
+ * @param[in] pNetworkContext The network context to close the connection.
+ *
+ * @return #SOCKETS_SUCCESS if successful; #SOCKETS_INVALID_PARAMETER on error.
+ */
+SocketStatus_t Plaintext_Disconnect( const NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Enable the MSG_ZEROCOPY send path for large payloads.
+ *
+ * Sends of at least @p thresholdBytes are handed to the kernel without
+ * copying them into the socket buffer. Since the caller of
+ * #TransportInterface.send may reuse its buffer as soon as the call returns,
+ * #Plaintext_Send waits for the completion notification of every zero-copy
+ * send on the socket error queue before returning. Zero-copy only pays off
+ * for payloads of roughly 10 KB and more, so small sends keep the regular
+ * copying path.
+ *
+ * The completion notification arrives only once the peer has acknowledged
+ * the data, so every zero-copy send costs at least one round trip, and a
+ * stream of large sends proceeds one send per round trip rather than
+ * filling the TCP window. Choose @p thresholdBytes so that the copy saved
+ * outweighs that stall; on high-latency links, a regular send is usually
+ * faster.
+ *
+ * If the kernel reports that it had to copy the data anyway (e.g. on a
+ * loopback device), the zero-copy path is disabled for the rest of the
+ * connection.
+ *
+ * @param[in] pNetworkContext The network context created using Plaintext_Connect API.
+ * @param[in] thresholdBytes Minimum size of a send to use MSG_ZEROCOPY. 0 disables it.
+ * @param[in] completionTimeoutMs Timeout to wait for a completion notification.
+ * 0 means the send timeout given to Plaintext_Connect.
+ *
+ * @return #SOCKETS_SUCCESS if successful; #SOCKETS_INVALID_PARAMETER on bad
+ * parameters, including a completionTimeoutMs of 0 on a connection whose
+ * send timeout is infinite; #SOCKETS_API_ERROR if the platform or socket
+ * does not support MSG_ZEROCOPY.
+ */
+SocketStatus_t Plaintext_EnableZeroCopy( NetworkContext_t * pNetworkContext,
+                                         size_t thresholdBytes,
+                                         uint32_t completionTimeoutMs );
+
+/**
+ * @brief Receives data over an established TCP connection.
+ *
+ * This can be used as #TransportInterface.recv function to receive data over
+ * the network.
+ *
+ * @param[in] pNetworkContext The network context created using Plaintext_Connect API.
+ * @param[out] pBuffer Buffer to receive network data into.
+ * @param[in] bytesToRecv Number of bytes requested from the network.
+ *
+ * @return Number of bytes received if successful; 0 if the receive timed out;
+ * negative value on error or if the server closed the connection.
+ */
+int32_t Plaintext_Recv( NetworkContext_t * pNetworkContext,
+                        void * pBuffer,
+                        size_t bytesToRecv );
+
+/**
+ * @brief Sends data over an established TCP connection.
+ *
+ * This can be used as the #TransportInterface.send function to send data
+ * over the network.
+ *
+ * @param[in] pNetworkContext The network context created using Plaintext_Connect API.
+ * @param[in] pBuffer Buffer containing the bytes to send over the network stack.
+ * @param[in] bytesToSend Number of bytes to send over the network.
+ *
+ * @return Number of bytes sent if successful; 0 if the socket was made
+ * non-blocking and is full; negative value on error or when the send timeout
+ * of #Plaintext_Connect expires, since coreMQTT retries a 0 without bound.
+ */
+int32_t Plaintext_Send( NetworkContext_t * pNetworkContext,
+                        const void * pBuffer,
+                        size_t bytesToSend );
+
+/**
+ * @brief Sends part of a file over the connection with sendfile, without
+ * copying it through user space.
+ *
+ * @param[in] pNetworkContext The network context created using Plaintext_Connect API.
+ * @param[in] fileDescriptor Descriptor of the file to send.
+ * @param[in,out] pOffset Offset in the file to send from; advanced by the
+ * number of bytes sent.
+ * @param[in] bytesToSend Number of bytes to send.
+ *
+ * @return Number of bytes sent if successful, which may be less than
+ * @p bytesToSend; 0 on timeout; negative value on error, including the end
+ * of the file before any byte is sent.
+ */
+int32_t Plaintext_SendFile( NetworkContext_t * pNetworkContext,
+                            int32_t fileDescriptor,
+                            int64_t * pOffset,
+                            size_t bytesToSend );
+
+#endif /* ifndef PLAINTEXT_POSIX_H_ */
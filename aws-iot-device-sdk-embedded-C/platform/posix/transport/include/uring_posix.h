@@ -0,0 +1,312 @@
+/*
+ * AWS IoT Device SDK for Embedded C V202011.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef URING_POSIX_H_
+#define URING_POSIX_H_
+
+/**************************************************/
+/******* DO NOT CHANGE the following order ********/
+/**************************************************/
+
+/* Logging related header files are required to be included in the following order:
+ * 1. Include the header file "logging_levels.h".
+ * 2. Define LIBRARY_LOG_NAME and  LIBRARY_LOG_LEVEL.
+ * 3. Include the header file "logging_stack.h".
+ */
+
+/* Include header that defines log levels. */
+#include "logging_levels.h"
+
+/* Logging configuration for the transport interface implementation which uses
+ * io_uring and sockets. */
+#ifndef LIBRARY_LOG_NAME
+    #define LIBRARY_LOG_NAME     "Transport_Uring_Sockets"
+#endif
+#ifndef LIBRARY_LOG_LEVEL
+    #define LIBRARY_LOG_LEVEL    LOG_ERROR
+#endif
+
+#include "logging_stack.h"
+
+/************ End of logging configuration ****************/
+
+/* Transport includes. */
+#include "transport_interface.h"
+
+/* Socket include. */
+#include "sockets_posix.h"
+
+/**
+ * @brief Number of submission queue entries of the reactor ring.
+ */
+#ifndef URING_QUEUE_DEPTH
+    #define URING_QUEUE_DEPTH          ( 256U )
+#endif
+
+/**
+ * @brief Maximum number of connections driven by one reactor.
+ */
+#ifndef URING_MAX_CONNECTIONS
+    #define URING_MAX_CONNECTIONS      ( 64U )
+#endif
+
+/**
+ * @brief Number of receive buffers shared by all connections of a reactor.
+ * Must be a power of 2 and not larger than 32768.
+ */
+#ifndef URING_RECV_BUFFER_COUNT
+    #define URING_RECV_BUFFER_COUNT    ( 256U )
+#endif
+
+/**
+ * @brief Size in bytes of one receive buffer.
+ */
+#ifndef URING_RECV_BUFFER_SIZE
+    #define URING_RECV_BUFFER_SIZE     ( 4096U )
+#endif
+
+/**
+ * @brief Size in bytes of the registered send buffer of one connection.
+ * Sends are copied into it and written to the socket in the next batch.
+ */
+#ifndef URING_SEND_BUFFER_SIZE
+    #define URING_SEND_BUFFER_SIZE     ( 16384U )
+#endif
+
+/**
+ * @brief io_uring transport and reactor return status.
+ */
+typedef enum UringStatus
+{
+    URING_SUCCESS = 0,         /**< Function successfully completed. */
+    URING_INVALID_PARAMETER,   /**< At least one parameter was invalid. */
+    URING_INSUFFICIENT_MEMORY, /**< Insufficient memory or no free connection slot. */
+    URING_NOT_SUPPORTED,       /**< The kernel does not provide the required io_uring features. */
+    URING_API_ERROR,           /**< A call to a system API resulted in an internal error. */
+    URING_DNS_FAILURE,         /**< Resolving hostname of the server failed. */
+    URING_CONNECT_FAILURE      /**< Initial connection to the server failed. */
+} UringStatus_t;
+
+/* Kernel io_uring structures, defined in <linux/io_uring.h>. */
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+/**
+ * @brief Received bytes of a connection held in one reactor receive buffer.
+ */
+typedef struct UringRecvSlice
+{
+    uint16_t bufferId; /**< @brief Receive buffer holding the bytes. */
+    uint32_t offset;   /**< @brief Offset of the first unread byte. */
+    uint32_t length;   /**< @brief Number of unread bytes. */
+} UringRecvSlice_t;
+
+/**
+ * @brief An io_uring instance that batches the submissions and completions
+ * of all of its connections.
+ *
+ * The ring memory, the provided receive buffers and the registered send
+ * buffers are set up by #UringReactor_Init. A reactor and its connections
+ * must be driven from a single thread.
+ *
+ * @note This structure is managed by the reactor and should not be modified
+ * by the application.
+ */
+typedef struct UringReactor
+{
+    int32_t ringDescriptor; /**< @brief The io_uring file descriptor. */
+
+    /* Submission queue. */
+    void * pSqRing;                     /**< @brief Mapped submission queue ring. */
+    size_t sqRingSize;                  /**< @brief Size of the mapped submission queue ring. */
+    struct io_uring_sqe * pSqEntries;   /**< @brief Mapped submission queue entries. */
+    size_t sqEntriesSize;               /**< @brief Size of the mapped submission queue entries. */
+    uint32_t * pSqHead;                 /**< @brief Submission queue head, advanced by the kernel. */
+    uint32_t * pSqTail;                 /**< @brief Submission queue tail, advanced by the reactor. */
+    uint32_t * pSqArray;                /**< @brief Submission queue index array. */
+    uint32_t sqMask;                    /**< @brief Submission queue index mask. */
+    uint32_t sqEntryCount;              /**< @brief Number of submission queue entries. */
+    uint32_t sqSubmitted;               /**< @brief Tail value already handed to the kernel. */
+
+    /* Completion queue. */
+    void * pCqRing;                     /**< @brief Mapped completion queue ring. */
+    size_t cqRingSize;                  /**< @brief Size of the mapped completion queue ring. */
+    struct io_uring_cqe * pCqEntries;   /**< @brief Completion queue entries. */
+    uint32_t * pCqHead;                 /**< @brief Completion queue head, advanced by the reactor. */
+    uint32_t * pCqTail;                 /**< @brief Completion queue tail, advanced by the kernel. */
+    uint32_t cqMask;                    /**< @brief Completion queue index mask. */
+
+    /* Buffers. */
+    struct io_uring_buf_ring * pBufferRing; /**< @brief Ring of provided receive buffers. */
+    size_t bufferRingSize;                  /**< @brief Size of the mapped buffer ring. */
+    uint8_t * pRecvBuffers;                 /**< @brief Memory of the receive buffers. */
+    uint8_t * pSendBuffers;                 /**< @brief Registered memory of the send buffers. */
+    uint16_t bufferRingTail;                /**< @brief Local tail of the buffer ring. */
+
+    NetworkContext_t * pConnections[ URING_MAX_CONNECTIONS ]; /**< @brief Connections by slot. */
+    uint32_t slotGenerations[ URING_MAX_CONNECTIONS ];        /**< @brief Generation of each slot, advanced on disconnect. */
+
+    uint64_t enterCount;      /**< @brief Number of io_uring_enter system calls. */
+    uint64_t completionCount; /**< @brief Number of completions processed. */
+} UringReactor_t;
+
+/**
+ * @brief Definition of the network context for the transport interface
+ * implementation that uses io_uring and POSIX sockets.
+ *
+ * @note This structure is managed by the transport and should not be
+ * modified by the application.
+ */
+struct NetworkContext
+{
+    int32_t socketDescriptor;
+    UringReactor_t * pReactor;
+    uint32_t slot;
+    uint32_t generation;
+    uint32_t sendTimeoutMs;
+    uint32_t recvTimeoutMs;
+
+    /* Receive state. */
+    UringRecvSlice_t recvQueue[ URING_RECV_BUFFER_COUNT ];
+    uint32_t recvHead;
+    uint32_t recvCount;
+    uint8_t recvArmed;
+    uint8_t peerClosed;
+
+    /* Send state. Bytes in [sentOffset, queuedOffset) of the connection's
+     * registered send buffer are waiting to be written. At most one write
+     * is in flight so that the byte stream stays ordered. */
+    uint32_t sentOffset;
+    uint32_t queuedOffset;
+    uint8_t sendInFlight;
+
+    int32_t pendingError;
+};
+
+/**
+ * @brief Set up an io_uring reactor.
+ *
+ * Creates the ring, registers the send buffers and the ring of provided
+ * receive buffers. Requires Linux 6.0 or later for multishot receive.
+ *
+ * @param[out] pReactor The reactor to set up.
+ *
+ * @return #URING_SUCCESS on success; #URING_INVALID_PARAMETER,
+ * #URING_INSUFFICIENT_MEMORY, #URING_NOT_SUPPORTED, #URING_API_ERROR on failure.
+ */
+UringStatus_t UringReactor_Init( UringReactor_t * pReactor );
+
+/**
+ * @brief Release all resources of a reactor. All connections must have been
+ * disconnected.
+ *
+ * @param[in] pReactor The reactor set up with #UringReactor_Init.
+ */
+void UringReactor_Deinit( UringReactor_t * pReactor );
+
+/**
+ * @brief Submit all queued operations of every connection in one system call,
+ * wait for completions and dispatch them to their connections.
+ *
+ * Sends only reach the network when the reactor is polled. #Uring_Recv polls
+ * the reactor when it has no data, so an application that runs
+ * MQTT_ProcessLoop on all of its connections drives the reactor implicitly.
+ *
+ * @param[in] pReactor The reactor set up with #UringReactor_Init.
+ * @param[in] timeoutMs Maximum time to wait for a completion. 0 does not wait.
+ *
+ * @return Number of completions processed; negative value on error.
+ */
+int32_t UringReactor_Poll( UringReactor_t * pReactor,
+                           uint32_t timeoutMs );
+
+/**
+ * @brief Establish a TCP connection to server and attach it to a reactor.
+ *
+ * A multishot receive is armed right away, so incoming data lands in the
+ * reactor's receive buffers without a system call per message.
+ *
+ * @param[out] pNetworkContext The output parameter to return the created network context.
+ * @param[in] pReactor The reactor that drives the connection.
+ * @param[in] pServerInfo Server connection info.
+ * @param[in] sendTimeoutMs Timeout to wait for room in the send buffer.
+ * @param[in] recvTimeoutMs Timeout to wait for data in #Uring_Recv.
+ *
+ * @return #URING_SUCCESS on success; #URING_INVALID_PARAMETER,
+ * #URING_INSUFFICIENT_MEMORY, #URING_DNS_FAILURE, #URING_CONNECT_FAILURE,
+ * #URING_API_ERROR on failure.
+ */
+UringStatus_t Uring_Connect( NetworkContext_t * pNetworkContext,
+                             UringReactor_t * pReactor,
+                             const ServerInfo_t * pServerInfo,
+                             uint32_t sendTimeoutMs,
+                             uint32_t recvTimeoutMs );
+
+/**
+ * @brief Flush pending sends, detach the connection from its reactor and
+ * close it.
+ *
+ * @param[in] pNetworkContext The network context created using Uring_Connect API.
+ *
+ * @return #URING_SUCCESS on success; #URING_INVALID_PARAMETER on failure.
+ */
+UringStatus_t Uring_Disconnect( NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Receives data from the reactor's completed receive buffers.
+ *
+ * This can be used as #TransportInterface.recv function to receive data over
+ * the network.
+ *
+ * @param[in] pNetworkContext The network context created using Uring_Connect API.
+ * @param[out] pBuffer Buffer to receive network data into.
+ * @param[in] bytesToRecv Number of bytes requested from the network.
+ *
+ * @return Number of bytes received if successful; 0 if no data arrived
+ * within the receive timeout; negative value on error or if the server
+ * closed the connection.
+ */
+int32_t Uring_Recv( NetworkContext_t * pNetworkContext,
+                    void * pBuffer,
+                    size_t bytesToRecv );
+
+/**
+ * @brief Queues data to be sent in the reactor's next submission batch.
+ *
+ * This can be used as the #TransportInterface.send function to send data
+ * over the network. The data is copied into the connection's registered send
+ * buffer, so the caller may reuse @p pBuffer when the call returns. Errors of
+ * a queued write are reported by the next call on the connection.
+ *
+ * @param[in] pNetworkContext The network context created using Uring_Connect API.
+ * @param[in] pBuffer Buffer containing the bytes to send over the network stack.
+ * @param[in] bytesToSend Number of bytes to send over the network.
+ *
+ * @return Number of bytes queued if successful; 0 if the send buffer stayed
+ * full for the send timeout; negative value on error.
+ */
+int32_t Uring_Send( NetworkContext_t * pNetworkContext,
+                    const void * pBuffer,
+                    size_t bytesToSend );
+
+#endif /* ifndef URING_POSIX_H_ */
@@ -49,7 +49,15 @@
 
 /************ End of logging configuration ****************/
 
-/* WolfSSL include. */
+/* WolfSSL includes. The build configuration of wolfSSL comes first, so
+ * that its headers and the feature checks of this transport agree with the
+ * library. A build that configures wolfSSL with WOLFSSL_USER_SETTINGS gets
+ * it from user_settings.h through settings.h instead; the Azure Sphere SDK
+ * configures its wolfSSL in the platform headers. */
+#if !defined( WOLFSSL_USER_SETTINGS ) && !defined( AzureSpherePlatform )
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/wolfcrypt/settings.h>
 #include <wolfssl/ssl.h>
 
 /* Transport includes. */
@@ -58,6 +66,110 @@
 /* Socket include. */
 #include "sockets_posix.h"
 
+/**
+ * @brief TLS protocol version negotiated by #Wolfssl_Connect.
+ */
+typedef enum WolfsslTlsVersion
+{
+    WOLFSSL_POSIX_TLS_AUTO = 0, /**< Offer TLS 1.3 when built with WOLFSSL_TLS13 and fall back to TLS 1.2; only TLS 1.2 on Azure Sphere. */
+    WOLFSSL_POSIX_TLS_1_2,      /**< Only negotiate TLS 1.2. */
+    WOLFSSL_POSIX_TLS_1_3       /**< Only negotiate TLS 1.3. */
+} WolfsslTlsVersion_t;
+
+/**
+ * @brief Policy deciding which application data may be sent as TLS 1.3 0-RTT
+ * early data.
+ *
+ * Early data is not protected against replay by the server, so it must only
+ * carry an idempotent first flight such as an MQTT CONNECT packet.
+ */
+typedef enum WolfsslEarlyDataPolicy
+{
+    WOLFSSL_POSIX_EARLY_DATA_OFF = 0,     /**< Never send early data. */
+    WOLFSSL_POSIX_EARLY_DATA_FIRST_FLIGHT /**< Send the first #Wolfssl_Send buffer as early data on resumption. */
+} WolfsslEarlyDataPolicy_t;
+
+/**
+ * @brief Directions of an established connection whose record encryption is
+ * handed to Linux kernel TLS.
+ *
+ * Offload requires building with WOLFSSL_POSIX_KTLS, a wolfSSL that exposes
+ * the traffic keys and sequence numbers (built with --enable-atomicuser) and
+ * a kernel with the tls module. The connection silently stays in wolfSSL when
+ * the negotiated cipher suite or the kernel does not support offload.
+ */
+typedef enum WolfsslKtlsMode
+{
+    WOLFSSL_POSIX_KTLS_OFF = 0, /**< Encrypt and decrypt in wolfSSL. */
+    WOLFSSL_POSIX_KTLS_TX,      /**< Encrypt in the kernel, which also enables #Wolfssl_SendFile zero copy. */
+    WOLFSSL_POSIX_KTLS_TX_RX    /**< Encrypt and decrypt in the kernel. Other post-handshake messages are dropped, so a TLS 1.3 connection with resumption configured keeps decrypting in wolfSSL, which stores the session tickets it receives. */
+} WolfsslKtlsMode_t;
+
+/**
+ * @brief Session resumption state kept by the application across connections.
+ *
+ * Pass the same structure in #WolfsslCredentials_t.pResumption for every
+ * connection to the same server. #Wolfssl_Connect offers the stored session
+ * (a TLS 1.3 PSK ticket or a TLS 1.2 session) and the stored session is
+ * replaced with the latest one on connect and on #Wolfssl_Disconnect.
+ *
+ * @note Zero-initialize before first use and release with
+ * #Wolfssl_FreeResumption.
+ */
+typedef struct WolfsslResumption
+{
+    WOLFSSL_SESSION * pSession;               /**< @brief Session to resume, NULL for a full handshake. */
+    WolfsslEarlyDataPolicy_t earlyDataPolicy; /**< @brief Which data may be sent as 0-RTT early data. */
+    uint32_t maxEarlyDataBytes;               /**< @brief Largest first flight sent as early data; larger flights wait for the handshake. */
+    uint8_t resumed;                          /**< @brief Set to 1 when the last handshake resumed the stored session. */
+    uint8_t earlyDataAccepted;                /**< @brief Set to 1 when the server accepted the last early data. */
+} WolfsslResumption_t;
+
+/**
+ * @brief Fixed memory from which wolfSSL allocates instead of the heap.
+ *
+ * Requires a wolfSSL built with WOLFSSL_STATIC_MEMORY. Give each connection
+ * its own pool with maxConnections set to 1, or let several connections share
+ * one pool sized for all of them. TLS memory is then bounded by the pool size
+ * and does not fragment the heap across reconnects.
+ *
+ * The pool holds the WOLFSSL_CTX of its connections, which is set up with the
+ * credentials of the first connection and reused by every later one, so all
+ * connections of a pool must use the same credentials. Sessions stored for
+ * resumption are allocated from the pool as well.
+ *
+ * @note Zero-initialize, then set the buffers and maxConnections before first
+ * use. Release with #Wolfssl_FreeMemoryPool once no connection uses it.
+ */
+typedef struct WolfsslMemoryPool
+{
+    uint8_t * pBuffer;       /**< @brief Memory for general allocations. Must outlive the pool. */
+    uint32_t bufferSize;     /**< @brief Size of pBuffer in bytes. */
+    uint8_t * pIoBuffer;     /**< @brief Optional separate memory for the fixed-size record buffers, NULL to use pBuffer. */
+    uint32_t ioBufferSize;   /**< @brief Size of pIoBuffer in bytes. */
+    uint32_t maxConnections; /**< @brief Number of connections that may use the pool at the same time. */
+
+    /* Managed by the transport. */
+    WOLFSSL_CTX * pSslContext;          /**< @brief Context living in the pool, created by the first connection. */
+    uint32_t peakConnectionBytes;       /**< @brief Largest memory use of one connection so far. */
+    uint32_t peakConnectionAllocations; /**< @brief Largest number of live allocations of one connection so far. */
+} WolfsslMemoryPool_t;
+
+/**
+ * @brief Memory use of a #WolfsslMemoryPool_t, reported by
+ * #Wolfssl_GetMemoryStats.
+ */
+typedef struct WolfsslMemoryStats
+{
+    uint32_t currentAllocations;        /**< @brief Blocks allocated from the pool now. */
+    uint32_t totalAllocations;          /**< @brief Blocks allocated since the pool was set up. */
+    uint32_t totalFrees;                /**< @brief Blocks freed since the pool was set up. */
+    uint32_t availableBytes;            /**< @brief Bytes in free blocks now. */
+    uint32_t availableIoBuffers;        /**< @brief Free record buffers now. */
+    uint32_t peakConnectionBytes;       /**< @brief High-water mark of the memory use of one connection. */
+    uint32_t peakConnectionAllocations; /**< @brief High-water mark of the live allocations of one connection. */
+} WolfsslMemoryStats_t;
+
 /**
  * @brief Definition of the network context for the transport interface
  * implementation that uses WolfSSL and POSIX sockets.
@@ -69,6 +181,12 @@ struct NetworkContext
 {
     int32_t socketDescriptor;
     WOLFSSL * pSsl;
+    WolfsslResumption_t * pResumption; /**< @brief Resumption state from the credentials, or NULL. */
+    uint8_t handshakePending;          /**< @brief Handshake deferred to carry 0-RTT early data. */
+    uint8_t nonBlocking;               /**< @brief Socket handed over by #Wolfssl_HandshakeStart, which may be non-blocking. */
+    WolfsslKtlsMode_t ktlsMode;        /**< @brief Kernel TLS offload requested in the credentials. */
+    uint8_t ktlsFlags;                 /**< @brief Directions offloaded to kernel TLS after the handshake. */
+    WolfsslMemoryPool_t * pMemoryPool; /**< @brief Static memory pool from the credentials, or NULL. */
 };
 
 /**
@@ -83,7 +201,9 @@ typedef enum WolfsslStatus
     WOLFSSL_HANDSHAKE_FAILED,    /**< Performing TLS handshake with server failed. */
     WOLFSSL_API_ERROR,           /**< A call to a system API resulted in an internal error. */
     WOLFSSL_DNS_FAILURE,         /**< Resolving hostname of the server failed. */
-    WOLFSSL_CONNECT_FAILURE      /**< Initial connection to the server failed. */
+    WOLFSSL_CONNECT_FAILURE,     /**< Initial connection to the server failed. */
+    WOLFSSL_HANDSHAKE_WANT_READ, /**< Non-blocking handshake waits for the socket to be readable. */
+    WOLFSSL_HANDSHAKE_WANT_WRITE /**< Non-blocking handshake waits for the socket to be writable. */
 } WolfsslStatus_t;
 
 /**
@@ -138,6 +258,34 @@ typedef struct WolfsslCredentials
     const char * pRootCaPath;     /**< @brief Filepath string to the trusted server root CA. */
     const char * pClientCertPath; /**< @brief Filepath string to the client certificate. */
     const char * pPrivateKeyPath; /**< @brief Filepath string to the client certificate's private key. */
+
+    /**
+     * @brief Highest and lowest TLS version to negotiate.
+     *
+     * @note The default of #WOLFSSL_POSIX_TLS_AUTO offers TLS 1.3, which saves
+     * one round trip per handshake, and falls back to TLS 1.2 for servers that
+     * do not support it. On Azure Sphere it negotiates TLS 1.2 only, as
+     * before.
+     */
+    WolfsslTlsVersion_t tlsVersion;
+
+    /**
+     * @brief Session resumption state. Set to NULL to disable resumption and
+     * early data.
+     */
+    WolfsslResumption_t * pResumption;
+
+    /**
+     * @brief Record encryption to offload to the kernel once the handshake
+     * completes.
+     */
+    WolfsslKtlsMode_t ktlsMode;
+
+    /**
+     * @brief Static memory pool to allocate the TLS session from. Set to NULL
+     * to allocate from the heap.
+     */
+    WolfsslMemoryPool_t * pMemoryPool;
 } WolfsslCredentials_t;
 
 /**
@@ -161,6 +309,41 @@ WolfsslStatus_t Wolfssl_Connect( NetworkContext_t * pNetworkContext,
                                  uint32_t sendTimeoutMs,
                                  uint32_t recvTimeoutMs );
 
+/**
+ * @brief Prepares a TLS session on an already connected socket without
+ * performing any I/O.
+ *
+ * Used to run the handshake on a non-blocking socket: the handshake is then
+ * driven with #Wolfssl_HandshakeContinue whenever the socket becomes ready.
+ * The early data policy of the resumption state is ignored on this path.
+ *
+ * @param[out] pNetworkContext The network context to set up.
+ * @param[in] socketDescriptor Connected TCP socket, owned by the network
+ * context from now on.
+ * @param[in] pWolfsslCredentials Credentials for the TLS connection.
+ *
+ * @return #WOLFSSL_SUCCEED on success;
+ * #WOLFSSL_INVALID_PARAMETER, #WOLFSSL_INVALID_CREDENTIALS,
+ * #WOLFSSL_API_ERROR on failure.
+ */
+WolfsslStatus_t Wolfssl_HandshakeStart( NetworkContext_t * pNetworkContext,
+                                        int32_t socketDescriptor,
+                                        const WolfsslCredentials_t * pWolfsslCredentials );
+
+/**
+ * @brief Advances a handshake prepared with #Wolfssl_HandshakeStart as far as
+ * the socket allows.
+ *
+ * @param[in] pNetworkContext The network context of the handshake.
+ *
+ * @return #WOLFSSL_SUCCEED once the handshake has completed;
+ * #WOLFSSL_HANDSHAKE_WANT_READ or #WOLFSSL_HANDSHAKE_WANT_WRITE when it has
+ * to be called again after the socket is ready; #WOLFSSL_INVALID_PARAMETER or
+ * #WOLFSSL_HANDSHAKE_FAILED on failure, after which only
+ * #Wolfssl_Disconnect may be called.
+ */
+WolfsslStatus_t Wolfssl_HandshakeContinue( NetworkContext_t * pNetworkContext );
+
 /**
  * @brief Closes a TLS session on top of a TCP connection using the WolfSSL API.
  *
@@ -171,6 +354,35 @@ WolfsslStatus_t Wolfssl_Connect( NetworkContext_t * pNetworkContext,
  */
 WolfsslStatus_t Wolfssl_Disconnect( const NetworkContext_t * pNetworkContext );
 
+/**
+ * @brief Reports the memory use of a static memory pool.
+ *
+ * The per-connection high-water marks are updated after each handshake and
+ * on #Wolfssl_Disconnect.
+ *
+ * @param[in] pMemoryPool Pool previously passed in the credentials.
+ * @param[out] pStats Memory use of the pool.
+ *
+ * @return #WOLFSSL_SUCCEED on success; #WOLFSSL_INVALID_PARAMETER on failure.
+ */
+WolfsslStatus_t Wolfssl_GetMemoryStats( const WolfsslMemoryPool_t * pMemoryPool,
+                                        WolfsslMemoryStats_t * pStats );
+
+/**
+ * @brief Releases the WOLFSSL_CTX held by a static memory pool. All
+ * connections using the pool must have been disconnected.
+ *
+ * @param[in] pMemoryPool Pool previously passed in the credentials.
+ */
+void Wolfssl_FreeMemoryPool( WolfsslMemoryPool_t * pMemoryPool );
+
+/**
+ * @brief Releases the session stored in resumption state.
+ *
+ * @param[in] pResumption Resumption state previously passed to #Wolfssl_Connect.
+ */
+void Wolfssl_FreeResumption( WolfsslResumption_t * pResumption );
+
 /**
  * @brief Receives data over an established TLS session using the WolfSSL API.
  *
@@ -197,10 +409,39 @@ int32_t Wolfssl_Recv( NetworkContext_t * pNetworkContext,
  * @param[in] pBuffer Buffer containing the bytes to send over the network stack.
  * @param[in] bytesToSend Number of bytes to send over the network.
  *
- * @return Number of bytes sent if successful; negative value on error.
+ * @note When the handshake was deferred for 0-RTT, the first call sends
+ * @p pBuffer as early data, completes the handshake and transparently
+ * resends the data if the server rejected it.
+ *
+ * @return Number of bytes sent if successful; 0 if the socket of a
+ * connection set up with #Wolfssl_HandshakeStart is full; negative value on
+ * error, including the send timeout of a connection set up with
+ * #Wolfssl_Connect.
  */
 int32_t Wolfssl_Send( NetworkContext_t * pNetworkContext,
                       const void * pBuffer,
                       size_t bytesToSend );
 
+/**
+ * @brief Sends part of a file over an established TLS session.
+ *
+ * When the transmit direction is offloaded to kernel TLS, the file is sent
+ * with sendfile and never copied to user space. Otherwise a chunk of the file
+ * is read and sent with #Wolfssl_Send.
+ *
+ * @param[in] pNetworkContext The network context created using Wolfssl_Connect API.
+ * @param[in] fileDescriptor Descriptor of the file to send.
+ * @param[in,out] pOffset Offset in the file to send from; advanced by the
+ * number of bytes sent.
+ * @param[in] bytesToSend Number of bytes to send.
+ *
+ * @return Number of bytes sent if successful, which may be less than
+ * @p bytesToSend; 0 on timeout; negative value on error, including the end
+ * of the file before any byte is sent.
+ */
+int32_t Wolfssl_SendFile( NetworkContext_t * pNetworkContext,
+                          int32_t fileDescriptor,
+                          int64_t * pOffset,
+                          size_t bytesToSend );
+
 #endif /* ifndef WOLFSSL_POSIX_H_ */
@@ -0,0 +1,395 @@
+/*
+ * AWS IoT Device SDK for Embedded C V202011.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Standard includes. */
+#include <assert.h>
+#include <string.h>
+
+/* Platform clock include. */
+#include "clock.h"
+
+#include "endpoint_set_posix.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Weight of a new latency sample in the smoothed latency, as a power
+ * of two divisor.
+ */
+#define LATENCY_SMOOTHING_SHIFT    2U
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Halve the failure score of an endpoint once per elapsed half-life.
+ *
+ * @param[in] pEndpointSet Endpoint set of the endpoint.
+ * @param[in] pEndpoint Endpoint to decay.
+ * @param[in] nowMs Current time.
+ */
+static void decayFailureScore( const EndpointSet_t * pEndpointSet,
+                               EndpointHealth_t * pEndpoint,
+                               uint32_t nowMs );
+
+/**
+ * @brief Compute the score of an endpoint; lower is better.
+ *
+ * @param[in] pEndpoint Endpoint to score.
+ * @param[in] unmeasuredLatencyMs Latency to assume if the endpoint has not
+ * been measured.
+ *
+ * @return Smoothed latency plus failure penalty in milliseconds.
+ */
+static uint64_t computeScore( const EndpointHealth_t * pEndpoint,
+                              uint32_t unmeasuredLatencyMs );
+
+/**
+ * @brief Find the endpoint with the lowest score that has not been tried.
+ *
+ * @param[in] pEndpointSet Endpoint set to select from.
+ * @param[in] pTried Per-endpoint flags of endpoints to skip, or NULL.
+ *
+ * @return Index of the best endpoint; @ref EndpointSet_t.endpointCount if
+ * every endpoint was skipped.
+ */
+static size_t selectBest( EndpointSet_t * pEndpointSet,
+                          const uint8_t * pTried );
+
+/*-----------------------------------------------------------*/
+
+static void decayFailureScore( const EndpointSet_t * pEndpointSet,
+                               EndpointHealth_t * pEndpoint,
+                               uint32_t nowMs )
+{
+    /* Unsigned subtraction keeps the elapsed time correct across a wrap
+     * of the millisecond clock. */
+    uint32_t elapsedMs = nowMs - pEndpoint->lastDecayMs;
+    uint32_t halvings = elapsedMs / pEndpointSet->halfLifeMs;
+
+    if( ( pEndpoint->failureScore == 0U ) || ( halvings >= 32U ) )
+    {
+        pEndpoint->failureScore = 0U;
+        pEndpoint->lastDecayMs = nowMs;
+    }
+    else if( halvings > 0U )
+    {
+        pEndpoint->failureScore >>= halvings;
+
+        /* Keep the fraction of the current half-life for the next decay. */
+        pEndpoint->lastDecayMs += halvings * pEndpointSet->halfLifeMs;
+    }
+    else
+    {
+        /* Empty else. */
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t computeScore( const EndpointHealth_t * pEndpoint,
+                              uint32_t unmeasuredLatencyMs )
+{
+    uint64_t penaltyMs = ( ( uint64_t ) pEndpoint->failureScore * ENDPOINT_SET_FAILURE_PENALTY_MS ) /
+                         ENDPOINT_SET_FAILURE_SCALE;
+    uint32_t latencyMs = ( pEndpoint->latencyMs == 0U ) ? unmeasuredLatencyMs : pEndpoint->latencyMs;
+
+    return ( uint64_t ) latencyMs + penaltyMs;
+}
+/*-----------------------------------------------------------*/
+
+static size_t selectBest( EndpointSet_t * pEndpointSet,
+                          const uint8_t * pTried )
+{
+    size_t bestIndex = pEndpointSet->endpointCount;
+    uint64_t bestScore = UINT64_MAX;
+    uint64_t score = 0U;
+    uint32_t nowMs = Clock_GetTimeMs();
+    uint32_t worstLatencyMs = 0U;
+    size_t i = 0U;
+
+    /* An unmeasured endpoint is scored as the slowest measured one, so it
+     * is not preferred to a faster measured endpoint. */
+    for( i = 0U; i < pEndpointSet->endpointCount; i++ )
+    {
+        if( pEndpointSet->endpoints[ i ].latencyMs > worstLatencyMs )
+        {
+            worstLatencyMs = pEndpointSet->endpoints[ i ].latencyMs;
+        }
+    }
+
+    for( i = 0U; i < pEndpointSet->endpointCount; i++ )
+    {
+        decayFailureScore( pEndpointSet, &pEndpointSet->endpoints[ i ], nowMs );
+
+        if( ( pTried == NULL ) || ( pTried[ i ] == 0U ) )
+        {
+            score = computeScore( &pEndpointSet->endpoints[ i ], worstLatencyMs );
+
+            /* Strictly lower, so that earlier endpoints win ties. */
+            if( score < bestScore )
+            {
+                bestScore = score;
+                bestIndex = i;
+            }
+        }
+    }
+
+    return bestIndex;
+}
+/*-----------------------------------------------------------*/
+
+EndpointSetStatus_t EndpointSet_Init( EndpointSet_t * pEndpointSet,
+                                      uint32_t halfLifeMs )
+{
+    EndpointSetStatus_t returnStatus = ENDPOINT_SET_SUCCESS;
+
+    if( pEndpointSet == NULL )
+    {
+        LogError( ( "Parameter check failed: pEndpointSet is NULL." ) );
+        returnStatus = ENDPOINT_SET_INVALID_PARAMETER;
+    }
+    else
+    {
+        ( void ) memset( pEndpointSet, 0, sizeof( EndpointSet_t ) );
+        pEndpointSet->halfLifeMs = ( halfLifeMs == 0U ) ? ENDPOINT_SET_DEFAULT_HALF_LIFE_MS : halfLifeMs;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+EndpointSetStatus_t EndpointSet_Add( EndpointSet_t * pEndpointSet,
+                                     const ServerInfo_t * pServerInfo )
+{
+    EndpointSetStatus_t returnStatus = ENDPOINT_SET_SUCCESS;
+    EndpointHealth_t * pEndpoint = NULL;
+
+    if( ( pEndpointSet == NULL ) || ( pServerInfo == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pEndpointSet=%p, pServerInfo=%p.",
+                    ( void * ) pEndpointSet,
+                    ( const void * ) pServerInfo ) );
+        returnStatus = ENDPOINT_SET_INVALID_PARAMETER;
+    }
+    else if( pServerInfo->pHostName == NULL )
+    {
+        LogError( ( "Parameter check failed: pServerInfo->pHostName is NULL." ) );
+        returnStatus = ENDPOINT_SET_INVALID_PARAMETER;
+    }
+    else if( pEndpointSet->endpointCount >= ENDPOINT_SET_MAX_ENDPOINTS )
+    {
+        LogError( ( "Endpoint set is full: ENDPOINT_SET_MAX_ENDPOINTS=%u.",
+                    ( unsigned int ) ENDPOINT_SET_MAX_ENDPOINTS ) );
+        returnStatus = ENDPOINT_SET_FULL;
+    }
+    else
+    {
+        pEndpoint = &pEndpointSet->endpoints[ pEndpointSet->endpointCount ];
+        ( void ) memset( pEndpoint, 0, sizeof( EndpointHealth_t ) );
+        pEndpoint->serverInfo = *pServerInfo;
+        pEndpoint->lastDecayMs = Clock_GetTimeMs();
+        pEndpointSet->endpointCount++;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+EndpointSetStatus_t EndpointSet_Select( EndpointSet_t * pEndpointSet,
+                                        size_t * pIndex )
+{
+    EndpointSetStatus_t returnStatus = ENDPOINT_SET_SUCCESS;
+
+    if( ( pEndpointSet == NULL ) || ( pIndex == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pEndpointSet=%p, pIndex=%p.",
+                    ( void * ) pEndpointSet,
+                    ( void * ) pIndex ) );
+        returnStatus = ENDPOINT_SET_INVALID_PARAMETER;
+    }
+    else if( pEndpointSet->endpointCount == 0U )
+    {
+        LogError( ( "Endpoint set is empty." ) );
+        returnStatus = ENDPOINT_SET_INVALID_PARAMETER;
+    }
+    else
+    {
+        *pIndex = selectBest( pEndpointSet, NULL );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+EndpointSetStatus_t EndpointSet_ReportSuccess( EndpointSet_t * pEndpointSet,
+                                               size_t index,
+                                               uint32_t latencyMs )
+{
+    EndpointSetStatus_t returnStatus = ENDPOINT_SET_SUCCESS;
+    EndpointHealth_t * pEndpoint = NULL;
+    uint32_t sampleMs = latencyMs;
+    int64_t delta = 0;
+
+    if( ( pEndpointSet == NULL ) || ( index >= pEndpointSet->endpointCount ) )
+    {
+        LogError( ( "Parameter check failed: pEndpointSet=%p, index=%lu.",
+                    ( void * ) pEndpointSet,
+                    ( unsigned long ) index ) );
+        returnStatus = ENDPOINT_SET_INVALID_PARAMETER;
+    }
+    else
+    {
+        pEndpoint = &pEndpointSet->endpoints[ index ];
+        decayFailureScore( pEndpointSet, pEndpoint, Clock_GetTimeMs() );
+
+        /* A latency of 0 marks an unmeasured endpoint. */
+        if( sampleMs == 0U )
+        {
+            sampleMs = 1U;
+        }
+
+        if( pEndpoint->latencyMs == 0U )
+        {
+            pEndpoint->latencyMs = sampleMs;
+        }
+        else
+        {
+            /* Exponentially weighted moving average of the latency. */
+            delta = ( int64_t ) sampleMs - ( int64_t ) pEndpoint->latencyMs;
+            pEndpoint->latencyMs = ( uint32_t ) ( ( int64_t ) pEndpoint->latencyMs +
+                                                  ( delta / ( int64_t ) ( 1U << LATENCY_SMOOTHING_SHIFT ) ) );
+        }
+
+        pEndpoint->consecutiveFailures = 0U;
+        pEndpoint->successCount++;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+EndpointSetStatus_t EndpointSet_ReportFailure( EndpointSet_t * pEndpointSet,
+                                               size_t index )
+{
+    EndpointSetStatus_t returnStatus = ENDPOINT_SET_SUCCESS;
+    EndpointHealth_t * pEndpoint = NULL;
+
+    if( ( pEndpointSet == NULL ) || ( index >= pEndpointSet->endpointCount ) )
+    {
+        LogError( ( "Parameter check failed: pEndpointSet=%p, index=%lu.",
+                    ( void * ) pEndpointSet,
+                    ( unsigned long ) index ) );
+        returnStatus = ENDPOINT_SET_INVALID_PARAMETER;
+    }
+    else
+    {
+        pEndpoint = &pEndpointSet->endpoints[ index ];
+        decayFailureScore( pEndpointSet, pEndpoint, Clock_GetTimeMs() );
+
+        /* Saturate instead of wrapping to a healthy score. */
+        if( pEndpoint->failureScore <= ( UINT32_MAX - ENDPOINT_SET_FAILURE_SCALE ) )
+        {
+            pEndpoint->failureScore += ENDPOINT_SET_FAILURE_SCALE;
+        }
+
+        pEndpoint->consecutiveFailures++;
+        pEndpoint->failureCount++;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+EndpointSetStatus_t EndpointSet_Connect( EndpointSet_t * pEndpointSet,
+                                         EndpointSetConnectFunc_t connectFunction,
+                                         void * pConnectContext,
+                                         size_t * pIndex )
+{
+    EndpointSetStatus_t returnStatus = ENDPOINT_SET_ALL_FAILED;
+    uint8_t tried[ ENDPOINT_SET_MAX_ENDPOINTS ] = { 0 };
+    const ServerInfo_t * pServerInfo = NULL;
+    uint32_t startTimeMs = 0U;
+    uint32_t latencyMs = 0U;
+    size_t index = 0U;
+    size_t attempt = 0U;
+
+    if( ( pEndpointSet == NULL ) || ( connectFunction == NULL ) || ( pIndex == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pEndpointSet=%p, connectFunction=%s, pIndex=%p.",
+                    ( void * ) pEndpointSet,
+                    ( connectFunction == NULL ) ? "NULL" : "set",
+                    ( void * ) pIndex ) );
+        returnStatus = ENDPOINT_SET_INVALID_PARAMETER;
+    }
+    else if( pEndpointSet->endpointCount == 0U )
+    {
+        LogError( ( "Endpoint set is empty." ) );
+        returnStatus = ENDPOINT_SET_INVALID_PARAMETER;
+    }
+    else
+    {
+        for( attempt = 0U;
+             ( attempt < pEndpointSet->endpointCount ) && ( returnStatus != ENDPOINT_SET_SUCCESS );
+             attempt++ )
+        {
+            index = selectBest( pEndpointSet, tried );
+            assert( index < pEndpointSet->endpointCount );
+            tried[ index ] = 1U;
+            pServerInfo = &pEndpointSet->endpoints[ index ].serverInfo;
+
+            LogInfo( ( "Connecting to endpoint %.*s:%u.",
+                       ( int ) pServerInfo->hostNameLength,
+                       pServerInfo->pHostName,
+                       pServerInfo->port ) );
+
+            startTimeMs = Clock_GetTimeMs();
+
+            if( connectFunction( pConnectContext, pServerInfo ) == 0 )
+            {
+                latencyMs = Clock_GetTimeMs() - startTimeMs;
+                ( void ) EndpointSet_ReportSuccess( pEndpointSet, index, latencyMs );
+                LogInfo( ( "Connected to endpoint %.*s:%u in %u ms.",
+                           ( int ) pServerInfo->hostNameLength,
+                           pServerInfo->pHostName,
+                           pServerInfo->port,
+                           ( unsigned int ) latencyMs ) );
+                *pIndex = index;
+                returnStatus = ENDPOINT_SET_SUCCESS;
+            }
+            else
+            {
+                ( void ) EndpointSet_ReportFailure( pEndpointSet, index );
+                LogWarn( ( "Connection to endpoint %.*s:%u failed, failing over.",
+                           ( int ) pServerInfo->hostNameLength,
+                           pServerInfo->pHostName,
+                           pServerInfo->port ) );
+            }
+        }
+    }
+
+    if( returnStatus == ENDPOINT_SET_ALL_FAILED )
+    {
+        LogError( ( "Connection to every endpoint failed." ) );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
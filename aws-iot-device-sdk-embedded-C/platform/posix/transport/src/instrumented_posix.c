@@ -0,0 +1,341 @@
+/*
+ * AWS IoT Device SDK for Embedded C V202011.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Standard includes. */
+#include <assert.h>
+#include <string.h>
+
+/* POSIX includes. */
+#include <time.h>
+
+#include "instrumented_posix.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Number of microseconds in one second.
+ */
+#define ONE_SEC_TO_US    ( 1000000 )
+
+/**
+ * @brief Number of nanoseconds in one microsecond.
+ */
+#define ONE_US_TO_NS     ( 1000 )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get a monotonic timestamp in microseconds.
+ *
+ * @return The timestamp.
+ */
+static uint64_t getTimeUs( void );
+
+/**
+ * @brief Add a sample to a histogram.
+ *
+ * @param[in,out] pHistogram The histogram.
+ * @param[in] value The sample.
+ */
+static void recordSample( InstrumentedHistogram_t * pHistogram,
+                          uint64_t value );
+
+/**
+ * @brief Account one transport call.
+ *
+ * @param[in,out] pStats Statistics of the direction of the call.
+ * @param[in] requested Number of bytes requested.
+ * @param[in] result Value returned by the inner transport.
+ * @param[in] latencyUs Duration of the call.
+ */
+static void recordCall( InstrumentedDirectionStats_t * pStats,
+                        size_t requested,
+                        int32_t result,
+                        uint64_t latencyUs );
+
+/*-----------------------------------------------------------*/
+
+static uint64_t getTimeUs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * ONE_SEC_TO_US ) +
+           ( ( uint64_t ) now.tv_nsec / ONE_US_TO_NS );
+}
+/*-----------------------------------------------------------*/
+
+static void recordSample( InstrumentedHistogram_t * pHistogram,
+                          uint64_t value )
+{
+    uint32_t bucket = 0;
+    uint64_t remaining = value;
+
+    assert( pHistogram != NULL );
+
+    /* The bucket is the bit length of the value. */
+    while( ( remaining != 0U ) && ( bucket < ( INSTRUMENTED_HISTOGRAM_BUCKETS - 1U ) ) )
+    {
+        remaining >>= 1U;
+        bucket++;
+    }
+
+    pHistogram->buckets[ bucket ]++;
+    pHistogram->count++;
+    pHistogram->sum += value;
+
+    if( value > pHistogram->max )
+    {
+        pHistogram->max = value;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void recordCall( InstrumentedDirectionStats_t * pStats,
+                        size_t requested,
+                        int32_t result,
+                        uint64_t latencyUs )
+{
+    uint32_t i = 0;
+
+    assert( pStats != NULL );
+
+    pStats->calls++;
+    recordSample( &pStats->latencyUs, latencyUs );
+
+    if( result < 0 )
+    {
+        pStats->errorCount++;
+
+        for( i = 0U; i < INSTRUMENTED_MAX_ERROR_CODES; i++ )
+        {
+            /* A zero count marks a free entry. */
+            if( ( pStats->errorCodes[ i ].count == 0U ) ||
+                ( pStats->errorCodes[ i ].code == result ) )
+            {
+                pStats->errorCodes[ i ].code = result;
+                pStats->errorCodes[ i ].count++;
+                break;
+            }
+        }
+    }
+    else
+    {
+        recordSample( &pStats->bytes, ( uint64_t ) result );
+        pStats->totalBytes += ( uint64_t ) result;
+
+        if( result == 0 )
+        {
+            pStats->zeroCount++;
+        }
+        else if( ( size_t ) result < requested )
+        {
+            pStats->partialCount++;
+        }
+        else
+        {
+            /* Empty else. */
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+InstrumentedStatus_t Instrumented_Init( InstrumentedTransport_t * pInstrumented,
+                                        const TransportInterface_t * pInner,
+                                        TransportInterface_t * pOuter )
+{
+    InstrumentedStatus_t returnStatus = INSTRUMENTED_SUCCESS;
+
+    if( ( pInstrumented == NULL ) || ( pInner == NULL ) || ( pOuter == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pInstrumented, pInner and pOuter must not be NULL." ) );
+        returnStatus = INSTRUMENTED_INVALID_PARAMETER;
+    }
+    else if( ( pInner->send == NULL ) || ( pInner->recv == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pInner must provide send and recv." ) );
+        returnStatus = INSTRUMENTED_INVALID_PARAMETER;
+    }
+    else
+    {
+        ( void ) memset( &pInstrumented->stats, 0, sizeof( InstrumentedStats_t ) );
+        pInstrumented->inner = *pInner;
+
+        if( pthread_mutex_init( &pInstrumented->lock, NULL ) != 0 )
+        {
+            LogError( ( "Failed to create the statistics lock." ) );
+            returnStatus = INSTRUMENTED_API_ERROR;
+        }
+    }
+
+    if( returnStatus == INSTRUMENTED_SUCCESS )
+    {
+        /* The decorator state is the network context of the outer interface.
+         * It is only ever converted back to its own type below. */
+        pOuter->pNetworkContext = ( NetworkContext_t * ) pInstrumented;
+        pOuter->send = Instrumented_Send;
+        pOuter->recv = Instrumented_Recv;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+void Instrumented_Deinit( InstrumentedTransport_t * pInstrumented )
+{
+    if( pInstrumented != NULL )
+    {
+        ( void ) pthread_mutex_destroy( &pInstrumented->lock );
+    }
+}
+/*-----------------------------------------------------------*/
+
+InstrumentedStatus_t Instrumented_Snapshot( InstrumentedTransport_t * pInstrumented,
+                                            InstrumentedStats_t * pSnapshot,
+                                            uint8_t reset )
+{
+    InstrumentedStatus_t returnStatus = INSTRUMENTED_SUCCESS;
+
+    if( ( pInstrumented == NULL ) || ( pSnapshot == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pInstrumented and pSnapshot must not be NULL." ) );
+        returnStatus = INSTRUMENTED_INVALID_PARAMETER;
+    }
+    else
+    {
+        ( void ) pthread_mutex_lock( &pInstrumented->lock );
+
+        *pSnapshot = pInstrumented->stats;
+
+        if( reset != 0U )
+        {
+            ( void ) memset( &pInstrumented->stats, 0, sizeof( InstrumentedStats_t ) );
+        }
+
+        ( void ) pthread_mutex_unlock( &pInstrumented->lock );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t Instrumented_Percentile( const InstrumentedHistogram_t * pHistogram,
+                                  uint32_t percentile )
+{
+    uint64_t value = 0;
+    uint64_t rank = 0;
+    uint64_t seen = 0;
+    uint32_t bucket = 0;
+
+    if( ( pHistogram != NULL ) && ( pHistogram->count > 0U ) )
+    {
+        /* Rank of the sample at the percentile, rounded up. */
+        rank = ( ( pHistogram->count * ( ( percentile > 100U ) ? 100U : percentile ) ) + 99U ) / 100U;
+
+        if( rank == 0U )
+        {
+            rank = 1U;
+        }
+
+        for( bucket = 0U; bucket < INSTRUMENTED_HISTOGRAM_BUCKETS; bucket++ )
+        {
+            seen += pHistogram->buckets[ bucket ];
+
+            if( seen >= rank )
+            {
+                break;
+            }
+        }
+
+        /* Upper bound of the bucket: 0 for bucket 0, 2^i - 1 otherwise. */
+        value = ( bucket == 0U ) ? 0U : ( ( ( uint64_t ) 1U << bucket ) - 1U );
+
+        if( ( value > pHistogram->max ) || ( bucket >= ( INSTRUMENTED_HISTOGRAM_BUCKETS - 1U ) ) )
+        {
+            value = pHistogram->max;
+        }
+    }
+
+    return value;
+}
+/*-----------------------------------------------------------*/
+
+int32_t Instrumented_Recv( NetworkContext_t * pNetworkContext,
+                           void * pBuffer,
+                           size_t bytesToRecv )
+{
+    int32_t bytesReceived = -1;
+    uint64_t startUs = 0;
+    uint64_t latencyUs = 0;
+    InstrumentedTransport_t * pInstrumented = ( InstrumentedTransport_t * ) pNetworkContext;
+
+    if( pInstrumented == NULL )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+    }
+    else
+    {
+        startUs = getTimeUs();
+        bytesReceived = pInstrumented->inner.recv( pInstrumented->inner.pNetworkContext,
+                                                   pBuffer,
+                                                   bytesToRecv );
+        latencyUs = getTimeUs() - startUs;
+
+        ( void ) pthread_mutex_lock( &pInstrumented->lock );
+        recordCall( &pInstrumented->stats.recv, bytesToRecv, bytesReceived, latencyUs );
+        ( void ) pthread_mutex_unlock( &pInstrumented->lock );
+    }
+
+    return bytesReceived;
+}
+/*-----------------------------------------------------------*/
+
+int32_t Instrumented_Send( NetworkContext_t * pNetworkContext,
+                           const void * pBuffer,
+                           size_t bytesToSend )
+{
+    int32_t bytesSent = -1;
+    uint64_t startUs = 0;
+    uint64_t latencyUs = 0;
+    InstrumentedTransport_t * pInstrumented = ( InstrumentedTransport_t * ) pNetworkContext;
+
+    if( pInstrumented == NULL )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+    }
+    else
+    {
+        startUs = getTimeUs();
+        bytesSent = pInstrumented->inner.send( pInstrumented->inner.pNetworkContext,
+                                               pBuffer,
+                                               bytesToSend );
+        latencyUs = getTimeUs() - startUs;
+
+        ( void ) pthread_mutex_lock( &pInstrumented->lock );
+        recordCall( &pInstrumented->stats.send, bytesToSend, bytesSent, latencyUs );
+        ( void ) pthread_mutex_unlock( &pInstrumented->lock );
+    }
+
+    return bytesSent;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,718 @@
+/*
+ * AWS IoT Device SDK for Embedded C V202011.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Standard includes. */
+#include <assert.h>
+#include <string.h>
+
+/* POSIX includes. */
+#include <time.h>
+
+#include "netem_posix.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Number of microseconds in one second.
+ */
+#define ONE_SEC_TO_US         ( 1000000U )
+
+/**
+ * @brief Number of microseconds in one millisecond.
+ */
+#define ONE_MS_TO_US          ( 1000U )
+
+/**
+ * @brief Number of nanoseconds in one microsecond.
+ */
+#define ONE_US_TO_NS          ( 1000U )
+
+/**
+ * @brief Denominator of #NetemConfig_t.stallPpm.
+ */
+#define ONE_MILLION           ( 1000000U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get a monotonic timestamp in microseconds.
+ *
+ * @return The timestamp.
+ */
+static uint64_t getTimeUs( void );
+
+/**
+ * @brief Block the calling thread.
+ *
+ * @param[in] durationUs Time to sleep in microseconds.
+ */
+static void sleepUs( uint64_t durationUs );
+
+/**
+ * @brief Draw the next value of the decorator's random number generator.
+ *
+ * @param[in,out] pNetem The decorator state.
+ *
+ * @return A uniformly distributed 32-bit value.
+ */
+static uint32_t nextRandom( NetemTransport_t * pNetem );
+
+/**
+ * @brief Decide whether the current call stalls, and if so, stall.
+ *
+ * @param[in,out] pNetem The decorator state.
+ *
+ * @return 1 if the call stalled; 0 otherwise.
+ */
+static uint8_t applyStall( NetemTransport_t * pNetem );
+
+/**
+ * @brief Draw the time a transfer spends in transit: the configured latency
+ * plus jitter.
+ *
+ * @param[in,out] pNetem The decorator state.
+ *
+ * @return The delay in microseconds.
+ */
+static uint64_t drawLatency( NetemTransport_t * pNetem );
+
+/**
+ * @brief Cut a transfer to a random size not above the configured chunk.
+ *
+ * @param[in,out] pNetem The decorator state.
+ * @param[in] requested Number of bytes requested by the caller.
+ * @param[in] maxChunk Configured maximum chunk. 0 disables fragmentation.
+ *
+ * @return Number of bytes to pass to the inner transport.
+ */
+static size_t applyFragmentation( NetemTransport_t * pNetem,
+                                  size_t requested,
+                                  size_t maxChunk );
+
+/**
+ * @brief Find the free space at the end of a link's ring.
+ *
+ * @param[in,out] pLink The direction of the link.
+ * @param[out] ppTail Where the next bytes go.
+ *
+ * @return The number of contiguous bytes free at @p ppTail; 0 if the ring
+ * is full.
+ */
+static size_t linkSpace( NetemLink_t * pLink,
+                         uint8_t ** ppTail );
+
+/**
+ * @brief Put the bytes just written at the end of a link's ring in transit.
+ *
+ * The transfer leaves the link once it is serialized at the configured
+ * bandwidth and has spent the latency plus jitter in transit, but never
+ * before an earlier transfer. If #NETEM_LINK_MAX_SEGMENTS transfers are in
+ * transit, the bytes join the newest one, which then leaves with them.
+ *
+ * @param[in,out] pNetem The decorator state.
+ * @param[in,out] pLink The direction of the link.
+ * @param[in] length Number of bytes written.
+ */
+static void enterLink( NetemTransport_t * pNetem,
+                       NetemLink_t * pLink,
+                       size_t length );
+
+/**
+ * @brief Count the bytes that have completed their transit.
+ *
+ * @param[in] pLink The direction of the link.
+ * @param[in] nowUs The current time.
+ *
+ * @return The number of bytes, from the oldest, whose transit is complete.
+ */
+static size_t dueBytes( const NetemLink_t * pLink,
+                        uint64_t nowUs );
+
+/**
+ * @brief Take bytes off the start of a link.
+ *
+ * @param[in,out] pLink The direction of the link.
+ * @param[in] length Number of bytes to take. Must not exceed the bytes in
+ * transit.
+ */
+static void leaveLink( NetemLink_t * pLink,
+                       size_t length );
+
+/**
+ * @brief Sleep until the oldest transfer on a link completes its transit.
+ *
+ * @param[in] pLink The direction of the link. Must have bytes in transit.
+ */
+static void waitForLink( const NetemLink_t * pLink );
+
+/**
+ * @brief Pass sent bytes that completed their transit to the wrapped
+ * transport.
+ *
+ * @param[in,out] pNetem The decorator state.
+ * @param[in] wait 1 to wait for every byte in transit; 0 to stop at the
+ * first byte not yet due.
+ *
+ * @return 0 if the wrapped transport took the bytes or none was due; the
+ * negative value returned by the wrapped transport on failure; 0 also if
+ * it took nothing, leaving the bytes on the link.
+ */
+static int32_t forwardSent( NetemTransport_t * pNetem,
+                            uint8_t wait );
+
+/*-----------------------------------------------------------*/
+
+static uint64_t getTimeUs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * ONE_SEC_TO_US ) +
+           ( ( uint64_t ) now.tv_nsec / ONE_US_TO_NS );
+}
+/*-----------------------------------------------------------*/
+
+static void sleepUs( uint64_t durationUs )
+{
+    struct timespec sleepTime;
+
+    if( durationUs > 0U )
+    {
+        sleepTime.tv_sec = ( time_t ) ( durationUs / ONE_SEC_TO_US );
+        sleepTime.tv_nsec = ( long ) ( ( durationUs % ONE_SEC_TO_US ) * ONE_US_TO_NS );
+
+        ( void ) nanosleep( &sleepTime, NULL );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t nextRandom( NetemTransport_t * pNetem )
+{
+    uint64_t mixed = 0;
+
+    assert( pNetem != NULL );
+
+    /* SplitMix64: a tiny generator with good statistical quality that keeps
+     * all of its state in the decorator, so runs are reproducible. */
+    pNetem->rngState += 0x9E3779B97F4A7C15ULL;
+    mixed = pNetem->rngState;
+    mixed = ( mixed ^ ( mixed >> 30U ) ) * 0xBF58476D1CE4E5B9ULL;
+    mixed = ( mixed ^ ( mixed >> 27U ) ) * 0x94D049BB133111EBULL;
+    mixed = mixed ^ ( mixed >> 31U );
+
+    return ( uint32_t ) ( mixed >> 32U );
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t applyStall( NetemTransport_t * pNetem )
+{
+    uint8_t stalled = 0U;
+
+    assert( pNetem != NULL );
+
+    if( ( pNetem->config.stallPpm > 0U ) &&
+        ( ( nextRandom( pNetem ) % ONE_MILLION ) < pNetem->config.stallPpm ) )
+    {
+        sleepUs( ( uint64_t ) pNetem->config.stallMs * ONE_MS_TO_US );
+        pNetem->stats.delayedUs += ( uint64_t ) pNetem->config.stallMs * ONE_MS_TO_US;
+        pNetem->stats.stalls++;
+        stalled = 1U;
+    }
+
+    return stalled;
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t drawLatency( NetemTransport_t * pNetem )
+{
+    int64_t delayUs = 0;
+    uint32_t jitterSpanUs = 0;
+
+    assert( pNetem != NULL );
+
+    delayUs = ( int64_t ) pNetem->config.latencyMs * ONE_MS_TO_US;
+
+    if( pNetem->config.jitterMs > 0U )
+    {
+        /* Uniform in [-jitter, +jitter]. */
+        jitterSpanUs = ( 2U * pNetem->config.jitterMs * ONE_MS_TO_US ) + 1U;
+        delayUs += ( int64_t ) ( nextRandom( pNetem ) % jitterSpanUs ) -
+                   ( ( int64_t ) pNetem->config.jitterMs * ONE_MS_TO_US );
+    }
+
+    return ( delayUs > 0 ) ? ( uint64_t ) delayUs : 0U;
+}
+/*-----------------------------------------------------------*/
+
+static size_t applyFragmentation( NetemTransport_t * pNetem,
+                                  size_t requested,
+                                  size_t maxChunk )
+{
+    size_t chunk = requested;
+
+    assert( pNetem != NULL );
+
+    if( ( maxChunk > 0U ) && ( requested > 1U ) )
+    {
+        if( chunk > maxChunk )
+        {
+            chunk = maxChunk;
+        }
+
+        chunk = 1U + ( ( size_t ) nextRandom( pNetem ) % chunk );
+    }
+
+    return chunk;
+}
+/*-----------------------------------------------------------*/
+
+static size_t linkSpace( NetemLink_t * pLink,
+                         uint8_t ** ppTail )
+{
+    size_t tail = 0;
+    size_t space = 0;
+
+    assert( pLink != NULL );
+    assert( ppTail != NULL );
+
+    tail = ( pLink->head + pLink->count ) % NETEM_LINK_BUFFER_SIZE;
+    space = NETEM_LINK_BUFFER_SIZE - pLink->count;
+
+    if( space > ( NETEM_LINK_BUFFER_SIZE - tail ) )
+    {
+        space = NETEM_LINK_BUFFER_SIZE - tail;
+    }
+
+    *ppTail = &pLink->buffer[ tail ];
+
+    return space;
+}
+/*-----------------------------------------------------------*/
+
+static void enterLink( NetemTransport_t * pNetem,
+                       NetemLink_t * pLink,
+                       size_t length )
+{
+    uint64_t nowUs = 0;
+    uint64_t departUs = 0;
+    uint64_t releaseUs = 0;
+    NetemSegment_t * pSegment = NULL;
+
+    assert( pNetem != NULL );
+    assert( pLink != NULL );
+
+    nowUs = getTimeUs();
+    departUs = nowUs;
+
+    if( pNetem->config.bandwidthBytesPerSec > 0U )
+    {
+        /* An idle link does not bank capacity. */
+        if( pLink->nextFreeUs > nowUs )
+        {
+            departUs = pLink->nextFreeUs;
+        }
+
+        departUs += ( ( uint64_t ) length * ONE_SEC_TO_US ) / pNetem->config.bandwidthBytesPerSec;
+        pLink->nextFreeUs = departUs;
+    }
+
+    /* Jitter delays a transfer, but does not reorder the byte stream. */
+    releaseUs = departUs + drawLatency( pNetem );
+
+    if( releaseUs < pLink->lastReleaseUs )
+    {
+        releaseUs = pLink->lastReleaseUs;
+    }
+
+    pLink->lastReleaseUs = releaseUs;
+
+    if( pLink->segmentCount < NETEM_LINK_MAX_SEGMENTS )
+    {
+        pSegment = &pLink->segments[ ( pLink->segmentHead + pLink->segmentCount ) % NETEM_LINK_MAX_SEGMENTS ];
+        pSegment->length = 0U;
+        pLink->segmentCount++;
+    }
+    else
+    {
+        pSegment = &pLink->segments[ ( pLink->segmentHead + pLink->segmentCount - 1U ) % NETEM_LINK_MAX_SEGMENTS ];
+    }
+
+    pSegment->releaseUs = releaseUs;
+    pSegment->length += length;
+    pLink->count += length;
+
+    pNetem->stats.delayedUs += releaseUs - nowUs;
+}
+/*-----------------------------------------------------------*/
+
+static size_t dueBytes( const NetemLink_t * pLink,
+                        uint64_t nowUs )
+{
+    size_t due = 0;
+    size_t i = 0;
+    const NetemSegment_t * pSegment = NULL;
+
+    assert( pLink != NULL );
+
+    for( i = 0U; i < pLink->segmentCount; i++ )
+    {
+        pSegment = &pLink->segments[ ( pLink->segmentHead + i ) % NETEM_LINK_MAX_SEGMENTS ];
+
+        /* Release times never decrease, so the first transfer still in
+         * transit ends the due bytes. */
+        if( pSegment->releaseUs > nowUs )
+        {
+            break;
+        }
+
+        due += pSegment->length;
+    }
+
+    return due;
+}
+/*-----------------------------------------------------------*/
+
+static void leaveLink( NetemLink_t * pLink,
+                       size_t length )
+{
+    size_t remaining = length;
+    NetemSegment_t * pSegment = NULL;
+
+    assert( pLink != NULL );
+    assert( length <= pLink->count );
+
+    pLink->head = ( pLink->head + length ) % NETEM_LINK_BUFFER_SIZE;
+    pLink->count -= length;
+
+    while( remaining > 0U )
+    {
+        pSegment = &pLink->segments[ pLink->segmentHead ];
+
+        if( pSegment->length <= remaining )
+        {
+            remaining -= pSegment->length;
+            pLink->segmentHead = ( pLink->segmentHead + 1U ) % NETEM_LINK_MAX_SEGMENTS;
+            pLink->segmentCount--;
+        }
+        else
+        {
+            pSegment->length -= remaining;
+            remaining = 0U;
+        }
+    }
+
+    /* Start over at the beginning of an empty ring, so that the next
+     * transfer has the whole ring in one piece. */
+    if( pLink->count == 0U )
+    {
+        pLink->head = 0U;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void waitForLink( const NetemLink_t * pLink )
+{
+    uint64_t nowUs = getTimeUs();
+    uint64_t releaseUs = 0;
+
+    assert( pLink != NULL );
+    assert( pLink->segmentCount > 0U );
+
+    releaseUs = pLink->segments[ pLink->segmentHead ].releaseUs;
+
+    if( releaseUs > nowUs )
+    {
+        sleepUs( releaseUs - nowUs );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static int32_t forwardSent( NetemTransport_t * pNetem,
+                            uint8_t wait )
+{
+    int32_t returnStatus = 0;
+    int32_t bytesSent = 0;
+    size_t due = 0;
+    NetemLink_t * pLink = NULL;
+
+    assert( pNetem != NULL );
+
+    pLink = &pNetem->sendLink;
+
+    while( pLink->count > 0U )
+    {
+        due = dueBytes( pLink, getTimeUs() );
+
+        if( due == 0U )
+        {
+            if( wait == 0U )
+            {
+                break;
+            }
+
+            waitForLink( pLink );
+        }
+        else
+        {
+            /* Pass the due bytes up to the end of the ring. */
+            if( due > ( NETEM_LINK_BUFFER_SIZE - pLink->head ) )
+            {
+                due = NETEM_LINK_BUFFER_SIZE - pLink->head;
+            }
+
+            bytesSent = pNetem->inner.send( pNetem->inner.pNetworkContext,
+                                            &pLink->buffer[ pLink->head ],
+                                            due );
+
+            if( bytesSent > 0 )
+            {
+                leaveLink( pLink, ( size_t ) bytesSent );
+            }
+            else
+            {
+                /* A failure, or a wrapped transport that takes no more for
+                 * now; the bytes stay on the link. */
+                returnStatus = ( bytesSent < 0 ) ? bytesSent : 0;
+                break;
+            }
+        }
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+NetemStatus_t Netem_Init( NetemTransport_t * pNetem,
+                          const TransportInterface_t * pInner,
+                          const NetemConfig_t * pConfig,
+                          TransportInterface_t * pOuter )
+{
+    NetemStatus_t returnStatus = NETEM_SUCCESS;
+
+    if( ( pNetem == NULL ) || ( pInner == NULL ) || ( pConfig == NULL ) || ( pOuter == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pNetem, pInner, pConfig and pOuter must not be NULL." ) );
+        returnStatus = NETEM_INVALID_PARAMETER;
+    }
+    else if( ( pInner->send == NULL ) || ( pInner->recv == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pInner must provide send and recv." ) );
+        returnStatus = NETEM_INVALID_PARAMETER;
+    }
+    else if( pConfig->stallPpm > ONE_MILLION )
+    {
+        LogError( ( "Parameter check failed: stallPpm must not exceed one million." ) );
+        returnStatus = NETEM_INVALID_PARAMETER;
+    }
+    else
+    {
+        ( void ) memset( pNetem, 0, sizeof( NetemTransport_t ) );
+        pNetem->inner = *pInner;
+        pNetem->config = *pConfig;
+        pNetem->rngState = pConfig->seed;
+
+        /* The decorator state is the network context of the outer interface.
+         * It is only ever converted back to its own type below. */
+        pOuter->pNetworkContext = ( NetworkContext_t * ) pNetem;
+        pOuter->send = Netem_Send;
+        pOuter->recv = Netem_Recv;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+int32_t Netem_Recv( NetworkContext_t * pNetworkContext,
+                    void * pBuffer,
+                    size_t bytesToRecv )
+{
+    int32_t bytesReceived = -1;
+    int32_t innerStatus = 0;
+    size_t space = 0;
+    size_t due = 0;
+    size_t available = 0;
+    size_t chunk = 0;
+    size_t first = 0;
+    uint8_t * pTail = NULL;
+    NetemLink_t * pLink = NULL;
+    NetemTransport_t * pNetem = ( NetemTransport_t * ) pNetworkContext;
+
+    if( pNetem == NULL )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+    }
+    else if( applyStall( pNetem ) == 1U )
+    {
+        bytesReceived = 0;
+    }
+    else
+    {
+        pLink = &pNetem->recvLink;
+
+        /* Sent bytes that are due reach the peer before anything else. */
+        innerStatus = forwardSent( pNetem, 0U );
+
+        if( innerStatus == 0 )
+        {
+            /* Stamp received bytes as soon as they arrive. */
+            space = linkSpace( pLink, &pTail );
+
+            if( space > 0U )
+            {
+                innerStatus = pNetem->inner.recv( pNetem->inner.pNetworkContext, pTail, space );
+
+                if( innerStatus > 0 )
+                {
+                    enterLink( pNetem, pLink, ( size_t ) innerStatus );
+                    innerStatus = 0;
+                }
+            }
+            else if( dueBytes( pLink, getTimeUs() ) == 0U )
+            {
+                /* The link is full of bytes in transit; the caller cannot
+                 * get anything before the oldest arrives. */
+                waitForLink( pLink );
+            }
+            else
+            {
+                /* Empty else. */
+            }
+        }
+
+        due = dueBytes( pLink, getTimeUs() );
+
+        if( due > 0U )
+        {
+            /* Bytes that completed their transit are delivered even if the
+             * wrapped transport just failed; the failure recurs on the next
+             * call. */
+            available = ( due < bytesToRecv ) ? due : bytesToRecv;
+            chunk = applyFragmentation( pNetem, available, pNetem->config.maxRecvChunk );
+
+            if( chunk < available )
+            {
+                pNetem->stats.fragmentedRecvs++;
+            }
+
+            first = NETEM_LINK_BUFFER_SIZE - pLink->head;
+
+            if( first > chunk )
+            {
+                first = chunk;
+            }
+
+            ( void ) memcpy( pBuffer, &pLink->buffer[ pLink->head ], first );
+            ( void ) memcpy( &( ( uint8_t * ) pBuffer )[ first ], pLink->buffer, chunk - first );
+            leaveLink( pLink, chunk );
+            bytesReceived = ( int32_t ) chunk;
+        }
+        else
+        {
+            bytesReceived = innerStatus;
+        }
+    }
+
+    return bytesReceived;
+}
+/*-----------------------------------------------------------*/
+
+int32_t Netem_Send( NetworkContext_t * pNetworkContext,
+                    const void * pBuffer,
+                    size_t bytesToSend )
+{
+    int32_t bytesSent = -1;
+    size_t space = 0;
+    size_t chunk = 0;
+    uint8_t * pTail = NULL;
+    NetemLink_t * pLink = NULL;
+    NetemTransport_t * pNetem = ( NetemTransport_t * ) pNetworkContext;
+
+    if( pNetem == NULL )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+    }
+    else if( applyStall( pNetem ) == 1U )
+    {
+        bytesSent = 0;
+    }
+    else
+    {
+        pLink = &pNetem->sendLink;
+        bytesSent = forwardSent( pNetem, 0U );
+        space = linkSpace( pLink, &pTail );
+
+        if( ( bytesSent == 0 ) && ( space == 0U ) )
+        {
+            /* The link is full, like a full socket buffer: wait for the
+             * oldest transfer to arrive, and make room. */
+            waitForLink( pLink );
+            bytesSent = forwardSent( pNetem, 0U );
+            space = linkSpace( pLink, &pTail );
+        }
+
+        if( bytesSent == 0 )
+        {
+            chunk = ( space < bytesToSend ) ? space : bytesToSend;
+            chunk = applyFragmentation( pNetem, chunk, pNetem->config.maxSendChunk );
+
+            if( chunk < bytesToSend )
+            {
+                pNetem->stats.fragmentedSends++;
+            }
+
+            if( chunk > 0U )
+            {
+                ( void ) memcpy( pTail, pBuffer, chunk );
+                enterLink( pNetem, pLink, chunk );
+            }
+
+            bytesSent = ( int32_t ) chunk;
+        }
+    }
+
+    return bytesSent;
+}
+/*-----------------------------------------------------------*/
+
+NetemStatus_t Netem_Flush( NetemTransport_t * pNetem )
+{
+    NetemStatus_t returnStatus = NETEM_SUCCESS;
+
+    if( pNetem == NULL )
+    {
+        LogError( ( "Parameter check failed: pNetem is NULL." ) );
+        returnStatus = NETEM_INVALID_PARAMETER;
+    }
+    else if( ( forwardSent( pNetem, 1U ) != 0 ) || ( pNetem->sendLink.count > 0U ) )
+    {
+        LogError( ( "The wrapped transport did not take the bytes sent." ) );
+        returnStatus = NETEM_SEND_FAILED;
+    }
+    else
+    {
+        /* Empty else. */
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,618 @@
+/*
+ * AWS IoT Device SDK for Embedded C V202011.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Standard includes. */
+#include <assert.h>
+#include <string.h>
+
+/* POSIX socket includes. */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <sys/time.h>
+
+/* Zero-copy completions are reported through the Linux socket error queue. */
+#if defined( __linux__ )
+    #include <netinet/in.h>
+    #include <linux/errqueue.h>
+#endif
+
+#include "plaintext_posix.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Whether the platform provides MSG_ZEROCOPY and its completion
+ * notifications.
+ */
+#if defined( __linux__ ) && defined( SO_ZEROCOPY ) && defined( MSG_ZEROCOPY ) && defined( SO_EE_ORIGIN_ZEROCOPY )
+    #define PLAINTEXT_ZEROCOPY_SUPPORTED    1
+#else
+    #define PLAINTEXT_ZEROCOPY_SUPPORTED    0
+#endif
+
+/**
+ * @brief Size of the control buffer used to read one error queue entry.
+ */
+#define ZEROCOPY_CONTROL_BUFFER_SIZE    ( 128U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Map a send that failed with EAGAIN to the return value of
+ * #Plaintext_Send.
+ *
+ * On a non-blocking socket the socket buffer is full, which is reported as
+ * 0 so that the caller retries. On the blocking socket of #Plaintext_Connect
+ * the send timeout expired. coreMQTT retries a 0 without bound, so a stalled
+ * peer would hang it; the timeout is reported as an error instead.
+ *
+ * @param[in] pNetworkContext The network context.
+ *
+ * @return 0 for a non-blocking socket; -1 otherwise.
+ */
+static int32_t sendBlockedStatus( const NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Send a buffer with a regular, copying send.
+ *
+ * @param[in] pNetworkContext The network context.
+ * @param[in] pBuffer Buffer containing the bytes to send.
+ * @param[in] bytesToSend Number of bytes to send.
+ *
+ * @return Number of bytes sent; 0 if a non-blocking socket is full; negative
+ * value on error or timeout.
+ */
+static int32_t sendCopy( const NetworkContext_t * pNetworkContext,
+                         const void * pBuffer,
+                         size_t bytesToSend );
+
+#if ( PLAINTEXT_ZEROCOPY_SUPPORTED == 1 )
+
+/**
+ * @brief Read the pending completion notifications from the socket error
+ * queue and update the zero-copy state.
+ *
+ * @param[in] pNetworkContext The network context.
+ *
+ * @return 0 if at least one notification was read or the queue was empty;
+ * -1 on a socket error.
+ */
+    static int32_t readZeroCopyCompletions( NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Block until the kernel has released the buffers of all zero-copy
+ * sends issued on the connection.
+ *
+ * @param[in] pNetworkContext The network context.
+ *
+ * @return 0 on success; -1 on a socket error or timeout.
+ */
+    static int32_t waitForZeroCopyCompletion( NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Send a buffer with MSG_ZEROCOPY and wait for its completion.
+ *
+ * @param[in] pNetworkContext The network context.
+ * @param[in] pBuffer Buffer containing the bytes to send.
+ * @param[in] bytesToSend Number of bytes to send.
+ *
+ * @return Number of bytes sent; 0 on timeout; negative value on error.
+ */
+    static int32_t sendZeroCopy( NetworkContext_t * pNetworkContext,
+                                 const void * pBuffer,
+                                 size_t bytesToSend );
+
+#endif /* if ( PLAINTEXT_ZEROCOPY_SUPPORTED == 1 ) */
+
+/*-----------------------------------------------------------*/
+
+static int32_t sendBlockedStatus( const NetworkContext_t * pNetworkContext )
+{
+    int32_t returnStatus = -1;
+    int flags = fcntl( pNetworkContext->socketDescriptor, F_GETFL );
+
+    if( ( flags >= 0 ) && ( ( flags & O_NONBLOCK ) != 0 ) )
+    {
+        returnStatus = 0;
+    }
+    else
+    {
+        LogError( ( "Failed to send data over network: send timed out." ) );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static int32_t sendCopy( const NetworkContext_t * pNetworkContext,
+                         const void * pBuffer,
+                         size_t bytesToSend )
+{
+    int32_t bytesSent = 0;
+
+    assert( pNetworkContext != NULL );
+
+    bytesSent = ( int32_t ) send( pNetworkContext->socketDescriptor,
+                                  pBuffer,
+                                  bytesToSend,
+                                  0 );
+
+    if( bytesSent < 0 )
+    {
+        if( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) )
+        {
+            bytesSent = sendBlockedStatus( pNetworkContext );
+        }
+        else
+        {
+            LogError( ( "Failed to send data over network: %s.",
+                        strerror( errno ) ) );
+        }
+    }
+
+    return bytesSent;
+}
+/*-----------------------------------------------------------*/
+
+#if ( PLAINTEXT_ZEROCOPY_SUPPORTED == 1 )
+
+    static int32_t readZeroCopyCompletions( NetworkContext_t * pNetworkContext )
+    {
+        int32_t returnStatus = 0;
+        ssize_t readStatus = 0;
+        struct msghdr message;
+        struct cmsghdr * pControlMessage = NULL;
+        const struct sock_extended_err * pExtendedError = NULL;
+        char control[ ZEROCOPY_CONTROL_BUFFER_SIZE ];
+        PlaintextZeroCopy_t * pZeroCopy = NULL;
+
+        assert( pNetworkContext != NULL );
+
+        pZeroCopy = &pNetworkContext->zeroCopy;
+
+        for( ; ; )
+        {
+            ( void ) memset( &message, 0, sizeof( message ) );
+            message.msg_control = control;
+            message.msg_controllen = sizeof( control );
+
+            readStatus = recvmsg( pNetworkContext->socketDescriptor,
+                                  &message,
+                                  MSG_ERRQUEUE | MSG_DONTWAIT );
+
+            if( readStatus < 0 )
+            {
+                if( ( errno != EAGAIN ) && ( errno != EWOULDBLOCK ) )
+                {
+                    LogError( ( "Failed to read zero-copy completion: %s.",
+                                strerror( errno ) ) );
+                    returnStatus = -1;
+                }
+
+                /* The error queue is drained. */
+                break;
+            }
+
+            for( pControlMessage = CMSG_FIRSTHDR( &message );
+                 pControlMessage != NULL;
+                 pControlMessage = CMSG_NXTHDR( &message, pControlMessage ) )
+            {
+                if( !( ( ( pControlMessage->cmsg_level == SOL_IP ) &&
+                         ( pControlMessage->cmsg_type == IP_RECVERR ) ) ||
+                       ( ( pControlMessage->cmsg_level == SOL_IPV6 ) &&
+                         ( pControlMessage->cmsg_type == IPV6_RECVERR ) ) ) )
+                {
+                    continue;
+                }
+
+                /* MISRA Rule 11.3 flags the following line for casting a pointer
+                 * of a object type to a pointer of a different object type. The
+                 * control message payload of an IP_RECVERR message is defined
+                 * by Linux to be a struct sock_extended_err. */
+                /* coverity[misra_c_2012_rule_11_3_violation] */
+                pExtendedError = ( const struct sock_extended_err * ) CMSG_DATA( pControlMessage );
+
+                if( ( pExtendedError->ee_errno != 0U ) ||
+                    ( pExtendedError->ee_origin != SO_EE_ORIGIN_ZEROCOPY ) )
+                {
+                    continue;
+                }
+
+                /* The notification covers the inclusive range of send
+                 * identifiers [ee_info, ee_data]. Notifications of a TCP
+                 * socket arrive in order, so only the upper bound matters. */
+                if( ( int32_t ) ( pExtendedError->ee_data + 1U - pZeroCopy->completedId ) > 0 )
+                {
+                    pZeroCopy->completedId = pExtendedError->ee_data + 1U;
+                }
+
+                if( ( pExtendedError->ee_code & SO_EE_CODE_ZEROCOPY_COPIED ) != 0U )
+                {
+                    pZeroCopy->copiedCount++;
+                }
+            }
+        }
+
+        return returnStatus;
+    }
+/*-----------------------------------------------------------*/
+
+    static int32_t waitForZeroCopyCompletion( NetworkContext_t * pNetworkContext )
+    {
+        int32_t returnStatus = 0;
+        int32_t pollStatus = 0;
+        struct pollfd pollDescriptor;
+        PlaintextZeroCopy_t * pZeroCopy = NULL;
+
+        assert( pNetworkContext != NULL );
+
+        pZeroCopy = &pNetworkContext->zeroCopy;
+
+        while( ( returnStatus == 0 ) &&
+               ( pZeroCopy->completedId != pZeroCopy->nextSendId ) )
+        {
+            /* An error queue entry is signaled with POLLERR, which is always
+             * reported, so no events need to be requested. */
+            pollDescriptor.fd = pNetworkContext->socketDescriptor;
+            pollDescriptor.events = 0;
+            pollDescriptor.revents = 0;
+
+            pollStatus = poll( &pollDescriptor,
+                               1,
+                               ( int ) pZeroCopy->completionTimeoutMs );
+
+            if( pollStatus < 0 )
+            {
+                if( errno != EINTR )
+                {
+                    LogError( ( "Polling for zero-copy completion failed: %s.",
+                                strerror( errno ) ) );
+                    returnStatus = -1;
+                }
+            }
+            else if( pollStatus == 0 )
+            {
+                LogError( ( "Timed out waiting for zero-copy completion." ) );
+                returnStatus = -1;
+            }
+            else
+            {
+                returnStatus = readZeroCopyCompletions( pNetworkContext );
+            }
+        }
+
+        return returnStatus;
+    }
+/*-----------------------------------------------------------*/
+
+    static int32_t sendZeroCopy( NetworkContext_t * pNetworkContext,
+                                 const void * pBuffer,
+                                 size_t bytesToSend )
+    {
+        int32_t bytesSent = 0;
+        PlaintextZeroCopy_t * pZeroCopy = NULL;
+
+        assert( pNetworkContext != NULL );
+
+        pZeroCopy = &pNetworkContext->zeroCopy;
+
+        bytesSent = ( int32_t ) send( pNetworkContext->socketDescriptor,
+                                      pBuffer,
+                                      bytesToSend,
+                                      MSG_ZEROCOPY );
+
+        if( bytesSent > 0 )
+        {
+            /* The kernel numbers every successful zero-copy send. */
+            pZeroCopy->nextSendId++;
+
+            /* The buffer belongs to the kernel until the completion
+             * notification arrives. The data is already queued, so a failure
+             * here cannot be reported as a timeout that invites a resend. */
+            if( waitForZeroCopyCompletion( pNetworkContext ) != 0 )
+            {
+                bytesSent = -1;
+            }
+            else if( pZeroCopy->copiedCount > 0U )
+            {
+                LogDebug( ( "Kernel copied zero-copy send data, "
+                            "disabling MSG_ZEROCOPY for this connection." ) );
+                pZeroCopy->thresholdBytes = 0U;
+            }
+            else
+            {
+                /* Empty else. */
+            }
+        }
+        else if( ( bytesSent < 0 ) && ( errno == ENOBUFS ) )
+        {
+            /* The socket's optmem limit for pinned pages is exhausted.
+             * Fall back to a regular copying send. */
+            bytesSent = sendCopy( pNetworkContext, pBuffer, bytesToSend );
+        }
+        else if( bytesSent < 0 )
+        {
+            if( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) )
+            {
+                bytesSent = sendBlockedStatus( pNetworkContext );
+            }
+            else
+            {
+                LogError( ( "Failed to send data over network: %s.",
+                            strerror( errno ) ) );
+            }
+        }
+        else
+        {
+            /* Empty else. */
+        }
+
+        return bytesSent;
+    }
+#endif /* if ( PLAINTEXT_ZEROCOPY_SUPPORTED == 1 ) */
+/*-----------------------------------------------------------*/
+
+SocketStatus_t Plaintext_Connect( NetworkContext_t * pNetworkContext,
+                                  const ServerInfo_t * pServerInfo,
+                                  uint32_t sendTimeoutMs,
+                                  uint32_t recvTimeoutMs )
+{
+    SocketStatus_t returnStatus = SOCKETS_SUCCESS;
+
+    if( pNetworkContext == NULL )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+        returnStatus = SOCKETS_INVALID_PARAMETER;
+    }
+    else
+    {
+        ( void ) memset( &pNetworkContext->zeroCopy, 0, sizeof( PlaintextZeroCopy_t ) );
+
+        returnStatus = Sockets_Connect( &pNetworkContext->socketDescriptor,
+                                        pServerInfo,
+                                        sendTimeoutMs,
+                                        recvTimeoutMs );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+SocketStatus_t Plaintext_Disconnect( const NetworkContext_t * pNetworkContext )
+{
+    SocketStatus_t returnStatus = SOCKETS_SUCCESS;
+
+    if( pNetworkContext == NULL )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+        returnStatus = SOCKETS_INVALID_PARAMETER;
+    }
+    else
+    {
+        returnStatus = Sockets_Disconnect( pNetworkContext->socketDescriptor );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+SocketStatus_t Plaintext_EnableZeroCopy( NetworkContext_t * pNetworkContext,
+                                         size_t thresholdBytes,
+                                         uint32_t completionTimeoutMs )
+{
+    SocketStatus_t returnStatus = SOCKETS_SUCCESS;
+
+    if( pNetworkContext == NULL )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+        returnStatus = SOCKETS_INVALID_PARAMETER;
+    }
+    else if( thresholdBytes == 0U )
+    {
+        pNetworkContext->zeroCopy.thresholdBytes = 0U;
+    }
+    else
+    {
+        #if ( PLAINTEXT_ZEROCOPY_SUPPORTED == 1 )
+            int32_t enable = 1;
+            uint32_t timeoutMs = completionTimeoutMs;
+            struct timeval sendTimeout = { 0 };
+            socklen_t timeoutLength = ( socklen_t ) sizeof( sendTimeout );
+
+            if( timeoutMs == 0U )
+            {
+                /* Default to the send timeout of the connection, so that a
+                 * dead peer cannot block a send for longer than a regular
+                 * send would. */
+                if( getsockopt( pNetworkContext->socketDescriptor,
+                                SOL_SOCKET,
+                                SO_SNDTIMEO,
+                                &sendTimeout,
+                                &timeoutLength ) == 0 )
+                {
+                    timeoutMs = ( uint32_t ) ( ( sendTimeout.tv_sec * 1000 ) +
+                                               ( sendTimeout.tv_usec / 1000 ) );
+                }
+            }
+
+            if( timeoutMs == 0U )
+            {
+                LogError( ( "Zero-copy sends need a completion timeout, "
+                            "but none was given and the send timeout is infinite." ) );
+                returnStatus = SOCKETS_INVALID_PARAMETER;
+            }
+            else if( setsockopt( pNetworkContext->socketDescriptor,
+                                 SOL_SOCKET,
+                                 SO_ZEROCOPY,
+                                 &enable,
+                                 ( socklen_t ) sizeof( enable ) ) < 0 )
+            {
+                LogError( ( "Enabling SO_ZEROCOPY failed: %s.", strerror( errno ) ) );
+                returnStatus = SOCKETS_API_ERROR;
+            }
+            else
+            {
+                pNetworkContext->zeroCopy.thresholdBytes = thresholdBytes;
+                pNetworkContext->zeroCopy.completionTimeoutMs = timeoutMs;
+            }
+        #else
+            ( void ) completionTimeoutMs;
+            LogError( ( "MSG_ZEROCOPY is not supported on this platform." ) );
+            returnStatus = SOCKETS_API_ERROR;
+        #endif
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+int32_t Plaintext_Recv( NetworkContext_t * pNetworkContext,
+                        void * pBuffer,
+                        size_t bytesToRecv )
+{
+    int32_t bytesReceived = -1;
+
+    if( pNetworkContext == NULL )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+    }
+    else
+    {
+        bytesReceived = ( int32_t ) recv( pNetworkContext->socketDescriptor,
+                                          pBuffer,
+                                          bytesToRecv,
+                                          0 );
+
+        if( bytesReceived == 0 )
+        {
+            /* The server closed the connection. */
+            LogError( ( "Connection closed by the server." ) );
+            bytesReceived = -1;
+        }
+        else if( bytesReceived < 0 )
+        {
+            if( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) )
+            {
+                /* There is no data to receive at this time. */
+                bytesReceived = 0;
+            }
+            else
+            {
+                LogError( ( "Failed to receive data over network: %s.",
+                            strerror( errno ) ) );
+            }
+        }
+        else
+        {
+            /* Empty else. */
+        }
+    }
+
+    return bytesReceived;
+}
+/*-----------------------------------------------------------*/
+
+int32_t Plaintext_Send( NetworkContext_t * pNetworkContext,
+                        const void * pBuffer,
+                        size_t bytesToSend )
+{
+    int32_t bytesSent = -1;
+
+    if( pNetworkContext == NULL )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+    }
+    else
+    {
+        #if ( PLAINTEXT_ZEROCOPY_SUPPORTED == 1 )
+            if( ( pNetworkContext->zeroCopy.thresholdBytes > 0U ) &&
+                ( bytesToSend >= pNetworkContext->zeroCopy.thresholdBytes ) )
+            {
+                bytesSent = sendZeroCopy( pNetworkContext, pBuffer, bytesToSend );
+            }
+            else
+        #endif
+        {
+            bytesSent = sendCopy( pNetworkContext, pBuffer, bytesToSend );
+        }
+    }
+
+    return bytesSent;
+}
+/*-----------------------------------------------------------*/
+
+int32_t Plaintext_SendFile( NetworkContext_t * pNetworkContext,
+                            int32_t fileDescriptor,
+                            int64_t * pOffset,
+                            size_t bytesToSend )
+{
+    int32_t bytesSent = -1;
+    off_t offset = 0;
+    ssize_t ret = 0;
+
+    if( ( pNetworkContext == NULL ) || ( pOffset == NULL ) || ( fileDescriptor < 0 ) )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext=%p, pOffset=%p, fileDescriptor=%d.",
+                    ( void * ) pNetworkContext,
+                    ( void * ) pOffset,
+                    ( int ) fileDescriptor ) );
+    }
+    else
+    {
+        offset = ( off_t ) *pOffset;
+
+        /* Cap a single call so that the byte count fits the return value. */
+        ret = sendfile( pNetworkContext->socketDescriptor,
+                        fileDescriptor,
+                        &offset,
+                        ( bytesToSend > ( size_t ) INT32_MAX ) ? ( size_t ) INT32_MAX : bytesToSend );
+
+        if( ( ret == 0 ) && ( bytesToSend > 0U ) )
+        {
+            /* sendfile returns 0 at the end of the file, which would
+             * otherwise look like a timeout to the caller. */
+            LogError( ( "Failed to send file over network: unexpected end of file." ) );
+        }
+        else if( ret >= 0 )
+        {
+            bytesSent = ( int32_t ) ret;
+            *pOffset = ( int64_t ) offset;
+        }
+        else if( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) )
+        {
+            /* The send timed out before any data could be sent. */
+            bytesSent = 0;
+        }
+        else
+        {
+            LogError( ( "Failed to send file over network: %s.",
+                        strerror( errno ) ) );
+        }
+    }
+
+    return bytesSent;
+}
+/*-----------------------------------------------------------*/
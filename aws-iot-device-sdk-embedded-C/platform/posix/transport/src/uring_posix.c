@@ -0,0 +1,1204 @@
+/*
+ * AWS IoT Device SDK for Embedded C V202011.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Standard includes. */
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+
+/* POSIX includes. */
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+/* Linux io_uring ABI. */
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+
+#include "uring_posix.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Number of milliseconds in one second.
+ */
+#define ONE_SEC_TO_MS            ( 1000 )
+
+/**
+ * @brief Number of nanoseconds in one millisecond.
+ */
+#define ONE_MS_TO_NS             ( 1000000 )
+
+/**
+ * @brief Buffer group of the provided receive buffers.
+ */
+#define URING_BUFFER_GROUP_ID    ( 0U )
+
+/**
+ * @brief Operation tags stored in the low bits of the user data of a
+ * submission, above which the connection slot is stored. The high 32 bits
+ * hold the generation of the slot, so that a late completion of an earlier
+ * connection in the slot is not applied to the current one.
+ */
+#define OPERATION_RECV           ( 1U )
+#define OPERATION_SEND           ( 2U )
+#define OPERATION_BITS           ( 8U )
+#define OPERATION_MASK           ( ( 1U << OPERATION_BITS ) - 1U )
+#define SLOT_BITS                ( 24U )
+#define SLOT_MASK                ( ( 1U << SLOT_BITS ) - 1U )
+#define GENERATION_SHIFT         ( OPERATION_BITS + SLOT_BITS )
+
+/**
+ * @brief Time to wait for in-flight operations of a connection to finish
+ * when it is disconnected.
+ */
+#define DISCONNECT_DRAIN_TIMEOUT_MS    ( 100U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Converts the sockets wrapper status to io_uring transport status.
+ *
+ * @param[in] socketStatus Sockets wrapper status.
+ *
+ * @return #URING_SUCCESS, #URING_INVALID_PARAMETER, #URING_DNS_FAILURE,
+ * and #URING_CONNECT_FAILURE.
+ */
+static UringStatus_t convertToUringStatus( SocketStatus_t socketStatus );
+
+/**
+ * @brief Map the rings of a newly created io_uring instance.
+ *
+ * @param[in,out] pReactor The reactor whose ring descriptor is set.
+ * @param[in] pParams Parameters returned by io_uring_setup.
+ *
+ * @return #URING_SUCCESS on success; #URING_API_ERROR on failure.
+ */
+static UringStatus_t mapRings( UringReactor_t * pReactor,
+                               const struct io_uring_params * pParams );
+
+/**
+ * @brief Allocate and register the send buffers and the provided receive
+ * buffer ring.
+ *
+ * @param[in,out] pReactor The reactor with mapped rings.
+ *
+ * @return #URING_SUCCESS on success; #URING_INSUFFICIENT_MEMORY,
+ * #URING_NOT_SUPPORTED, #URING_API_ERROR on failure.
+ */
+static UringStatus_t registerBuffers( UringReactor_t * pReactor );
+
+/**
+ * @brief Return a receive buffer to the provided buffer ring.
+ *
+ * The new ring tail is made visible to the kernel by @ref publishBuffers.
+ *
+ * @param[in] pReactor The reactor owning the buffer.
+ * @param[in] bufferId The buffer to return.
+ */
+static void recycleBuffer( UringReactor_t * pReactor,
+                           uint16_t bufferId );
+
+/**
+ * @brief Make recycled receive buffers visible to the kernel.
+ *
+ * @param[in] pReactor The reactor owning the buffer ring.
+ */
+static void publishBuffers( UringReactor_t * pReactor );
+
+/**
+ * @brief Get a free submission queue entry, submitting the queued entries
+ * if the queue is full.
+ *
+ * @param[in] pReactor The reactor.
+ *
+ * @return A zeroed entry; NULL if the queue could not be drained.
+ */
+static struct io_uring_sqe * getSubmissionEntry( UringReactor_t * pReactor );
+
+/**
+ * @brief Make a filled submission queue entry visible to the kernel.
+ *
+ * @param[in] pReactor The reactor.
+ */
+static void commitSubmissionEntry( UringReactor_t * pReactor );
+
+/**
+ * @brief Submit the queued entries and optionally wait for a completion.
+ *
+ * @param[in] pReactor The reactor.
+ * @param[in] waitTimeoutMs Time to wait for a completion. 0 does not wait.
+ *
+ * @return 0 on success; -1 on error.
+ */
+static int32_t submitAndWait( UringReactor_t * pReactor,
+                              uint32_t waitTimeoutMs );
+
+/**
+ * @brief Dispatch all available completions to their connections.
+ *
+ * @param[in] pReactor The reactor.
+ *
+ * @return Number of completions processed.
+ */
+static int32_t reapCompletions( UringReactor_t * pReactor );
+
+/**
+ * @brief Handle the completion of a multishot receive.
+ *
+ * @param[in] pReactor The reactor.
+ * @param[in] pNetworkContext The connection, or NULL if it is already detached.
+ * @param[in] pCompletion The completion queue entry.
+ */
+static void handleRecvCompletion( UringReactor_t * pReactor,
+                                  NetworkContext_t * pNetworkContext,
+                                  const struct io_uring_cqe * pCompletion );
+
+/**
+ * @brief Handle the completion of a write.
+ *
+ * @param[in] pNetworkContext The connection, or NULL if it is already detached.
+ * @param[in] pCompletion The completion queue entry.
+ */
+static void handleSendCompletion( NetworkContext_t * pNetworkContext,
+                                  const struct io_uring_cqe * pCompletion );
+
+/**
+ * @brief Tag a submission with its connection and operation.
+ *
+ * @param[in] pNetworkContext The connection.
+ * @param[in] operation #OPERATION_RECV or #OPERATION_SEND.
+ *
+ * @return The user data of the submission.
+ */
+static uint64_t makeUserData( const NetworkContext_t * pNetworkContext,
+                              uint32_t operation );
+
+/**
+ * @brief Queue a multishot receive into the provided receive buffers.
+ *
+ * @param[in] pNetworkContext The connection.
+ *
+ * @return 0 on success; -1 if no submission queue entry was available.
+ */
+static int32_t armRecv( NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Queue a write of all unsent bytes of the connection's send buffer.
+ *
+ * @param[in] pNetworkContext The connection.
+ *
+ * @return 0 on success; -1 if no submission queue entry was available.
+ */
+static int32_t queueWrite( NetworkContext_t * pNetworkContext );
+
+/*-----------------------------------------------------------*/
+
+static UringStatus_t convertToUringStatus( SocketStatus_t socketStatus )
+{
+    UringStatus_t uringStatus = URING_INVALID_PARAMETER;
+
+    switch( socketStatus )
+    {
+        case SOCKETS_SUCCESS:
+            uringStatus = URING_SUCCESS;
+            break;
+
+        case SOCKETS_INVALID_PARAMETER:
+            uringStatus = URING_INVALID_PARAMETER;
+            break;
+
+        case SOCKETS_INSUFFICIENT_MEMORY:
+            uringStatus = URING_INSUFFICIENT_MEMORY;
+            break;
+
+        case SOCKETS_DNS_FAILURE:
+            uringStatus = URING_DNS_FAILURE;
+            break;
+
+        case SOCKETS_CONNECT_FAILURE:
+            uringStatus = URING_CONNECT_FAILURE;
+            break;
+
+        default:
+            uringStatus = URING_API_ERROR;
+            break;
+    }
+
+    return uringStatus;
+}
+/*-----------------------------------------------------------*/
+
+static UringStatus_t mapRings( UringReactor_t * pReactor,
+                               const struct io_uring_params * pParams )
+{
+    UringStatus_t returnStatus = URING_SUCCESS;
+    uint8_t * pRing = NULL;
+    void * pMapping = NULL;
+
+    assert( pReactor != NULL );
+    assert( pParams != NULL );
+
+    /* With IORING_FEAT_SINGLE_MMAP both rings share one mapping. */
+    pReactor->sqRingSize = pParams->sq_off.array + ( pParams->sq_entries * sizeof( uint32_t ) );
+    pReactor->cqRingSize = pParams->cq_off.cqes + ( pParams->cq_entries * sizeof( struct io_uring_cqe ) );
+
+    if( pReactor->cqRingSize > pReactor->sqRingSize )
+    {
+        pReactor->sqRingSize = pReactor->cqRingSize;
+    }
+
+    pMapping = mmap( NULL,
+                     pReactor->sqRingSize,
+                     PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE,
+                     pReactor->ringDescriptor,
+                     IORING_OFF_SQ_RING );
+
+    if( pMapping == MAP_FAILED )
+    {
+        LogError( ( "Failed to map io_uring rings: %s.", strerror( errno ) ) );
+        returnStatus = URING_API_ERROR;
+    }
+    else
+    {
+        pReactor->pSqRing = pMapping;
+        pReactor->pCqRing = pMapping;
+        pRing = ( uint8_t * ) pMapping;
+
+        /* The kernel reports where each ring field lives in the mapping. */
+        pReactor->pSqHead = ( uint32_t * ) &pRing[ pParams->sq_off.head ];
+        pReactor->pSqTail = ( uint32_t * ) &pRing[ pParams->sq_off.tail ];
+        pReactor->pSqArray = ( uint32_t * ) &pRing[ pParams->sq_off.array ];
+        pReactor->sqMask = *( const uint32_t * ) &pRing[ pParams->sq_off.ring_mask ];
+        pReactor->sqEntryCount = *( const uint32_t * ) &pRing[ pParams->sq_off.ring_entries ];
+        pReactor->sqSubmitted = *pReactor->pSqTail;
+
+        pReactor->pCqHead = ( uint32_t * ) &pRing[ pParams->cq_off.head ];
+        pReactor->pCqTail = ( uint32_t * ) &pRing[ pParams->cq_off.tail ];
+        pReactor->cqMask = *( const uint32_t * ) &pRing[ pParams->cq_off.ring_mask ];
+        pReactor->pCqEntries = ( struct io_uring_cqe * ) &pRing[ pParams->cq_off.cqes ];
+    }
+
+    if( returnStatus == URING_SUCCESS )
+    {
+        pReactor->sqEntriesSize = pParams->sq_entries * sizeof( struct io_uring_sqe );
+
+        pMapping = mmap( NULL,
+                         pReactor->sqEntriesSize,
+                         PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE,
+                         pReactor->ringDescriptor,
+                         IORING_OFF_SQES );
+
+        if( pMapping == MAP_FAILED )
+        {
+            LogError( ( "Failed to map io_uring submission entries: %s.", strerror( errno ) ) );
+            returnStatus = URING_API_ERROR;
+        }
+        else
+        {
+            pReactor->pSqEntries = ( struct io_uring_sqe * ) pMapping;
+        }
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static UringStatus_t registerBuffers( UringReactor_t * pReactor )
+{
+    UringStatus_t returnStatus = URING_SUCCESS;
+    struct iovec sendRegion;
+    struct io_uring_buf_reg bufferRing;
+    void * pMapping = NULL;
+    uint16_t bufferId = 0;
+
+    assert( pReactor != NULL );
+
+    /* Send buffers, registered once so writes skip the per-call page pinning. */
+    pMapping = mmap( NULL,
+                     URING_MAX_CONNECTIONS * URING_SEND_BUFFER_SIZE,
+                     PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS,
+                     -1,
+                     0 );
+
+    if( pMapping == MAP_FAILED )
+    {
+        returnStatus = URING_INSUFFICIENT_MEMORY;
+    }
+    else
+    {
+        pReactor->pSendBuffers = ( uint8_t * ) pMapping;
+        sendRegion.iov_base = pMapping;
+        sendRegion.iov_len = URING_MAX_CONNECTIONS * URING_SEND_BUFFER_SIZE;
+
+        if( syscall( __NR_io_uring_register,
+                     pReactor->ringDescriptor,
+                     IORING_REGISTER_BUFFERS,
+                     &sendRegion,
+                     1U ) < 0 )
+        {
+            LogError( ( "Failed to register send buffers: %s.", strerror( errno ) ) );
+            returnStatus = ( errno == ENOMEM ) ? URING_INSUFFICIENT_MEMORY : URING_API_ERROR;
+        }
+    }
+
+    /* Receive buffers, handed to the kernel through a provided buffer ring so
+     * that a multishot receive picks one per completion. */
+    if( returnStatus == URING_SUCCESS )
+    {
+        pMapping = mmap( NULL,
+                         URING_RECV_BUFFER_COUNT * URING_RECV_BUFFER_SIZE,
+                         PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS,
+                         -1,
+                         0 );
+
+        if( pMapping == MAP_FAILED )
+        {
+            returnStatus = URING_INSUFFICIENT_MEMORY;
+        }
+        else
+        {
+            pReactor->pRecvBuffers = ( uint8_t * ) pMapping;
+        }
+    }
+
+    if( returnStatus == URING_SUCCESS )
+    {
+        pReactor->bufferRingSize = URING_RECV_BUFFER_COUNT * sizeof( struct io_uring_buf );
+
+        pMapping = mmap( NULL,
+                         pReactor->bufferRingSize,
+                         PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS,
+                         -1,
+                         0 );
+
+        if( pMapping == MAP_FAILED )
+        {
+            returnStatus = URING_INSUFFICIENT_MEMORY;
+        }
+        else
+        {
+            pReactor->pBufferRing = ( struct io_uring_buf_ring * ) pMapping;
+        }
+    }
+
+    if( returnStatus == URING_SUCCESS )
+    {
+        ( void ) memset( &bufferRing, 0, sizeof( bufferRing ) );
+        bufferRing.ring_addr = ( uint64_t ) ( uintptr_t ) pReactor->pBufferRing;
+        bufferRing.ring_entries = URING_RECV_BUFFER_COUNT;
+        bufferRing.bgid = URING_BUFFER_GROUP_ID;
+
+        if( syscall( __NR_io_uring_register,
+                     pReactor->ringDescriptor,
+                     IORING_REGISTER_PBUF_RING,
+                     &bufferRing,
+                     1U ) < 0 )
+        {
+            LogError( ( "Failed to register receive buffer ring: %s.", strerror( errno ) ) );
+            returnStatus = ( errno == EINVAL ) ? URING_NOT_SUPPORTED : URING_API_ERROR;
+        }
+    }
+
+    if( returnStatus == URING_SUCCESS )
+    {
+        for( bufferId = 0U; bufferId < URING_RECV_BUFFER_COUNT; bufferId++ )
+        {
+            recycleBuffer( pReactor, bufferId );
+        }
+
+        publishBuffers( pReactor );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static void recycleBuffer( UringReactor_t * pReactor,
+                           uint16_t bufferId )
+{
+    struct io_uring_buf * pBuffer = NULL;
+
+    assert( pReactor != NULL );
+    assert( bufferId < URING_RECV_BUFFER_COUNT );
+
+    pBuffer = &pReactor->pBufferRing->bufs[ pReactor->bufferRingTail & ( URING_RECV_BUFFER_COUNT - 1U ) ];
+
+    /* Only the address, length and ID are written. The reserved field of the
+     * first entry holds the ring tail. */
+    pBuffer->addr = ( uint64_t ) ( uintptr_t ) &pReactor->pRecvBuffers[ ( size_t ) bufferId * URING_RECV_BUFFER_SIZE ];
+    pBuffer->len = URING_RECV_BUFFER_SIZE;
+    pBuffer->bid = bufferId;
+
+    pReactor->bufferRingTail++;
+}
+/*-----------------------------------------------------------*/
+
+static void publishBuffers( UringReactor_t * pReactor )
+{
+    assert( pReactor != NULL );
+
+    __atomic_store_n( &pReactor->pBufferRing->tail,
+                      pReactor->bufferRingTail,
+                      __ATOMIC_RELEASE );
+}
+/*-----------------------------------------------------------*/
+
+static struct io_uring_sqe * getSubmissionEntry( UringReactor_t * pReactor )
+{
+    struct io_uring_sqe * pEntry = NULL;
+    uint32_t head = 0;
+    uint32_t tail = 0;
+
+    assert( pReactor != NULL );
+
+    tail = *pReactor->pSqTail;
+    head = __atomic_load_n( pReactor->pSqHead, __ATOMIC_ACQUIRE );
+
+    if( ( tail - head ) >= pReactor->sqEntryCount )
+    {
+        /* The queue is full, hand the queued entries to the kernel. */
+        ( void ) submitAndWait( pReactor, 0U );
+        head = __atomic_load_n( pReactor->pSqHead, __ATOMIC_ACQUIRE );
+    }
+
+    if( ( tail - head ) < pReactor->sqEntryCount )
+    {
+        pEntry = &pReactor->pSqEntries[ tail & pReactor->sqMask ];
+        ( void ) memset( pEntry, 0, sizeof( struct io_uring_sqe ) );
+    }
+    else
+    {
+        LogError( ( "io_uring submission queue is full." ) );
+    }
+
+    return pEntry;
+}
+/*-----------------------------------------------------------*/
+
+static void commitSubmissionEntry( UringReactor_t * pReactor )
+{
+    uint32_t tail = 0;
+
+    assert( pReactor != NULL );
+
+    tail = *pReactor->pSqTail;
+    pReactor->pSqArray[ tail & pReactor->sqMask ] = tail & pReactor->sqMask;
+
+    __atomic_store_n( pReactor->pSqTail, tail + 1U, __ATOMIC_RELEASE );
+}
+/*-----------------------------------------------------------*/
+
+static int32_t submitAndWait( UringReactor_t * pReactor,
+                              uint32_t waitTimeoutMs )
+{
+    int32_t returnStatus = 0;
+    long enterStatus = 0;
+    uint32_t toSubmit = 0;
+    uint32_t minComplete = 0;
+    uint32_t flags = 0;
+    struct __kernel_timespec timeout;
+    struct io_uring_getevents_arg waitArgument;
+    const void * pArgument = NULL;
+    size_t argumentSize = 0;
+
+    assert( pReactor != NULL );
+
+    toSubmit = *pReactor->pSqTail - pReactor->sqSubmitted;
+
+    if( waitTimeoutMs > 0U )
+    {
+        timeout.tv_sec = ( int64_t ) ( waitTimeoutMs / ONE_SEC_TO_MS );
+        timeout.tv_nsec = ( long long ) ( waitTimeoutMs % ONE_SEC_TO_MS ) * ONE_MS_TO_NS;
+
+        ( void ) memset( &waitArgument, 0, sizeof( waitArgument ) );
+        waitArgument.sigmask_sz = _NSIG / 8;
+        waitArgument.ts = ( uint64_t ) ( uintptr_t ) &timeout;
+
+        pArgument = &waitArgument;
+        argumentSize = sizeof( waitArgument );
+        minComplete = 1U;
+        flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    }
+
+    /* Nothing to submit and nothing to wait for needs no system call. */
+    if( ( toSubmit > 0U ) || ( minComplete > 0U ) )
+    {
+        enterStatus = syscall( __NR_io_uring_enter,
+                               pReactor->ringDescriptor,
+                               toSubmit,
+                               minComplete,
+                               flags,
+                               pArgument,
+                               argumentSize );
+        pReactor->enterCount++;
+
+        if( enterStatus >= 0 )
+        {
+            pReactor->sqSubmitted += ( uint32_t ) enterStatus;
+        }
+        else if( ( errno == ETIME ) || ( errno == EINTR ) ||
+                 ( errno == EAGAIN ) || ( errno == EBUSY ) )
+        {
+            /* Timed out, interrupted, or the completion queue must be
+             * reaped before more entries are accepted. */
+        }
+        else
+        {
+            LogError( ( "io_uring_enter failed: %s.", strerror( errno ) ) );
+            returnStatus = -1;
+        }
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static int32_t reapCompletions( UringReactor_t * pReactor )
+{
+    int32_t completions = 0;
+    uint32_t head = 0;
+    uint32_t tail = 0;
+    uint32_t slot = 0;
+    uint32_t generation = 0;
+    uint32_t operation = 0;
+    NetworkContext_t * pNetworkContext = NULL;
+    const struct io_uring_cqe * pCompletion = NULL;
+
+    assert( pReactor != NULL );
+
+    head = *pReactor->pCqHead;
+    tail = __atomic_load_n( pReactor->pCqTail, __ATOMIC_ACQUIRE );
+
+    while( head != tail )
+    {
+        pCompletion = &pReactor->pCqEntries[ head & pReactor->cqMask ];
+
+        slot = ( uint32_t ) ( pCompletion->user_data >> OPERATION_BITS ) & SLOT_MASK;
+        generation = ( uint32_t ) ( pCompletion->user_data >> GENERATION_SHIFT );
+        operation = ( uint32_t ) ( pCompletion->user_data & OPERATION_MASK );
+        pNetworkContext = ( slot < URING_MAX_CONNECTIONS ) ? pReactor->pConnections[ slot ] : NULL;
+
+        if( ( pNetworkContext != NULL ) && ( pNetworkContext->generation != generation ) )
+        {
+            /* A late completion of a connection that has left the slot. */
+            pNetworkContext = NULL;
+        }
+
+        if( operation == OPERATION_RECV )
+        {
+            handleRecvCompletion( pReactor, pNetworkContext, pCompletion );
+        }
+        else if( operation == OPERATION_SEND )
+        {
+            handleSendCompletion( pNetworkContext, pCompletion );
+        }
+        else
+        {
+            /* Empty else. */
+        }
+
+        head++;
+        completions++;
+    }
+
+    __atomic_store_n( pReactor->pCqHead, head, __ATOMIC_RELEASE );
+
+    publishBuffers( pReactor );
+    pReactor->completionCount += ( uint64_t ) completions;
+
+    return completions;
+}
+/*-----------------------------------------------------------*/
+
+static void handleRecvCompletion( UringReactor_t * pReactor,
+                                  NetworkContext_t * pNetworkContext,
+                                  const struct io_uring_cqe * pCompletion )
+{
+    uint16_t bufferId = 0;
+    uint32_t queueIndex = 0;
+
+    assert( pReactor != NULL );
+    assert( pCompletion != NULL );
+
+    if( ( pCompletion->flags & IORING_CQE_F_BUFFER ) != 0U )
+    {
+        bufferId = ( uint16_t ) ( pCompletion->flags >> IORING_CQE_BUFFER_SHIFT );
+
+        if( ( pNetworkContext != NULL ) && ( pCompletion->res > 0 ) )
+        {
+            /* A connection can hold at most every buffer of the reactor, so
+             * its queue cannot overflow. */
+            assert( pNetworkContext->recvCount < URING_RECV_BUFFER_COUNT );
+
+            queueIndex = ( pNetworkContext->recvHead + pNetworkContext->recvCount ) % URING_RECV_BUFFER_COUNT;
+            pNetworkContext->recvQueue[ queueIndex ].bufferId = bufferId;
+            pNetworkContext->recvQueue[ queueIndex ].offset = 0U;
+            pNetworkContext->recvQueue[ queueIndex ].length = ( uint32_t ) pCompletion->res;
+            pNetworkContext->recvCount++;
+        }
+        else
+        {
+            recycleBuffer( pReactor, bufferId );
+        }
+    }
+
+    if( pNetworkContext != NULL )
+    {
+        if( pCompletion->res == 0 )
+        {
+            pNetworkContext->peerClosed = 1U;
+        }
+        else if( ( pCompletion->res < 0 ) && ( pCompletion->res != -ENOBUFS ) )
+        {
+            pNetworkContext->pendingError = pCompletion->res;
+        }
+        else
+        {
+            /* Data, or the receive buffers ran out. In the latter case the
+             * receive is re-armed once the connection returns buffers. */
+        }
+
+        if( ( pCompletion->flags & IORING_CQE_F_MORE ) == 0U )
+        {
+            pNetworkContext->recvArmed = 0U;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void handleSendCompletion( NetworkContext_t * pNetworkContext,
+                                  const struct io_uring_cqe * pCompletion )
+{
+    assert( pCompletion != NULL );
+
+    if( pNetworkContext != NULL )
+    {
+        pNetworkContext->sendInFlight = 0U;
+
+        if( pCompletion->res < 0 )
+        {
+            pNetworkContext->pendingError = pCompletion->res;
+        }
+        else
+        {
+            pNetworkContext->sentOffset += ( uint32_t ) pCompletion->res;
+
+            if( pNetworkContext->sentOffset == pNetworkContext->queuedOffset )
+            {
+                /* Everything is written, start over at the buffer's beginning. */
+                pNetworkContext->sentOffset = 0U;
+                pNetworkContext->queuedOffset = 0U;
+            }
+            else
+            {
+                /* A short write, or bytes queued while the write was in flight. */
+                ( void ) queueWrite( pNetworkContext );
+            }
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t makeUserData( const NetworkContext_t * pNetworkContext,
+                              uint32_t operation )
+{
+    assert( pNetworkContext != NULL );
+
+    return ( ( uint64_t ) pNetworkContext->generation << GENERATION_SHIFT ) |
+           ( ( uint64_t ) pNetworkContext->slot << OPERATION_BITS ) |
+           operation;
+}
+/*-----------------------------------------------------------*/
+
+static int32_t armRecv( NetworkContext_t * pNetworkContext )
+{
+    int32_t returnStatus = -1;
+    struct io_uring_sqe * pEntry = NULL;
+
+    assert( pNetworkContext != NULL );
+
+    pEntry = getSubmissionEntry( pNetworkContext->pReactor );
+
+    if( pEntry != NULL )
+    {
+        pEntry->opcode = IORING_OP_RECV;
+        pEntry->fd = pNetworkContext->socketDescriptor;
+        pEntry->ioprio = IORING_RECV_MULTISHOT;
+        pEntry->flags = IOSQE_BUFFER_SELECT;
+        pEntry->buf_group = URING_BUFFER_GROUP_ID;
+        pEntry->user_data = makeUserData( pNetworkContext, OPERATION_RECV );
+
+        commitSubmissionEntry( pNetworkContext->pReactor );
+        pNetworkContext->recvArmed = 1U;
+        returnStatus = 0;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static int32_t queueWrite( NetworkContext_t * pNetworkContext )
+{
+    int32_t returnStatus = -1;
+    struct io_uring_sqe * pEntry = NULL;
+    uint8_t * pSendBuffer = NULL;
+
+    assert( pNetworkContext != NULL );
+    assert( pNetworkContext->sendInFlight == 0U );
+
+    pSendBuffer = &pNetworkContext->pReactor->pSendBuffers[ ( size_t ) pNetworkContext->slot * URING_SEND_BUFFER_SIZE ];
+    pEntry = getSubmissionEntry( pNetworkContext->pReactor );
+
+    if( pEntry != NULL )
+    {
+        /* The whole send region is registered as buffer 0. */
+        pEntry->opcode = IORING_OP_WRITE_FIXED;
+        pEntry->fd = pNetworkContext->socketDescriptor;
+        pEntry->addr = ( uint64_t ) ( uintptr_t ) &pSendBuffer[ pNetworkContext->sentOffset ];
+        pEntry->len = pNetworkContext->queuedOffset - pNetworkContext->sentOffset;
+        pEntry->buf_index = 0U;
+        pEntry->user_data = makeUserData( pNetworkContext, OPERATION_SEND );
+
+        commitSubmissionEntry( pNetworkContext->pReactor );
+        pNetworkContext->sendInFlight = 1U;
+        returnStatus = 0;
+    }
+    else
+    {
+        pNetworkContext->pendingError = -EBUSY;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+UringStatus_t UringReactor_Init( UringReactor_t * pReactor )
+{
+    UringStatus_t returnStatus = URING_SUCCESS;
+    struct io_uring_params params;
+    long setupStatus = -1;
+
+    if( pReactor == NULL )
+    {
+        LogError( ( "Parameter check failed: pReactor is NULL." ) );
+        returnStatus = URING_INVALID_PARAMETER;
+    }
+    else
+    {
+        ( void ) memset( pReactor, 0, sizeof( UringReactor_t ) );
+        pReactor->ringDescriptor = -1;
+
+        /* Completions are only reaped by the reactor thread, so the kernel
+         * need not interrupt it to run task work. */
+        ( void ) memset( &params, 0, sizeof( params ) );
+        params.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+        setupStatus = syscall( __NR_io_uring_setup, URING_QUEUE_DEPTH, &params );
+
+        if( ( setupStatus < 0 ) && ( errno == EINVAL ) )
+        {
+            /* Older kernel without the setup flags. */
+            ( void ) memset( &params, 0, sizeof( params ) );
+            setupStatus = syscall( __NR_io_uring_setup, URING_QUEUE_DEPTH, &params );
+        }
+
+        if( setupStatus < 0 )
+        {
+            LogError( ( "io_uring_setup failed: %s.", strerror( errno ) ) );
+            returnStatus = ( ( errno == ENOSYS ) || ( errno == EPERM ) ) ?
+                           URING_NOT_SUPPORTED : URING_API_ERROR;
+        }
+        else if( ( ( params.features & IORING_FEAT_SINGLE_MMAP ) == 0U ) ||
+                 ( ( params.features & IORING_FEAT_EXT_ARG ) == 0U ) )
+        {
+            pReactor->ringDescriptor = ( int32_t ) setupStatus;
+            LogError( ( "Kernel io_uring lacks single mmap or extended wait arguments." ) );
+            returnStatus = URING_NOT_SUPPORTED;
+        }
+        else
+        {
+            pReactor->ringDescriptor = ( int32_t ) setupStatus;
+        }
+    }
+
+    if( returnStatus == URING_SUCCESS )
+    {
+        returnStatus = mapRings( pReactor, &params );
+    }
+
+    if( returnStatus == URING_SUCCESS )
+    {
+        returnStatus = registerBuffers( pReactor );
+    }
+
+    if( ( returnStatus != URING_SUCCESS ) && ( pReactor != NULL ) )
+    {
+        UringReactor_Deinit( pReactor );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+void UringReactor_Deinit( UringReactor_t * pReactor )
+{
+    if( pReactor != NULL )
+    {
+        /* Closing the ring drops the registered buffers and buffer ring. */
+        if( pReactor->ringDescriptor >= 0 )
+        {
+            ( void ) close( pReactor->ringDescriptor );
+        }
+
+        if( pReactor->pSqEntries != NULL )
+        {
+            ( void ) munmap( pReactor->pSqEntries, pReactor->sqEntriesSize );
+        }
+
+        if( pReactor->pSqRing != NULL )
+        {
+            ( void ) munmap( pReactor->pSqRing, pReactor->sqRingSize );
+        }
+
+        if( pReactor->pBufferRing != NULL )
+        {
+            ( void ) munmap( pReactor->pBufferRing, pReactor->bufferRingSize );
+        }
+
+        if( pReactor->pRecvBuffers != NULL )
+        {
+            ( void ) munmap( pReactor->pRecvBuffers, URING_RECV_BUFFER_COUNT * URING_RECV_BUFFER_SIZE );
+        }
+
+        if( pReactor->pSendBuffers != NULL )
+        {
+            ( void ) munmap( pReactor->pSendBuffers, URING_MAX_CONNECTIONS * URING_SEND_BUFFER_SIZE );
+        }
+
+        ( void ) memset( pReactor, 0, sizeof( UringReactor_t ) );
+        pReactor->ringDescriptor = -1;
+    }
+}
+/*-----------------------------------------------------------*/
+
+int32_t UringReactor_Poll( UringReactor_t * pReactor,
+                           uint32_t timeoutMs )
+{
+    int32_t returnStatus = -1;
+    uint32_t waitTimeoutMs = timeoutMs;
+
+    if( ( pReactor == NULL ) || ( pReactor->ringDescriptor < 0 ) )
+    {
+        LogError( ( "Parameter check failed: pReactor is not initialized." ) );
+    }
+    else
+    {
+        /* Do not block when completions are already waiting. */
+        if( *pReactor->pCqHead != __atomic_load_n( pReactor->pCqTail, __ATOMIC_ACQUIRE ) )
+        {
+            waitTimeoutMs = 0U;
+        }
+
+        returnStatus = submitAndWait( pReactor, waitTimeoutMs );
+
+        if( returnStatus == 0 )
+        {
+            returnStatus = reapCompletions( pReactor );
+        }
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+UringStatus_t Uring_Connect( NetworkContext_t * pNetworkContext,
+                             UringReactor_t * pReactor,
+                             const ServerInfo_t * pServerInfo,
+                             uint32_t sendTimeoutMs,
+                             uint32_t recvTimeoutMs )
+{
+    UringStatus_t returnStatus = URING_SUCCESS;
+    SocketStatus_t socketStatus = SOCKETS_SUCCESS;
+    uint32_t slot = 0;
+
+    if( pNetworkContext == NULL )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+        returnStatus = URING_INVALID_PARAMETER;
+    }
+    else if( ( pReactor == NULL ) || ( pReactor->ringDescriptor < 0 ) )
+    {
+        LogError( ( "Parameter check failed: pReactor is not initialized." ) );
+        returnStatus = URING_INVALID_PARAMETER;
+    }
+    else
+    {
+        for( slot = 0U; slot < URING_MAX_CONNECTIONS; slot++ )
+        {
+            if( pReactor->pConnections[ slot ] == NULL )
+            {
+                break;
+            }
+        }
+
+        if( slot == URING_MAX_CONNECTIONS )
+        {
+            LogError( ( "All %u reactor connection slots are in use.",
+                        ( unsigned int ) URING_MAX_CONNECTIONS ) );
+            returnStatus = URING_INSUFFICIENT_MEMORY;
+        }
+    }
+
+    if( returnStatus == URING_SUCCESS )
+    {
+        ( void ) memset( pNetworkContext, 0, sizeof( NetworkContext_t ) );
+
+        socketStatus = Sockets_Connect( &pNetworkContext->socketDescriptor,
+                                        pServerInfo,
+                                        sendTimeoutMs,
+                                        recvTimeoutMs );
+        returnStatus = convertToUringStatus( socketStatus );
+    }
+
+    if( returnStatus == URING_SUCCESS )
+    {
+        pNetworkContext->pReactor = pReactor;
+        pNetworkContext->slot = slot;
+        pNetworkContext->generation = pReactor->slotGenerations[ slot ];
+        pNetworkContext->sendTimeoutMs = sendTimeoutMs;
+        pNetworkContext->recvTimeoutMs = recvTimeoutMs;
+        pReactor->pConnections[ slot ] = pNetworkContext;
+
+        if( armRecv( pNetworkContext ) != 0 )
+        {
+            pReactor->pConnections[ slot ] = NULL;
+            ( void ) Sockets_Disconnect( pNetworkContext->socketDescriptor );
+            returnStatus = URING_API_ERROR;
+        }
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+UringStatus_t Uring_Disconnect( NetworkContext_t * pNetworkContext )
+{
+    UringStatus_t returnStatus = URING_SUCCESS;
+    UringReactor_t * pReactor = NULL;
+
+    if( ( pNetworkContext == NULL ) || ( pNetworkContext->pReactor == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is not connected." ) );
+        returnStatus = URING_INVALID_PARAMETER;
+    }
+    else
+    {
+        pReactor = pNetworkContext->pReactor;
+
+        /* Flush queued sends while the connection is healthy. */
+        while( ( pNetworkContext->pendingError == 0 ) &&
+               ( pNetworkContext->queuedOffset > pNetworkContext->sentOffset ) )
+        {
+            if( UringReactor_Poll( pReactor, pNetworkContext->sendTimeoutMs + 1U ) <= 0 )
+            {
+                break;
+            }
+        }
+
+        /* Shutting the socket down ends the multishot receive. */
+        ( void ) shutdown( pNetworkContext->socketDescriptor, SHUT_RDWR );
+
+        while( ( pNetworkContext->recvArmed == 1U ) || ( pNetworkContext->sendInFlight == 1U ) )
+        {
+            if( UringReactor_Poll( pReactor, DISCONNECT_DRAIN_TIMEOUT_MS ) <= 0 )
+            {
+                /* Late completions carry the old generation of the slot,
+                 * and are discarded. */
+                break;
+            }
+        }
+
+        /* Give unread receive buffers back to the reactor. */
+        while( pNetworkContext->recvCount > 0U )
+        {
+            recycleBuffer( pReactor, pNetworkContext->recvQueue[ pNetworkContext->recvHead ].bufferId );
+            pNetworkContext->recvHead = ( pNetworkContext->recvHead + 1U ) % URING_RECV_BUFFER_COUNT;
+            pNetworkContext->recvCount--;
+        }
+
+        publishBuffers( pReactor );
+
+        pReactor->pConnections[ pNetworkContext->slot ] = NULL;
+        pReactor->slotGenerations[ pNetworkContext->slot ]++;
+        pNetworkContext->pReactor = NULL;
+
+        returnStatus = convertToUringStatus( Sockets_Disconnect( pNetworkContext->socketDescriptor ) );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+int32_t Uring_Recv( NetworkContext_t * pNetworkContext,
+                    void * pBuffer,
+                    size_t bytesToRecv )
+{
+    int32_t bytesReceived = -1;
+    size_t copied = 0;
+    size_t chunk = 0;
+    uint8_t recycled = 0U;
+    UringReactor_t * pReactor = NULL;
+    UringRecvSlice_t * pSlice = NULL;
+
+    if( ( pNetworkContext == NULL ) || ( pNetworkContext->pReactor == NULL ) || ( pBuffer == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is not connected or pBuffer is NULL." ) );
+    }
+    else if( pNetworkContext->pendingError != 0 )
+    {
+        LogError( ( "Failed to receive data over network: %s.",
+                    strerror( -pNetworkContext->pendingError ) ) );
+    }
+    else
+    {
+        pReactor = pNetworkContext->pReactor;
+
+        if( ( pNetworkContext->recvCount == 0U ) && ( pNetworkContext->peerClosed == 0U ) )
+        {
+            /* Wait for this or any other connection of the reactor to make
+             * progress. Returning with no data is valid for the caller. */
+            ( void ) UringReactor_Poll( pReactor, pNetworkContext->recvTimeoutMs );
+        }
+
+        while( ( copied < bytesToRecv ) && ( pNetworkContext->recvCount > 0U ) )
+        {
+            pSlice = &pNetworkContext->recvQueue[ pNetworkContext->recvHead ];
+            chunk = bytesToRecv - copied;
+
+            if( chunk > pSlice->length )
+            {
+                chunk = pSlice->length;
+            }
+
+            ( void ) memcpy( &( ( uint8_t * ) pBuffer )[ copied ],
+                             &pReactor->pRecvBuffers[ ( ( size_t ) pSlice->bufferId * URING_RECV_BUFFER_SIZE ) + pSlice->offset ],
+                             chunk );
+
+            copied += chunk;
+            pSlice->offset += ( uint32_t ) chunk;
+            pSlice->length -= ( uint32_t ) chunk;
+
+            if( pSlice->length == 0U )
+            {
+                recycleBuffer( pReactor, pSlice->bufferId );
+                pNetworkContext->recvHead = ( pNetworkContext->recvHead + 1U ) % URING_RECV_BUFFER_COUNT;
+                pNetworkContext->recvCount--;
+                recycled = 1U;
+            }
+        }
+
+        if( recycled == 1U )
+        {
+            publishBuffers( pReactor );
+        }
+
+        if( pNetworkContext->pendingError != 0 )
+        {
+            LogError( ( "Failed to receive data over network: %s.",
+                        strerror( -pNetworkContext->pendingError ) ) );
+        }
+        else if( ( copied == 0U ) && ( pNetworkContext->peerClosed == 1U ) )
+        {
+            LogError( ( "Connection closed by the server." ) );
+        }
+        else
+        {
+            /* Re-arm a receive that stopped because the buffers ran out. */
+            if( ( pNetworkContext->recvArmed == 0U ) && ( pNetworkContext->peerClosed == 0U ) )
+            {
+                ( void ) armRecv( pNetworkContext );
+            }
+
+            bytesReceived = ( int32_t ) copied;
+        }
+    }
+
+    return bytesReceived;
+}
+/*-----------------------------------------------------------*/
+
+int32_t Uring_Send( NetworkContext_t * pNetworkContext,
+                    const void * pBuffer,
+                    size_t bytesToSend )
+{
+    int32_t bytesSent = -1;
+    size_t space = 0;
+    uint8_t * pSendBuffer = NULL;
+
+    if( ( pNetworkContext == NULL ) || ( pNetworkContext->pReactor == NULL ) || ( pBuffer == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is not connected or pBuffer is NULL." ) );
+    }
+    else if( pNetworkContext->pendingError != 0 )
+    {
+        LogError( ( "Failed to send data over network: %s.",
+                    strerror( -pNetworkContext->pendingError ) ) );
+    }
+    else
+    {
+        if( pNetworkContext->queuedOffset == URING_SEND_BUFFER_SIZE )
+        {
+            /* The send buffer is full. Let the reactor write some of it. */
+            ( void ) UringReactor_Poll( pNetworkContext->pReactor, pNetworkContext->sendTimeoutMs );
+        }
+
+        space = URING_SEND_BUFFER_SIZE - pNetworkContext->queuedOffset;
+
+        if( space > bytesToSend )
+        {
+            space = bytesToSend;
+        }
+
+        pSendBuffer = &pNetworkContext->pReactor->pSendBuffers[ ( size_t ) pNetworkContext->slot * URING_SEND_BUFFER_SIZE ];
+        ( void ) memcpy( &pSendBuffer[ pNetworkContext->queuedOffset ], pBuffer, space );
+        pNetworkContext->queuedOffset += ( uint32_t ) space;
+
+        /* Bytes queued behind an in-flight write go out when it completes. */
+        if( ( space > 0U ) && ( pNetworkContext->sendInFlight == 0U ) )
+        {
+            ( void ) queueWrite( pNetworkContext );
+        }
+
+        bytesSent = ( pNetworkContext->pendingError == 0 ) ? ( int32_t ) space : -1;
+    }
+
+    return bytesSent;
+}
+/*-----------------------------------------------------------*/
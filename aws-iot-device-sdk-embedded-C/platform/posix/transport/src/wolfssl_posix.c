@@ -27,6 +27,16 @@
 
 /* POSIX socket include. */
 #include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+
+#if defined( WOLFSSL_POSIX_KTLS ) && defined( __linux__ ) && !defined( AzureSpherePlatform )
+    /* Kernel TLS includes. */
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <sys/sendfile.h>
+    #include <linux/tls.h>
+#endif
 
 /* Transport interface include. */
 #include "transport_interface.h"
@@ -50,6 +60,102 @@
  */
 #define CLIENT_KEY_LABEL     "client's key"
 
+/**
+ * @brief Whether the linked wolfSSL can negotiate TLS 1.3.
+ *
+ * Azure Sphere keeps negotiating TLS 1.2 only, as it did before: its
+ * wolfSSL is part of the OS, like the session APIs below.
+ */
+#if defined( WOLFSSL_TLS13 ) && !defined( AzureSpherePlatform )
+    #define WOLFSSL_POSIX_TLS13_SUPPORTED         1
+#else
+    #define WOLFSSL_POSIX_TLS13_SUPPORTED         0
+#endif
+
+/**
+ * @brief Whether sessions can be exported for resumption.
+ *
+ * wolfSSL on Azure Sphere platform does not include the session APIs due to
+ * ABI consideration.
+ */
+#if !defined( NO_SESSION_CACHE ) && !defined( AzureSpherePlatform )
+    #define WOLFSSL_POSIX_RESUMPTION_SUPPORTED    1
+#else
+    #define WOLFSSL_POSIX_RESUMPTION_SUPPORTED    0
+#endif
+
+/**
+ * @brief Whether 0-RTT early data can be sent on a resumed TLS 1.3 session.
+ */
+#if ( WOLFSSL_POSIX_TLS13_SUPPORTED == 1 ) && ( WOLFSSL_POSIX_RESUMPTION_SUPPORTED == 1 ) && defined( WOLFSSL_EARLY_DATA )
+    #define WOLFSSL_POSIX_EARLY_DATA_SUPPORTED    1
+#else
+    #define WOLFSSL_POSIX_EARLY_DATA_SUPPORTED    0
+#endif
+
+/**
+ * @brief Whether record encryption can be offloaded to Linux kernel TLS.
+ */
+#if defined( WOLFSSL_POSIX_KTLS ) && defined( __linux__ ) && !defined( AzureSpherePlatform )
+    #define WOLFSSL_POSIX_KTLS_SUPPORTED          1
+#else
+    #define WOLFSSL_POSIX_KTLS_SUPPORTED          0
+#endif
+
+/**
+ * @brief Whether TLS sessions can be allocated from a static memory pool.
+ */
+#if defined( WOLFSSL_STATIC_MEMORY ) && !defined( AzureSpherePlatform )
+    #define WOLFSSL_POSIX_STATIC_MEMORY_SUPPORTED    1
+#else
+    #define WOLFSSL_POSIX_STATIC_MEMORY_SUPPORTED    0
+#endif
+
+/**
+ * @brief Bit of NetworkContext.ktlsFlags set when sends are encrypted by the kernel.
+ */
+#define KTLS_FLAG_TX                 0x01U
+
+/**
+ * @brief Bit of NetworkContext.ktlsFlags set when receives are decrypted by the kernel.
+ */
+#define KTLS_FLAG_RX                 0x02U
+
+/**
+ * @brief TLS record content type of alerts.
+ */
+#define TLS_RECORD_TYPE_ALERT        21U
+
+/**
+ * @brief TLS record content type of application data.
+ */
+#define TLS_RECORD_TYPE_DATA         23U
+
+/**
+ * @brief Size of the buffer used by #Wolfssl_SendFile when the file has to
+ * pass through wolfSSL.
+ */
+#ifndef WOLFSSL_POSIX_SENDFILE_CHUNK_SIZE
+    #define WOLFSSL_POSIX_SENDFILE_CHUNK_SIZE    4096U
+#endif
+
+/*-----------------------------------------------------------*/
+
+#if ( WOLFSSL_POSIX_KTLS_SUPPORTED == 1 )
+
+/**
+ * @brief Kernel TLS crypto parameters for the cipher suites it supports.
+ */
+    typedef union KtlsCryptoInfo
+    {
+        struct tls_crypto_info info;                          /**< @brief Common header. */
+        struct tls12_crypto_info_aes_gcm_128 aesGcm128;       /**< @brief TLS_AES_128_GCM suites. */
+        struct tls12_crypto_info_aes_gcm_256 aesGcm256;       /**< @brief TLS_AES_256_GCM suites. */
+        struct tls12_crypto_info_chacha20_poly1305 chacha20;  /**< @brief TLS_CHACHA20_POLY1305 suites. */
+    } KtlsCryptoInfo_t;
+
+#endif
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -122,6 +228,186 @@ static int32_t setCredentials( WOLFSSL_CTX * pSslContext,
 static void setOptionalConfigurations( WOLFSSL * pSsl,
                                        const WolfsslCredentials_t * pWolfsslCredentials );
 
+/**
+ * @brief Select the client method for the requested TLS version.
+ *
+ * @param[in] tlsVersion Requested TLS version.
+ *
+ * @return The client method; NULL if the version is not supported by the
+ * linked wolfSSL.
+ */
+static WOLFSSL_METHOD * selectClientMethod( WolfsslTlsVersion_t tlsVersion );
+
+/**
+ * @brief Raise the minimum TLS version and load the credentials into an SSL
+ * context.
+ *
+ * @param[in] pSslContext SSL context to configure.
+ * @param[in] pWolfsslCredentials TLS setup parameters.
+ *
+ * @return #WOLFSSL_SUCCEED on success; #WOLFSSL_API_ERROR or
+ * #WOLFSSL_INVALID_CREDENTIALS on failure.
+ */
+static WolfsslStatus_t configureContext( WOLFSSL_CTX * pSslContext,
+                                         const WolfsslCredentials_t * pWolfsslCredentials );
+
+/**
+ * @brief Make sure a static memory pool holds a configured SSL context.
+ *
+ * The context is created inside the pool by the first connection.
+ *
+ * @param[in] pMemoryPool Pool to allocate from.
+ * @param[in] pWolfsslCredentials TLS setup parameters.
+ *
+ * @return #WOLFSSL_SUCCEED on success; #WOLFSSL_INVALID_PARAMETER if static
+ * memory is not supported, #WOLFSSL_INSUFFICIENT_MEMORY, #WOLFSSL_API_ERROR or
+ * #WOLFSSL_INVALID_CREDENTIALS on failure.
+ */
+static WolfsslStatus_t acquirePoolContext( WolfsslMemoryPool_t * pMemoryPool,
+                                           const WolfsslCredentials_t * pWolfsslCredentials );
+
+/**
+ * @brief Fold the memory use of a connection into the high-water marks of its
+ * static memory pool.
+ *
+ * @param[in] pNetworkContext Network context of the connection.
+ */
+static void recordMemoryPeak( const NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Replace the session stored in the resumption state with the current
+ * session of the connection.
+ *
+ * @param[in] pNetworkContext Network context of the connection.
+ */
+static void storeSession( const NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Create the SSL object of a connection on its connected socket.
+ *
+ * Sets up the credentials, offers the stored session for resumption and
+ * applies the optional configurations. The SSL object is freed on failure.
+ *
+ * @param[in] pNetworkContext Network context with a connected socket.
+ * @param[in] pWolfsslCredentials TLS setup parameters.
+ *
+ * @return #WOLFSSL_SUCCEED on success; #WOLFSSL_API_ERROR or
+ * #WOLFSSL_INVALID_CREDENTIALS on failure.
+ */
+static WolfsslStatus_t createSslObject( NetworkContext_t * pNetworkContext,
+                                        const WolfsslCredentials_t * pWolfsslCredentials );
+
+/**
+ * @brief Verify the server certificate once wolfSSL_connect has succeeded.
+ *
+ * Records whether the stored session was resumed, stores the new session and
+ * enables kTLS if requested.
+ *
+ * @param[in] pNetworkContext Network context of the connection.
+ *
+ * @return #WOLFSSL_SUCCEED on success; #WOLFSSL_HANDSHAKE_FAILED on failure.
+ */
+static WolfsslStatus_t completeHandshake( NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Perform the TLS handshake and verify the server certificate.
+ *
+ * @param[in] pNetworkContext Network context of the connection.
+ *
+ * @return #WOLFSSL_SUCCEED on success; #WOLFSSL_HANDSHAKE_FAILED on failure.
+ */
+static WolfsslStatus_t performHandshake( NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Send the first flight as 0-RTT early data and complete the deferred
+ * handshake.
+ *
+ * @param[in] pNetworkContext Network context of the connection.
+ * @param[in] pBuffer Buffer containing the first flight.
+ * @param[in] bytesToSend Number of bytes in the first flight.
+ *
+ * @return @p bytesToSend if the server accepted the early data; 0 if the data
+ * still has to be sent with wolfSSL_write; negative value on error.
+ */
+#if ( WOLFSSL_POSIX_EARLY_DATA_SUPPORTED == 1 )
+    static int32_t sendEarlyData( NetworkContext_t * pNetworkContext,
+                                  const void * pBuffer,
+                                  size_t bytesToSend );
+#endif
+
+#if ( WOLFSSL_POSIX_KTLS_SUPPORTED == 1 )
+
+/**
+ * @brief Fill the kernel TLS parameters of one direction from the traffic
+ * keys negotiated by wolfSSL.
+ *
+ * @param[in] pSsl Connection that completed its handshake.
+ * @param[in] pKey Traffic key of the direction.
+ * @param[in] pIv Static IV of the direction.
+ * @param[in] sequenceNumber Sequence number of the next record of the direction.
+ * @param[out] pCryptoInfo Kernel TLS parameters.
+ * @param[out] pCryptoInfoLength Size of the parameters of the negotiated cipher.
+ *
+ * @return 1 on success; 0 if the negotiated version or cipher cannot be offloaded.
+ */
+    static int32_t buildCryptoInfo( WOLFSSL * pSsl,
+                                    const uint8_t * pKey,
+                                    const uint8_t * pIv,
+                                    uint64_t sequenceNumber,
+                                    KtlsCryptoInfo_t * pCryptoInfo,
+                                    socklen_t * pCryptoInfoLength );
+
+/**
+ * @brief Offload record encryption of the directions requested in the
+ * network context to kernel TLS.
+ *
+ * Failures are not fatal: a direction that cannot be offloaded stays in
+ * wolfSSL.
+ *
+ * @param[in] pNetworkContext Network context of a connection that completed
+ * its handshake.
+ */
+    static void enableKtls( NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Receive application data decrypted by kernel TLS.
+ *
+ * @param[in] pNetworkContext Network context with an offloaded receive direction.
+ * @param[out] pBuffer Buffer to receive into.
+ * @param[in] bytesToRecv Size of @p pBuffer.
+ *
+ * @return Number of bytes received; 0 if no application data is available;
+ * negative value on error.
+ */
+    static int32_t ktlsRecv( const NetworkContext_t * pNetworkContext,
+                             void * pBuffer,
+                             size_t bytesToRecv );
+
+/**
+ * @brief Send a close_notify alert through kernel TLS.
+ *
+ * @param[in] pNetworkContext Network context with an offloaded send direction.
+ */
+    static void ktlsSendCloseNotify( const NetworkContext_t * pNetworkContext );
+
+#endif /* if ( WOLFSSL_POSIX_KTLS_SUPPORTED == 1 ) */
+
+/**
+ * @brief Send with the socket API on a connection whose sends are encrypted
+ * by kernel TLS.
+ *
+ * @param[in] pNetworkContext Network context with an offloaded send direction.
+ * @param[in] pBuffer Buffer to send.
+ * @param[in] bytesToSend Number of bytes to send.
+ *
+ * @return Number of bytes sent; 0 if the buffer of a non-blocking socket is
+ * full; negative value on error, including the send timeout of a blocking
+ * socket.
+ */
+static int32_t ktlsSend( const NetworkContext_t * pNetworkContext,
+                         const void * pBuffer,
+                         size_t bytesToSend );
+
 /**
  * @brief Converts the sockets wrapper status to wolfssl status.
  *
@@ -392,58 +678,64 @@ static void setOptionalConfigurations( WOLFSSL * pSsl,
 }
 /*-----------------------------------------------------------*/
 
-WolfsslStatus_t Wolfssl_Connect( NetworkContext_t * pNetworkContext,
-                                 const ServerInfo_t * pServerInfo,
-                                 const WolfsslCredentials_t * pWolfsslCredentials,
-                                 uint32_t sendTimeoutMs,
-                                 uint32_t recvTimeoutMs )
+static WOLFSSL_METHOD * selectClientMethod( WolfsslTlsVersion_t tlsVersion )
 {
-    SocketStatus_t socketStatus = SOCKETS_SUCCESS;
-    WolfsslStatus_t returnStatus = WOLFSSL_SUCCEED;
-    int32_t sslStatus = 0;
-    uint8_t sslObjectCreated = 0;
-    WOLFSSL_CTX *pSslContext = NULL;
-    int ret = WOLFSSL_FAILURE;
+    WOLFSSL_METHOD * pMethod = NULL;
 
-    /* Validate parameters. */
-    if( pNetworkContext == NULL )
-    {
-        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
-        returnStatus = WOLFSSL_INVALID_PARAMETER;
-    }
-    else if( pWolfsslCredentials == NULL )
-    {
-        LogError( ( "Parameter check failed: pWolfsslCredentials is NULL." ) );
-        returnStatus = WOLFSSL_INVALID_PARAMETER;
-    }
-    else
+    switch( tlsVersion )
     {
-        /* Empty else. */
-    }
+        case WOLFSSL_POSIX_TLS_1_2:
+            pMethod = wolfTLSv1_2_client_method();
+            break;
 
-    /* Establish the TCP connection. */
-    if( returnStatus == WOLFSSL_SUCCEED)
-    {
-        socketStatus = Sockets_Connect( &pNetworkContext->socketDescriptor,
-                                        pServerInfo,
-                                        sendTimeoutMs,
-                                        recvTimeoutMs );
+        case WOLFSSL_POSIX_TLS_1_3:
+            #if ( WOLFSSL_POSIX_TLS13_SUPPORTED == 1 )
+                pMethod = wolfTLSv1_3_client_method();
+            #else
+                LogError( ( "TLS 1.3 requested but wolfSSL was built without WOLFSSL_TLS13." ) );
+            #endif
+            break;
 
-        /* Convert socket wrapper status to wolfssl status. */
-        returnStatus = convertToWolfsslStatus( socketStatus );
+        default:
+            #if ( WOLFSSL_POSIX_TLS13_SUPPORTED == 1 )
+                /* Offer the highest version and let the server pick. The
+                 * minimum version is raised to TLS 1.2 by the caller. */
+                pMethod = wolfSSLv23_client_method();
+            #else
+                pMethod = wolfTLSv1_2_client_method();
+            #endif
+            break;
     }
 
-    /* Create SSL context. */
-    if( returnStatus == WOLFSSL_SUCCEED )
-    {
-        pSslContext = wolfSSL_CTX_new( wolfTLSv1_2_client_method() );
+    return pMethod;
+}
+/*-----------------------------------------------------------*/
 
-        if( pSslContext == NULL )
+static WolfsslStatus_t configureContext( WOLFSSL_CTX * pSslContext,
+                                         const WolfsslCredentials_t * pWolfsslCredentials )
+{
+    WolfsslStatus_t returnStatus = WOLFSSL_SUCCEED;
+    int32_t sslStatus = 0;
+    int ret = WOLFSSL_FAILURE;
+
+    assert( pSslContext != NULL );
+    assert( pWolfsslCredentials != NULL );
+
+    #if ( WOLFSSL_POSIX_TLS13_SUPPORTED == 1 )
+        /* Do not let the version negotiation fall back below TLS 1.2. */
+        if( pWolfsslCredentials->tlsVersion == WOLFSSL_POSIX_TLS_AUTO )
         {
-            LogError( ( "Creation of a new WOLFSSL_CTX object failed." ) );
-            returnStatus = WOLFSSL_API_ERROR;
+            ret = wolfSSL_CTX_SetMinVersion( pSslContext, WOLFSSL_TLSV1_2 );
+
+            if( ret != WOLFSSL_SUCCESS )
+            {
+                LogError( ( "Failed to set the minimum TLS version." ) );
+                returnStatus = WOLFSSL_API_ERROR;
+            }
         }
-    }
+    #else
+        ( void ) ret;
+    #endif
 
     /* Setup credentials. */
     if( returnStatus == WOLFSSL_SUCCEED)
@@ -461,85 +753,901 @@ WolfsslStatus_t Wolfssl_Connect( NetworkContext_t * pNetworkContext,
         }
     }
 
-    /* Create a new SSL session. */
-    if( returnStatus == WOLFSSL_SUCCEED )
-    {
-        pNetworkContext->pSsl = wolfSSL_new( pSslContext );
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
 
-        if( pNetworkContext->pSsl == NULL )
+static WolfsslStatus_t acquirePoolContext( WolfsslMemoryPool_t * pMemoryPool,
+                                           const WolfsslCredentials_t * pWolfsslCredentials )
+{
+    WolfsslStatus_t returnStatus = WOLFSSL_SUCCEED;
+
+    assert( pMemoryPool != NULL );
+    assert( pWolfsslCredentials != NULL );
+
+    #if ( WOLFSSL_POSIX_STATIC_MEMORY_SUPPORTED == 1 )
+        wolfSSL_method_func method = NULL;
+        int ret = WOLFSSL_FAILURE;
+
+        if( pMemoryPool->pSslContext != NULL )
         {
-            LogError( ( "SSL_new failed to create a new SSL context." ) );
-            returnStatus = WOLFSSL_API_ERROR;
+            /* Reuse the context and the credentials already loaded into it. */
         }
-        else
+        else if( ( pMemoryPool->pBuffer == NULL ) ||
+                 ( pMemoryPool->bufferSize == 0U ) ||
+                 ( pMemoryPool->maxConnections == 0U ) ||
+                 ( ( pMemoryPool->pIoBuffer != NULL ) && ( pMemoryPool->ioBufferSize == 0U ) ) )
         {
-            sslObjectCreated = 1u;
+            LogError( ( "Parameter check failed: memory pool has no buffer or no connections." ) );
+            returnStatus = WOLFSSL_INVALID_PARAMETER;
         }
-    }
-
-    /* Setup the socket to use for communication. */
-    if( returnStatus == WOLFSSL_SUCCEED )
-    {
+        else
+        {
+            switch( pWolfsslCredentials->tlsVersion )
+            {
+                case WOLFSSL_POSIX_TLS_1_2:
+                    method = wolfTLSv1_2_client_method_ex;
+                    break;
+
+                case WOLFSSL_POSIX_TLS_1_3:
+                    #if ( WOLFSSL_POSIX_TLS13_SUPPORTED == 1 )
+                        method = wolfTLSv1_3_client_method_ex;
+                    #else
+                        LogError( ( "TLS 1.3 requested but wolfSSL was built without WOLFSSL_TLS13." ) );
+                    #endif
+                    break;
+
+                default:
+                    #if ( WOLFSSL_POSIX_TLS13_SUPPORTED == 1 )
+                        method = wolfSSLv23_client_method_ex;
+                    #else
+                        method = wolfTLSv1_2_client_method_ex;
+                    #endif
+                    break;
+            }
 
-#if !defined( AzureSpherePlatform )
-        /* wolfSSL on Azure Sphere platform does not include wolfSSL_CTX_set_verify due to ABI consideration */
+            if( method == NULL )
+            {
+                returnStatus = WOLFSSL_API_ERROR;
+            }
+            else
+            {
+                /* Track per-connection statistics for the high-water marks. */
+                ret = wolfSSL_CTX_load_static_memory( &pMemoryPool->pSslContext,
+                                                      method,
+                                                      pMemoryPool->pBuffer,
+                                                      pMemoryPool->bufferSize,
+                                                      WOLFMEM_GENERAL | WOLFMEM_TRACK_STATS,
+                                                      ( int ) pMemoryPool->maxConnections );
+
+                if( ret != WOLFSSL_SUCCESS )
+                {
+                    LogError( ( "Failed to set up the static memory pool of %u bytes.",
+                                ( unsigned int ) pMemoryPool->bufferSize ) );
+                    returnStatus = WOLFSSL_INSUFFICIENT_MEMORY;
+                }
+            }
 
-        wolfSSL_CTX_set_verify( pNetworkContext->pSsl, WOLFSSL_VERIFY_PEER, NULL );
-#endif
+            if( ( returnStatus == WOLFSSL_SUCCEED ) && ( pMemoryPool->pIoBuffer != NULL ) )
+            {
+                ret = wolfSSL_CTX_load_static_memory( &pMemoryPool->pSslContext,
+                                                      NULL,
+                                                      pMemoryPool->pIoBuffer,
+                                                      pMemoryPool->ioBufferSize,
+                                                      WOLFMEM_IO_POOL_FIXED | WOLFMEM_TRACK_STATS,
+                                                      ( int ) pMemoryPool->maxConnections );
+
+                if( ret != WOLFSSL_SUCCESS )
+                {
+                    LogError( ( "Failed to set up the static I/O pool of %u bytes.",
+                                ( unsigned int ) pMemoryPool->ioBufferSize ) );
+                    returnStatus = WOLFSSL_INSUFFICIENT_MEMORY;
+                }
+            }
 
-        ret = wolfSSL_set_fd( pNetworkContext->pSsl, pNetworkContext->socketDescriptor );
+            if( returnStatus == WOLFSSL_SUCCEED )
+            {
+                returnStatus = configureContext( pMemoryPool->pSslContext, pWolfsslCredentials );
+            }
 
-        if( ret != WOLFSSL_SUCCESS )
-        {
-            LogError( ( "Failed to set the socket fd to SSL context." ) );
-            returnStatus = WOLFSSL_API_ERROR;
+            if( ( returnStatus != WOLFSSL_SUCCEED ) && ( pMemoryPool->pSslContext != NULL ) )
+            {
+                wolfSSL_CTX_free( pMemoryPool->pSslContext );
+                pMemoryPool->pSslContext = NULL;
+            }
         }
-    }
+    #else /* if ( WOLFSSL_POSIX_STATIC_MEMORY_SUPPORTED == 1 ) */
+        LogError( ( "Memory pool requested but wolfSSL was built without WOLFSSL_STATIC_MEMORY." ) );
+        returnStatus = WOLFSSL_INVALID_PARAMETER;
+    #endif /* if ( WOLFSSL_POSIX_STATIC_MEMORY_SUPPORTED == 1 ) */
 
-    /* Perform the TLS handshake. */
-    if( returnStatus == WOLFSSL_SUCCEED )
-    {
-        setOptionalConfigurations( pNetworkContext->pSsl, pWolfsslCredentials );
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
 
-        ret = wolfSSL_connect( pNetworkContext->pSsl );
+static void recordMemoryPeak( const NetworkContext_t * pNetworkContext )
+{
+    assert( pNetworkContext != NULL );
 
-        if( ret != WOLFSSL_SUCCESS )
+    #if ( WOLFSSL_POSIX_STATIC_MEMORY_SUPPORTED == 1 )
+        WOLFSSL_MEM_CONN_STATS connectionStats;
+        WolfsslMemoryPool_t * pMemoryPool = pNetworkContext->pMemoryPool;
+
+        if( ( pMemoryPool != NULL ) && ( pNetworkContext->pSsl != NULL ) &&
+            ( wolfSSL_is_static_memory( pNetworkContext->pSsl, &connectionStats ) == 1 ) )
         {
-            LogError( ( "Failed to perform TLS handshake, error = %d.", 
-                        wolfSSL_get_error( pNetworkContext->pSsl, ret ) ) );
-            returnStatus = WOLFSSL_HANDSHAKE_FAILED;
+            if( connectionStats.peakMem > pMemoryPool->peakConnectionBytes )
+            {
+                pMemoryPool->peakConnectionBytes = connectionStats.peakMem;
+            }
+
+            if( connectionStats.peakAlloc > pMemoryPool->peakConnectionAllocations )
+            {
+                pMemoryPool->peakConnectionAllocations = connectionStats.peakAlloc;
+            }
         }
-    }
+    #else
+        ( void ) pNetworkContext;
+    #endif
+}
+/*-----------------------------------------------------------*/
 
-    /* Verify X509 certificate from peer. */
-    if( returnStatus == WOLFSSL_SUCCEED )
-    {
-#if !defined( AzureSpherePlatform )
-        /* wolfSSL on Azure Sphere platform does not include wolfSSL_get_verify_result due to ABI consideration */
+static void storeSession( const NetworkContext_t * pNetworkContext )
+{
+    #if ( WOLFSSL_POSIX_RESUMPTION_SUPPORTED == 1 )
+        WOLFSSL_SESSION * pSession = NULL;
 
-        long verifyPeerCertStatus = wolfSSL_get_verify_result( pNetworkContext->pSsl );
+        assert( pNetworkContext != NULL );
 
-        if( verifyPeerCertStatus != X509_V_OK )
+        if( ( pNetworkContext->pResumption != NULL ) &&
+            ( pNetworkContext->pSsl != NULL ) &&
+            ( pNetworkContext->handshakePending == 0U ) )
         {
-            LogError( ( "Failed to verify X509 certificate from peer." ) );
-            returnStatus = WOLFSSL_HANDSHAKE_FAILED;
-        }
-#endif
-    }
+            pSession = wolfSSL_get1_session( pNetworkContext->pSsl );
 
-    /* Free the SSL context. */
-    if( pSslContext != NULL )
-    {
-        wolfSSL_CTX_free( pSslContext );
+            /* Keep the previous session when the connection has none, e.g.
+             * when the TLS 1.3 ticket has not been received yet. */
+            if( pSession != NULL )
+            {
+                if( pNetworkContext->pResumption->pSession != NULL )
+                {
+                    wolfSSL_SESSION_free( pNetworkContext->pResumption->pSession );
+                }
+
+                pNetworkContext->pResumption->pSession = pSession;
+            }
+        }
+    #else
+        ( void ) pNetworkContext;
+    #endif /* if ( WOLFSSL_POSIX_RESUMPTION_SUPPORTED == 1 ) */
+}
+/*-----------------------------------------------------------*/
+
+static WolfsslStatus_t createSslObject( NetworkContext_t * pNetworkContext,
+                                        const WolfsslCredentials_t * pWolfsslCredentials )
+{
+    WolfsslStatus_t returnStatus = WOLFSSL_SUCCEED;
+    WOLFSSL_CTX *pSslContext = NULL;
+    WOLFSSL_METHOD * pMethod = NULL;
+    int ret = WOLFSSL_FAILURE;
+
+    assert( pNetworkContext != NULL );
+    assert( pWolfsslCredentials != NULL );
+
+    if( pWolfsslCredentials->pMemoryPool != NULL )
+    {
+        /* The context lives in the pool and is shared by its connections. */
+        returnStatus = acquirePoolContext( pWolfsslCredentials->pMemoryPool,
+                                           pWolfsslCredentials );
+    }
+    else
+    {
+        /* Create SSL context. */
+        pMethod = selectClientMethod( pWolfsslCredentials->tlsVersion );
+
+        if( pMethod != NULL )
+        {
+            pSslContext = wolfSSL_CTX_new( pMethod );
+        }
+
+        if( pSslContext == NULL )
+        {
+            LogError( ( "Creation of a new WOLFSSL_CTX object failed." ) );
+            returnStatus = WOLFSSL_API_ERROR;
+        }
+        else
+        {
+            returnStatus = configureContext( pSslContext, pWolfsslCredentials );
+        }
+    }
+
+    /* Create a new SSL session. */
+    if( returnStatus == WOLFSSL_SUCCEED )
+    {
+        pNetworkContext->pSsl = wolfSSL_new( ( pSslContext != NULL ) ?
+                                             pSslContext :
+                                             pWolfsslCredentials->pMemoryPool->pSslContext );
+
+        if( pNetworkContext->pSsl == NULL )
+        {
+            LogError( ( "SSL_new failed to create a new SSL context." ) );
+            returnStatus = WOLFSSL_API_ERROR;
+        }
+    }
+
+    /* Setup the socket to use for communication. */
+    if( returnStatus == WOLFSSL_SUCCEED )
+    {
+
+#if !defined( AzureSpherePlatform )
+        /* wolfSSL on Azure Sphere platform does not include wolfSSL_CTX_set_verify due to ABI consideration */
+
+        wolfSSL_CTX_set_verify( pNetworkContext->pSsl, WOLFSSL_VERIFY_PEER, NULL );
+#endif
+
+        ret = wolfSSL_set_fd( pNetworkContext->pSsl, pNetworkContext->socketDescriptor );
+
+        if( ret != WOLFSSL_SUCCESS )
+        {
+            LogError( ( "Failed to set the socket fd to SSL context." ) );
+            returnStatus = WOLFSSL_API_ERROR;
+        }
+    }
+
+    /* Offer the stored session for resumption. */
+    #if ( WOLFSSL_POSIX_RESUMPTION_SUPPORTED == 1 )
+        if( ( returnStatus == WOLFSSL_SUCCEED ) &&
+            ( pNetworkContext->pResumption != NULL ) )
+        {
+            pNetworkContext->pResumption->resumed = 0U;
+            pNetworkContext->pResumption->earlyDataAccepted = 0U;
+
+            if( pNetworkContext->pResumption->pSession != NULL )
+            {
+                ret = wolfSSL_set_session( pNetworkContext->pSsl,
+                                           pNetworkContext->pResumption->pSession );
+
+                if( ret != WOLFSSL_SUCCESS )
+                {
+                    /* An expired or foreign session only costs a full handshake. */
+                    LogWarn( ( "Failed to set the stored session, performing a full handshake." ) );
+                }
+            }
+        }
+    #endif /* if ( WOLFSSL_POSIX_RESUMPTION_SUPPORTED == 1 ) */
+
+    if( returnStatus == WOLFSSL_SUCCEED )
+    {
+        setOptionalConfigurations( pNetworkContext->pSsl, pWolfsslCredentials );
+    }
+
+    /* Free the SSL context. A pooled context is kept until the pool is freed. */
+    if( pSslContext != NULL )
+    {
+        wolfSSL_CTX_free( pSslContext );
     }
 
     /* Clean up on error. */
-    if( ( returnStatus != WOLFSSL_SUCCEED ) && ( sslObjectCreated == 1u ) )
+    if( ( returnStatus != WOLFSSL_SUCCEED ) && ( pNetworkContext->pSsl != NULL ) )
     {
         wolfSSL_free( pNetworkContext->pSsl );
         pNetworkContext->pSsl = NULL;
     }
 
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static WolfsslStatus_t completeHandshake( NetworkContext_t * pNetworkContext )
+{
+    WolfsslStatus_t returnStatus = WOLFSSL_SUCCEED;
+
+    assert( pNetworkContext != NULL );
+    assert( pNetworkContext->pSsl != NULL );
+
+    /* Verify X509 certificate from peer. */
+#if !defined( AzureSpherePlatform )
+    /* wolfSSL on Azure Sphere platform does not include wolfSSL_get_verify_result due to ABI consideration */
+
+    long verifyPeerCertStatus = wolfSSL_get_verify_result( pNetworkContext->pSsl );
+
+    if( verifyPeerCertStatus != X509_V_OK )
+    {
+        LogError( ( "Failed to verify X509 certificate from peer." ) );
+        returnStatus = WOLFSSL_HANDSHAKE_FAILED;
+    }
+#endif
+
+    if( returnStatus == WOLFSSL_SUCCEED )
+    {
+        #if ( WOLFSSL_POSIX_RESUMPTION_SUPPORTED == 1 )
+            if( pNetworkContext->pResumption != NULL )
+            {
+                pNetworkContext->pResumption->resumed =
+                    ( wolfSSL_session_reused( pNetworkContext->pSsl ) == 1 ) ? 1U : 0U;
+
+                LogDebug( ( "TLS handshake completed: version=%s, resumed=%u.",
+                            wolfSSL_get_version( pNetworkContext->pSsl ),
+                            pNetworkContext->pResumption->resumed ) );
+            }
+        #endif
+
+        storeSession( pNetworkContext );
+        recordMemoryPeak( pNetworkContext );
+
+        #if ( WOLFSSL_POSIX_KTLS_SUPPORTED == 1 )
+            enableKtls( pNetworkContext );
+        #endif
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static WolfsslStatus_t performHandshake( NetworkContext_t * pNetworkContext )
+{
+    WolfsslStatus_t returnStatus = WOLFSSL_SUCCEED;
+    int ret = WOLFSSL_FAILURE;
+
+    assert( pNetworkContext != NULL );
+    assert( pNetworkContext->pSsl != NULL );
+
+    pNetworkContext->handshakePending = 0U;
+
+    ret = wolfSSL_connect( pNetworkContext->pSsl );
+
+    if( ret != WOLFSSL_SUCCESS )
+    {
+        LogError( ( "Failed to perform TLS handshake, error = %d.",
+                    wolfSSL_get_error( pNetworkContext->pSsl, ret ) ) );
+        returnStatus = WOLFSSL_HANDSHAKE_FAILED;
+    }
+    else
+    {
+        returnStatus = completeHandshake( pNetworkContext );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+#if ( WOLFSSL_POSIX_EARLY_DATA_SUPPORTED == 1 )
+    static int32_t sendEarlyData( NetworkContext_t * pNetworkContext,
+                                  const void * pBuffer,
+                                  size_t bytesToSend )
+    {
+        int32_t bytesSent = 0;
+        int earlyDataSent = 0;
+        int ret = WOLFSSL_FAILURE;
+
+        assert( pNetworkContext != NULL );
+        assert( pNetworkContext->pResumption != NULL );
+
+        /* The ClientHello and the early data leave in the same flight. */
+        ret = wolfSSL_write_early_data( pNetworkContext->pSsl,
+                                        pBuffer,
+                                        ( int ) bytesToSend,
+                                        &earlyDataSent );
+
+        if( ret < 0 )
+        {
+            /* The session does not allow early data; wolfSSL_connect below
+             * still completes a regular resumption. */
+            LogWarn( ( "Failed to send early data, error = %d.",
+                       wolfSSL_get_error( pNetworkContext->pSsl, ret ) ) );
+            earlyDataSent = 0;
+        }
+
+        if( performHandshake( pNetworkContext ) != WOLFSSL_SUCCEED )
+        {
+            bytesSent = -1;
+        }
+        else if( ( earlyDataSent == ( int ) bytesToSend ) &&
+                 ( wolfSSL_get_early_data_status( pNetworkContext->pSsl ) == WOLFSSL_EARLY_DATA_ACCEPTED ) )
+        {
+            pNetworkContext->pResumption->earlyDataAccepted = 1U;
+            bytesSent = ( int32_t ) bytesToSend;
+        }
+        else
+        {
+            /* The server discarded the early data, so the caller's data is
+             * sent again in the first 1-RTT record. */
+            LogDebug( ( "Early data was not accepted by the server." ) );
+        }
+
+        return bytesSent;
+    }
+    /*-----------------------------------------------------------*/
+#endif /* if ( WOLFSSL_POSIX_EARLY_DATA_SUPPORTED == 1 ) */
+
+#if ( WOLFSSL_POSIX_KTLS_SUPPORTED == 1 )
+    static int32_t buildCryptoInfo( WOLFSSL * pSsl,
+                                    const uint8_t * pKey,
+                                    const uint8_t * pIv,
+                                    uint64_t sequenceNumber,
+                                    KtlsCryptoInfo_t * pCryptoInfo,
+                                    socklen_t * pCryptoInfoLength )
+    {
+        int32_t status = 1;
+        int version = wolfSSL_version( pSsl );
+        int bulkCipher = wolfSSL_GetBulkCipher( pSsl );
+        int keySize = wolfSSL_GetKeySize( pSsl );
+        uint8_t recordSequence[ 8 ];
+        uint8_t explicitIv[ 8 ];
+        const uint8_t * pKernelIv = NULL;
+        size_t i = 0U;
+
+        ( void ) memset( pCryptoInfo, 0, sizeof( KtlsCryptoInfo_t ) );
+
+        /* Record sequence numbers are big-endian on the wire. */
+        for( i = 0U; i < sizeof( recordSequence ); i++ )
+        {
+            recordSequence[ i ] = ( uint8_t ) ( sequenceNumber >> ( 56U - ( 8U * i ) ) );
+        }
+
+        /* TLS 1.2 AES-GCM carries an explicit nonce in every record, which
+         * only has to be unique; the sequence number is used as is done by
+         * other TLS stacks. TLS 1.3 derives the nonce from the IV. */
+        if( version == TLS_1_2_VERSION )
+        {
+            ( void ) memcpy( explicitIv, recordSequence, sizeof( explicitIv ) );
+            pKernelIv = explicitIv;
+        }
+        else if( version == TLS_1_3_VERSION )
+        {
+            pKernelIv = &pIv[ TLS_CIPHER_AES_GCM_128_SALT_SIZE ];
+        }
+        else
+        {
+            LogInfo( ( "Kernel TLS does not support TLS version 0x%04x.", version ) );
+            status = 0;
+        }
+
+        if( status == 0 )
+        {
+            /* Empty if. */
+        }
+        else if( ( bulkCipher == wolfssl_aes_gcm ) && ( keySize == TLS_CIPHER_AES_GCM_128_KEY_SIZE ) )
+        {
+            pCryptoInfo->info.cipher_type = TLS_CIPHER_AES_GCM_128;
+            ( void ) memcpy( pCryptoInfo->aesGcm128.key, pKey, TLS_CIPHER_AES_GCM_128_KEY_SIZE );
+            ( void ) memcpy( pCryptoInfo->aesGcm128.salt, pIv, TLS_CIPHER_AES_GCM_128_SALT_SIZE );
+            ( void ) memcpy( pCryptoInfo->aesGcm128.iv, pKernelIv, TLS_CIPHER_AES_GCM_128_IV_SIZE );
+            ( void ) memcpy( pCryptoInfo->aesGcm128.rec_seq, recordSequence, TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE );
+            *pCryptoInfoLength = ( socklen_t ) sizeof( pCryptoInfo->aesGcm128 );
+        }
+        else if( ( bulkCipher == wolfssl_aes_gcm ) && ( keySize == TLS_CIPHER_AES_GCM_256_KEY_SIZE ) )
+        {
+            pCryptoInfo->info.cipher_type = TLS_CIPHER_AES_GCM_256;
+            ( void ) memcpy( pCryptoInfo->aesGcm256.key, pKey, TLS_CIPHER_AES_GCM_256_KEY_SIZE );
+            ( void ) memcpy( pCryptoInfo->aesGcm256.salt, pIv, TLS_CIPHER_AES_GCM_256_SALT_SIZE );
+            ( void ) memcpy( pCryptoInfo->aesGcm256.iv, pKernelIv, TLS_CIPHER_AES_GCM_256_IV_SIZE );
+            ( void ) memcpy( pCryptoInfo->aesGcm256.rec_seq, recordSequence, TLS_CIPHER_AES_GCM_256_REC_SEQ_SIZE );
+            *pCryptoInfoLength = ( socklen_t ) sizeof( pCryptoInfo->aesGcm256 );
+        }
+        else if( bulkCipher == wolfssl_chacha )
+        {
+            /* ChaCha20-Poly1305 uses the full 12-byte IV in both versions. */
+            pCryptoInfo->info.cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+            ( void ) memcpy( pCryptoInfo->chacha20.key, pKey, TLS_CIPHER_CHACHA20_POLY1305_KEY_SIZE );
+            ( void ) memcpy( pCryptoInfo->chacha20.iv, pIv, TLS_CIPHER_CHACHA20_POLY1305_IV_SIZE );
+            ( void ) memcpy( pCryptoInfo->chacha20.rec_seq, recordSequence, TLS_CIPHER_CHACHA20_POLY1305_REC_SEQ_SIZE );
+            *pCryptoInfoLength = ( socklen_t ) sizeof( pCryptoInfo->chacha20 );
+        }
+        else
+        {
+            LogInfo( ( "Kernel TLS does not support the negotiated cipher: bulkCipher=%d, keySize=%d.",
+                       bulkCipher,
+                       keySize ) );
+            status = 0;
+        }
+
+        if( status == 1 )
+        {
+            pCryptoInfo->info.version = ( uint16_t ) version;
+        }
+
+        return status;
+    }
+    /*-----------------------------------------------------------*/
+
+    static void enableKtls( NetworkContext_t * pNetworkContext )
+    {
+        KtlsCryptoInfo_t cryptoInfo;
+        socklen_t cryptoInfoLength = 0;
+        word64 sequenceNumber = 0U;
+        volatile uint8_t * pWipe = NULL;
+        size_t i = 0U;
+        int ret = 0;
+
+        assert( pNetworkContext != NULL );
+        assert( pNetworkContext->pSsl != NULL );
+
+        if( pNetworkContext->ktlsMode != WOLFSSL_POSIX_KTLS_OFF )
+        {
+            ret = setsockopt( pNetworkContext->socketDescriptor, SOL_TCP, TCP_ULP, "tls", sizeof( "tls" ) );
+
+            if( ret != 0 )
+            {
+                LogInfo( ( "Kernel TLS is not available: errno=%d.", errno ) );
+            }
+        }
+
+        /* This transport is always the client, so it sends with the client
+         * write key and receives with the server write key. */
+        if( ( pNetworkContext->ktlsMode != WOLFSSL_POSIX_KTLS_OFF ) && ( ret == 0 ) &&
+            ( wolfSSL_GetSequenceNumber( pNetworkContext->pSsl, &sequenceNumber ) == WOLFSSL_SUCCESS ) &&
+            ( buildCryptoInfo( pNetworkContext->pSsl,
+                               wolfSSL_GetClientWriteKey( pNetworkContext->pSsl ),
+                               wolfSSL_GetClientWriteIV( pNetworkContext->pSsl ),
+                               ( uint64_t ) sequenceNumber,
+                               &cryptoInfo,
+                               &cryptoInfoLength ) == 1 ) )
+        {
+            if( setsockopt( pNetworkContext->socketDescriptor, SOL_TLS, TLS_TX, &cryptoInfo, cryptoInfoLength ) == 0 )
+            {
+                pNetworkContext->ktlsFlags |= KTLS_FLAG_TX;
+            }
+            else
+            {
+                LogInfo( ( "Failed to offload sends to kernel TLS: errno=%d.", errno ) );
+            }
+        }
+
+        /* Receives can only move to the kernel if wolfSSL has not already
+         * read records past the handshake from the socket. */
+        if( ( pNetworkContext->ktlsMode == WOLFSSL_POSIX_KTLS_TX_RX ) &&
+            ( ( pNetworkContext->ktlsFlags & KTLS_FLAG_TX ) != 0U ) )
+        {
+            if( ( pNetworkContext->pResumption != NULL ) &&
+                ( wolfSSL_version( pNetworkContext->pSsl ) == TLS1_3_VERSION ) )
+            {
+                /* TLS 1.3 session tickets arrive after the handshake, and
+                 * the kernel would drop them, so resumption would keep
+                 * using the first ticket until it expires. */
+                LogInfo( ( "Receives stay in wolfSSL: session tickets are expected." ) );
+            }
+            else if( ( wolfSSL_pending( pNetworkContext->pSsl ) != 0 ) ||
+                     ( wolfSSL_has_pending( pNetworkContext->pSsl ) != 0 ) )
+            {
+                LogInfo( ( "Receives stay in wolfSSL: records are already buffered." ) );
+            }
+            else if( ( wolfSSL_GetPeerSequenceNumber( pNetworkContext->pSsl, &sequenceNumber ) == WOLFSSL_SUCCESS ) &&
+                     ( buildCryptoInfo( pNetworkContext->pSsl,
+                                        wolfSSL_GetServerWriteKey( pNetworkContext->pSsl ),
+                                        wolfSSL_GetServerWriteIV( pNetworkContext->pSsl ),
+                                        ( uint64_t ) sequenceNumber,
+                                        &cryptoInfo,
+                                        &cryptoInfoLength ) == 1 ) &&
+                     ( setsockopt( pNetworkContext->socketDescriptor, SOL_TLS, TLS_RX, &cryptoInfo, cryptoInfoLength ) == 0 ) )
+            {
+                pNetworkContext->ktlsFlags |= KTLS_FLAG_RX;
+            }
+            else
+            {
+                LogInfo( ( "Failed to offload receives to kernel TLS: errno=%d.", errno ) );
+            }
+        }
+
+        /* Do not leave traffic keys on the stack. */
+        pWipe = ( volatile uint8_t * ) &cryptoInfo;
+
+        for( i = 0U; i < sizeof( cryptoInfo ); i++ )
+        {
+            pWipe[ i ] = 0U;
+        }
+
+        if( pNetworkContext->ktlsFlags != 0U )
+        {
+            LogInfo( ( "Offloaded TLS records to the kernel: tx=%u, rx=%u.",
+                       ( ( pNetworkContext->ktlsFlags & KTLS_FLAG_TX ) != 0U ) ? 1U : 0U,
+                       ( ( pNetworkContext->ktlsFlags & KTLS_FLAG_RX ) != 0U ) ? 1U : 0U ) );
+        }
+    }
+    /*-----------------------------------------------------------*/
+
+    static int32_t ktlsRecv( const NetworkContext_t * pNetworkContext,
+                             void * pBuffer,
+                             size_t bytesToRecv )
+    {
+        int32_t bytesReceived = 0;
+        ssize_t ret = 0;
+        struct msghdr message;
+        struct iovec ioVector;
+        struct cmsghdr * pControl = NULL;
+        uint8_t recordType = TLS_RECORD_TYPE_DATA;
+        union
+        {
+            struct cmsghdr header;
+            uint8_t buffer[ CMSG_SPACE( sizeof( uint8_t ) ) ];
+        } control;
+
+        ( void ) memset( &message, 0, sizeof( message ) );
+        ioVector.iov_base = pBuffer;
+        ioVector.iov_len = bytesToRecv;
+        message.msg_iov = &ioVector;
+        message.msg_iovlen = 1;
+        message.msg_control = control.buffer;
+        message.msg_controllen = sizeof( control.buffer );
+
+        ret = recvmsg( pNetworkContext->socketDescriptor, &message, 0 );
+
+        if( ret < 0 )
+        {
+            if( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) )
+            {
+                /* There is no data to receive at this time. */
+                bytesReceived = 0;
+            }
+            else
+            {
+                LogError( ( "Failed to receive data over network: errno=%d.", errno ) );
+                bytesReceived = -1;
+            }
+        }
+        else if( ret == 0 )
+        {
+            LogError( ( "Failed to receive data over network: connection closed." ) );
+            bytesReceived = -1;
+        }
+        else
+        {
+            /* The kernel reports the type of every record that is not
+             * application data in a control message. */
+            pControl = CMSG_FIRSTHDR( &message );
+
+            if( ( pControl != NULL ) &&
+                ( pControl->cmsg_level == SOL_TLS ) &&
+                ( pControl->cmsg_type == TLS_GET_RECORD_TYPE ) )
+            {
+                recordType = *( ( const uint8_t * ) CMSG_DATA( pControl ) );
+            }
+
+            if( recordType == TLS_RECORD_TYPE_DATA )
+            {
+                bytesReceived = ( int32_t ) ret;
+            }
+            else if( recordType == TLS_RECORD_TYPE_ALERT )
+            {
+                LogError( ( "Received TLS alert over network." ) );
+                bytesReceived = -1;
+            }
+            else
+            {
+                /* Post-handshake messages such as session tickets are not
+                 * application data. */
+                LogDebug( ( "Dropped TLS record of type %u.", recordType ) );
+                bytesReceived = 0;
+            }
+        }
+
+        return bytesReceived;
+    }
+    /*-----------------------------------------------------------*/
+
+    static void ktlsSendCloseNotify( const NetworkContext_t * pNetworkContext )
+    {
+        /* Warning level close_notify. */
+        uint8_t alert[ 2 ] = { 1U, 0U };
+        struct msghdr message;
+        struct iovec ioVector;
+        struct cmsghdr * pControl = NULL;
+        union
+        {
+            struct cmsghdr header;
+            uint8_t buffer[ CMSG_SPACE( sizeof( uint8_t ) ) ];
+        } control;
+
+        ( void ) memset( &message, 0, sizeof( message ) );
+        ( void ) memset( &control, 0, sizeof( control ) );
+        ioVector.iov_base = alert;
+        ioVector.iov_len = sizeof( alert );
+        message.msg_iov = &ioVector;
+        message.msg_iovlen = 1;
+        message.msg_control = control.buffer;
+        message.msg_controllen = sizeof( control.buffer );
+
+        pControl = CMSG_FIRSTHDR( &message );
+        pControl->cmsg_level = SOL_TLS;
+        pControl->cmsg_type = TLS_SET_RECORD_TYPE;
+        pControl->cmsg_len = CMSG_LEN( sizeof( uint8_t ) );
+        *( ( uint8_t * ) CMSG_DATA( pControl ) ) = TLS_RECORD_TYPE_ALERT;
+
+        if( sendmsg( pNetworkContext->socketDescriptor, &message, MSG_NOSIGNAL ) < 0 )
+        {
+            LogWarn( ( "Failed to send close_notify: errno=%d.", errno ) );
+        }
+    }
+    /*-----------------------------------------------------------*/
+#endif /* if ( WOLFSSL_POSIX_KTLS_SUPPORTED == 1 ) */
+
+static int32_t ktlsSend( const NetworkContext_t * pNetworkContext,
+                         const void * pBuffer,
+                         size_t bytesToSend )
+{
+    int32_t bytesSent = 0;
+    ssize_t ret = send( pNetworkContext->socketDescriptor, pBuffer, bytesToSend, MSG_NOSIGNAL );
+
+    if( ret >= 0 )
+    {
+        bytesSent = ( int32_t ) ret;
+    }
+    else if( ( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) ) &&
+             ( pNetworkContext->nonBlocking == 1U ) )
+    {
+        /* The socket buffer is full; try again later. */
+        bytesSent = 0;
+    }
+    else
+    {
+        /* On a blocking socket, EAGAIN is the send timeout. */
+        LogError( ( "Failed to send data over network: errno=%d.", errno ) );
+        bytesSent = -1;
+    }
+
+    return bytesSent;
+}
+/*-----------------------------------------------------------*/
+
+void Wolfssl_FreeResumption( WolfsslResumption_t * pResumption )
+{
+    if( pResumption == NULL )
+    {
+        LogError( ( "Parameter check failed: pResumption is NULL." ) );
+    }
+    else if( pResumption->pSession != NULL )
+    {
+        #if ( WOLFSSL_POSIX_RESUMPTION_SUPPORTED == 1 )
+            wolfSSL_SESSION_free( pResumption->pSession );
+        #endif
+        pResumption->pSession = NULL;
+    }
+    else
+    {
+        /* Empty else. */
+    }
+}
+/*-----------------------------------------------------------*/
+
+WolfsslStatus_t Wolfssl_GetMemoryStats( const WolfsslMemoryPool_t * pMemoryPool,
+                                        WolfsslMemoryStats_t * pStats )
+{
+    WolfsslStatus_t returnStatus = WOLFSSL_SUCCEED;
+
+    if( ( pMemoryPool == NULL ) || ( pStats == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pMemoryPool=%p, pStats=%p.",
+                    ( const void * ) pMemoryPool,
+                    ( void * ) pStats ) );
+        returnStatus = WOLFSSL_INVALID_PARAMETER;
+    }
+    else
+    {
+        ( void ) memset( pStats, 0x00, sizeof( WolfsslMemoryStats_t ) );
+        pStats->peakConnectionBytes = pMemoryPool->peakConnectionBytes;
+        pStats->peakConnectionAllocations = pMemoryPool->peakConnectionAllocations;
+
+        #if ( WOLFSSL_POSIX_STATIC_MEMORY_SUPPORTED == 1 )
+            WOLFSSL_MEM_STATS poolStats;
+            uint32_t bucket = 0U;
+
+            if( ( pMemoryPool->pSslContext != NULL ) &&
+                ( wolfSSL_CTX_is_static_memory( pMemoryPool->pSslContext, &poolStats ) == 1 ) )
+            {
+                pStats->currentAllocations = poolStats.curAlloc;
+                pStats->totalAllocations = poolStats.totalAlloc;
+                pStats->totalFrees = poolStats.totalFr;
+                pStats->availableIoBuffers = poolStats.avaIO;
+
+                for( bucket = 0U; bucket < ( uint32_t ) WOLFMEM_MAX_BUCKETS; bucket++ )
+                {
+                    pStats->availableBytes += poolStats.avaBlock[ bucket ] * poolStats.blockSz[ bucket ];
+                }
+            }
+        #endif
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+void Wolfssl_FreeMemoryPool( WolfsslMemoryPool_t * pMemoryPool )
+{
+    if( pMemoryPool == NULL )
+    {
+        LogError( ( "Parameter check failed: pMemoryPool is NULL." ) );
+    }
+    else if( pMemoryPool->pSslContext != NULL )
+    {
+        wolfSSL_CTX_free( pMemoryPool->pSslContext );
+        pMemoryPool->pSslContext = NULL;
+    }
+    else
+    {
+        /* Empty else. */
+    }
+}
+/*-----------------------------------------------------------*/
+
+WolfsslStatus_t Wolfssl_Connect( NetworkContext_t * pNetworkContext,
+                                 const ServerInfo_t * pServerInfo,
+                                 const WolfsslCredentials_t * pWolfsslCredentials,
+                                 uint32_t sendTimeoutMs,
+                                 uint32_t recvTimeoutMs )
+{
+    SocketStatus_t socketStatus = SOCKETS_SUCCESS;
+    WolfsslStatus_t returnStatus = WOLFSSL_SUCCEED;
+
+    /* Validate parameters. */
+    if( pNetworkContext == NULL )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+        returnStatus = WOLFSSL_INVALID_PARAMETER;
+    }
+    else if( pWolfsslCredentials == NULL )
+    {
+        LogError( ( "Parameter check failed: pWolfsslCredentials is NULL." ) );
+        returnStatus = WOLFSSL_INVALID_PARAMETER;
+    }
+    else
+    {
+        /* Empty else. */
+    }
+
+    /* Establish the TCP connection. */
+    if( returnStatus == WOLFSSL_SUCCEED)
+    {
+        pNetworkContext->pSsl = NULL;
+        pNetworkContext->pResumption = pWolfsslCredentials->pResumption;
+        pNetworkContext->handshakePending = 0U;
+        pNetworkContext->nonBlocking = 0U;
+        pNetworkContext->ktlsMode = pWolfsslCredentials->ktlsMode;
+        pNetworkContext->ktlsFlags = 0U;
+        pNetworkContext->pMemoryPool = pWolfsslCredentials->pMemoryPool;
+
+        socketStatus = Sockets_Connect( &pNetworkContext->socketDescriptor,
+                                        pServerInfo,
+                                        sendTimeoutMs,
+                                        recvTimeoutMs );
+
+        /* Convert socket wrapper status to wolfssl status. */
+        returnStatus = convertToWolfsslStatus( socketStatus );
+    }
+
+    if( returnStatus == WOLFSSL_SUCCEED )
+    {
+        returnStatus = createSslObject( pNetworkContext, pWolfsslCredentials );
+    }
+
+    /* Perform the TLS handshake. */
+    if( returnStatus == WOLFSSL_SUCCEED )
+    {
+        #if ( WOLFSSL_POSIX_EARLY_DATA_SUPPORTED == 1 )
+            /* Defer the handshake so that the first send leaves together
+             * with the ClientHello as 0-RTT early data. */
+            if( ( pNetworkContext->pResumption != NULL ) &&
+                ( pNetworkContext->pResumption->pSession != NULL ) &&
+                ( pNetworkContext->pResumption->earlyDataPolicy == WOLFSSL_POSIX_EARLY_DATA_FIRST_FLIGHT ) &&
+                ( pWolfsslCredentials->tlsVersion != WOLFSSL_POSIX_TLS_1_2 ) )
+            {
+                LogDebug( ( "Deferring TLS handshake to send early data." ) );
+                pNetworkContext->handshakePending = 1U;
+            }
+        #endif
+
+        if( pNetworkContext->handshakePending == 0U )
+        {
+            returnStatus = performHandshake( pNetworkContext );
+
+            /* Clean up on error. */
+            if( returnStatus != WOLFSSL_SUCCEED )
+            {
+                wolfSSL_free( pNetworkContext->pSsl );
+                pNetworkContext->pSsl = NULL;
+            }
+        }
+    }
+
     /* Log failure or success depending on status. */
     if( returnStatus != WOLFSSL_SUCCEED )
     {
@@ -554,6 +1662,97 @@ WolfsslStatus_t Wolfssl_Connect( NetworkContext_t * pNetworkContext,
 }
 /*-----------------------------------------------------------*/
 
+WolfsslStatus_t Wolfssl_HandshakeStart( NetworkContext_t * pNetworkContext,
+                                        int32_t socketDescriptor,
+                                        const WolfsslCredentials_t * pWolfsslCredentials )
+{
+    WolfsslStatus_t returnStatus = WOLFSSL_SUCCEED;
+
+    if( pNetworkContext == NULL )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+        returnStatus = WOLFSSL_INVALID_PARAMETER;
+    }
+    else if( pWolfsslCredentials == NULL )
+    {
+        LogError( ( "Parameter check failed: pWolfsslCredentials is NULL." ) );
+        returnStatus = WOLFSSL_INVALID_PARAMETER;
+    }
+    else if( socketDescriptor < 0 )
+    {
+        LogError( ( "Parameter check failed: socketDescriptor is invalid." ) );
+        returnStatus = WOLFSSL_INVALID_PARAMETER;
+    }
+    else
+    {
+        pNetworkContext->socketDescriptor = socketDescriptor;
+        pNetworkContext->pSsl = NULL;
+        pNetworkContext->pResumption = pWolfsslCredentials->pResumption;
+        pNetworkContext->handshakePending = 0U;
+        pNetworkContext->nonBlocking = 1U;
+        pNetworkContext->ktlsMode = pWolfsslCredentials->ktlsMode;
+        pNetworkContext->ktlsFlags = 0U;
+        pNetworkContext->pMemoryPool = pWolfsslCredentials->pMemoryPool;
+
+        /* Early data is not deferred here: the caller drives the handshake
+         * and sends its first flight after it has completed. */
+        returnStatus = createSslObject( pNetworkContext, pWolfsslCredentials );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+WolfsslStatus_t Wolfssl_HandshakeContinue( NetworkContext_t * pNetworkContext )
+{
+    WolfsslStatus_t returnStatus = WOLFSSL_SUCCEED;
+    int ret = WOLFSSL_FAILURE;
+    int sslError = 0;
+
+    if( ( pNetworkContext == NULL ) || ( pNetworkContext->pSsl == NULL ) )
+    {
+        LogError( ( "Parameter check failed: no SSL object to continue the handshake on." ) );
+        returnStatus = WOLFSSL_INVALID_PARAMETER;
+    }
+    else
+    {
+        ret = wolfSSL_connect( pNetworkContext->pSsl );
+
+        if( ret == WOLFSSL_SUCCESS )
+        {
+            returnStatus = completeHandshake( pNetworkContext );
+        }
+        else
+        {
+            sslError = wolfSSL_get_error( pNetworkContext->pSsl, ret );
+
+            if( sslError == WOLFSSL_ERROR_WANT_READ )
+            {
+                returnStatus = WOLFSSL_HANDSHAKE_WANT_READ;
+            }
+            else if( sslError == WOLFSSL_ERROR_WANT_WRITE )
+            {
+                returnStatus = WOLFSSL_HANDSHAKE_WANT_WRITE;
+            }
+            else
+            {
+                LogError( ( "Failed to perform TLS handshake, error = %d.", sslError ) );
+                returnStatus = WOLFSSL_HANDSHAKE_FAILED;
+            }
+        }
+
+        /* Leave only the socket for Wolfssl_Disconnect to close. */
+        if( returnStatus == WOLFSSL_HANDSHAKE_FAILED )
+        {
+            wolfSSL_free( pNetworkContext->pSsl );
+            pNetworkContext->pSsl = NULL;
+        }
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
 WolfsslStatus_t Wolfssl_Disconnect( const NetworkContext_t * pNetworkContext )
 {
     SocketStatus_t socketStatus = SOCKETS_INVALID_PARAMETER;
@@ -570,11 +1769,28 @@ WolfsslStatus_t Wolfssl_Disconnect( const NetworkContext_t * pNetworkContext )
     {
         if( pNetworkContext->pSsl != NULL )
         {
+            /* TLS 1.3 session tickets arrive after the handshake, so keep
+             * the latest session for the next connection. */
+            storeSession( pNetworkContext );
+            recordMemoryPeak( pNetworkContext );
+
+            if( ( pNetworkContext->ktlsFlags & KTLS_FLAG_TX ) != 0U )
+            {
+                /* wolfSSL no longer knows the send sequence number, so the
+                 * alert has to be encrypted by the kernel. */
+                #if ( WOLFSSL_POSIX_KTLS_SUPPORTED == 1 )
+                    ktlsSendCloseNotify( pNetworkContext );
+                #endif
+            }
             /* WOLFSSL shutdown should be called twice. */
-            if( wolfSSL_shutdown( pNetworkContext->pSsl ) == WOLFSSL_SHUTDOWN_NOT_DONE )
+            else if( wolfSSL_shutdown( pNetworkContext->pSsl ) == WOLFSSL_SHUTDOWN_NOT_DONE )
             {
                 ( void ) wolfSSL_shutdown( pNetworkContext->pSsl );
             }
+            else
+            {
+                /* Empty else. */
+            }
 
             wolfSSL_free( pNetworkContext->pSsl );
         }
@@ -601,6 +1817,20 @@ int32_t Wolfssl_Recv( NetworkContext_t * pNetworkContext,
     {
         LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
     }
+    else if( ( pNetworkContext->handshakePending == 1U ) &&
+             ( performHandshake( pNetworkContext ) != WOLFSSL_SUCCEED ) )
+    {
+        /* Nothing was sent before the first receive, so the deferred
+         * handshake is completed without early data. */
+        bytesReceived = -1;
+    }
+
+    #if ( WOLFSSL_POSIX_KTLS_SUPPORTED == 1 )
+        else if( ( pNetworkContext->ktlsFlags & KTLS_FLAG_RX ) != 0U )
+        {
+            bytesReceived = ktlsRecv( pNetworkContext, pBuffer, bytesToRecv );
+        }
+    #endif
     else if( pNetworkContext->pSsl != NULL )
     {
         /* blocking SSL read of data. */
@@ -648,18 +1878,64 @@ int32_t Wolfssl_Send( NetworkContext_t * pNetworkContext,
     {
         LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
     }
+    else if( ( pNetworkContext->ktlsFlags & KTLS_FLAG_TX ) != 0U )
+    {
+        bytesSent = ktlsSend( pNetworkContext, pBuffer, bytesToSend );
+    }
     else if( pNetworkContext->pSsl != NULL )
     {
-        /* blocking SSL write of data. */
-        bytesSent = wolfSSL_write( pNetworkContext->pSsl,
-                                   pBuffer,
-                                   ( int ) bytesToSend );
+        #if ( WOLFSSL_POSIX_EARLY_DATA_SUPPORTED == 1 )
+            if( pNetworkContext->handshakePending == 1U )
+            {
+                if( bytesToSend <= pNetworkContext->pResumption->maxEarlyDataBytes )
+                {
+                    bytesSent = sendEarlyData( pNetworkContext, pBuffer, bytesToSend );
+                }
+                else if( performHandshake( pNetworkContext ) != WOLFSSL_SUCCEED )
+                {
+                    bytesSent = -1;
+                }
+                else
+                {
+                    /* Too large for the early data policy; sent below. */
+                }
+            }
+        #endif
 
-        if( bytesSent <= 0 )
+        if( ( bytesSent == 0 ) && ( ( pNetworkContext->ktlsFlags & KTLS_FLAG_TX ) != 0U ) )
         {
-            sslError = wolfSSL_get_error( pNetworkContext->pSsl, bytesSent );
+            /* The deferred handshake just offloaded sends to the kernel, so
+             * wolfSSL must not encrypt the data as well. */
+            bytesSent = ktlsSend( pNetworkContext, pBuffer, bytesToSend );
+        }
+        else
+        {
+            /* blocking SSL write of data. */
+            if( bytesSent == 0 )
+            {
+                bytesSent = wolfSSL_write( pNetworkContext->pSsl,
+                                           pBuffer,
+                                           ( int ) bytesToSend );
+            }
 
-            LogError( ( "Failed to send data over network: error = %d.", sslError ) );
+            if( bytesSent <= 0 )
+            {
+                sslError = wolfSSL_get_error( pNetworkContext->pSsl, bytesSent );
+
+                if( ( sslError == WOLFSSL_ERROR_WANT_WRITE ) &&
+                    ( pNetworkContext->nonBlocking == 1U ) )
+                {
+                    /* The non-blocking socket is full. The same buffer has to
+                     * be passed again once the socket is writable. A blocking
+                     * socket reports its send timeout the same way, which
+                     * stays an error, as coreMQTT retries a 0 without bound. */
+                    bytesSent = 0;
+                }
+                else
+                {
+                    LogError( ( "Failed to send data over network: error = %d.", sslError ) );
+                }
+            }
         }
     }
     else
@@ -671,3 +1947,84 @@ int32_t Wolfssl_Send( NetworkContext_t * pNetworkContext,
     return bytesSent;
 }
 /*-----------------------------------------------------------*/
+
+int32_t Wolfssl_SendFile( NetworkContext_t * pNetworkContext,
+                          int32_t fileDescriptor,
+                          int64_t * pOffset,
+                          size_t bytesToSend )
+{
+    int32_t bytesSent = -1;
+    uint8_t chunk[ WOLFSSL_POSIX_SENDFILE_CHUNK_SIZE ];
+    size_t chunkLength = 0U;
+    ssize_t ret = 0;
+
+    #if ( WOLFSSL_POSIX_KTLS_SUPPORTED == 1 )
+        off_t offset = 0;
+    #endif
+
+    if( ( pNetworkContext == NULL ) || ( pOffset == NULL ) || ( fileDescriptor < 0 ) )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext=%p, pOffset=%p, fileDescriptor=%d.",
+                    ( void * ) pNetworkContext,
+                    ( void * ) pOffset,
+                    ( int ) fileDescriptor ) );
+    }
+
+    #if ( WOLFSSL_POSIX_KTLS_SUPPORTED == 1 )
+        else if( ( pNetworkContext->ktlsFlags & KTLS_FLAG_TX ) != 0U )
+        {
+            /* The kernel encrypts straight from the page cache. */
+            offset = ( off_t ) *pOffset;
+            ret = sendfile( pNetworkContext->socketDescriptor,
+                            fileDescriptor,
+                            &offset,
+                            ( bytesToSend > ( size_t ) INT32_MAX ) ? ( size_t ) INT32_MAX : bytesToSend );
+
+            if( ( ret == 0 ) && ( bytesToSend > 0U ) )
+            {
+                /* The file ended before the requested length. */
+                LogError( ( "Failed to send file over network: unexpected end of file." ) );
+            }
+            else if( ret >= 0 )
+            {
+                bytesSent = ( int32_t ) ret;
+                *pOffset = ( int64_t ) offset;
+            }
+            else if( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) )
+            {
+                bytesSent = 0;
+            }
+            else
+            {
+                LogError( ( "Failed to send file over network: errno=%d.", errno ) );
+            }
+        }
+    #endif /* if ( WOLFSSL_POSIX_KTLS_SUPPORTED == 1 ) */
+    else
+    {
+        chunkLength = ( bytesToSend < sizeof( chunk ) ) ? bytesToSend : sizeof( chunk );
+        ret = pread( fileDescriptor, chunk, chunkLength, ( off_t ) *pOffset );
+
+        if( ret < 0 )
+        {
+            LogError( ( "Failed to read file: errno=%d.", errno ) );
+        }
+        else if( ret == 0 )
+        {
+            /* The file ended before the requested length. */
+            LogError( ( "Failed to read file: unexpected end of file." ) );
+        }
+        else
+        {
+            bytesSent = Wolfssl_Send( pNetworkContext, chunk, ( size_t ) ret );
+
+            if( bytesSent > 0 )
+            {
+                *pOffset += bytesSent;
+            }
+        }
+    }
+
+    return bytesSent;
+}
+/*-----------------------------------------------------------*/